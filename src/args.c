@@ -20,7 +20,7 @@
 #include "args.h"
 
 #include <stdio.h> /* stderr fprintf() puts() snprintf() */
-#include <stdlib.h> /* EXIT_FAILURE EXIT_SUCCESS exit() */
+#include <stdlib.h> /* EXIT_FAILURE EXIT_SUCCESS exit() free() */
 #include <string.h> /* strcmp() */
 
 #include "compat/fs_limits.h"
@@ -51,22 +51,24 @@ static void quit_on_arg_parsing(int code);
 
 /* Command line arguments definition for getopt_long(). */
 static struct option long_opts[] = {
-	{ "logging",      optional_argument, .flag = NULL, .val = 'l' },
-	{ "no-configs",   no_argument,       .flag = NULL, .val = 'n' },
-	{ "select",       required_argument, .flag = NULL, .val = 's' },
-	{ "choose-files", required_argument, .flag = NULL, .val = 'F' },
-	{ "choose-dir",   required_argument, .flag = NULL, .val = 'D' },
-	{ "delimiter",    required_argument, .flag = NULL, .val = 'd' },
-	{ "on-choose",    required_argument, .flag = NULL, .val = 'o' },
+	{ "logging",         optional_argument, .flag = NULL, .val = 'l' },
+	{ "no-configs",      no_argument,       .flag = NULL, .val = 'n' },
+	{ "startup-profile", required_argument, .flag = NULL, .val = 'p' },
+	{ "select",          required_argument, .flag = NULL, .val = 's' },
+	{ "choose-files",    required_argument, .flag = NULL, .val = 'F' },
+	{ "choose-dir",      required_argument, .flag = NULL, .val = 'D' },
+	{ "delimiter",       required_argument, .flag = NULL, .val = 'd' },
+	{ "on-choose",       required_argument, .flag = NULL, .val = 'o' },
 
 #ifdef ENABLE_REMOTE_CMDS
-	{ "server-list",  no_argument,       .flag = NULL, .val = 'L' },
-	{ "server-name",  required_argument, .flag = NULL, .val = 'N' },
-	{ "remote",       no_argument,       .flag = NULL, .val = 'r' },
+	{ "server-list",     no_argument,       .flag = NULL, .val = 'L' },
+	{ "server-name",     required_argument, .flag = NULL, .val = 'N' },
+	{ "remote",          no_argument,       .flag = NULL, .val = 'r' },
+	{ "remote-wait",     no_argument,       .flag = NULL, .val = 'w' },
 #endif
 
-	{ "help",         no_argument,       .flag = NULL, .val = 'h' },
-	{ "version",      no_argument,       .flag = NULL, .val = 'v' },
+	{ "help",            no_argument,       .flag = NULL, .val = 'h' },
+	{ "version",         no_argument,       .flag = NULL, .val = 'v' },
 
 	{ }
 };
@@ -108,6 +110,10 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 			case 'r': /* --remote <args>... */
 				args->remote_cmds = argv + optind;
 				return;
+			case 'w': /* --remote-wait <args>... */
+				args->remote_cmds = argv + optind;
+				args->remote_wait = 1;
+				return;
 
 			case 'h': /* -h, --help */
 				/* Only first one of -v and -h should take effect. */
@@ -137,6 +143,9 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 			case 'n': /* --no-configs */
 				args->no_configs = 1;
 				break;
+			case 'p': /* --startup-profile <path>|- */
+				get_path_or_std(dir, optarg, args->startup_profile);
+				break;
 
 			case 's': /* --select <path> */
 				handle_arg_or_fail(optarg, 1, dir, args);
@@ -380,6 +389,9 @@ show_help_msg(const char wrong_arg[])
 	puts("    log path is specified and permissions allow to open it for");
 	puts("    writing, then logging of early initialization (before value of");
 	puts("    $VIFM is determined) is put there.\n");
+	puts("  vifm --startup-profile <path>|-");
+	puts("    measure duration of initialization steps and write report to the");
+	puts("    file once startup is over.  \"-\" means standard output on exit.\n");
 
 #ifdef ENABLE_REMOTE_CMDS
 	puts("  vifm --server-list");
@@ -388,6 +400,9 @@ show_help_msg(const char wrong_arg[])
 	puts("    name of target or this instance.\n");
 	puts("  vifm --remote");
 	puts("    passes all arguments that left in command line to active vifm server.\n");
+	puts("  vifm --remote-wait");
+	puts("    same as --remote, but waits for the arguments to be processed,");
+	puts("    prints messages and reports failure via exit code.\n");
 #endif
 	puts("  vifm -c <command> | +<command>");
 	puts("    run <command> on startup.\n");
@@ -423,12 +438,24 @@ process_non_general_args(args_t *args)
 {
 	if(args->remote_cmds != NULL)
 	{
-		if(ipc_send(args->server_name, args->remote_cmds) != 0)
+		int status = 0;
+		char *output = NULL;
+
+		if(ipc_send(args->server_name, args->remote_cmds,
+					args->remote_wait ? &status : NULL,
+					args->remote_wait ? &output : NULL) != 0)
 		{
 			fprintf(stderr, "%s\n", "Sending remote commands failed.");
 			quit_on_arg_parsing(EXIT_FAILURE);
+			return;
 		}
-		quit_on_arg_parsing(EXIT_SUCCESS);
+
+		if(output != NULL)
+		{
+			puts(output);
+			free(output);
+		}
+		quit_on_arg_parsing(status == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
 		return;
 	}
 
@@ -33,6 +33,8 @@ typedef struct
 	int logging;            /* Enable logging. */
 	char *startup_log_path; /* Path for startup log (during initialization). */
 
+	char startup_profile[PATH_MAX]; /* Output for profile of startup. */
+
 	int no_configs;  /* Skip reading configuration files. */
 	int file_picker; /* Use predefined $VIFM/vimfiles for list of files. */
 
@@ -43,6 +45,7 @@ typedef struct
 
 	const char *server_name; /* Name of this/target server. */
 	char **remote_cmds;      /* Arguments to pass to server instance. */
+	int remote_wait;         /* Whether to wait for remote_cmds to be run. */
 
 	char lwin_path[PATH_MAX]; /* Chosen path of the left pane. */
 	char rwin_path[PATH_MAX]; /* Chosen path of the right pane. */
@@ -25,20 +25,19 @@
 
 #include <pthread.h> /* PTHREAD_* pthread_*() */
 
-#include <fcntl.h> /* open() */
-#include <unistd.h> /* select() */
+#include <fcntl.h> /* F_GETFL F_SETFL O_NONBLOCK fcntl() open() */
+#include <unistd.h> /* close() read() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* errno */
-#include <stddef.h> /* wchar_t NULL */
-#include <stdlib.h> /* EXIT_FAILURE _Exit() free() malloc() */
+#include <errno.h> /* EAGAIN EINTR errno */
+#include <stddef.h> /* wchar_t NULL size_t */
+#include <stdlib.h> /* EXIT_FAILURE _Exit() free() malloc() realloc() */
 #include <string.h>
 #include <sys/stat.h> /* O_RDONLY */
 #include <sys/types.h> /* pid_t ssize_t */
 #ifndef _WIN32
-#include <sys/select.h> /* FD_* select */
-#include <sys/time.h> /* timeval */
 #include <sys/wait.h> /* WEXITSTATUS() waitpid() */
+#include <poll.h> /* POLLIN pollfd poll() */
 #endif
 
 #include "cfg/config.h"
@@ -101,6 +100,13 @@ background_task_args;
 static void job_check(job_t *const job);
 static void job_free(job_t *const job);
 #ifndef _WIN32
+static void check_error_streams(void);
+static int read_error_stream(job_t *job);
+static int add_error_stream(job_t *job);
+static void remove_error_stream(size_t idx);
+static void forget_error_stream(const job_t *job);
+#endif
+#ifndef _WIN32
 static job_t * add_background_job(pid_t pid, const char cmd[], int fd,
 		BgJobType type);
 #else
@@ -110,9 +116,32 @@ static job_t * add_background_job(pid_t pid, const char cmd[], HANDLE hprocess,
 static void * background_task_bootstrap(void *arg);
 static void set_current_job(job_t *job);
 static void make_current_job_key(void);
+static void register_job_event(void);
 
 job_t *jobs;
 
+#ifndef _WIN32
+/* Error streams of external commands that are still open, which allows waiting
+ * for all of them at once. */
+static struct pollfd *err_fds;
+/* Jobs that correspond to elements of err_fds (indexes match). */
+static job_t **err_jobs;
+/* Number of elements in err_fds and err_jobs. */
+static size_t nerr_fds;
+/* Number of elements err_fds and err_jobs have room for. */
+static size_t err_fds_capacity;
+#endif
+
+/* Number of jobs that are run in background threads. */
+static int nthread_jobs;
+
+/* Incremented on events that need to be processed by the main thread, like
+ * termination of jobs or errors of tasks.  Accessed only atomically as it's
+ * updated by background threads and signal handler. */
+static int job_events;
+/* Value of job_events for which the events were processed. */
+static int handled_job_events;
+
 static pthread_key_t current_job;
 static pthread_once_t current_job_once = PTHREAD_ONCE_INIT;
 
@@ -136,6 +165,7 @@ add_finished_job(pid_t pid, int exit_code)
 		{
 			job->running = 0;
 			job->exit_code = exit_code;
+			register_job_event();
 			break;
 		}
 		job = job->next;
@@ -148,6 +178,7 @@ check_background_jobs(void)
 	job_t *head = jobs;
 	job_t *prev;
 	job_t *p;
+	int events;
 
 	/* Quit if there is no jobs or list is unavailable (e.g. used by another
 	 * invocation of this function). */
@@ -164,6 +195,25 @@ check_background_jobs(void)
 	head = jobs;
 	jobs = NULL;
 
+#ifndef _WIN32
+	check_error_streams();
+
+	/* Nothing else to do unless some jobs changed their state. */
+	events = __atomic_load_n(&job_events, __ATOMIC_ACQUIRE);
+	if(events == handled_job_events)
+	{
+		assert(jobs == NULL && "Job list shouldn't be used by anyone.");
+		jobs = head;
+		bg_jobs_unfreeze();
+		return;
+	}
+	handled_job_events = events;
+#else
+	/* There is no notification about termination of processes, so each of them
+	 * needs to be checked. */
+	(void)events;
+#endif
+
 	p = head;
 	prev = NULL;
 	while(p != NULL)
@@ -186,6 +236,11 @@ check_background_jobs(void)
 				ui_stat_job_bar_remove(&j->bg_op);
 			}
 
+			if(j->type != BJT_COMMAND)
+			{
+				--nthread_jobs;
+			}
+
 			job_free(j);
 		}
 		else
@@ -201,24 +256,12 @@ check_background_jobs(void)
 	bg_jobs_unfreeze();
 }
 
-/* Checks status of the job.  Processes error stream or checks whether process
+/* Checks status of the job.  Reports errors of a task or checks whether process
  * is still running. */
 static void
 job_check(job_t *const job)
 {
 #ifndef _WIN32
-	fd_set ready;
-	int max_fd = 0;
-	struct timeval ts = { .tv_sec = 0, .tv_usec = 1000 };
-
-	/* Setup pipe for reading */
-	FD_ZERO(&ready);
-	if(job->fd >= 0)
-	{
-		FD_SET(job->fd, &ready);
-		max_fd = job->fd;
-	}
-
 	if(job->error != NULL)
 	{
 		if(!job->skip_errors)
@@ -229,34 +272,148 @@ job_check(job_t *const job)
 		free(job->error);
 		job->error = NULL;
 	}
+#else
+	DWORD retcode;
+	if(GetExitCodeProcess(job->hprocess, &retcode) != 0)
+	{
+		if(retcode != STILL_ACTIVE)
+		{
+			job->running = 0;
+		}
+	}
+#endif
+}
+
+#ifndef _WIN32
+
+/* Checks error streams of all external commands at once and processes only
+ * those of them that have data or were closed. */
+static void
+check_error_streams(void)
+{
+	size_t i;
+
+	if(nerr_fds == 0U || poll(err_fds, nerr_fds, 0) <= 0)
+	{
+		return;
+	}
+
+	i = 0U;
+	while(i < nerr_fds)
+	{
+		job_t *const job = err_jobs[i];
+
+		if(err_fds[i].revents == 0 || read_error_stream(job) == 0)
+		{
+			++i;
+			continue;
+		}
+
+		/* Nothing will be read from the stream anymore, so don't keep it open to
+		 * avoid reporting it as ready over and over.  Another element takes place
+		 * of the removed one, so index isn't incremented. */
+		close(job->fd);
+		job->fd = NO_JOB_ID;
+		remove_error_stream(i);
+	}
+}
 
-	while(select(max_fd + 1, &ready, NULL, NULL, &ts) > 0)
+/* Reads everything that is available in error stream of the job and reports it
+ * to the user.  Returns non-zero if the stream is closed, otherwise zero is
+ * returned. */
+static int
+read_error_stream(job_t *job)
+{
+	while(1)
 	{
 		char err_msg[ERR_MSG_LEN];
 
 		const ssize_t nread = read(job->fd, err_msg, sizeof(err_msg) - 1);
 		if(nread == 0)
 		{
-			break;
+			return 1;
 		}
-		else if(nread > 0 && !job->skip_errors)
+		if(nread < 0)
+		{
+			return (errno != EAGAIN && errno != EINTR);
+		}
+
+		if(!job->skip_errors)
 		{
 			err_msg[nread] = '\0';
 			job->skip_errors = prompt_error_msg("Background Process Error", err_msg);
 		}
 	}
-#else
-	DWORD retcode;
-	if(GetExitCodeProcess(job->hprocess, &retcode) != 0)
+}
+
+/* Registers error stream of the job for checking.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+add_error_stream(job_t *job)
+{
+	if(nerr_fds == err_fds_capacity)
 	{
-		if(retcode != STILL_ACTIVE)
+		const size_t capacity = (err_fds_capacity == 0U) ? 8U
+		                                                 : err_fds_capacity*2U;
+		struct pollfd *fds;
+		job_t **fd_jobs;
+
+		fds = realloc(err_fds, sizeof(*err_fds)*capacity);
+		if(fds == NULL)
 		{
-			job->running = 0;
+			return 1;
+		}
+		err_fds = fds;
+
+		fd_jobs = realloc(err_jobs, sizeof(*err_jobs)*capacity);
+		if(fd_jobs == NULL)
+		{
+			return 1;
 		}
+		err_jobs = fd_jobs;
+
+		err_fds_capacity = capacity;
 	}
-#endif
+
+	/* Reading stops when there is no more data. */
+	(void)fcntl(job->fd, F_SETFL, fcntl(job->fd, F_GETFL) | O_NONBLOCK);
+
+	err_fds[nerr_fds].fd = job->fd;
+	err_fds[nerr_fds].events = POLLIN;
+	err_fds[nerr_fds].revents = 0;
+	err_jobs[nerr_fds] = job;
+	++nerr_fds;
+	return 0;
 }
 
+/* Removes element of error streams list at specified index by putting the last
+ * element in its place. */
+static void
+remove_error_stream(size_t idx)
+{
+	--nerr_fds;
+	err_fds[idx] = err_fds[nerr_fds];
+	err_jobs[idx] = err_jobs[nerr_fds];
+}
+
+/* Removes error stream of the job from the list of error streams if it's
+ * there. */
+static void
+forget_error_stream(const job_t *job)
+{
+	size_t i;
+	for(i = 0U; i < nerr_fds; ++i)
+	{
+		if(err_jobs[i] == job)
+		{
+			remove_error_stream(i);
+			break;
+		}
+	}
+}
+
+#endif
+
 /* Frees resources allocated by the job as well as the job_t structure itself.
  * The job can be NULL. */
 static void
@@ -275,6 +432,7 @@ job_free(job_t *const job)
 #ifndef _WIN32
 	if(job->fd != NO_JOB_ID)
 	{
+		forget_error_stream(job);
 		close(job->fd);
 	}
 #else
@@ -374,6 +532,7 @@ error_msg(const char *title, const char *text)
 	else
 	{
 		(void)replace_string(&job->error, text);
+		register_job_event();
 	}
 }
 #endif
@@ -709,6 +868,7 @@ start_background_job(const char *cmd, int skip_errors)
 		job = add_background_job(pid, command, error_pipe[0], BJT_COMMAND);
 		if(job == NULL)
 		{
+			close(error_pipe[0]);
 			free(command);
 			return -1;
 		}
@@ -814,6 +974,7 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 		/* Mark job as finished with error. */
 		task_args->job->running = 0;
 		task_args->job->exit_code = 1;
+		register_job_event();
 
 		free(task_args);
 		ret = 1;
@@ -855,12 +1016,24 @@ add_background_job(pid_t pid, const char cmd[], HANDLE hprocess, BgJobType type)
 	if(type != BJT_COMMAND)
 	{
 		pthread_mutex_init(&new->bg_op_guard, NULL);
+		++nthread_jobs;
 	}
 	new->bg_op.total = 0;
 	new->bg_op.done = 0;
 	new->bg_op.progress = -1;
 	new->bg_op.descr = NULL;
 
+#ifndef _WIN32
+	/* Error stream that isn't checked would never be drained, so bail out. */
+	if(fd != NO_JOB_ID && add_error_stream(new) != 0)
+	{
+		show_error_msg("Memory error", "Unable to allocate enough memory");
+		free(new->cmd);
+		free(new);
+		return NULL;
+	}
+#endif
+
 	jobs = new;
 	return new;
 }
@@ -880,6 +1053,7 @@ background_task_bootstrap(void *arg)
 	/* Mark task as finished normally. */
 	task_args->job->running = 0;
 	task_args->job->exit_code = 0;
+	register_job_event();
 
 	free(task_args);
 
@@ -901,6 +1075,14 @@ make_current_job_key(void)
 	(void)pthread_key_create(&current_job, NULL);
 }
 
+/* Notifies main thread about an event it needs to process.  Can be called from
+ * any thread and from a signal handler. */
+static void
+register_job_event(void)
+{
+	(void)__atomic_fetch_add(&job_events, 1, __ATOMIC_RELEASE);
+}
+
 int
 bg_has_active_jobs(void)
 {
@@ -928,6 +1110,29 @@ bg_has_active_jobs(void)
 	return bg_op_count > 0;
 }
 
+int
+bg_jobs_get_fds(int fds[], int len)
+{
+#ifndef _WIN32
+	size_t i;
+
+	/* Threads can't be waited on via a file descriptor.  Termination of processes
+	 * is signaled by SIGCHLD, so only error streams need to be waited on. */
+	if(nthread_jobs != 0 || nerr_fds > (size_t)len)
+	{
+		return -1;
+	}
+
+	for(i = 0U; i < nerr_fds; ++i)
+	{
+		fds[i] = err_fds[i].fd;
+	}
+	return nerr_fds;
+#else
+	return (jobs == NULL) ? 0 : -1;
+#endif
+}
+
 int
 bg_jobs_freeze(void)
 {
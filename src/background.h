@@ -122,6 +122,11 @@ int bg_execute(const char descr[], const char op_descr[], int total,
  * by vifm) running in background. */
 int bg_has_active_jobs(void);
 
+/* Fills fds array of length len with file descriptors that become ready on
+ * changes of state of background jobs.  Returns number of descriptors or -1 if
+ * state of some of the jobs can't be tracked this way. */
+int bg_jobs_get_fds(int fds[], int len);
+
 /* Performs preparations necessary for safe access of the jobs list.  Effect of
  * calling this function must be reverted by calling bg_jobs_unfreeze().
  * Returns zero on success, otherwise non-zero is returned. */
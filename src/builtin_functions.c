@@ -19,24 +19,56 @@
 #include "builtin_functions.h"
 
 #include <sys/types.h> /* mode_t */
+#include <pthread.h> /* PTHREAD_MUTEX_INITIALIZER pthread_mutex_t
+                        pthread_mutex_lock() pthread_mutex_unlock() */
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* free() */
+#include <stdlib.h> /* free() malloc() */
 #include <string.h> /* strcmp() strdup() strpbrk() */
+#include <time.h> /* time_t time() */
 
+#include "cfg/config.h"
+#include "compat/fs_limits.h"
 #include "engine/functions.h"
 #include "engine/var.h"
 #include "ui/cancellation.h"
 #include "ui/ui.h"
+#include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/path.h"
+#include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/utils.h"
+#include "background.h"
 #include "filelist.h"
 #include "macros.h"
 #include "types.h"
 
+/* Maximum number of outputs of system() that are remembered. */
+#define SYSTEM_MEMO_SIZE 32
+
+/* Remembered output of a command run by system(). */
+typedef struct
+{
+	char *cmd;                /* Command that was run or NULL for free slot. */
+	char *cwd;                /* Directory in which the command was run. */
+	char *output;             /* Output of the command. */
+	time_t stamp;             /* When the output was obtained. */
+	unsigned long long usage; /* Value of memo_usage on last use. */
+	int refreshing;           /* Whether the output is being updated. */
+}
+system_memo_t;
+
+/* Arguments of background update of output of a command. */
+typedef struct
+{
+	char *cmd;   /* Command to run. */
+	char *cwd;   /* Directory in which the command must be run. */
+	char *shell; /* Shell to run the command with. */
+}
+refresh_args_t;
+
 static var_t executable_builtin(const call_info_t *call_info);
 static var_t expand_builtin(const call_info_t *call_info);
 static var_t filetype_builtin(const call_info_t *call_info);
@@ -46,9 +78,18 @@ static var_t has_builtin(const call_info_t *call_info);
 static var_t layoutis_builtin(const call_info_t *call_info);
 static var_t paneisat_builtin(const call_info_t *call_info);
 static var_t system_builtin(const call_info_t *call_info);
+static char * memoized_system(const char cmd[], int ttl, int async);
+static system_memo_t * find_memo(const char cmd[], const char cwd[]);
+static void memoize_output(const char cmd[], const char cwd[],
+		const char output[]);
+static int start_refresh(const char cmd[], const char cwd[]);
+static void refresh_task(bg_op_t *bg_op, void *arg);
+static char * run_cmd(const char cmd[], const char shell[], const char cwd[],
+		int interactive);
+static void free_memo(system_memo_t *memo);
 
 static const function_t functions[] = {
-	/* Name        Argc  Handler  */
+	/* Name        Argc  Handler                Optional */
 	{ "executable",  1, &executable_builtin },
 	{ "expand",      1, &expand_builtin },
 	{ "filetype",    1, &filetype_builtin },
@@ -56,9 +97,18 @@ static const function_t functions[] = {
 	{ "has",         1, &has_builtin },
 	{ "layoutis",    1, &layoutis_builtin },
 	{ "paneisat",    1, &paneisat_builtin },
-	{ "system",      1, &system_builtin },
+	{ "system",      1, &system_builtin,        2 },
 };
 
+/* Remembered outputs of system(), accessed by background refreshes as well. */
+static system_memo_t system_memo[SYSTEM_MEMO_SIZE];
+
+/* Counter of uses of system_memo, used to find least recently used item. */
+static unsigned long long memo_usage;
+
+/* Protects system_memo and memo_usage. */
+static pthread_mutex_t memo_lock = PTHREAD_MUTEX_INITIALIZER;
+
 void
 init_builtin_functions(void)
 {
@@ -69,6 +119,13 @@ init_builtin_functions(void)
 		assert(result == 0 && "Builtin function registration error");
 		(void)result;
 	}
+
+	pthread_mutex_lock(&memo_lock);
+	for(i = 0; i < ARRAY_LEN(system_memo); ++i)
+	{
+		free_memo(&system_memo[i]);
+	}
+	pthread_mutex_unlock(&memo_lock);
 }
 
 /* Checks whether executable exists at absolute path orin directories listed in
@@ -265,41 +322,270 @@ paneisat_builtin(const call_info_t *call_info)
 
 /* Runs the command in shell and returns its output (joined standard output and
  * standard error streams).  All trailing newline characters are stripped to
- * allow easy appending to command output.  Returns the output. */
+ * allow easy appending to command output.  Optional second argument specifies
+ * for how many seconds output is reused for the same command run in the same
+ * directory.  Non-zero third argument makes expired output to be returned while
+ * it's updated in background.  Returns the output. */
 static var_t
 system_builtin(const call_info_t *call_info)
 {
 	var_t result;
 	char *cmd;
-	FILE *cmd_stream;
-	size_t cmd_out_len;
 	var_val_t var_val;
 
 	cmd = var_to_string(call_info->argv[0]);
-	cmd_stream = read_cmd_output(cmd);
+	if(call_info->argc == 1)
+	{
+		var_val.string = run_cmd(cmd, cfg.shell, NULL, 1);
+	}
+	else
+	{
+		const int ttl = var_to_integer(call_info->argv[1]);
+		const int async = (call_info->argc > 2)
+		                ? var_to_boolean(call_info->argv[2])
+		                : 0;
+		var_val.string = memoized_system(cmd, ttl, async);
+	}
 	free(cmd);
 
-	ui_cancellation_enable();
-	var_val.string = read_nonseekable_stream(cmd_stream, &cmd_out_len);
-	ui_cancellation_disable();
-	fclose(cmd_stream);
-
 	if(var_val.string == NULL)
 	{
 		var_val.string = "";
 		return var_new(VTYPE_STRING, var_val);
 	}
 
+	result = var_new(VTYPE_STRING, var_val);
+	free(var_val.string);
+	return result;
+}
+
+/* Retrieves output of the command reusing output of its previous run in
+ * current directory if it's not older than ttl seconds.  When async is set,
+ * expired output is still reused, but is updated in background.  Returns newly
+ * allocated string or NULL on error. */
+static char *
+memoized_system(const char cmd[], int ttl, int async)
+{
+	char cwd[PATH_MAX];
+	system_memo_t *memo;
+	char *output;
+
+	if(get_cwd(cwd, sizeof(cwd)) == NULL)
+	{
+		return run_cmd(cmd, cfg.shell, NULL, 1);
+	}
+
+	pthread_mutex_lock(&memo_lock);
+	memo = find_memo(cmd, cwd);
+	if(memo != NULL)
+	{
+		const int expired = (time(NULL) - memo->stamp >= ttl);
+
+		memo->usage = ++memo_usage;
+		if(!expired || async)
+		{
+			output = strdup(memo->output);
+			if(expired && !memo->refreshing)
+			{
+				memo->refreshing = (start_refresh(cmd, cwd) == 0);
+			}
+			pthread_mutex_unlock(&memo_lock);
+			return output;
+		}
+	}
+	pthread_mutex_unlock(&memo_lock);
+
+	output = run_cmd(cmd, cfg.shell, NULL, 1);
+	if(output != NULL)
+	{
+		memoize_output(cmd, cwd, output);
+	}
+	return output;
+}
+
+/* Looks up remembered output of the command run in the directory.  Must be
+ * called with memo_lock held.  Returns the memo or NULL if there is none. */
+static system_memo_t *
+find_memo(const char cmd[], const char cwd[])
+{
+	size_t i;
+	for(i = 0U; i < ARRAY_LEN(system_memo); ++i)
+	{
+		system_memo_t *const memo = &system_memo[i];
+		if(memo->cmd != NULL && strcmp(memo->cmd, cmd) == 0 &&
+				strcmp(memo->cwd, cwd) == 0)
+		{
+			return memo;
+		}
+	}
+	return NULL;
+}
+
+/* Remembers output of the command run in the directory replacing least recently
+ * used output if there is no more space. */
+static void
+memoize_output(const char cmd[], const char cwd[], const char output[])
+{
+	system_memo_t *memo;
+	char *const output_copy = strdup(output);
+	if(output_copy == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&memo_lock);
+
+	memo = find_memo(cmd, cwd);
+	if(memo == NULL)
+	{
+		size_t i;
+		memo = &system_memo[0];
+		for(i = 1U; i < ARRAY_LEN(system_memo) && memo->cmd != NULL; ++i)
+		{
+			if(system_memo[i].cmd == NULL || system_memo[i].usage < memo->usage)
+			{
+				memo = &system_memo[i];
+			}
+		}
+
+		free_memo(memo);
+		memo->cmd = strdup(cmd);
+		memo->cwd = strdup(cwd);
+		if(memo->cmd == NULL || memo->cwd == NULL)
+		{
+			free_memo(memo);
+			pthread_mutex_unlock(&memo_lock);
+			free(output_copy);
+			return;
+		}
+	}
+
+	free(memo->output);
+	memo->output = output_copy;
+	memo->stamp = time(NULL);
+	memo->usage = ++memo_usage;
+
+	pthread_mutex_unlock(&memo_lock);
+}
+
+/* Starts updating output of the command in background.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+start_refresh(const char cmd[], const char cwd[])
+{
+	char *task_desc;
+	refresh_args_t *const args = malloc(sizeof(*args));
+	if(args == NULL)
+	{
+		return 1;
+	}
+
+	/* Everything the task needs is captured here, because the task must not
+	 * depend on current directory or settings, which can change meanwhile. */
+	args->cmd = strdup(cmd);
+	args->cwd = strdup(cwd);
+	args->shell = strdup(cfg.shell);
+	task_desc = format_str("Updating system() output: %s", cmd);
+	if(args->cmd == NULL || args->cwd == NULL || args->shell == NULL ||
+			task_desc == NULL ||
+			bg_execute(task_desc, cmd, BG_UNDEFINED_TOTAL, 0, &refresh_task,
+				args) != 0)
+	{
+		free(task_desc);
+		free(args->cmd);
+		free(args->cwd);
+		free(args->shell);
+		free(args);
+		return 1;
+	}
+	free(task_desc);
+	return 0;
+}
+
+/* Entry point of background update of output of a command. */
+static void
+refresh_task(bg_op_t *bg_op, void *arg)
+{
+	refresh_args_t *const args = arg;
+	char *output = run_cmd(args->cmd, args->shell, args->cwd, 0);
+	system_memo_t *memo;
+
+	pthread_mutex_lock(&memo_lock);
+	memo = find_memo(args->cmd, args->cwd);
+	if(memo != NULL)
+	{
+		if(output != NULL)
+		{
+			free(memo->output);
+			memo->output = output;
+			memo->stamp = time(NULL);
+			output = NULL;
+		}
+		memo->refreshing = 0;
+	}
+	pthread_mutex_unlock(&memo_lock);
+
+	free(output);
+	free(args->cmd);
+	free(args->cwd);
+	free(args->shell);
+	free(args);
+}
+
+/* Runs the command via the shell in cwd directory (current one if it's NULL)
+ * and collects its output with trailing newlines removed.
+ * Running command can be cancelled by the user if interactive is non-zero.
+ * Returns newly allocated string or NULL on error. */
+static char *
+run_cmd(const char cmd[], const char shell[], const char cwd[],
+		int interactive)
+{
+	char *output;
+	size_t len;
+
+	FILE *const cmd_stream = read_cmd_output_at(cmd, shell, cwd);
+	if(cmd_stream == NULL)
+	{
+		return NULL;
+	}
+
+	if(interactive)
+	{
+		ui_cancellation_enable();
+	}
+	output = read_nonseekable_stream(cmd_stream, &len);
+	if(interactive)
+	{
+		ui_cancellation_disable();
+	}
+	fclose(cmd_stream);
+
+	if(output == NULL)
+	{
+		return NULL;
+	}
+
 	/* Remove trailing new line characters. */
-	while(cmd_out_len != 0U && var_val.string[cmd_out_len - 1] == '\n')
+	while(len != 0U && output[len - 1] == '\n')
 	{
-		var_val.string[cmd_out_len - 1] = '\0';
-		--cmd_out_len;
+		output[--len] = '\0';
 	}
 
-	result = var_new(VTYPE_STRING, var_val);
-	free(var_val.string);
-	return result;
+	return output;
+}
+
+/* Frees fields of the memo and marks it as a free slot.  Must be called with
+ * memo_lock held. */
+static void
+free_memo(system_memo_t *memo)
+{
+	free(memo->cmd);
+	free(memo->cwd);
+	free(memo->output);
+	memo->cmd = NULL;
+	memo->cwd = NULL;
+	memo->output = NULL;
+	memo->refreshing = 0;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -37,11 +37,10 @@
 #include <stddef.h> /* size_t */
 #include <stdio.h> /* FILE snprintf() */
 #include <stdlib.h> /* free() */
-#include <string.h> /* memmove() memset() strdup() */
+#include <string.h> /* memset() strdup() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
-#include "../compat/reallocarray.h"
 #include "../int/term_title.h"
 #include "../io/iop.h"
 #include "../modes/dialogs/msg_dialog.h"
@@ -53,6 +52,7 @@
 #include "../utils/macros.h"
 #include "../utils/str.h"
 #include "../utils/path.h"
+#include "../utils/profiler.h"
 #include "../utils/utils.h"
 #include "../cmd_core.h"
 #include "../filelist.h"
@@ -103,11 +103,7 @@ static void add_default_marks(void);
 static int source_file_internal(FILE *fp, const char filename[]);
 static void show_sourcing_error(const char filename[], int line_num);
 static void disable_history(void);
-static void free_view_history(FileView *view);
-static void decrease_history(size_t new_len, size_t removed_count);
-static void reduce_view_history(FileView *view, int size);
 static void reallocate_history(size_t new_len);
-static void zero_new_history_items(size_t old_len, size_t delta);
 static void save_into_history(const char item[], hist_t *hist, int len);
 
 void
@@ -686,6 +682,7 @@ cfg_source_file(const char filename[])
 
 	FILE *fp;
 	int result;
+	int prof_id;
 	SourcingState sourcing_state;
 
 	if((fp = os_fopen(filename, "r")) == NULL)
@@ -693,6 +690,8 @@ cfg_source_file(const char filename[])
 		return 1;
 	}
 
+	prof_id = prof_enter("source", filename);
+
 	sourcing_state = curr_stats.sourcing_state;
 	curr_stats.sourcing_state = SOURCING_PROCESSING;
 
@@ -701,6 +700,7 @@ cfg_source_file(const char filename[])
 	curr_stats.sourcing_state = sourcing_state;
 
 	fclose(fp);
+	prof_leave(prof_id);
 	return result;
 }
 
@@ -807,7 +807,6 @@ void
 cfg_resize_histories(int new_len)
 {
 	const int old_len = MAX(cfg.history_len, 0);
-	const int delta = new_len - old_len;
 
 	if(new_len <= 0)
 	{
@@ -815,18 +814,8 @@ cfg_resize_histories(int new_len)
 		return;
 	}
 
-	if(delta < 0)
-	{
-		decrease_history(new_len, -delta);
-	}
-
 	reallocate_history(new_len);
 
-	if(delta > 0)
-	{
-		zero_new_history_items(old_len, delta);
-	}
-
 	cfg.history_len = new_len;
 
 	if(old_len == 0)
@@ -840,98 +829,29 @@ cfg_resize_histories(int new_len)
 static void
 disable_history(void)
 {
-	free_view_history(&lwin);
-	free_view_history(&rwin);
+	flist_hist_resize(&lwin, 0);
+	flist_hist_resize(&rwin, 0);
 
-	(void)hist_reset(&cfg.search_hist, cfg.history_len);
-	(void)hist_reset(&cfg.cmd_hist, cfg.history_len);
-	(void)hist_reset(&cfg.prompt_hist, cfg.history_len);
-	(void)hist_reset(&cfg.filter_hist, cfg.history_len);
+	hist_reset(&cfg.search_hist);
+	hist_reset(&cfg.cmd_hist);
+	hist_reset(&cfg.prompt_hist);
+	hist_reset(&cfg.filter_hist);
 
 	cfg.history_len = 0;
 }
 
-/* Clears and frees directory history of the view. */
-static void
-free_view_history(FileView *view)
-{
-	cfg_free_history_items(view->history, view->history_num);
-	free(view->history);
-	view->history = NULL;
-
-	view->history_num = 0;
-	view->history_pos = 0;
-}
-
-/* Reduces amount of memory taken by the history.  The new_len specifies new
- * size of the history, while removed_count parameter designates number of
- * removed elements. */
-static void
-decrease_history(size_t new_len, size_t removed_count)
-{
-	reduce_view_history(&lwin, (int)new_len);
-	reduce_view_history(&rwin, (int)new_len);
-
-	hist_trunc(&cfg.search_hist, new_len, removed_count);
-	hist_trunc(&cfg.cmd_hist, new_len, removed_count);
-	hist_trunc(&cfg.prompt_hist, new_len, removed_count);
-	hist_trunc(&cfg.filter_hist, new_len, removed_count);
-}
-
-/* Moves items of directory history when size of history becomes smaller. */
-static void
-reduce_view_history(FileView *view, int size)
-{
-	const int delta = MIN(view->history_num - size, view->history_pos);
-	if(delta <= 0)
-	{
-		return;
-	}
-
-	cfg_free_history_items(view->history, MIN(size, delta));
-	memmove(view->history, view->history + delta,
-			sizeof(history_t)*(view->history_num - delta));
-
-	if(view->history_num >= size)
-	{
-		view->history_num = size - 1;
-	}
-	view->history_pos -= delta;
-}
-
 /* Reallocates memory taken by history elements.  The new_len specifies new
  * size of the history. */
 static void
 reallocate_history(size_t new_len)
 {
-	lwin.history = reallocarray(lwin.history, new_len, sizeof(history_t));
-	rwin.history = reallocarray(rwin.history, new_len, sizeof(history_t));
-
-	cfg.cmd_hist.items = reallocarray(cfg.cmd_hist.items, new_len,
-			sizeof(char *));
-	cfg.search_hist.items = reallocarray(cfg.search_hist.items, new_len,
-			sizeof(char *));
-	cfg.prompt_hist.items = reallocarray(cfg.prompt_hist.items, new_len,
-			sizeof(char *));
-	cfg.filter_hist.items = reallocarray(cfg.filter_hist.items, new_len,
-			sizeof(char *));
-}
-
-/* Zeroes new elements of the history.  The old_len specifies old history size,
- * while delta parameter designates number of new elements. */
-static void
-zero_new_history_items(size_t old_len, size_t delta)
-{
-	const size_t hist_item_len = sizeof(history_t)*delta;
-	const size_t str_item_len = sizeof(char *)*delta;
-
-	memset(lwin.history + old_len, 0, hist_item_len);
-	memset(rwin.history + old_len, 0, hist_item_len);
+	flist_hist_resize(&lwin, new_len);
+	flist_hist_resize(&rwin, new_len);
 
-	memset(cfg.cmd_hist.items + old_len, 0, str_item_len);
-	memset(cfg.search_hist.items + old_len, 0, str_item_len);
-	memset(cfg.prompt_hist.items + old_len, 0, str_item_len);
-	memset(cfg.filter_hist.items + old_len, 0, str_item_len);
+	(void)hist_resize(&cfg.cmd_hist, new_len);
+	(void)hist_resize(&cfg.search_hist, new_len);
+	(void)hist_resize(&cfg.prompt_hist, new_len);
+	(void)hist_resize(&cfg.filter_hist, new_len);
 }
 
 int
@@ -1008,14 +928,14 @@ save_into_history(const char item[], hist_t *hist, int len)
 {
 	if(len >= 0)
 	{
-		hist_add(hist, item, len);
+		(void)hist_add(hist, item);
 	}
 }
 
 const char *
 cfg_get_last_search_pattern(void)
 {
-	return hist_is_empty(&cfg.search_hist) ? "" : cfg.search_hist.items[0];
+	return hist_is_empty(&cfg.search_hist) ? "" : hist_get(&cfg.search_hist, 0);
 }
 
 void
@@ -20,43 +20,107 @@
 
 #include <stddef.h> /* NULL size_t */
 #include <stdlib.h> /* calloc() free() */
-#include <string.h> /* memmove() */
+#include <string.h> /* memset() strcmp() strdup() */
 
 #include "../utils/macros.h"
-#include "../utils/string_array.h"
 
 #define NO_POS (-1)
 
+/* Minimal number of slots in the index. */
+#define MIN_INDEX_SIZE 16U
+
 static int move_to_first_position(hist_t *hist, const char item[]);
-static int insert_at_first_position(hist_t *hist, size_t size, const char item[]);
+static int insert_at_first_position(hist_t *hist, const char item[]);
+static int get_count(const hist_t *hist);
+static int ring_pos(const hist_t *hist, int i);
+static int index_reserve(hist_t *hist, size_t count);
+static void index_refill(hist_t *hist);
+static void index_remove(hist_t *hist, const char item[]);
+static char ** find_slot(const hist_t *hist, const char item[]);
+static size_t hash_str(const char str[]);
 
 int
 hist_init(hist_t *hist, size_t size)
 {
+	memset(hist, 0, sizeof(*hist));
 	hist->pos = NO_POS;
-	hist->items = calloc(size, sizeof(char *));
-	return hist->items == NULL;
+	return hist_resize(hist, size);
 }
 
 void
-hist_reset(hist_t *hist, size_t size)
+hist_reset(hist_t *hist)
 {
-	free_string_array(hist->items, size);
-	hist->items = NULL;
+	const int count = get_count(hist);
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		free(hist->ring[ring_pos(hist, i)]);
+	}
+	free(hist->ring);
+	free(hist->index);
+
+	memset(hist, 0, sizeof(*hist));
 	hist->pos = NO_POS;
 }
 
 int
 hist_is_empty(const hist_t *hist)
 {
-	return hist->pos == NO_POS;
+	return get_count(hist) == 0;
 }
 
-void
-hist_trunc(hist_t *hist, size_t new_size, size_t removed_count)
+int
+hist_resize(hist_t *hist, size_t new_size)
+{
+	char **ring;
+	const int old_count = get_count(hist);
+	int count;
+	int i;
+
+	if(new_size == 0U)
+	{
+		hist_reset(hist);
+		return 0;
+	}
+
+	ring = calloc(new_size, sizeof(*ring));
+	if(ring == NULL)
+	{
+		return 1;
+	}
+
+	count = MIN(old_count, (int)new_size);
+	for(i = 0; i < old_count; ++i)
+	{
+		char *const item = hist->ring[ring_pos(hist, i)];
+		if(i < count)
+		{
+			ring[i] = item;
+		}
+		else
+		{
+			free(item);
+		}
+	}
+
+	free(hist->ring);
+	hist->ring = ring;
+	hist->head = 0;
+	hist->size = new_size;
+
+	hist->pos = (count == 0) ? NO_POS : count - 1;
+
+	if(count < old_count)
+	{
+		index_refill(hist);
+	}
+	return 0;
+}
+
+const char *
+hist_get(const hist_t *hist, int i)
 {
-	free_strings(hist->items + new_size, removed_count);
-	hist->pos = MIN(hist->pos, (int)new_size - 1);
+	return hist->ring[ring_pos(hist, i)];
 }
 
 int
@@ -66,17 +130,17 @@ hist_contains(const hist_t *hist, const char item[])
 	{
 		return 0;
 	}
-	return is_in_string_array(hist->items, hist->pos + 1, item);
+	return *find_slot(hist, item) != NULL;
 }
 
 int
-hist_add(hist_t *hist, const char item[], size_t size)
+hist_add(hist_t *hist, const char item[])
 {
-	if(size > 0 && item[0] != '\0')
+	if(hist->size > 0 && item[0] != '\0')
 	{
 		if(move_to_first_position(hist, item) != 0)
 		{
-			return insert_at_first_position(hist, size, item);
+			return insert_at_first_position(hist, item);
 		}
 	}
 	return 0;
@@ -87,43 +151,184 @@ hist_add(hist_t *hist, const char item[], size_t size)
 static int
 move_to_first_position(hist_t *hist, const char item[])
 {
-	const int pos = string_array_pos(hist->items, hist->pos + 1, item);
-	if(pos == 0)
+	char *found;
+	char *carry;
+	int i;
+
+	if(hist_is_empty(hist) || (found = *find_slot(hist, item)) == NULL)
 	{
-		return 0;
+		return 1;
 	}
-	else if(pos > 0)
+
+	/* Shift items that precede the found one by one position. */
+	carry = found;
+	for(i = 0; carry != NULL; ++i)
 	{
-		char *const item = hist->items[pos];
-		memmove(hist->items + 1, hist->items, sizeof(char *)*pos);
-		hist->items[0] = item;
-		return 0;
+		char **const cell = &hist->ring[ring_pos(hist, i)];
+		char *const next = *cell;
+		*cell = carry;
+		carry = (next == found) ? NULL : next;
 	}
-	return 1;
+	return 0;
 }
 
-/* Inserts item at the first position.  Returns zero on success or non-zero on
- * failure. */
+/* Inserts item at the first position dropping the last item if the history is
+ * full.  Returns zero on success or non-zero on failure. */
 static int
-insert_at_first_position(hist_t *hist, size_t size, const char item[])
+insert_at_first_position(hist_t *hist, const char item[])
 {
 	char *const item_copy = strdup(item);
-	if(item_copy == NULL)
+	if(item_copy == NULL || index_reserve(hist, hist->pos + 2) != 0)
 	{
+		free(item_copy);
 		return 1;
 	}
 
-	hist->pos = MIN(hist->pos + 1, (int)size - 1);
-	if(hist->pos > 0)
+	/* In a full ring the last item occupies slot that precedes the first one. */
+	hist->head = (hist->head + hist->size - 1)%hist->size;
+	if(hist->pos + 1 == hist->size)
+	{
+		index_remove(hist, hist->ring[hist->head]);
+		free(hist->ring[hist->head]);
+	}
+	else
+	{
+		++hist->pos;
+	}
+
+	hist->ring[hist->head] = item_copy;
+	*find_slot(hist, item_copy) = item_copy;
+	return 0;
+}
+
+/* Computes number of items in the history.  Returns the number. */
+static int
+get_count(const hist_t *hist)
+{
+	return (hist->size == 0) ? 0 : hist->pos + 1;
+}
+
+/* Maps position of history item to its index in the ring.  Returns the
+ * index. */
+static int
+ring_pos(const hist_t *hist, int i)
+{
+	return (hist->head + i)%hist->size;
+}
+
+/* Makes sure that index has enough free slots for count items keeping them
+ * sparse enough for fast lookups.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+index_reserve(hist_t *hist, size_t count)
+{
+	size_t new_size = (hist->index_size == 0U) ? MIN_INDEX_SIZE
+	                                           : hist->index_size;
+	char **index;
+
+	while(new_size < count*2U)
+	{
+		new_size *= 2U;
+	}
+	if(new_size == hist->index_size)
+	{
+		return 0;
+	}
+
+	index = calloc(new_size, sizeof(*index));
+	if(index == NULL)
 	{
-		free(hist->items[hist->pos]);
-		memmove(hist->items + 1, hist->items, sizeof(char *)*hist->pos);
-		hist->items[0] = NULL;
+		return 1;
 	}
 
-	hist->items[0] = item_copy;
+	free(hist->index);
+	hist->index = index;
+	hist->index_size = new_size;
+	index_refill(hist);
 	return 0;
 }
 
+/* Fills index with all items of the history discarding its previous
+ * contents. */
+static void
+index_refill(hist_t *hist)
+{
+	int i;
+
+	if(hist->index == NULL)
+	{
+		return;
+	}
+
+	memset(hist->index, 0, sizeof(*hist->index)*hist->index_size);
+	for(i = 0; i <= hist->pos; ++i)
+	{
+		char *const item = hist->ring[ring_pos(hist, i)];
+		*find_slot(hist, item) = item;
+	}
+}
+
+/* Removes item from the index, if it's there, moving items that follow it
+ * closer to their preferred slots so that they remain reachable. */
+static void
+index_remove(hist_t *hist, const char item[])
+{
+	const size_t mask = hist->index_size - 1U;
+	char **const slot = find_slot(hist, item);
+	size_t hole = slot - hist->index;
+	size_t i = hole;
+
+	if(*slot == NULL)
+	{
+		return;
+	}
+
+	while(1)
+	{
+		size_t home;
+
+		i = (i + 1U) & mask;
+		if(hist->index[i] == NULL)
+		{
+			break;
+		}
+
+		/* Item can fill the hole only if the hole lies on its probing path. */
+		home = hash_str(hist->index[i]) & mask;
+		if(((i - home) & mask) >= ((i - hole) & mask))
+		{
+			hist->index[hole] = hist->index[i];
+			hole = i;
+		}
+	}
+	hist->index[hole] = NULL;
+}
+
+/* Looks up item in the index, which must not be empty.  Returns pointer to the
+ * slot that holds the item or to empty slot where it should be put. */
+static char **
+find_slot(const hist_t *hist, const char item[])
+{
+	const size_t mask = hist->index_size - 1U;
+	size_t i = hash_str(item) & mask;
+	while(hist->index[i] != NULL && strcmp(hist->index[i], item) != 0)
+	{
+		i = (i + 1U) & mask;
+	}
+	return &hist->index[i];
+}
+
+/* Computes FNV-1a hash of the string.  Returns the hash. */
+static size_t
+hash_str(const char str[])
+{
+	size_t hash = 2166136261U;
+	while(*str != '\0')
+	{
+		hash = (hash ^ (unsigned char)*str++)*16777619U;
+	}
+	return hash;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
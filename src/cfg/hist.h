@@ -21,14 +21,27 @@
 
 #include <stddef.h> /* size_t */
 
-/* History object structure.  Doesn't store its length. */
+/* History object structure.  Items are kept in a ring buffer, which allows
+ * adding new items without moving all of the old ones, and are indexed by a
+ * hash table to find duplicates without comparing strings. */
 typedef struct
 {
-	/* List of history items.  Can be NULL for empty list. */
-	char **items;
-	/* Position of the last item in the items list.  Undefined (likely to be
+	/* Ring buffer of history items of size length.  Can be NULL for empty
+	 * list. */
+	char **ring;
+	/* Index of the first (most recent) item in the ring. */
+	int head;
+	/* Position of the last item in the list of items.  Undefined (likely to be
 	 * negative) for empty lists. */
 	int pos;
+	/* Capacity of the history. */
+	int size;
+
+	/* Open addressing hash table of pointers to items of the ring.  Can be NULL
+	 * for empty list. */
+	char **index;
+	/* Number of slots in the index, which is zero or a power of two. */
+	size_t index_size;
 }
 hist_t;
 
@@ -36,27 +49,31 @@ hist_t;
  * otherwise non-zero is returned. */
 int hist_init(hist_t *hist, size_t size);
 
-/* Resets content of the history of given size and empties it.  All associated
- * resources are freed. */
-void hist_reset(hist_t *hist, size_t size);
+/* Empties the history and frees all associated resources.  Size of the history
+ * becomes zero. */
+void hist_reset(hist_t *hist);
 
 /* Checks whether history is empty.  Returns non-zero for empty history,
- * otherwise non-zero is returned. */
+ * otherwise zero is returned. */
 int hist_is_empty(const hist_t *hist);
 
-/* Reduces amount of memory taken by the history.  The new_size specifies new
- * size of the history, while removed_count parameter designates number of
- * removed elements. */
-void hist_trunc(hist_t *hist, size_t new_size, size_t removed_count);
+/* Changes size of the history dropping the oldest items that don't fit.
+ * Returns zero on success, otherwise non-zero is returned and the history is
+ * left unchanged. */
+int hist_resize(hist_t *hist, size_t new_size);
+
+/* Retrieves item of the history by its position, which should be in the
+ * [0; pos] range.  The first item is the most recent one.  Returns the item. */
+const char * hist_get(const hist_t *hist, int i);
 
 /* Checks whether given item present in the history.  Returns non-zero if
- * present, otherwise non-zero is returned. */
+ * present, otherwise zero is returned. */
 int hist_contains(const hist_t *hist, const char item[]);
 
 /* Adds new item to the front of the history, thus it becomes its first
  * element.  If item already present in history list, it's moved.  Returns zero
  * when item is added/moved or rejected, on failure non-zero is returned. */
-int hist_add(hist_t *hist, const char item[], size_t size);
+int hist_add(hist_t *hist, const char item[]);
 
 #endif /* VIFM__CFG__HISTORY_H__ */
 
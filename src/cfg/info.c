@@ -23,7 +23,7 @@
 #include <ctype.h> /* isdigit() */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* fgets() fprintf() fputc() fscanf() snprintf() */
-#include <stdlib.h> /* abs() free() */
+#include <stdlib.h> /* abs() free() malloc() */
 #include <string.h> /* memcpy() memset() strtol() strcmp() strchr() strlen() */
 
 #include "../compat/fs_limits.h"
@@ -42,6 +42,7 @@
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "../bmarks.h"
 #include "../cmd_core.h"
@@ -57,6 +58,23 @@
 #include "hist.h"
 #include "info_chars.h"
 
+/* Sets of entries of current state, which allow merging entries of vifminfo
+ * without searching for each of them in corresponding lists. */
+typedef struct
+{
+	int valid; /* Whether sets were successfully built. */
+
+	trie_t filetypes;   /* Keys are "pattern\ncommand" of file types. */
+	trie_t xfiletypes;  /* Keys are "pattern\ncommand" of X file types. */
+	trie_t fileviewers; /* Keys are "pattern\ncommand" of file viewers. */
+	trie_t cmds;        /* Names of user-defined commands. */
+	trie_t lwin_hist;   /* Directories of history of the left view. */
+	trie_t rwin_hist;   /* Directories of history of the right view. */
+	trie_t bmarks;      /* Paths of bookmarks with their timestamps as data. */
+	trie_t trash;       /* Names of files in trash. */
+}
+merge_index_t;
+
 static void get_sort_info(FileView *view, const char line[]);
 static void append_to_history(hist_t *hist, void (*saver)(const char[]),
 		const char item[]);
@@ -64,11 +82,28 @@ static void ensure_history_not_full(hist_t *hist);
 static void get_history(FileView *view, int reread, const char *dir,
 		const char *file, int pos);
 static void set_view_property(FileView *view, char type, const char value[]);
-static int copy_file(const char src[], const char dst[]);
-static int copy_file_internal(FILE *const src, FILE *const dst);
-static void update_info_file(const char filename[]);
-static void process_hist_entry(FileView *view, const char dir[],
-		const char file[], int pos, char ***lh, int *nlh, int **lhp, size_t *nlhp);
+static int update_info_file(const char src[], const char dst[]);
+static void process_hist_entry(FileView *view, const merge_index_t *idx,
+		trie_t dirs, const char dir[], const char file[], int pos, char ***lh,
+		int *nlh, int **lhp, size_t *nlhp);
+static void build_merge_index(merge_index_t *idx, char *cmds_list[],
+		int ncmds_list);
+static void free_merge_index(merge_index_t *idx);
+static int index_assocs(trie_t set, const assoc_list_t *assocs);
+static int index_view_hist(trie_t set, const FileView *view);
+static void index_bmark(const char path[], const char tags[], time_t timestamp,
+		void *arg);
+static int index_trash(trie_t set);
+static int assoc_is_known(const merge_index_t *idx, trie_t set,
+		const assoc_list_t *assocs, const char pattern[], const char cmd[]);
+static char * make_assoc_key(const char pattern[], const char cmd[]);
+static int cmd_is_known(const merge_index_t *idx, char *cmds_list[],
+		int ncmds_list, const char name[]);
+static int bmark_is_newer(const merge_index_t *idx, const char path[],
+		time_t timestamp);
+static int trash_is_known(const merge_index_t *idx, const char trash_name[]);
+static int put_path(trie_t set, const char path[], const void *data);
+static int get_path(trie_t set, const char path[], void **data);
 static char * convert_old_trash_path(const char trash_path[]);
 static void write_options(FILE *const fp);
 static void write_assocs(FILE *fp, const char str[], char mark,
@@ -262,7 +297,7 @@ read_info_file(int reread)
 				if(!reread && view->history_num > 0)
 				{
 					copy_str(view->curr_dir, sizeof(view->curr_dir),
-							view->history[view->history_pos].dir);
+							flist_hist_get(view, view->history_pos)->dir);
 				}
 			}
 			else if((line2 = read_vifminfo_line(fp, line2)) != NULL)
@@ -469,73 +504,24 @@ write_info_file(void)
 	(void)snprintf(info_file, sizeof(info_file), "%s/vifminfo", cfg.config_dir);
 	(void)snprintf(tmp_file, sizeof(tmp_file), "%s_%u", info_file, get_pid());
 
-	if(os_access(info_file, R_OK) != 0 || copy_file(info_file, tmp_file) == 0)
-	{
-		update_info_file(tmp_file);
-
-		if(rename_file(tmp_file, info_file) != 0)
-		{
-			LOG_ERROR_MSG("Can't replace vifminfo file with its temporary copy");
-			(void)remove(tmp_file);
-		}
-	}
-}
-
-/* Copies the src file to the dst location.  Returns zero on success. */
-static int
-copy_file(const char src[], const char dst[])
-{
-	FILE *const src_fp = os_fopen(src, "rb");
-	FILE *const dst_fp = os_fopen(dst, "wb");
-	int result;
-
-	result = copy_file_internal(src_fp, dst_fp);
-
-	if(dst_fp != NULL)
-	{
-		(void)fclose(dst_fp);
-	}
-	if(src_fp != NULL)
+	if(update_info_file(info_file, tmp_file) != 0)
 	{
-		(void)fclose(src_fp);
+		(void)remove(tmp_file);
+		return;
 	}
 
-	if(result != 0)
+	if(rename_file(tmp_file, info_file) != 0)
 	{
-		(void)remove(dst);
+		LOG_ERROR_MSG("Can't replace vifminfo file with its temporary copy");
+		(void)remove(tmp_file);
 	}
-
-	return result;
 }
 
-/* Internal sub-function of the copy_file() function.  Returns zero on
- * success. */
+/* Merges contents of the src file as an info file with the state of current
+ * instance and writes result to the dst file.  Returns zero if dst file was
+ * written, otherwise non-zero is returned. */
 static int
-copy_file_internal(FILE *const src, FILE *const dst)
-{
-	char buffer[4*1024];
-	size_t nread;
-
-	if(src == NULL || dst == NULL)
-	{
-		return 1;
-	}
-
-	while((nread = fread(&buffer[0], 1, sizeof(buffer), src)))
-	{
-		if(fwrite(&buffer[0], 1, nread, dst) != nread)
-		{
-			break;
-		}
-	}
-
-	return nread > 0;
-}
-
-/* Reads contents of the filename file as an info file and updates it with the
- * state of current instance. */
-static void
-update_info_file(const char filename[])
+update_info_file(const char src[], const char dst[])
 {
 	/* TODO: refactor this function update_info_file() */
 
@@ -553,16 +539,28 @@ update_info_file(const char filename[])
 	char **dir_stack = NULL;
 	int ndir_stack = 0;
 	char *non_conflicting_marks;
+	merge_index_t idx;
+	int result = 1;
 
 	if(cfg.vifm_info == 0)
-		return;
+		return 1;
+
+	fp = os_fopen(src, "r");
+	/* Don't overwrite state that can't be merged in. */
+	if(fp == NULL && os_access(src, F_OK) == 0)
+	{
+		LOG_ERROR_MSG("Can't read vifminfo file: %s", src);
+		return 1;
+	}
 
 	cmds_list = list_udf();
 	while(cmds_list[++ncmds_list] != NULL);
 
 	non_conflicting_marks = strdup(valid_marks);
 
-	if((fp = os_fopen(filename, "r")) != NULL)
+	build_merge_index(&idx, cmds_list, ncmds_list);
+
+	if(fp != NULL)
 	{
 		size_t nlhp = 0UL, nrhp = 0UL, nbt = 0UL, nbmt = 0UL;
 		char *line = NULL, *line2 = NULL, *line3 = NULL, *line4 = NULL;
@@ -578,7 +576,8 @@ update_info_file(const char filename[])
 			{
 				if((line2 = read_vifminfo_line(fp, line2)) != NULL)
 				{
-					if(!ft_assoc_exists(&filetypes, line_val, line2))
+					if(!assoc_is_known(&idx, idx.filetypes, &filetypes, line_val,
+								line2))
 					{
 						nft = add_to_string_array(&ft, nft, 2, line_val, line2);
 					}
@@ -588,7 +587,8 @@ update_info_file(const char filename[])
 			{
 				if((line2 = read_vifminfo_line(fp, line2)) != NULL)
 				{
-					if(!ft_assoc_exists(&xfiletypes, line_val, line2))
+					if(!assoc_is_known(&idx, idx.xfiletypes, &xfiletypes, line_val,
+								line2))
 					{
 						nfx = add_to_string_array(&fx, nfx, 2, line_val, line2);
 					}
@@ -598,7 +598,8 @@ update_info_file(const char filename[])
 			{
 				if((line2 = read_vifminfo_line(fp, line2)) != NULL)
 				{
-					if(!ft_assoc_exists(&fileviewers, line_val, line2))
+					if(!assoc_is_known(&idx, idx.fileviewers, &fileviewers, line_val,
+								line2))
 					{
 						nfv = add_to_string_array(&fv, nfv, 2, line_val, line2);
 					}
@@ -610,18 +611,7 @@ update_info_file(const char filename[])
 					continue;
 				if((line2 = read_vifminfo_line(fp, line2)) != NULL)
 				{
-					int i;
-					const char *p = line_val;
-					for(i = 0; i < ncmds_list; i += 2)
-					{
-						int cmp = strcmp(cmds_list[i], p);
-						if(cmp < 0)
-							continue;
-						if(cmp == 0)
-							p = NULL;
-						break;
-					}
-					if(p == NULL)
+					if(cmd_is_known(&idx, cmds_list, ncmds_list, line_val))
 						continue;
 					ncmds = add_to_string_array(&cmds, ncmds, 2, line_val, line2);
 				}
@@ -636,13 +626,13 @@ update_info_file(const char filename[])
 
 					if(type == LINE_TYPE_LWIN_HIST)
 					{
-						process_hist_entry(&lwin, line_val, line2, pos, &lh, &nlh, &lhp,
-								&nlhp);
+						process_hist_entry(&lwin, &idx, idx.lwin_hist, line_val, line2,
+								pos, &lh, &nlh, &lhp, &nlhp);
 					}
 					else
 					{
-						process_hist_entry(&rwin, line_val, line2, pos, &rh, &nrh, &rhp,
-								&nrhp);
+						process_hist_entry(&rwin, &idx, idx.rwin_hist, line_val, line2,
+								pos, &rh, &nrh, &rhp, &nrhp);
 					}
 				}
 			}
@@ -688,7 +678,7 @@ update_info_file(const char filename[])
 					{
 						long timestamp;
 						if(read_number(line3, &timestamp) &&
-								bmark_is_older(line_val, timestamp))
+								bmark_is_newer(&idx, line_val, timestamp))
 						{
 							nbmarks = add_to_string_array(&bmarks, nbmarks, 2, line_val,
 									line2);
@@ -702,7 +692,7 @@ update_info_file(const char filename[])
 				if((line2 = read_vifminfo_line(fp, line2)) != NULL)
 				{
 					char *const trash_name = convert_old_trash_path(line_val);
-					if(exists_in_trash(trash_name) && !is_in_trash(trash_name))
+					if(exists_in_trash(trash_name) && !trash_is_known(&idx, trash_name))
 					{
 						ntrash = add_to_string_array(&trash, ntrash, 2, trash_name, line2);
 					}
@@ -767,7 +757,9 @@ update_info_file(const char filename[])
 		fclose(fp);
 	}
 
-	if((fp = os_fopen(filename, "w")) != NULL)
+	free_merge_index(&idx);
+
+	if((fp = os_fopen(dst, "w")) != NULL)
 	{
 		fprintf(fp, "# You can edit this file by hand, but it's recommended not to "
 				"do that.\n");
@@ -859,7 +851,7 @@ update_info_file(const char filename[])
 			fprintf(fp, "c%s\n", cfg.cs.name);
 		}
 
-		fclose(fp);
+		result = (fclose(fp) != 0);
 	}
 
 	free_string_array(ft, nft);
@@ -883,15 +875,31 @@ update_info_file(const char filename[])
 	free_string_array(bmarks, nbmarks);
 	free_string_array(dir_stack, ndir_stack);
 	free(non_conflicting_marks);
+
+	return result;
 }
 
-/* Handles single directory history entry, possibly skipping merging it in. */
+/* Handles single directory history entry, possibly skipping merging it in.
+ * The dirs set contains directories of the view history. */
 static void
-process_hist_entry(FileView *view, const char dir[], const char file[], int pos,
-		char ***lh, int *nlh, int **lhp, size_t *nlhp)
+process_hist_entry(FileView *view, const merge_index_t *idx, trie_t dirs,
+		const char dir[], const char file[], int pos, char ***lh, int *nlh,
+		int **lhp, size_t *nlhp)
 {
-	if(view->history_pos + *nlh/2 == cfg.history_len - 1 ||
-			is_in_view_history(view, dir) || !is_dir(dir))
+	void *data;
+
+	if(view->history_pos + *nlh/2 == cfg.history_len - 1)
+	{
+		return;
+	}
+
+	if(idx->valid ? get_path(dirs, dir, &data) == 0
+	              : is_in_view_history(view, dir))
+	{
+		return;
+	}
+
+	if(!is_dir(dir))
 	{
 		return;
 	}
@@ -904,6 +912,307 @@ process_hist_entry(FileView *view, const char dir[], const char file[], int pos,
 	}
 }
 
+/* Fills sets of the index with entries of current state.  On failure index is
+ * marked as invalid and entries have to be looked up in their lists. */
+static void
+build_merge_index(merge_index_t *idx, char *cmds_list[], int ncmds_list)
+{
+	int i;
+	int failed;
+
+	idx->valid = 0;
+	idx->filetypes = trie_create();
+	idx->xfiletypes = trie_create();
+	idx->fileviewers = trie_create();
+	idx->cmds = trie_create();
+	idx->lwin_hist = trie_create();
+	idx->rwin_hist = trie_create();
+	idx->bmarks = trie_create();
+	idx->trash = trie_create();
+
+	failed = index_assocs(idx->filetypes, &filetypes)
+	      || index_assocs(idx->xfiletypes, &xfiletypes)
+	      || index_assocs(idx->fileviewers, &fileviewers)
+	      || index_view_hist(idx->lwin_hist, &lwin)
+	      || index_view_hist(idx->rwin_hist, &rwin)
+	      || index_trash(idx->trash);
+
+	for(i = 0; i < ncmds_list && !failed; i += 2)
+	{
+		failed = (trie_put(idx->cmds, cmds_list[i]) < 0);
+	}
+
+	if(!failed)
+	{
+		idx->valid = 1;
+		bmarks_list(&index_bmark, idx);
+	}
+
+	if(!idx->valid)
+	{
+		free_merge_index(idx);
+	}
+}
+
+/* Frees sets of the index. */
+static void
+free_merge_index(merge_index_t *idx)
+{
+	trie_free(idx->filetypes);
+	trie_free(idx->xfiletypes);
+	trie_free(idx->fileviewers);
+	trie_free(idx->cmds);
+	trie_free(idx->lwin_hist);
+	trie_free(idx->rwin_hist);
+	trie_free_with_data(idx->bmarks);
+	trie_free(idx->trash);
+	memset(idx, 0, sizeof(*idx));
+}
+
+/* Puts all records of associations into the set.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+index_assocs(trie_t set, const assoc_list_t *assocs)
+{
+	int i;
+	for(i = 0; i < assocs->count; ++i)
+	{
+		int j;
+		const assoc_t *const assoc = &assocs->list[i];
+		const char *const pattern = matcher_get_expr(assoc->matcher);
+
+		for(j = 0; j < assoc->records.count; ++j)
+		{
+			char *const key = format_str("%s\n%s", pattern,
+					assoc->records.list[j].command);
+			const int failed = (key == NULL || trie_put(set, key) < 0);
+			free(key);
+			if(failed)
+			{
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* Puts directories of history of the view into the set.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+index_view_hist(trie_t set, const FileView *view)
+{
+	int i;
+
+	if(view->history == NULL)
+	{
+		return 0;
+	}
+
+	for(i = MIN(view->history_pos, view->history_num - 1); i >= 0; --i)
+	{
+		const char *const dir = flist_hist_get(view, i)->dir;
+		if(dir == NULL || dir[0] == '\0')
+		{
+			break;
+		}
+		if(put_path(set, dir, NULL) < 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* bmarks_list() callback that puts path of the bookmark along with its
+ * timestamp into the index.  Invalidates index on failure. */
+static void
+index_bmark(const char path[], const char tags[], time_t timestamp, void *arg)
+{
+	merge_index_t *const idx = arg;
+	time_t *const data = malloc(sizeof(*data));
+
+	if(data == NULL)
+	{
+		idx->valid = 0;
+		return;
+	}
+
+	*data = timestamp;
+	if(put_path(idx->bmarks, path, data) < 0)
+	{
+		free(data);
+		idx->valid = 0;
+	}
+}
+
+/* Puts names of all files in trash into the set.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+index_trash(trie_t set)
+{
+	int i;
+	for(i = 0; i < nentries; ++i)
+	{
+		if(put_path(set, trash_list[i].trash_name, NULL) < 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether association is already in the list.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+assoc_is_known(const merge_index_t *idx, trie_t set, const assoc_list_t *assocs,
+		const char pattern[], const char cmd[])
+{
+	char *key;
+	void *data;
+	int found;
+
+	if(!idx->valid)
+	{
+		return ft_assoc_exists(assocs, pattern, cmd);
+	}
+
+	key = make_assoc_key(pattern, cmd);
+	if(key == NULL)
+	{
+		return ft_assoc_exists(assocs, pattern, cmd);
+	}
+
+	found = (trie_get(set, key, &data) == 0);
+	free(key);
+	return found;
+}
+
+/* Makes key of association for looking it up in a set.  Description of the
+ * command is skipped and its commas are undoubled just like
+ * ft_assoc_exists() does.  Returns newly allocated string or NULL on error. */
+static char *
+make_assoc_key(const char pattern[], const char cmd[])
+{
+	char *key;
+	char *p;
+
+	if(*cmd == '{')
+	{
+		const char *const descr_end = strchr(cmd + 1, '}');
+		if(descr_end != NULL)
+		{
+			cmd = descr_end + 1;
+		}
+	}
+
+	key = format_str("%s\n%s", pattern, cmd);
+	if(key == NULL)
+	{
+		return NULL;
+	}
+
+	p = key + strlen(pattern) + 1;
+	cmd = p;
+	while(*cmd != '\0')
+	{
+		if(cmd[0] == ',' && cmd[1] == ',')
+		{
+			++cmd;
+		}
+		*p++ = *cmd++;
+	}
+	*p = '\0';
+
+	return key;
+}
+
+/* Checks whether user-defined command with the name exists.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+cmd_is_known(const merge_index_t *idx, char *cmds_list[], int ncmds_list,
+		const char name[])
+{
+	int i;
+	void *data;
+
+	if(idx->valid)
+	{
+		return (trie_get(idx->cmds, name, &data) == 0);
+	}
+
+	for(i = 0; i < ncmds_list; i += 2)
+	{
+		if(strcmp(cmds_list[i], name) == 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Checks whether bookmark from vifminfo should replace the one in memory.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+bmark_is_newer(const merge_index_t *idx, const char path[], time_t timestamp)
+{
+	void *data;
+
+	if(!idx->valid)
+	{
+		return bmark_is_older(path, timestamp);
+	}
+
+	if(get_path(idx->bmarks, path, &data) != 0)
+	{
+		return 1;
+	}
+	return *(const time_t *)data < timestamp;
+}
+
+/* Checks whether file is in the list of trashed files.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+trash_is_known(const merge_index_t *idx, const char trash_name[])
+{
+	void *data;
+	return idx->valid ? (get_path(idx->trash, trash_name, &data) == 0)
+	                  : is_in_trash(trash_name);
+}
+
+/* Puts path into the set respecting case sensitivity of file system.  Returns
+ * what trie_set() returns. */
+static int
+put_path(trie_t set, const char path[], const void *data)
+{
+#ifndef _WIN32
+	return trie_set(set, path, data);
+#else
+	char lower[PATH_MAX];
+	if(str_to_lower(path, lower, sizeof(lower)) != 0)
+	{
+		return -1;
+	}
+	return trie_set(set, lower, data);
+#endif
+}
+
+/* Looks up path in the set respecting case sensitivity of file system.
+ * Returns what trie_get() returns. */
+static int
+get_path(trie_t set, const char path[], void **data)
+{
+#ifndef _WIN32
+	return trie_get(set, path, data);
+#else
+	char lower[PATH_MAX];
+	if(str_to_lower(path, lower, sizeof(lower)) != 0)
+	{
+		return 1;
+	}
+	return trie_get(set, lower, data);
+#endif
+}
+
 /* Performs conversions on files in trash required for partial backward
  * compatibility.  Returns newly allocated string that should be freed by the
  * caller. */
@@ -1223,8 +1532,9 @@ write_view_history(FILE *fp, FileView *view, const char str[], char mark,
 	}
 	for(i = 0; i <= view->history_pos && i < view->history_num; i++)
 	{
-		fprintf(fp, "%c%s\n\t%s\n%d\n", mark, view->history[i].dir,
-				view->history[i].file, view->history[i].rel_pos);
+		const history_t *const item = flist_hist_get(view, i);
+		fprintf(fp, "%c%s\n\t%s\n%d\n", mark, item->dir, item->file,
+				item->rel_pos);
 	}
 	if(cfg.vifm_info & VIFMINFO_SAVEDIRS)
 	{
@@ -1245,7 +1555,7 @@ write_history(FILE *fp, const char str[], char mark, int prev_count,
 	}
 	for(i = hist->pos; i >= 0; i--)
 	{
-		fprintf(fp, "%c%s\n", mark, hist->items[i]);
+		fprintf(fp, "%c%s\n", mark, hist_get(hist, i));
 	}
 }
 
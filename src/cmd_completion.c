@@ -36,13 +36,14 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* free() */
+#include <stdlib.h> /* calloc() free() */
 #include <stdio.h> /* snprintf() */
 #include <string.h> /* strdup() strlen() strncasecmp() strncmp() strrchr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "compat/reallocarray.h"
 #include "engine/abbrevs.h"
 #include "engine/cmds.h"
 #include "engine/completion.h"
@@ -58,6 +59,7 @@
 #include "ui/color_scheme.h"
 #include "ui/colors.h"
 #include "ui/statusbar.h"
+#include "utils/filemon.h"
 #include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/path.h"
@@ -69,6 +71,39 @@
 #include "filetype.h"
 #include "tags.h"
 
+/* Number of directories whose lists of files are cached for completion. */
+#define COMPL_DIR_CACHE_SIZE 16
+
+/* Entry of a cached directory.  Type checks are performed on demand. */
+typedef struct
+{
+	char *name;         /* Name of the entry. */
+#ifndef _WIN32
+	unsigned char type; /* Value of d_type field of the entry. */
+#endif
+	signed char dir;    /* Whether entry is a directory or -1 if not known. */
+	signed char exec;   /* Whether entry is an executable or -1 if not known. */
+}
+compl_entry_t;
+
+/* List of files of a directory along with results of the last lookup. */
+typedef struct
+{
+	char *path;              /* Full path to the directory or NULL. */
+	filemon_t mon;           /* State of the directory when it was read. */
+	compl_entry_t *entries;  /* Entries of the directory. */
+	size_t nentries;         /* Number of entries. */
+	char *prefix;            /* Prefix of the last lookup or NULL. */
+	size_t *matches;         /* Entries that matched the prefix. */
+	size_t nmatches;         /* Number of elements in matches array. */
+}
+compl_dir_t;
+
+/* Cache of directory lists.  Slots are reused in round-robin fashion. */
+static compl_dir_t dir_cache[COMPL_DIR_CACHE_SIZE];
+/* Index of the slot of dir_cache to use for the next directory. */
+static int next_dir_slot;
+
 static int cmd_ends_with_space(const char *cmd);
 static void complete_colorscheme(const char *str, size_t arg_num);
 static void complete_selective_sync(const char str[]);
@@ -87,12 +122,19 @@ static void complete_from_string_list(const char str[], const char *list[],
 static void complete_command_name(const char beginning[]);
 static void filename_completion_in_dir(const char *path, const char *str,
 		CompletionType type);
-static void filename_completion_internal(DIR *dir, const char dirname[],
+static void filename_completion_internal(compl_dir_t *dir,
 		const char filename[], CompletionType type);
-static int is_dirent_targets_exec(const struct dirent *d);
+static compl_dir_t * get_cached_cwd(void);
+static int read_dir(compl_dir_t *dir);
+static void forget_entry_types(compl_dir_t *dir);
+static void clear_dir(compl_dir_t *dir);
+static int is_entry_dir(compl_entry_t *entry);
+static int is_entry_exec(compl_entry_t *entry);
 #ifdef _WIN32
 static void complete_with_shared(const char *server, const char *file);
 #endif
+static int resolve_cmd_path(const char cmd[], size_t path_len, char path[],
+		int *from_path);
 
 int
 complete_args(int id, const cmd_info_t *cmd_info, int arg_pos, void *extra_arg)
@@ -736,7 +778,7 @@ void
 filename_completion(const char *str, CompletionType type)
 {
 	/* TODO refactor filename_completion(...) function */
-	DIR *dir;
+	compl_dir_t *dir;
 	char *dirname;
 	char *filename;
 	char *temp;
@@ -801,63 +843,96 @@ filename_completion(const char *str, CompletionType type)
 	}
 #endif
 
-	dir = os_opendir(dirname);
-
 	cwd = save_cwd();
 
-	if(dir == NULL || vifm_chdir(dirname) != 0)
+	if(vifm_chdir(dirname) != 0)
 	{
 		vle_compl_add_path_match(filename);
 	}
 	else
 	{
-		filename_completion_internal(dir, dirname, filename, type);
+		dir = get_cached_cwd();
+		if(dir == NULL)
+		{
+			vle_compl_add_path_match(filename);
+		}
+		else
+		{
+			filename_completion_internal(dir, filename, type);
+		}
 		(void)vifm_chdir(flist_get_dir(curr_view));
 	}
 
 	free(filename);
 	free(dirname);
 
-	if(dir != NULL)
-	{
-		os_closedir(dir);
-	}
-
 	restore_cwd(cwd);
 }
 
+/* Adds entries of the directory, which must be current working directory,
+ * that match the filename prefix and completion type. */
 static void
-filename_completion_internal(DIR *dir, const char dirname[],
-		const char filename[], CompletionType type)
+filename_completion_internal(compl_dir_t *dir, const char filename[],
+		CompletionType type)
 {
-	struct dirent *d;
-
-	size_t filename_len = strlen(filename);
-	while((d = os_readdir(dir)) != NULL)
+	size_t i;
+	size_t *matches;
+	size_t nmatches = 0U;
+	const size_t filename_len = strlen(filename);
+
+	/* Results of the previous lookup can be narrowed down if the prefix has
+	 * grown.  Empty prefix excludes dot files, so it's not narrowed down to a
+	 * prefix that starts with a dot. */
+	const int narrow = dir->prefix != NULL
+	                && starts_with(filename, dir->prefix)
+	                && (dir->prefix[0] != '\0' || filename[0] != '.');
+	const size_t ncandidates = narrow ? dir->nmatches : dir->nentries;
+
+	/* Failing to allocate this array only prevents memorizing the result. */
+	matches = reallocarray(NULL, ncandidates + 1U, sizeof(*matches));
+
+	for(i = 0U; i < ncandidates; ++i)
 	{
-		if(filename[0] == '\0' && d->d_name[0] == '.')
+		const size_t idx = narrow ? dir->matches[i] : i;
+		compl_entry_t *const entry = &dir->entries[idx];
+
+		if(filename[0] == '\0' && entry->name[0] == '.')
 			continue;
-		if(strnoscmp(d->d_name, filename, filename_len) != 0)
+		if(strnoscmp(entry->name, filename, filename_len) != 0)
 			continue;
 
-		if(type == CT_DIRONLY && !is_dirent_targets_dir(d))
+		if(matches != NULL)
+		{
+			matches[nmatches++] = idx;
+		}
+
+		if(type == CT_DIRONLY && !is_entry_dir(entry))
 			continue;
-		else if(type == CT_EXECONLY && !is_dirent_targets_exec(d))
+		else if(type == CT_EXECONLY && !is_entry_exec(entry))
 			continue;
-		else if(type == CT_DIREXEC && !is_dirent_targets_dir(d) &&
-				!is_dirent_targets_exec(d))
+		else if(type == CT_DIREXEC && !is_entry_dir(entry) &&
+				!is_entry_exec(entry))
 			continue;
 
-		if(is_dirent_targets_dir(d) && type != CT_ALL_WOS)
+		if(is_entry_dir(entry) && type != CT_ALL_WOS)
 		{
-			vle_compl_put_path_match(format_str("%s/", d->d_name));
+			vle_compl_put_path_match(format_str("%s/", entry->name));
 		}
 		else
 		{
-			vle_compl_add_path_match(d->d_name);
+			vle_compl_add_path_match(entry->name);
 		}
 	}
 
+	free(dir->matches);
+	dir->matches = matches;
+	dir->nmatches = nmatches;
+	if(matches == NULL || replace_string(&dir->prefix, filename) != 0)
+	{
+		free(dir->prefix);
+		dir->prefix = NULL;
+	}
+
 	vle_compl_finish_group();
 	if(type != CT_EXECONLY)
 	{
@@ -865,20 +940,187 @@ filename_completion_internal(DIR *dir, const char dirname[],
 	}
 }
 
-/* Uses dentry to check file type.  Returns non-zero for directories,
- * otherwise zero is returned.  Symbolic links are dereferenced. */
+/* Retrieves list of files of current working directory re-reading it if it
+ * has changed since the last time.  Returns the list or NULL on error. */
+static compl_dir_t *
+get_cached_cwd(void)
+{
+	char cwd[PATH_MAX];
+	filemon_t mon;
+	compl_dir_t *dir = NULL;
+	int i;
+
+	if(get_cwd(cwd, sizeof(cwd)) == NULL || filemon_from_file(".", &mon) != 0)
+	{
+		return NULL;
+	}
+
+	for(i = 0; i < COMPL_DIR_CACHE_SIZE; ++i)
+	{
+		if(dir_cache[i].path != NULL && strcmp(dir_cache[i].path, cwd) == 0)
+		{
+			dir = &dir_cache[i];
+			break;
+		}
+	}
+
+	if(dir != NULL && filemon_equal(&dir->mon, &mon))
+	{
+		/* Permissions of files and targets of symbolic links can change without
+		 * affecting the directory, so types of entries need to be checked
+		 * anew. */
+		forget_entry_types(dir);
+		return dir;
+	}
+
+	if(dir == NULL)
+	{
+		dir = &dir_cache[next_dir_slot];
+		next_dir_slot = (next_dir_slot + 1)%COMPL_DIR_CACHE_SIZE;
+	}
+
+	clear_dir(dir);
+	dir->path = strdup(cwd);
+	filemon_assign(&dir->mon, &mon);
+	if(dir->path == NULL || read_dir(dir) != 0)
+	{
+		clear_dir(dir);
+		return NULL;
+	}
+	return dir;
+}
+
+/* Reads entries of current working directory into the dir.  Returns zero on
+ * success, otherwise non-zero is returned. */
 static int
-is_dirent_targets_exec(const struct dirent *d)
+read_dir(compl_dir_t *dir)
 {
+	struct dirent *d;
+	size_t capacity = 0U;
+
+	DIR *const dp = os_opendir(".");
+	if(dp == NULL)
+	{
+		return 1;
+	}
+
+	while((d = os_readdir(dp)) != NULL)
+	{
+		compl_entry_t *entry;
+
+		if(dir->nentries == capacity)
+		{
+			const size_t new_capacity = (capacity == 0U) ? 64U : capacity*2U;
+			void *const p = reallocarray(dir->entries, new_capacity,
+					sizeof(*dir->entries));
+			if(p == NULL)
+			{
+				os_closedir(dp);
+				return 1;
+			}
+			dir->entries = p;
+			capacity = new_capacity;
+		}
+
+		entry = &dir->entries[dir->nentries];
+		entry->name = strdup(d->d_name);
+		if(entry->name == NULL)
+		{
+			os_closedir(dp);
+			return 1;
+		}
 #ifndef _WIN32
-	if(d->d_type == DT_DIR)
-		return 0;
-	if(d->d_type == DT_LNK && get_symlink_type(d->d_name) != SLT_UNKNOWN)
-		return 0;
-	return os_access(d->d_name, X_OK) == 0;
+		entry->type = d->d_type;
+#endif
+		entry->dir = -1;
+		entry->exec = -1;
+		++dir->nentries;
+	}
+
+	os_closedir(dp);
+	return 0;
+}
+
+/* Resets results of type checks of all entries of the cached directory. */
+static void
+forget_entry_types(compl_dir_t *dir)
+{
+	size_t i;
+	for(i = 0U; i < dir->nentries; ++i)
+	{
+		dir->entries[i].dir = -1;
+		dir->entries[i].exec = -1;
+	}
+}
+
+/* Frees resources of the cached directory and resets it. */
+static void
+clear_dir(compl_dir_t *dir)
+{
+	size_t i;
+	for(i = 0U; i < dir->nentries; ++i)
+	{
+		free(dir->entries[i].name);
+	}
+	free(dir->entries);
+	free(dir->path);
+	free(dir->prefix);
+	free(dir->matches);
+
+	dir->path = NULL;
+	dir->entries = NULL;
+	dir->nentries = 0U;
+	dir->prefix = NULL;
+	dir->matches = NULL;
+	dir->nmatches = 0U;
+}
+
+/* Checks whether entry of current working directory is a directory.  Symbolic
+ * links are dereferenced.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_entry_dir(compl_entry_t *entry)
+{
+	if(entry->dir < 0)
+	{
+#ifndef _WIN32
+		if(entry->type == DT_UNKNOWN)
+		{
+			entry->dir = (is_dir(entry->name) != 0);
+		}
+		else
+		{
+			entry->dir = entry->type == DT_DIR
+			          || (entry->type == DT_LNK &&
+			              get_symlink_type(entry->name) != SLT_UNKNOWN);
+		}
 #else
-	return is_win_executable(d->d_name);
+		entry->dir = (is_dir(entry->name) != 0);
 #endif
+	}
+	return entry->dir;
+}
+
+/* Checks whether entry of current working directory is an executable file.
+ * Symbolic links are dereferenced.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_entry_exec(compl_entry_t *entry)
+{
+	if(entry->exec < 0)
+	{
+#ifndef _WIN32
+		if(entry->type == DT_DIR)
+			entry->exec = 0;
+		else if(entry->type == DT_LNK && is_entry_dir(entry))
+			entry->exec = 0;
+		else
+			entry->exec = (os_access(entry->name, X_OK) == 0);
+#else
+		entry->exec = (is_win_executable(entry->name) != 0);
+#endif
+	}
+	return entry->exec;
 }
 
 #ifndef _WIN32
@@ -972,31 +1214,43 @@ int
 external_command_exists(const char cmd[])
 {
 	char path[PATH_MAX];
+	int from_path;
 
-	if(get_cmd_path(cmd, sizeof(path), path) == 0)
+	if(resolve_cmd_path(cmd, sizeof(path), path, &from_path) != 0)
 	{
-		return executable_exists(path);
+		return 0;
 	}
-	return 0;
+
+	/* Lookup in $PATH already checks that the command is executable. */
+	return from_path || executable_exists(path);
 }
 
 int
 get_cmd_path(const char cmd[], size_t path_len, char path[])
+{
+	int from_path;
+	return resolve_cmd_path(cmd, path_len, path, &from_path);
+}
+
+/* Finds path to executable of the command, which is either specified
+ * explicitly or looked up in $PATH.  Sets *from_path to non-zero in the latter
+ * case.  Returns zero on success, otherwise non-zero is returned. */
+static int
+resolve_cmd_path(const char cmd[], size_t path_len, char path[],
+		int *from_path)
 {
 	if(starts_with(cmd, "!!"))
 	{
 		cmd += 2;
 	}
 
-	if(contains_slash(cmd))
+	*from_path = !contains_slash(cmd);
+	if(!*from_path)
 	{
 		copy_str(path, path_len, cmd);
 		return 0;
 	}
-	else
-	{
-		return find_cmd_in_path(cmd, path_len, path);
-	}
+	return find_cmd_in_path(cmd, path_len, path);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
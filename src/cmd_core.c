@@ -246,7 +246,7 @@ prepare_extcmd_file(FILE *fp, const char beginning[], CmdInputType type)
 	fprintf(fp, "%s\n", beginning);
 	for(i = 0; i <= hist->pos; i++)
 	{
-		fprintf(fp, "%s\n", hist->items[i]);
+		fprintf(fp, "%s\n", hist_get(hist, i));
 	}
 
 	if(is_cmd)
@@ -388,10 +388,8 @@ select_range(int id, const cmd_info_t *cmd_info)
 			if(is_parent_dir(curr_view->dir_entry[x].name) &&
 					cmd_info->begin != cmd_info->end)
 				continue;
-			curr_view->dir_entry[x].selected = 1;
-			y++;
+			flist_sel_entry(curr_view, x, 1);
 		}
-		curr_view->selected_files = y;
 	}
 	else if(curr_view->selected_files == 0)
 	{
@@ -404,10 +402,9 @@ select_range(int id, const cmd_info_t *cmd_info)
 			{
 				if(y == 1)
 					break;
-				curr_view->dir_entry[x].selected = 1;
+				flist_sel_entry(curr_view, x, 1);
 				y++;
 			}
-			curr_view->selected_files = y;
 		}
 		else if(id != COM_FIND && id != COM_GREP)
 		{
@@ -419,10 +416,9 @@ select_range(int id, const cmd_info_t *cmd_info)
 				if(y == 1)
 					break;
 
-				curr_view->dir_entry[x].selected = 1;
+				flist_sel_entry(curr_view, x, 1);
 				y++;
 			}
-			curr_view->selected_files = y;
 		}
 	}
 	else
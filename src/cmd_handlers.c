@@ -99,6 +99,7 @@
 
 static int goto_cmd(const cmd_info_t *cmd_info);
 static int emark_cmd(const cmd_info_t *cmd_info);
+static int run_in_batches(const cmd_info_t *cmd_info);
 static int alink_cmd(const cmd_info_t *cmd_info);
 static int apropos_cmd(const cmd_info_t *cmd_info);
 static int autocmd_cmd(const cmd_info_t *cmd_info);
@@ -536,8 +537,7 @@ select_count(const cmd_info_t *cmd_info, int count)
 	{
 		if(!is_parent_dir(curr_view->dir_entry[pos].name))
 		{
-			curr_view->dir_entry[pos].selected = 1;
-			curr_view->selected_files++;
+			flist_sel_entry(curr_view, pos, 1);
 		}
 		pos++;
 	}
@@ -587,6 +587,11 @@ emark_cmd(const cmd_info_t *cmd_info)
 	}
 
 	flags = (MacroFlags)cmd_info->usr1;
+	if(flags == MF_BATCHED)
+	{
+		return run_in_batches(cmd_info);
+	}
+
 	handled = run_ext_command(com, flags, cmd_info->bg, &save_msg);
 	if(handled > 0)
 	{
@@ -631,6 +636,75 @@ emark_cmd(const cmd_info_t *cmd_info)
 	return save_msg;
 }
 
+/* Runs command of :! in batches like xargs, so that lists of selected files
+ * don't exceed limits on length of command-line.  Background batches run in
+ * parallel, foreground ones one after another.  Returns value for save_msg. */
+static int
+run_in_batches(const cmd_info_t *cmd_info)
+{
+	char buf[COMMAND_GROUP_INFO_LEN];
+	MacroFlags flags;
+	int i, count;
+	int use_term_mux;
+	char **const cmds = ma_expand_batched(skip_whitespace(cmd_info->raw_args),
+			NULL, &flags, get_max_cmd_len(), 1, &count);
+	if(cmds == NULL)
+	{
+		status_bar_error("Failed to expand command");
+		return 1;
+	}
+
+	use_term_mux = flags != MF_NO_TERM_MUX;
+
+	if(!cmd_info->bg)
+	{
+		clean_selected_files(curr_view);
+	}
+
+	snprintf(buf, sizeof(buf), "in %s: !%s",
+			replace_home_part(flist_get_dir(curr_view)), cmd_info->raw_args);
+	cmd_group_begin(buf);
+
+	for(i = 0; i < count; ++i)
+	{
+		if(cmd_info->bg)
+		{
+			start_background_job(cmds[i], 0);
+		}
+		else
+		{
+			const int last = (i == count - 1);
+			const ShellPause pause = (cmd_info->emark && last) ? PAUSE_ALWAYS
+			                                                   : PAUSE_ON_ERROR;
+			if(cfg.fast_run)
+			{
+				char *const completed = fast_run_complete(cmds[i]);
+				if(completed != NULL)
+				{
+					(void)shellout(completed, pause, use_term_mux);
+					free(completed);
+				}
+			}
+			else
+			{
+				(void)shellout(cmds[i], pause, use_term_mux);
+			}
+		}
+		add_operation(OP_USR, strdup(cmds[i]), NULL, "", "");
+	}
+
+	cmd_group_end();
+
+	free_string_array(cmds, count);
+
+	if(count > 1)
+	{
+		status_bar_messagef("Ran command in %d batches", count);
+		return 1;
+	}
+	return 0;
+}
+
 /* Creates symbolic links with absolute paths to files. */
 static int
 alink_cmd(const cmd_info_t *cmd_info)
@@ -1857,7 +1931,7 @@ get_filter_value(const char filter[])
 	{
 		if(!hist_is_empty(&cfg.search_hist))
 		{
-			filter = cfg.search_hist.items[0];
+			filter = hist_get(&cfg.search_hist, 0);
 		}
 	}
 	return filter;
@@ -2805,7 +2879,7 @@ nohlsearch_cmd(const cmd_info_t *cmd_info)
 	if(curr_view->selected_files != 0)
 	{
 		clean_selected_files(curr_view);
-		redraw_current_view();
+		fview_redraw_damaged(curr_view);
 	}
 	return 0;
 }
@@ -20,9 +20,11 @@
 
 #include <regex.h> /* regex_t regcomp() regexec() regfree() */
 
+#include <ctype.h> /* tolower() */
 #include <stddef.h> /* size_t */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strcasecmp() strchr() strdup() */
+#include <stdlib.h> /* calloc() free() qsort() */
+#include <string.h> /* memcpy() strcasecmp() strchr() strcpy() strdup()
+                       strlen() strpbrk() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/reallocarray.h"
@@ -31,6 +33,11 @@
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/trie.h"
+
+/* Maximum number of memoized matches per event, after reaching the limit
+ * memoized data is dropped. */
+#define MAX_MEMOIZED 256
 
 /* Describes single registered autocommand. */
 typedef struct
@@ -44,11 +51,38 @@ typedef struct
 }
 aucmd_info_t;
 
+/* Index of autocommands of a single event.  Lists of autocommand indexes are
+ * stored as arrays of int, first element of which is number of indexes that
+ * follow it. */
+typedef struct
+{
+	char *event;     /* Name of the event. */
+	trie_t paths;    /* Lower-cased literal path -> list of autocommands. */
+	trie_t names;    /* Lower-cased literal file name -> list of autocommands. */
+	trie_t prefixes; /* Lower-cased prefix of recursive patterns -> list. */
+	int *others;     /* Autocommands that have to be matched one by one. */
+	int nothers;     /* Number of elements in the others array. */
+	trie_t matches;  /* Memoized results: path -> list of autocommands. */
+	int nmatches;    /* Number of entries in the matches trie. */
+}
+event_index_t;
+
 static int add_aucmd(const char event[], const char pattern[], int negated,
 		const char action[], vle_aucmd_handler handler);
 static int is_pattern_match(const aucmd_info_t *autocmd, const char path[]);
 static void free_autocmd_data(aucmd_info_t *autocmd);
 static char ** get_patterns(const char patterns[], int *len);
+static int * get_matches(const char event[], const char path[]);
+static event_index_t * get_event_index(const char event[]);
+static void build_index(void);
+static int index_autocmd(int idx);
+static event_index_t * add_event_index(const char event[]);
+static void drop_index(void);
+static int add_to_list(trie_t trie, const char key[], int idx);
+static int * find_matches(const event_index_t *index, const char path[]);
+static int append_list(trie_t trie, const char key[], int **list);
+static int compare_ints(const void *a, const void *b);
+static int str_to_lower_ascii(char str[]);
 
 /* List of registered autocommands. */
 static aucmd_info_t *autocmds;
@@ -58,6 +92,15 @@ static DA_INSTANCE(autocmds);
 /* Pattern expansion hook. */
 static vle_aucmd_expand_hook expand_hook = &strdup;
 
+/* Number of changes of the list of autocommands, used to detect changes. */
+static unsigned int changes;
+/* Index of autocommands by their events. */
+static event_index_t *event_index;
+/* Number of elements in the event_index array. */
+static int nevents;
+/* Whether event_index corresponds to the list of autocommands. */
+static int index_valid;
+
 void
 vle_aucmd_set_expand_hook(vle_aucmd_expand_hook hook)
 {
@@ -144,15 +187,17 @@ add_aucmd(const char event[], const char pattern[], int negated,
 	}
 
 	DA_COMMIT(autocmds);
-	/* TODO: sort by event name (case insensitive) and then by pattern? */
+	++changes;
+	index_valid = 0;
 	return 0;
 }
 
 void
 vle_aucmd_execute(const char event[], const char path[], void *arg)
 {
-	size_t i;
+	size_t i = 0U;
 	char canonic_path[PATH_MAX];
+	int *matches;
 
 	canonicalize_path(path, canonic_path, sizeof(canonic_path));
 	if(!is_root_dir(canonic_path))
@@ -160,7 +205,30 @@ vle_aucmd_execute(const char event[], const char path[], void *arg)
 		chosp(canonic_path);
 	}
 
-	for(i = 0U; i < DA_SIZE(autocmds); ++i)
+	matches = get_matches(event, canonic_path);
+	if(matches != NULL)
+	{
+		const unsigned int initial_changes = changes;
+		int j;
+
+		i = DA_SIZE(autocmds);
+		for(j = 1; j <= matches[0]; ++j)
+		{
+			const aucmd_info_t *const autocmd = &autocmds[matches[j]];
+			autocmd->handler(autocmd->action, arg);
+
+			/* Handlers can change the list of autocommands, in which case the rest
+			 * of it is processed without the index. */
+			if(changes != initial_changes)
+			{
+				i = matches[j] + 1;
+				break;
+			}
+		}
+		free(matches);
+	}
+
+	for(; i < DA_SIZE(autocmds); ++i)
 	{
 		if(strcasecmp(event, autocmds[i].event) == 0 &&
 				is_pattern_match(&autocmds[i], canonic_path))
@@ -170,6 +238,348 @@ vle_aucmd_execute(const char event[], const char path[], void *arg)
 	}
 }
 
+/* Finds autocommands of the event that match canonicalized path using index
+ * and memoized results.  Returns newly allocated list of indexes in ascending
+ * order (first element being number of indexes) or NULL on error. */
+static int *
+get_matches(const char event[], const char path[])
+{
+	void *data;
+	const int *matches;
+	int *copy;
+	event_index_t *index;
+
+	if(!index_valid)
+	{
+		build_index();
+		if(!index_valid)
+		{
+			return NULL;
+		}
+	}
+
+	index = get_event_index(event);
+	if(index == NULL)
+	{
+		return calloc(1U, sizeof(int));
+	}
+
+	if(trie_get(index->matches, path, &data) != 0)
+	{
+		data = find_matches(index, path);
+		if(data == NULL)
+		{
+			return NULL;
+		}
+
+		if(index->nmatches == MAX_MEMOIZED)
+		{
+			trie_free_with_data(index->matches);
+			index->matches = trie_create();
+			index->nmatches = 0;
+		}
+
+		if(trie_set(index->matches, path, data) != 0)
+		{
+			/* Not memoized, so just give the list to the caller. */
+			return data;
+		}
+		++index->nmatches;
+	}
+
+	matches = data;
+	copy = reallocarray(NULL, matches[0] + 1, sizeof(*copy));
+	if(copy != NULL)
+	{
+		memcpy(copy, matches, sizeof(*copy)*(matches[0] + 1));
+	}
+	return copy;
+}
+
+/* Looks up index of the event.  Returns the index or NULL if there are no
+ * autocommands for the event. */
+static event_index_t *
+get_event_index(const char event[])
+{
+	int i;
+	for(i = 0; i < nevents; ++i)
+	{
+		if(strcasecmp(event_index[i].event, event) == 0)
+		{
+			return &event_index[i];
+		}
+	}
+	return NULL;
+}
+
+/* Builds index of all autocommands.  Sets index_valid on success. */
+static void
+build_index(void)
+{
+	size_t i;
+
+	drop_index();
+
+	for(i = 0U; i < DA_SIZE(autocmds); ++i)
+	{
+		if(index_autocmd(i) != 0)
+		{
+			drop_index();
+			return;
+		}
+	}
+
+	index_valid = 1;
+}
+
+/* Adds autocommand to the index.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+index_autocmd(int idx)
+{
+	const aucmd_info_t *const autocmd = &autocmds[idx];
+	const char *const pattern = autocmd->pattern;
+	const size_t len = strlen(pattern);
+	char key[len + 1U];
+	const char *wildcard;
+	event_index_t *index;
+	void *p;
+
+	index = get_event_index(autocmd->event);
+	if(index == NULL)
+	{
+		index = add_event_index(autocmd->event);
+		if(index == NULL)
+		{
+			return 1;
+		}
+	}
+
+	strcpy(key, pattern);
+	wildcard = strpbrk(pattern, "*?[\\");
+
+	/* Negated patterns and case of non-ASCII characters are handled only by
+	 * regular expressions. */
+	if(!autocmd->negated && str_to_lower_ascii(key))
+	{
+		if(wildcard == NULL)
+		{
+			trie_t trie = (strchr(pattern, '/') == NULL) ? index->names
+			                                              : index->paths;
+			return add_to_list(trie, key, idx);
+		}
+
+		if(wildcard == pattern + len - 2U && ends_with(pattern, "/**"))
+		{
+			key[len - 3U] = '\0';
+			return add_to_list(index->prefixes, key, idx);
+		}
+	}
+
+	p = reallocarray(index->others, index->nothers + 1, sizeof(*index->others));
+	if(p == NULL)
+	{
+		return 1;
+	}
+	index->others = p;
+	index->others[index->nothers++] = idx;
+	return 0;
+}
+
+/* Adds empty index for the event.  Returns the index or NULL on error. */
+static event_index_t *
+add_event_index(const char event[])
+{
+	event_index_t *index;
+
+	void *const p = reallocarray(event_index, nevents + 1, sizeof(*event_index));
+	if(p == NULL)
+	{
+		return NULL;
+	}
+	event_index = p;
+
+	index = &event_index[nevents++];
+	index->event = strdup(event);
+	index->paths = trie_create();
+	index->names = trie_create();
+	index->prefixes = trie_create();
+	index->others = NULL;
+	index->nothers = 0;
+	index->matches = trie_create();
+	index->nmatches = 0;
+
+	if(index->event == NULL || index->paths == NULL_TRIE ||
+			index->names == NULL_TRIE || index->prefixes == NULL_TRIE ||
+			index->matches == NULL_TRIE)
+	{
+		return NULL;
+	}
+	return index;
+}
+
+/* Frees index of autocommands. */
+static void
+drop_index(void)
+{
+	int i;
+	for(i = 0; i < nevents; ++i)
+	{
+		free(event_index[i].event);
+		trie_free_with_data(event_index[i].paths);
+		trie_free_with_data(event_index[i].names);
+		trie_free_with_data(event_index[i].prefixes);
+		free(event_index[i].others);
+		trie_free_with_data(event_index[i].matches);
+	}
+	free(event_index);
+	event_index = NULL;
+	nevents = 0;
+	index_valid = 0;
+}
+
+/* Appends autocommand index to the list stored in the trie by the key.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+add_to_list(trie_t trie, const char key[], int idx)
+{
+	void *data = NULL;
+	int *list;
+	int count = 0;
+
+	if(trie_get(trie, key, &data) == 0)
+	{
+		count = ((int *)data)[0];
+	}
+
+	list = reallocarray(data, count + 2, sizeof(*list));
+	if(list == NULL)
+	{
+		return 1;
+	}
+
+	list[0] = count + 1;
+	list[count + 1] = idx;
+	return (trie_set(trie, key, list) < 0);
+}
+
+/* Finds autocommands that match the canonicalized path.  Returns newly
+ * allocated list of indexes in ascending order or NULL on error. */
+static int *
+find_matches(const event_index_t *index, const char path[])
+{
+	const size_t len = strlen(path);
+	char key[len + 1U];
+	int *list = calloc(1U, sizeof(*list));
+	int i;
+
+	strcpy(key, path);
+	(void)str_to_lower_ascii(key);
+
+	if(append_list(index->paths, key, &list) != 0 ||
+			append_list(index->names, get_last_path_component(key), &list) != 0)
+	{
+		free(list);
+		return NULL;
+	}
+
+	/* Parent directories are matched against prefixes. */
+	for(i = (int)len - 1; i >= 0; --i)
+	{
+		if(key[i] == '/')
+		{
+			key[i] = '\0';
+			if(append_list(index->prefixes, key, &list) != 0)
+			{
+				free(list);
+				return NULL;
+			}
+		}
+	}
+
+	for(i = 0; i < index->nothers; ++i)
+	{
+		const int idx = index->others[i];
+		if(is_pattern_match(&autocmds[idx], path))
+		{
+			int *const p = reallocarray(list, list[0] + 2, sizeof(*list));
+			if(p == NULL)
+			{
+				free(list);
+				return NULL;
+			}
+			list = p;
+			list[++list[0]] = idx;
+		}
+	}
+
+	qsort(&list[1], list[0], sizeof(*list), &compare_ints);
+	return list;
+}
+
+/* Appends list stored in the trie by the key (if any) to the *list.  Returns
+ * zero on success, otherwise non-zero is returned. */
+static int
+append_list(trie_t trie, const char key[], int **list)
+{
+	void *data;
+	const int *other;
+	int *p;
+
+	if(*list == NULL)
+	{
+		return 1;
+	}
+
+	if(trie_get(trie, key, &data) != 0)
+	{
+		return 0;
+	}
+	other = data;
+
+	p = reallocarray(*list, (*list)[0] + other[0] + 1, sizeof(**list));
+	if(p == NULL)
+	{
+		return 1;
+	}
+
+	memcpy(&p[p[0] + 1], &other[1], sizeof(*other)*other[0]);
+	p[0] += other[0];
+	*list = p;
+	return 0;
+}
+
+/* qsort() comparer for integers.  Returns standard -1, 0, 1 for comparisons. */
+static int
+compare_ints(const void *a, const void *b)
+{
+	const int lhs = *(const int *)a;
+	const int rhs = *(const int *)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+/* Converts ASCII characters of the string to lower case in place.  Returns
+ * non-zero if the string consists of ASCII characters only, otherwise zero is
+ * returned. */
+static int
+str_to_lower_ascii(char str[])
+{
+	int ascii = 1;
+	while(*str != '\0')
+	{
+		if((unsigned char)*str < 0x80)
+		{
+			*str = tolower(*str);
+		}
+		else
+		{
+			ascii = 0;
+		}
+		++str;
+	}
+	return ascii;
+}
+
 /* Checks whether path matches pattern in the autocommand.  Returns non-zero if
  * so, otherwise zero is returned. */
 static int
@@ -214,6 +624,8 @@ vle_aucmd_remove(const char event[], const char patterns[])
 
 		free_autocmd_data(&autocmds[i]);
 		DA_REMOVE(autocmds, &autocmds[i]);
+		++changes;
+		index_valid = 0;
 	}
 
 	free_string_array(pats, len);
@@ -32,6 +32,7 @@
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/test_helpers.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "completion.h"
 
@@ -72,12 +73,23 @@ typedef struct cmd_t
 	struct cmd_t *next;
 }cmd_t;
 
+/* Information about commands that start with a particular prefix. */
+typedef struct
+{
+	cmd_t *first; /* First command in the list with this prefix or NULL. */
+	int udfs;     /* Number of user-defined commands without suffix. */
+}
+prefix_info_t;
+
 typedef struct
 {
 	cmd_t head;
 	cmd_add_t user_cmd_handler;
 	cmd_handler command_handler;
 	int udf_count;
+	/* Maps every prefix of every command name to prefix_info_t.  NULL_TRIE when
+	 * it couldn't be maintained, in which case the list is traversed. */
+	trie_t index;
 }inner_t;
 
 /* List of characters, which are treated as range separators. */
@@ -108,6 +120,10 @@ static const char * get_user_cmd_name(const char cmd[], char buf[],
 static int is_correct_name(const char name[]);
 static cmd_t * insert_cmd(cmd_t *after);
 static int delcommand_cmd(const cmd_info_t *cmd_info);
+static void index_cmd(const cmd_t *cmd);
+static void unindex_cmd(const cmd_t *cmd);
+static int is_plain_udf(const cmd_t *cmd);
+static void drop_index(void);
 TSTATIC char ** dispatch_line(const char args[], int *count, char sep,
 		int regexp, int quotes, int comments, int *last_arg, int (**positions)[2]);
 static int is_separator(char c, char sep);
@@ -147,6 +163,7 @@ init_cmds(int udf, cmds_conf_t *conf)
 		conf->inner = calloc(1, sizeof(inner_t));
 		assert(conf->inner != NULL);
 		inner = conf->inner;
+		inner->index = trie_create();
 
 		if(udf)
 			add_builtin_commands(commands, ARRAY_LEN(commands));
@@ -169,6 +186,7 @@ reset_cmds(void)
 
 	inner->head.next = NULL;
 	inner->user_cmd_handler.handler = NULL;
+	drop_index();
 
 	free(inner);
 	cmds_conf->inner = NULL;
@@ -359,6 +377,9 @@ correct_limit(const char cmd[], cmd_info_t *cmd_info)
 	return cmd;
 }
 
+/* Checks whether name is an abbreviation of more than one user-defined
+ * command, while not being a full name of any command.  Returns non-zero if
+ * so, otherwise zero is returned. */
 static int
 udf_is_ambiguous(const char name[])
 {
@@ -366,6 +387,24 @@ udf_is_ambiguous(const char name[])
 	int count;
 	cmd_t *cur;
 
+	if(inner->index != NULL_TRIE)
+	{
+		void *data;
+		const prefix_info_t *info;
+
+		if(trie_get(inner->index, name, &data) != 0)
+		{
+			return 0;
+		}
+
+		info = data;
+		if(info->first != NULL && strcmp(info->first->name, name) == 0)
+		{
+			return 0;
+		}
+		return (info->udfs > 1);
+	}
+
 	len = strlen(name);
 	count = 0;
 	cur = inner->head.next;
@@ -568,11 +607,23 @@ skip_prefix_commands(const char cmd[])
 	return cmd;
 }
 
+/* Finds the first (in sorted order) command whose name starts with the name.
+ * Returns the command or NULL if there is no such command. */
 static cmd_t *
 find_cmd(const char name[])
 {
 	cmd_t *cmd;
 
+	if(inner->index != NULL_TRIE)
+	{
+		void *data;
+		if(trie_get(inner->index, name, &data) != 0)
+		{
+			return NULL;
+		}
+		return ((prefix_info_t *)data)->first;
+	}
+
 	cmd = inner->head.next;
 	while(cmd != NULL && strcmp(cmd->name, name) < 0)
 	{
@@ -726,27 +777,23 @@ get_cmd_name(const char cmd[], char buf[], size_t buf_len)
 	buf[len] = '\0';
 	if(*t == '?' || *t == '!')
 	{
-		int cmp;
 		cmd_t *cur;
 
-		cur = inner->head.next;
-		while(cur != NULL && (cmp = strncmp(cur->name, buf, len)) <= 0)
+		cur = find_cmd(buf);
+		while(cur != NULL && strncmp(cur->name, buf, len) == 0)
 		{
-			if(cmp == 0)
+			/* Check for user-defined command that ends with the char. */
+			if(cur->type == USER_CMD && cur->name[strlen(cur->name) - 1] == *t)
 			{
-				/* Check for user-defined command that ends with the char. */
-				if(cur->type == USER_CMD && cur->name[strlen(cur->name) - 1] == *t)
-				{
-					strncpy(buf, cur->name, buf_len);
-					break;
-				}
-				/* Or builtin abbreviation that supports the mark. */
-				if(cur->type == BUILTIN_ABBR &&
-						((*t == '!' && cur->emark) || (*t == '?' && cur->qmark)))
-				{
-					strncpy(buf, cur->name, buf_len);
-					break;
-				}
+				strncpy(buf, cur->name, buf_len);
+				break;
+			}
+			/* Or builtin abbreviation that supports the mark. */
+			if(cur->type == BUILTIN_ABBR &&
+					((*t == '!' && cur->emark) || (*t == '?' && cur->qmark)))
+			{
+				strncpy(buf, cur->name, buf_len);
+				break;
 			}
 			cur = cur->next;
 		}
@@ -813,9 +860,7 @@ complete_cmd_name(const char cmd_name[], int user_only)
 	cmd_t *cur;
 	size_t len;
 
-	cur = inner->head.next;
-	while(cur != NULL && strcmp(cur->name, cmd_name) < 0)
-		cur = cur->next;
+	cur = find_cmd(cmd_name);
 
 	len = strlen(cmd_name);
 	while(cur != NULL && strncmp(cur->name, cmd_name, len) == 0)
@@ -932,6 +977,7 @@ add_builtin_cmd(const char name[], int abbr, const cmd_add_t *conf)
 	new->quote = conf->quote;
 	new->cmd = NULL;
 
+	index_cmd(new);
 	return 0;
 }
 
@@ -945,6 +991,7 @@ comclear_cmd(const cmd_info_t *cmd_info)
 		if(cur->next->type == USER_CMD)
 		{
 			cmd_t *this = cur->next;
+			unindex_cmd(this);
 			cur->next = this->next;
 
 			free(this->cmd);
@@ -1015,6 +1062,7 @@ command_cmd(const cmd_info_t *cmd_info)
 			return CMDS_ERR_NO_BUILTIN_REDEFINE;
 		if(!cmd_info->emark)
 			return CMDS_ERR_NEED_BANG;
+		unindex_cmd(cur);
 		free(cur->name);
 		free(cur->cmd);
     new = cur;
@@ -1044,6 +1092,7 @@ command_cmd(const cmd_info_t *cmd_info)
 	new->select = inner->user_cmd_handler.select;
 	new->bg = inner->user_cmd_handler.bg;
 	new->quote = inner->user_cmd_handler.quote;
+	index_cmd(new);
 
 	inner->udf_count++;
 	return 0;
@@ -1115,6 +1164,7 @@ delcommand_cmd(const cmd_info_t *cmd_info)
 		return CMDS_ERR_NO_SUCH_UDF;
 
 	cmd = cur->next;
+	unindex_cmd(cmd);
 	cur->next = cmd->next;
 	free(cmd->name);
 	free(cmd->cmd);
@@ -1124,6 +1174,124 @@ delcommand_cmd(const cmd_info_t *cmd_info)
 	return 0;
 }
 
+/* Adds command, which must already be in the list, to the index. */
+static void
+index_cmd(const cmd_t *cmd)
+{
+	const size_t len = strlen(cmd->name);
+	char prefix[len + 1U];
+	size_t i;
+
+	if(inner->index == NULL_TRIE)
+	{
+		return;
+	}
+
+	strcpy(prefix, cmd->name);
+	for(i = 0U; i <= len; ++i)
+	{
+		void *data;
+		prefix_info_t *info;
+		const char c = prefix[i];
+
+		prefix[i] = '\0';
+		if(trie_get(inner->index, prefix, &data) == 0)
+		{
+			info = data;
+		}
+		else
+		{
+			info = calloc(1U, sizeof(*info));
+			if(info == NULL || trie_set(inner->index, prefix, info) < 0)
+			{
+				free(info);
+				drop_index();
+				return;
+			}
+		}
+		prefix[i] = c;
+
+		if(info->first == NULL || strcmp(cmd->name, info->first->name) < 0)
+		{
+			info->first = (cmd_t *)cmd;
+		}
+		if(is_plain_udf(cmd))
+		{
+			++info->udfs;
+		}
+	}
+}
+
+/* Removes command from the index.  Must be called before the command is
+ * unlinked from the list. */
+static void
+unindex_cmd(const cmd_t *cmd)
+{
+	const size_t len = strlen(cmd->name);
+	char prefix[len + 1U];
+	size_t i;
+
+	if(inner->index == NULL_TRIE)
+	{
+		return;
+	}
+
+	strcpy(prefix, cmd->name);
+	for(i = 0U; i <= len; ++i)
+	{
+		void *data;
+		prefix_info_t *info;
+		const char c = prefix[i];
+
+		prefix[i] = '\0';
+		if(trie_get(inner->index, prefix, &data) != 0)
+		{
+			prefix[i] = c;
+			continue;
+		}
+		info = data;
+
+		/* The list is sorted, so commands with the same prefix follow each
+		 * other. */
+		if(info->first == cmd)
+		{
+			const cmd_t *const next = cmd->next;
+			info->first = (next != NULL && starts_with(next->name, prefix))
+			            ? (cmd_t *)next
+			            : NULL;
+		}
+		if(is_plain_udf(cmd))
+		{
+			--info->udfs;
+		}
+		prefix[i] = c;
+	}
+}
+
+/* Checks whether command is user-defined one which doesn't end with ! or ?.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_plain_udf(const cmd_t *cmd)
+{
+	char c;
+
+	if(cmd->type != USER_CMD)
+	{
+		return 0;
+	}
+
+	c = cmd->name[strlen(cmd->name) - 1];
+	return (c != '!' && c != '?');
+}
+
+/* Frees the index, which makes lookups fall back to traversing the list. */
+static void
+drop_index(void)
+{
+	trie_free_with_data(inner->index);
+	inner->index = NULL_TRIE;
+}
+
 char *
 get_last_argument(const char cmd[], int quotes, size_t *len)
 {
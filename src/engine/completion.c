@@ -38,6 +38,8 @@ state = NOT_STARTED;
 
 static char **lines;
 static int count;
+/* Number of elements lines array can hold without reallocation. */
+static int capacity;
 static int curr = -1;
 static int group_begin;
 static int order;
@@ -57,6 +59,7 @@ vle_compl_reset(void)
 	lines = NULL;
 
 	count = 0;
+	capacity = 0;
 	state = NOT_STARTED;
 	curr = -1;
 	group_begin = 0;
@@ -111,13 +114,18 @@ add_match(char match[])
 		return -1;
 	}
 
-	p = reallocarray(lines, count + 1, sizeof(*lines));
-	if(p == NULL)
+	if(count == capacity)
 	{
-		free(match);
-		return -1;
+		const int new_capacity = (capacity == 0) ? 16 : capacity*2;
+		p = reallocarray(lines, new_capacity, sizeof(*lines));
+		if(p == NULL)
+		{
+			free(match);
+			return -1;
+		}
+		lines = p;
+		capacity = new_capacity;
 	}
-	lines = p;
 
 	lines[count] = match;
 	count++;
@@ -89,7 +89,7 @@ function_call(const char func_name[], const call_info_t *call_info)
 				func_name);
 		return var_error();
 	}
-	if(call_info->argc > function->arg_count)
+	if(call_info->argc > function->arg_count + function->opt_count)
 	{
 		vle_tb_append_linef(vle_err, "%s: %s", "Too many arguments for function",
 				func_name);
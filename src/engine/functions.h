@@ -40,6 +40,7 @@ typedef struct
 	const char *name; /* Name of a function. */
 	size_t arg_count; /* Required number of arguments. */
 	function_ptr_t ptr; /* Pointer to function implementation. */
+	size_t opt_count; /* Number of optional arguments after required ones. */
 }
 function_t;
 
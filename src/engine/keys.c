@@ -45,6 +45,12 @@ typedef struct key_chunk_t
 	struct key_chunk_t *child;
 	struct key_chunk_t *parent;
 	struct key_chunk_t *prev, *next;
+
+	/* Array of children sorted by key for fast lookup, which is built lazily and
+	 * is up to date only when children_gen equals to generation. */
+	struct key_chunk_t **children;
+	size_t nchildren;          /* Number of elements in the children array. */
+	unsigned int children_gen; /* Generation of the children array. */
 }key_chunk_t;
 
 static key_chunk_t *builtin_cmds_root;
@@ -58,10 +64,17 @@ static size_t counter;
 static size_t enters_counter;
 /* Shows whether a mapping handler is being executed at the moment. */
 static int inside_mapping;
+/* Number of changes in structure of trees, which invalidates lookup arrays of
+ * all chunks.  Starts with one to make zeroed chunks invalid. */
+static unsigned int generation = 1U;
 
 static void free_forest(key_chunk_t *forest, size_t size);
 static void free_tree(key_chunk_t *root);
 static void free_chunk(key_chunk_t *chunk);
+static void release_chunk(key_chunk_t *chunk);
+static key_chunk_t * find_child(key_chunk_t *chunk, wchar_t key);
+static int index_children(key_chunk_t *chunk);
+static int has_nim_child(const key_chunk_t *chunk);
 static int execute_keys_general_wrapper(const wchar_t keys[], int timed_out,
 		int mapped, int no_remap);
 static int execute_keys_general(const wchar_t keys[], int timed_out, int mapped,
@@ -159,6 +172,11 @@ clear_user_keys(void)
 static void
 free_tree(key_chunk_t *root)
 {
+	++generation;
+	free(root->children);
+	root->children = NULL;
+	root->nchildren = 0U;
+
 	if(root->child != NULL)
 	{
 		free_tree(root->child);
@@ -180,7 +198,7 @@ free_chunk(key_chunk_t *chunk)
 {
 	if(chunk->enters == 0)
 	{
-		free(chunk);
+		release_chunk(chunk);
 	}
 	else
 	{
@@ -188,6 +206,102 @@ free_chunk(key_chunk_t *chunk)
 	}
 }
 
+/* Frees memory occupied by the chunk. */
+static void
+release_chunk(key_chunk_t *chunk)
+{
+	free(chunk->children);
+	free(chunk);
+}
+
+/* Looks up child of the chunk by its key.  Returns the child or NULL. */
+static key_chunk_t *
+find_child(key_chunk_t *chunk, wchar_t key)
+{
+	size_t l, r;
+
+	if(chunk->children_gen != generation && index_children(chunk) != 0)
+	{
+		/* Fallback to linear search. */
+		key_chunk_t *p = chunk->child;
+		while(p != NULL && p->key < key)
+		{
+			p = p->next;
+		}
+		return (p != NULL && p->key == key) ? p : NULL;
+	}
+
+	l = 0U;
+	r = chunk->nchildren;
+	while(l < r)
+	{
+		const size_t m = l + (r - l)/2U;
+		key_chunk_t *const child = chunk->children[m];
+		if(child->key == key)
+		{
+			return child;
+		}
+
+		if(child->key < key)
+		{
+			l = m + 1U;
+		}
+		else
+		{
+			r = m;
+		}
+	}
+	return NULL;
+}
+
+/* Builds array of children of the chunk for lookups.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+index_children(key_chunk_t *chunk)
+{
+	size_t n = 0U;
+	key_chunk_t *p;
+	void *ptr;
+
+	for(p = chunk->child; p != NULL; p = p->next)
+	{
+		++n;
+	}
+
+	ptr = reallocarray(chunk->children, n + 1U, sizeof(*chunk->children));
+	if(ptr == NULL)
+	{
+		return 1;
+	}
+	chunk->children = ptr;
+
+	/* The list is sorted by key already. */
+	n = 0U;
+	for(p = chunk->child; p != NULL; p = p->next)
+	{
+		chunk->children[n++] = p;
+	}
+	chunk->nchildren = n;
+	chunk->children_gen = generation;
+	return 0;
+}
+
+/* Checks whether any child of the chunk expects number in the middle.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+has_nim_child(const key_chunk_t *chunk)
+{
+	const key_chunk_t *p;
+	for(p = chunk->child; p != NULL; p = p->next)
+	{
+		if(p->conf.type == BUILTIN_NIM_KEYS)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 void
 set_def_handler(int mode, default_handler handler)
 {
@@ -318,32 +432,15 @@ dispatch_keys_at_root(const wchar_t keys[], keys_info_t *keys_info,
 	curr = root;
 	while(*keys != L'\0')
 	{
-		key_chunk_t *p;
-		int number_in_the_middle = 0;
-
-		p = curr->child;
-		while(p != NULL && p->key < *keys)
+		key_chunk_t *const p = find_child(curr, *keys);
+		if(p == NULL)
 		{
-			if(p->conf.type == BUILTIN_NIM_KEYS)
-			{
-				number_in_the_middle = 1;
-			}
-			p = p->next;
-		}
+			int number_in_the_middle;
 
-		if(p == NULL || p->key != *keys)
-		{
 			if(curr == root)
 				return KEYS_UNKNOWN;
 
-			while(p != NULL)
-			{
-				if(p->conf.type == BUILTIN_NIM_KEYS)
-				{
-					number_in_the_middle = 1;
-				}
-				p = p->next;
-			}
+			number_in_the_middle = has_nim_child(curr);
 
 			if(curr->conf.followed != FOLLOWED_BY_NONE &&
 					(!number_in_the_middle || !is_at_count(keys)))
@@ -421,13 +518,8 @@ contains_chain(key_chunk_t *root, const wchar_t *begin, const wchar_t *end)
 	curr = root;
 	while(begin != end)
 	{
-		key_chunk_t *p;
-
-		p = curr->child;
-		while(p != NULL && p->key < *begin)
-			p = p->next;
-
-		if(p == NULL || p->key != *begin)
+		key_chunk_t *const p = find_child(curr, *begin);
+		if(p == NULL)
 			return 0;
 
 		begin++;
@@ -601,16 +693,23 @@ execute_after_remapping(const wchar_t rhs[], const wchar_t left_keys[],
 	}
 	else
 	{
-		wchar_t buf[16 + wcslen(rhs) + 1 + wcslen(left_keys) + 1];
+		/* Buffer is allocated dynamically as this function is called recursively
+		 * once per mapping in the input and left_keys can be long. */
+		const size_t buf_len = 16 + wcslen(rhs) + 1 + wcslen(left_keys) + 1;
+		wchar_t *const buf = reallocarray(NULL, buf_len, sizeof(*buf));
+		if(buf == NULL)
+		{
+			return KEYS_UNKNOWN;
+		}
 
 		buf[0] = '\0';
 		if(key_info.reg != NO_REG_GIVEN)
 		{
-			vifm_swprintf(buf, ARRAY_LEN(buf), L"\"%c", key_info.reg);
+			vifm_swprintf(buf, buf_len, L"\"%c", key_info.reg);
 		}
 		if(key_info.count != NO_COUNT_GIVEN)
 		{
-			vifm_swprintf(buf + wcslen(buf), ARRAY_LEN(buf) - wcslen(buf), L"%d",
+			vifm_swprintf(buf + wcslen(buf), buf_len - wcslen(buf), L"%d",
 					key_info.count);
 		}
 		wcscat(buf, rhs);
@@ -624,6 +723,8 @@ execute_after_remapping(const wchar_t rhs[], const wchar_t left_keys[],
 		enter_chunk(curr);
 		result = dispatch_keys(buf, &keys_info, curr->no_remap, NO_COUNT_GIVEN);
 		leave_chunk(curr);
+
+		free(buf);
 	}
 	return result;
 }
@@ -646,7 +747,7 @@ leave_chunk(key_chunk_t *chunk)
 	{
 		/* Removal of the chunk was postponed because it was in use, proceed with
 		 * this now. */
-		free(chunk);
+		release_chunk(chunk);
 	}
 }
 
@@ -792,6 +893,8 @@ remove_user_keys(const wchar_t *keys, int mode)
 	if(curr->children_count > 0)
 		return 0;
 
+	++generation;
+
 	do
 	{
 		key_chunk_t *const parent = curr->parent;
@@ -817,12 +920,9 @@ find_user_keys(const wchar_t *keys, int mode)
 	key_chunk_t *curr = &user_cmds_root[mode];
 	while(*keys != L'\0')
 	{
-		key_chunk_t *p = curr->child;
-		while(p != NULL && p->key < *keys)
-			p = p->next;
-		if(p == NULL || p->key != *keys)
+		curr = find_child(curr, *keys);
+		if(curr == NULL)
 			return NULL;
-		curr = p;
 		keys++;
 	}
 	return (curr->conf.type == USER_CMD) ? curr : NULL;
@@ -907,12 +1007,16 @@ add_keys_inner(key_chunk_t *root, const wchar_t *keys)
 			c->enters = 0;
 			c->deleted = 0;
 			c->no_remap = 1;
+			c->children = NULL;
+			c->nchildren = 0U;
+			c->children_gen = 0U;
 			if(prev == NULL)
 				curr->child = c;
 			else
 				prev->next = c;
 			if(p != NULL)
 				p->prev = c;
+			++generation;
 
 			if(keys[1] == L'\0')
 			{
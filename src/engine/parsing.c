@@ -16,12 +16,16 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
-/* The parsing and evaluation are mostly separated.  Currently parsing evaluates
- * values without side-effects, but this can be changed later.
+/* The parsing and evaluation are separated.  Parsing doesn't evaluate anything
+ * except for literals, values of environment variables and options are read
+ * during evaluation.
  *
  * Output of parsing phase is an expression tree, which is made of nodes of type
  * expr_t.  After parsing they either contain literals or specification of how
- * their value should be evaluated.  Expression value is evaluated at most once.
+ * their value should be evaluated.  Evaluation doesn't modify the tree, so it
+ * can be evaluated multiple times.  Trees of successfully parsed expressions
+ * are cached by their text, this way expressions that are evaluated repeatedly
+ * (e.g. in autocommands) are parsed only once.
  *
  * There are two types of evaluation-time operations (part of Ops enumeration):
  *  1. With specific evaluation order requirements.
@@ -33,7 +37,7 @@
  * Second type is for the rest of builtins and user-provided functions.
  *
  * parse_or_expr() is a root-level parser of expressions and it basically
- * performs parsing phase.  parse_or_expr() evaluates expression, which is the
+ * performs parsing phase.  eval_expr() evaluates expression, which is the
  * second phase.
  *
  * If parsing stops before the end of an expression, partial result is stored in
@@ -51,6 +55,7 @@
 
 #include "../compat/reallocarray.h"
 #include "../utils/str.h"
+#include "../utils/trie.h"
 #include "private/options.h"
 #include "functions.h"
 #include "options.h"
@@ -61,6 +66,10 @@
 #define NAME_LENGTH_MAX 256
 #define CMD_LINE_LENGTH_MAX 4096
 
+/* Maximum number of parsed expressions to keep in the cache.  The cache is
+ * emptied on reaching the limit. */
+#define EXPR_CACHE_SIZE 512
+
 /* Supported types of tokens. */
 typedef enum
 {
@@ -94,10 +103,12 @@ TOKENS_TYPE;
 /* Types of evaluation operations. */
 typedef enum
 {
-	OP_NONE, /* The node has already been evaluated or is a literal. */
-	OP_OR,   /* Logical OR. */
-	OP_AND,  /* Logical AND. */
-	OP_CALL, /* Builtin operator implemented as a function or builtin function. */
+	OP_NONE,   /* The node is a literal. */
+	OP_OR,     /* Logical OR. */
+	OP_AND,    /* Logical AND. */
+	OP_CALL,   /* Builtin operator implemented as a function or a function. */
+	OP_ENVVAR, /* Value of environment variable. */
+	OP_OPT,    /* Value of an option. */
 }
 Ops;
 
@@ -105,21 +116,42 @@ Ops;
  * evaluation. */
 typedef struct expr_t
 {
-	var_t value;        /* Value of a literal or result of evaluation. */
+	var_t value;        /* Value of a literal. */
 	Ops op_type;        /* Type of operation. */
-	char *func;         /* Function (builtin or user) name for OP_CALL. */
+	char *func;         /* Function (builtin or user) name for OP_CALL, name of
+	                       variable or option for OP_ENVVAR and OP_OPT. */
+	OPT_SCOPE scope;    /* Scope of option for OP_OPT. */
 	int nops;           /* Number of operands. */
 	struct expr_t *ops; /* Operands. */
 }
 expr_t;
 
-static int eval_expr(expr_t *expr);
-static int eval_or_op(int nops, expr_t ops[], var_t *result);
-static int eval_and_op(int nops, expr_t ops[], var_t *result);
-static int eval_call_op(const char name[], int nops, expr_t ops[],
+/* Parsed expression along with state of the parser after parsing it, which is
+ * enough to evaluate the expression again without reparsing it. */
+typedef struct
+{
+	expr_t root;           /* Root of the expression tree. */
+	size_t position;       /* Offset of last_position at the end of parsing. */
+	size_t parsed_char;    /* Offset of last_parsed_char. */
+	int partial;           /* Whether expression is followed by something. */
+	TOKENS_TYPE prev_type; /* Type of the token before the last one. */
+}
+parsed_expr_t;
+
+static parsed_expr_t * get_parsed(const char input[]);
+static int parse_expr(const char input[], parsed_expr_t *parsed);
+static parsed_expr_t * cache_parsed(const char input[],
+		const parsed_expr_t *parsed);
+static void clear_cache(void);
+static int eval_expr(const expr_t *expr, var_t *result);
+static int eval_or_op(int nops, const expr_t ops[], var_t *result);
+static int eval_and_op(int nops, const expr_t ops[], var_t *result);
+static int eval_call_op(const char name[], int nops, const expr_t ops[],
 		var_t *result);
 static int compare_variables(TOKENS_TYPE operation, var_t lhs, var_t rhs);
-static var_t eval_concat(int nops, expr_t ops[]);
+static var_t eval_concat(int nops, const var_t args[]);
+static var_t eval_envvar(const char name[]);
+static var_t eval_opt(const char name[], OPT_SCOPE scope);
 static int add_expr_op(expr_t *expr, const expr_t *arg);
 static void free_expr(const expr_t *expr);
 static expr_t parse_or_expr(const char **in);
@@ -134,8 +166,8 @@ static var_t parse_singly_quoted_string(const char **in);
 static int parse_singly_quoted_char(const char **in, char buffer[]);
 static var_t parse_doubly_quoted_string(const char **in);
 static int parse_doubly_quoted_char(const char **in, char buffer[]);
-static var_t eval_envvar(const char **in);
-static var_t eval_opt(const char **in);
+static expr_t parse_envvar(const char **in);
+static expr_t parse_opt(const char **in);
 static expr_t parse_logical_not(const char **in);
 static int parse_sequence(const char **in, const char first[],
 		const char other[], size_t buf_len, char buf[]);
@@ -163,6 +195,13 @@ static var_t res_val;
 /* Empty expression to be returned on errors. */
 static expr_t null_expr;
 
+/* Cache of parsed expressions, maps text of expression to parsed_expr_t. */
+static trie_t expr_cache;
+/* Entries of the expr_cache for freeing them. */
+static parsed_expr_t **cached;
+/* Number of elements in the cached array. */
+static int ncached;
+
 /* Public interface --------------------------------------------------------- */
 
 void
@@ -170,6 +209,8 @@ init_parser(getenv_func getenv_f)
 {
 	getenv_fu = getenv_f;
 	initialized = 1;
+
+	clear_cache();
 }
 
 const char *
@@ -189,17 +230,85 @@ get_last_parsed_char(void)
 ParsingErrors
 parse(const char input[], var_t *result)
 {
-	expr_t expr_root;
+	parsed_expr_t local;
+	parsed_expr_t *parsed;
 
 	assert(initialized && "Parser must be initialized before use.");
 
+	parsed = get_parsed(input);
+	if(parsed == NULL)
+	{
+		if(parse_expr(input, &local) != 0)
+		{
+			return last_error;
+		}
+		parsed = cache_parsed(input, &local);
+		if(parsed == NULL)
+		{
+			parsed = &local;
+		}
+	}
+
+	last_error = PE_NO_ERROR;
+	last_position = input + parsed->position;
+	last_parsed_char = input + parsed->parsed_char;
+	prev_token.type = parsed->prev_type;
+
+	if(parsed->partial)
+	{
+		var_t value;
+		if(eval_expr(&parsed->root, &value) == 0)
+		{
+			var_free(res_val);
+			res_val = value;
+			last_error = PE_INVALID_EXPRESSION;
+		}
+	}
+	else
+	{
+		var_t value;
+		if(eval_expr(&parsed->root, &value) == 0)
+		{
+			var_free(res_val);
+			res_val = var_clone(value);
+			*result = value;
+		}
+	}
+
+	if(last_error == PE_INVALID_EXPRESSION)
+	{
+		last_position = skip_whitespace(input);
+	}
+
+	if(parsed == &local)
+	{
+		free_expr(&local.root);
+	}
+	return last_error;
+}
+
+/* Looks up parsed expression in the cache.  Returns the expression or NULL. */
+static parsed_expr_t *
+get_parsed(const char input[])
+{
+	void *data;
+	return (trie_get(expr_cache, input, &data) == 0) ? data : NULL;
+}
+
+/* Parses the input into *parsed.  Returns zero on success, otherwise non-zero
+ * is returned, last_error and last_position are set and *parsed is left
+ * uninitialized. */
+static int
+parse_expr(const char input[], parsed_expr_t *parsed)
+{
 	last_error = PE_NO_ERROR;
 	last_token.type = BEGIN;
 
 	last_position = input;
 	get_next(&last_position);
-	expr_root = parse_or_expr(&last_position);
+	parsed->root = parse_or_expr(&last_position);
 	last_parsed_char = last_position;
+	parsed->partial = 0;
 
 	if(last_token.type != END)
 	{
@@ -214,32 +323,92 @@ parse(const char input[], var_t *result)
 				/* This is a comment, just ignore it. */
 				last_position += strlen(last_position);
 			}
-			else if(eval_expr(&expr_root) == 0)
+			else
 			{
-				var_free(res_val);
-				res_val = var_clone(expr_root.value);
-				last_error = PE_INVALID_EXPRESSION;
+				parsed->partial = 1;
 			}
 		}
 	}
 
-	if(last_error == PE_NO_ERROR)
+	if(last_error != PE_NO_ERROR)
 	{
-		if(eval_expr(&expr_root) == 0)
+		if(last_error == PE_INVALID_EXPRESSION)
 		{
-			var_free(res_val);
-			res_val = var_clone(expr_root.value);
-			*result = var_clone(expr_root.value);
+			last_position = skip_whitespace(input);
 		}
+		free_expr(&parsed->root);
+		return 1;
 	}
 
-	if(last_error == PE_INVALID_EXPRESSION)
+	parsed->position = last_position - input;
+	parsed->parsed_char = last_parsed_char - input;
+	parsed->prev_type = prev_token.type;
+	return 0;
+}
+
+/* Puts copy of the *parsed into the cache taking ownership of its tree.
+ * Returns the copy or NULL on memory allocation error, in which case the tree
+ * remains owned by the caller. */
+static parsed_expr_t *
+cache_parsed(const char input[], const parsed_expr_t *parsed)
+{
+	parsed_expr_t *entry;
+	void *p;
+
+	if(ncached == EXPR_CACHE_SIZE)
 	{
-		last_position = skip_whitespace(input);
+		clear_cache();
 	}
 
-	free_expr(&expr_root);
-	return last_error;
+	if(expr_cache == NULL_TRIE)
+	{
+		expr_cache = trie_create();
+		if(expr_cache == NULL_TRIE)
+		{
+			return NULL;
+		}
+	}
+
+	p = reallocarray(cached, ncached + 1, sizeof(*cached));
+	if(p == NULL)
+	{
+		return NULL;
+	}
+	cached = p;
+
+	entry = malloc(sizeof(*entry));
+	if(entry == NULL)
+	{
+		return NULL;
+	}
+
+	if(trie_set(expr_cache, input, entry) != 0)
+	{
+		free(entry);
+		return NULL;
+	}
+
+	*entry = *parsed;
+	cached[ncached++] = entry;
+	return entry;
+}
+
+/* Empties cache of parsed expressions. */
+static void
+clear_cache(void)
+{
+	int i;
+	for(i = 0; i < ncached; ++i)
+	{
+		free_expr(&cached[i]->root);
+		free(cached[i]);
+	}
+	free(cached);
+	cached = NULL;
+	ncached = 0;
+
+	trie_free(expr_cache);
+	expr_cache = NULL_TRIE;
 }
 
 var_t
@@ -258,41 +427,40 @@ is_prev_token_whitespace(void)
 
 /* Expression evaluation ---------------------------------------------------- */
 
-/* Evaluates values of an expression.  Returns zero on success, which means that
- * expr->value is now correct, otherwise non-zero is returned. */
+/* Evaluates value of an expression.  Returns zero on success, which means that
+ * *result is set, otherwise non-zero is returned. */
 static int
-eval_expr(expr_t *expr)
+eval_expr(const expr_t *expr, var_t *result)
 {
-	int result = 1;
 	switch(expr->op_type)
 	{
 		case OP_NONE:
-			/* Do nothing, value is already available. */
+			*result = var_clone(expr->value);
 			return 0;
 		case OP_OR:
-			result = eval_or_op(expr->nops, expr->ops, &expr->value);
-			break;
+			return eval_or_op(expr->nops, expr->ops, result);
 		case OP_AND:
-			result = eval_and_op(expr->nops, expr->ops, &expr->value);
-			break;
+			return eval_and_op(expr->nops, expr->ops, result);
 		case OP_CALL:
 			assert(expr->func != NULL && "Function must have a name.");
-			result = eval_call_op(expr->func, expr->nops, expr->ops, &expr->value);
-			break;
-	}
-	if(result == 0)
-	{
-		expr->op_type = OP_NONE;
+			return eval_call_op(expr->func, expr->nops, expr->ops, result);
+		case OP_ENVVAR:
+			*result = eval_envvar(expr->func);
+			return 0;
+		case OP_OPT:
+			*result = eval_opt(expr->func, expr->scope);
+			return (last_error != PE_NO_ERROR);
 	}
-	return result;
+	assert(0 && "Unknown operation type.");
+	return 1;
 }
 
 /* Evaluates logical OR operation.  All operands are evaluated lazily from left
  * to right.  Returns zero on success, otherwise non-zero is returned. */
 static int
-eval_or_op(int nops, expr_t ops[], var_t *result)
+eval_or_op(int nops, const expr_t ops[], var_t *result)
 {
-	int val;
+	int val = 0;
 	int i;
 
 	if(nops == 0)
@@ -301,28 +469,22 @@ eval_or_op(int nops, expr_t ops[], var_t *result)
 		return 0;
 	}
 
-	if(eval_expr(&ops[0]) != 0)
-	{
-		return 1;
-	}
-
 	if(nops == 1)
 	{
-		*result = var_clone(ops[0].value);
-		return 0;
+		return eval_expr(&ops[0], result);
 	}
 
-	/* Conversion to integer so that strings are converted into numbers instead of
-	 * checked to be empty. */
-	val = var_to_integer(ops[0].value);
-
-	for(i = 1; i < nops && !val; ++i)
+	for(i = 0; i < nops && !val; ++i)
 	{
-		if(eval_expr(&ops[i]) != 0)
+		var_t op_val;
+		if(eval_expr(&ops[i], &op_val) != 0)
 		{
 			return 1;
 		}
-		val |= var_to_integer(ops[i].value);
+		/* Conversion to integer so that strings are converted into numbers instead
+		 * of checked to be empty. */
+		val |= var_to_integer(op_val);
+		var_free(op_val);
 	}
 
 	*result = var_from_bool(val);
@@ -332,9 +494,9 @@ eval_or_op(int nops, expr_t ops[], var_t *result)
 /* Evaluates logical AND operation.  All operands are evaluated lazily from left
  * to right.  Returns zero on success, otherwise non-zero is returned. */
 static int
-eval_and_op(int nops, expr_t ops[], var_t *result)
+eval_and_op(int nops, const expr_t ops[], var_t *result)
 {
-	int val;
+	int val = 1;
 	int i;
 
 	if(nops == 0)
@@ -343,28 +505,22 @@ eval_and_op(int nops, expr_t ops[], var_t *result)
 		return 0;
 	}
 
-	if(eval_expr(&ops[0]) != 0)
-	{
-		return 1;
-	}
-
 	if(nops == 1)
 	{
-		*result = var_clone(ops[0].value);
-		return 0;
+		return eval_expr(&ops[0], result);
 	}
 
-	/* Conversion to integer so that strings are converted into numbers instead of
-	 * checked to be empty. */
-	val = var_to_integer(ops[0].value);
-
-	for(i = 1; i < nops && val; ++i)
+	for(i = 0; i < nops && val; ++i)
 	{
-		if(eval_expr(&ops[i]) != 0)
+		var_t op_val;
+		if(eval_expr(&ops[i], &op_val) != 0)
 		{
 			return 1;
 		}
-		val &= var_to_integer(ops[i].value);
+		/* Conversion to integer so that strings are converted into numbers instead
+		 * of checked to be empty. */
+		val &= var_to_integer(op_val);
+		var_free(op_val);
 	}
 
 	*result = var_from_bool(val);
@@ -374,14 +530,26 @@ eval_and_op(int nops, expr_t ops[], var_t *result)
 /* Evaluates invocation operation.  All operands are evaluated beforehand.
  * Returns zero on success, otherwise non-zero is returned. */
 static int
-eval_call_op(const char name[], int nops, expr_t ops[], var_t *result)
+eval_call_op(const char name[], int nops, const expr_t ops[], var_t *result)
 {
 	int i;
+	var_t *const args = reallocarray(NULL, nops + 1, sizeof(*args));
+
+	if(args == NULL)
+	{
+		last_error = PE_INTERNAL;
+		return 1;
+	}
 
 	for(i = 0; i < nops; ++i)
 	{
-		if(eval_expr(&ops[i]) != 0)
+		if(eval_expr(&ops[i], &args[i]) != 0)
 		{
+			while(i-- > 0)
+			{
+				var_free(args[i]);
+			}
+			free(args);
 			return 1;
 		}
 	}
@@ -389,46 +557,46 @@ eval_call_op(const char name[], int nops, expr_t ops[], var_t *result)
 	if(strcmp(name, "==") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(EQ, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(EQ, args[0], args[1]));
 	}
 	else if(strcmp(name, "!=") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(NE, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(NE, args[0], args[1]));
 	}
 	else if(strcmp(name, "<") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(LT, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(LT, args[0], args[1]));
 	}
 	else if(strcmp(name, "<=") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(LE, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(LE, args[0], args[1]));
 	}
 	else if(strcmp(name, ">") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(GT, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(GT, args[0], args[1]));
 	}
 	else if(strcmp(name, ">=") == 0)
 	{
 		assert(nops == 2 && "Must be two arguments.");
-		*result = var_from_bool(compare_variables(GE, ops[0].value, ops[1].value));
+		*result = var_from_bool(compare_variables(GE, args[0], args[1]));
 	}
 	else if(strcmp(name, ".") == 0)
 	{
-		*result = eval_concat(nops, ops);
+		*result = eval_concat(nops, args);
 	}
 	else if(strcmp(name, "!") == 0)
 	{
 		assert(nops == 1 && "Must be single argument.");
-		*result = var_from_bool(!var_to_integer(ops[0].value));
+		*result = var_from_bool(!var_to_integer(args[0]));
 	}
 	else if(strcmp(name, "-") == 0 || strcmp(name, "+") == 0)
 	{
 		assert(nops == 1 && "Must be single argument.");
-		var_val_t val = { .integer = var_to_integer(ops[0].value) };
+		var_val_t val = { .integer = var_to_integer(args[0]) };
 		if(name[0] == '-')
 		{
 			val.integer = -val.integer;
@@ -437,14 +605,15 @@ eval_call_op(const char name[], int nops, expr_t ops[], var_t *result)
 	}
 	else
 	{
-		int i;
 		call_info_t call_info;
 		function_call_info_init(&call_info);
 
+		/* Ownership of arguments is passed to the call_info. */
 		for(i = 0; i < nops; ++i)
 		{
-			function_call_info_add_arg(&call_info, var_clone(ops[i].value));
+			function_call_info_add_arg(&call_info, args[i]);
 		}
+		nops = 0;
 
 		*result = function_call(name, &call_info);
 		if(result->type == VTYPE_ERROR)
@@ -456,6 +625,12 @@ eval_call_op(const char name[], int nops, expr_t ops[], var_t *result)
 		function_call_info_free(&call_info);
 	}
 
+	for(i = 0; i < nops; ++i)
+	{
+		var_free(args[i]);
+	}
+	free(args);
+
 	return (last_error != PE_NO_ERROR);
 }
 
@@ -505,7 +680,7 @@ compare_variables(TOKENS_TYPE operation, var_t lhs, var_t rhs)
 /* Evaluates concatenation of expressions.  Returns resultant value or variable
  * of type VTYPE_ERROR. */
 static var_t
-eval_concat(int nops, expr_t ops[])
+eval_concat(int nops, const var_t args[])
 {
 	var_t result = var_error();
 	int i;
@@ -514,7 +689,7 @@ eval_concat(int nops, expr_t ops[])
 
 	if(nops == 1)
 	{
-		return var_clone(ops[0].value);
+		return var_clone(args[0]);
 	}
 
 	char res[CMD_LINE_LENGTH_MAX];
@@ -523,7 +698,7 @@ eval_concat(int nops, expr_t ops[])
 
 	for(i = 0; i < nops; ++i)
 	{
-		char *const str_val = var_to_string(ops[i].value);
+		char *const str_val = var_to_string(args[i]);
 		if(str_val == NULL)
 		{
 			last_error = PE_INTERNAL;
@@ -543,6 +718,55 @@ eval_concat(int nops, expr_t ops[])
 	return result;
 }
 
+/* Evaluates value of environment variable.  Returns the value. */
+static var_t
+eval_envvar(const char name[])
+{
+	var_val_t var_val = { .const_string = getenv_fu(name) };
+	return var_new(VTYPE_STRING, var_val);
+}
+
+/* Evaluates value of an option.  Returns the value, which is false on error in
+ * which case last_error is updated. */
+static var_t
+eval_opt(const char name[], OPT_SCOPE scope)
+{
+	var_val_t var_val;
+
+	const opt_t *const option = find_option(name, scope);
+	if(option == NULL)
+	{
+		last_error = PE_INVALID_EXPRESSION;
+		return var_false();
+	}
+
+	switch(option->type)
+	{
+		case OPT_STR:
+		case OPT_STRLIST:
+		case OPT_CHARSET:
+			var_val.string = option->val.str_val;
+			return var_new(VTYPE_STRING, var_val);
+
+		case OPT_BOOL:
+			var_val.integer = option->val.bool_val;
+			return var_new(VTYPE_INT, var_val);
+
+		case OPT_INT:
+			var_val.integer = option->val.int_val;
+			return var_new(VTYPE_INT, var_val);
+
+		case OPT_ENUM:
+		case OPT_SET:
+			var_val.const_string = get_value(option);
+			return var_new(VTYPE_STRING, var_val);
+
+		default:
+			assert(0 && "Unexpected option type");
+			return var_false();
+	}
+}
+
 /* Appends operand to an expression.  Returns zero on success, otherwise
  * non-zero is returned and the *op is freed. */
 static int
@@ -786,11 +1010,11 @@ parse_term(const char **in)
 			break;
 		case DOLLAR:
 			get_next(in);
-			result.value = eval_envvar(in);
+			result = parse_envvar(in);
 			break;
 		case AMPERSAND:
 			get_next(in);
-			result.value = eval_opt(in);
+			result = parse_opt(in);
 			break;
 		case EMARK:
 			get_next(in);
@@ -979,36 +1203,40 @@ parse_doubly_quoted_char(const char **in, char buffer[])
 }
 
 /* envvar ::= '$' envvarname */
-static var_t
-eval_envvar(const char **in)
+static expr_t
+parse_envvar(const char **in)
 {
-	var_val_t var_val;
+	expr_t result = { .op_type = OP_ENVVAR };
 
 	char name[ENVVAR_NAME_LENGTH_MAX];
 	if(!parse_sequence(in, ENV_VAR_NAME_FIRST_CHAR, ENV_VAR_NAME_CHARS,
 		sizeof(name), name))
 	{
 		last_error = PE_INVALID_EXPRESSION;
-		return var_false();
+		return null_expr;
 	}
 
-	var_val.const_string = getenv_fu(name);
-	return var_new(VTYPE_STRING, var_val);
+	result.func = strdup(name);
+	if(result.func == NULL)
+	{
+		last_error = PE_INTERNAL;
+		return null_expr;
+	}
+
+	return result;
 }
 
-/* envvar ::= '&' [ 'l:' | 'g:' ] optname */
-static var_t
-eval_opt(const char **in)
+/* opt ::= '&' [ 'l:' | 'g:' ] optname */
+static expr_t
+parse_opt(const char **in)
 {
-	OPT_SCOPE scope = OPT_ANY;
-	const opt_t *option;
-	var_val_t var_val;
+	expr_t result = { .op_type = OP_OPT, .scope = OPT_ANY };
 
 	char name[OPTION_NAME_MAX];
 
 	if((last_token.c == 'l' || last_token.c == 'g') && **in == ':')
 	{
-		scope = (last_token.c == 'l') ? OPT_LOCAL : OPT_GLOBAL;
+		result.scope = (last_token.c == 'l') ? OPT_LOCAL : OPT_GLOBAL;
 		get_next(in);
 		get_next(in);
 	}
@@ -1017,41 +1245,25 @@ eval_opt(const char **in)
 		name))
 	{
 		last_error = PE_INVALID_EXPRESSION;
-		return var_false();
+		return null_expr;
 	}
 
-	option = find_option(name, scope);
-	if(option == NULL)
+	/* Option is looked up by its name on each evaluation as options can be
+	 * added and removed, but report unknown ones early. */
+	if(find_option(name, result.scope) == NULL)
 	{
 		last_error = PE_INVALID_EXPRESSION;
-		return var_false();
+		return null_expr;
 	}
 
-	switch(option->type)
+	result.func = strdup(name);
+	if(result.func == NULL)
 	{
-		case OPT_STR:
-		case OPT_STRLIST:
-		case OPT_CHARSET:
-			var_val.string = option->val.str_val;
-			return var_new(VTYPE_STRING, var_val);
-
-		case OPT_BOOL:
-			var_val.integer = option->val.bool_val;
-			return var_new(VTYPE_INT, var_val);
-
-		case OPT_INT:
-			var_val.integer = option->val.int_val;
-			return var_new(VTYPE_INT, var_val);
-
-		case OPT_ENUM:
-		case OPT_SET:
-			var_val.const_string = get_value(option);
-			return var_new(VTYPE_STRING, var_val);
-
-		default:
-			assert(0 && "Unexpected option type");
-			return var_false();
+		last_error = PE_INTERNAL;
+		return null_expr;
 	}
+
+	return result;
 }
 
 /* logical_not ::= '!' term */
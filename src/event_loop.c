@@ -19,9 +19,17 @@
 
 #include "event_loop.h"
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 #include <curses.h>
 
-#include <unistd.h>
+#ifndef _WIN32
+#include <poll.h> /* POLLIN poll() pollfd */
+#endif
+#include <sys/time.h> /* gettimeofday() timeval */
+#include <unistd.h> /* STDIN_FILENO */
 
 #include <assert.h> /* assert() */
 #include <signal.h> /* signal() */
@@ -45,11 +53,30 @@
 #include "background.h"
 #include "filelist.h"
 #include "ipc.h"
+#include "signals.h"
 #include "status.h"
 #include "vifm.h"
 
+#ifndef _WIN32
+/* Maximum number of file descriptors to wait on in the main loop. */
+#define MAX_WAIT_FDS 128
+
+/* Type of functions that fill fds array of length len with file descriptors to
+ * wait on.  Should return number of descriptors or -1 if polling is needed. */
+typedef int (*get_fds_func)(int fds[], int len);
+#endif
+
 static int ensure_term_is_ready(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout);
+static int load_deferred_views(void);
+static int wait_for_events(int timeout);
+#ifndef _WIN32
+static int add_wait_fd(struct pollfd fds[], int *nfds, int fd);
+static int add_view_fd(struct pollfd fds[], int *nfds, const FileView *view);
+static int add_wait_fds(struct pollfd fds[], int *nfds,
+		get_fds_func get_fds);
+#endif
+static int min_period(int a, int b);
 static void process_scheduled_updates(void);
 static int process_scheduled_updates_of_view(FileView *view);
 static int should_check_views_for_changes(void);
@@ -109,7 +136,9 @@ event_loop(const int *quit)
 
 			check_background_jobs();
 
-			got_input = (get_char_async_loop(status_bar, &c, timeout) != ERR);
+			/* There is no need for timeout unless a key sequence is being typed. */
+			got_input = (get_char_async_loop(status_bar, &c,
+						input_buf_pos == 0 ? -1 : timeout) != ERR);
 
 			/* This loop can be infinite if terminal becomes not available, so force
 			 * checking terminal state here. */
@@ -285,16 +314,17 @@ ensure_term_is_ready(void)
  *  - checks for new IPC messages;
  *  - checks whether contents of displayed directories changed;
  *  - redraws UI if requested.
- * Returns KEY_CODE_YES for functional keys, OK for wide character and ERR
- * otherwise (e.g. after timeout). */
+ * Negative timeout means waiting until the first event of any kind.  Returns
+ * KEY_CODE_YES for functional keys, OK for wide character and ERR otherwise
+ * (e.g. after timeout). */
 static int
 get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 {
-	const int IPC_F = ipc_enabled() ? 10 : 1;
+	int waited = 0;
 
-	do
+	while(1)
 	{
-		int i;
+		int result;
 
 		if(should_check_views_for_changes())
 		{
@@ -304,27 +334,197 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 
 		process_scheduled_updates();
 
-		for(i = 0; i < IPC_F; ++i)
+		ipc_check();
+
+		wtimeout(win, 0);
+		result = compat_wget_wch(win, c);
+		if(result != ERR)
 		{
-			int result;
+			/* Keys might refer to files of any view, so they shouldn't be processed
+			 * before lists are loaded. */
+			(void)load_deferred_views();
+			return result;
+		}
 
-			ipc_check();
-			wtimeout(win, MIN(cfg.min_timeout_len, timeout)/IPC_F);
+		if(timeout == 0 || (timeout < 0 && waited))
+		{
+			return ERR;
+		}
 
-			result = compat_wget_wch(win, c);
-			if(result != ERR)
-			{
-				return result;
-			}
+		/* Views that weren't loaded on startup are loaded only when there is no
+		 * input to process. */
+		if(vle_mode_get_primary() != MENU_MODE && load_deferred_views())
+		{
+			continue;
+		}
 
-			process_scheduled_updates();
+		timeout = wait_for_events(timeout);
+		waited = 1;
+	}
+}
+
+/* Loads lists of views whose loading was postponed and redraws UI afterwards.
+ * Returns non-zero if any of the views was loaded. */
+static int
+load_deferred_views(void)
+{
+	if(!ui_views_load_deferred())
+	{
+		return 0;
+	}
+
+	(void)vifm_chdir(flist_get_dir(curr_view));
+	modes_redraw();
+	return 1;
+}
+
+/* Blocks until something that might need processing happens or timeout (in
+ * milliseconds) expires.  Negative timeout means no limit.  Returns the rest
+ * of the timeout. */
+static int
+wait_for_events(int timeout)
+{
+	struct timeval start, end;
+	int elapsed;
+
+#ifndef _WIN32
+	struct pollfd fds[MAX_WAIT_FDS];
+	int nfds = 0;
+	int period = -1;
+
+	/* Descriptors that can't be waited on require periodic checks instead. */
+
+	add_wait_fd(fds, &nfds, STDIN_FILENO);
+	if(!add_wait_fd(fds, &nfds, signals_get_wakeup_fd()))
+	{
+		period = cfg.min_timeout_len;
+	}
+
+	if(!add_wait_fds(fds, &nfds, &ipc_get_fds))
+	{
+		period = min_period(period, cfg.min_timeout_len/10);
+	}
+
+	if(should_check_views_for_changes())
+	{
+		if(!add_view_fd(fds, &nfds, curr_view) ||
+				!add_view_fd(fds, &nfds, other_view))
+		{
+			period = min_period(period, cfg.min_timeout_len);
 		}
+	}
+
+	/* Jobs are checked by the main loop only after getting out of here. */
+	if(timeout < 0 && !add_wait_fds(fds, &nfds, &bg_jobs_get_fds))
+	{
+		period = min_period(period, cfg.min_timeout_len);
+	}
+
+	if(modes_needs_periodic())
+	{
+		period = min_period(period, cfg.min_timeout_len);
+	}
+
+	(void)gettimeofday(&start, NULL);
+	(void)poll(fds, nfds, min_period(timeout, period));
+	signals_clear_wakeup();
+	(void)gettimeofday(&end, NULL);
+#else
+	const int period = cfg.min_timeout_len/(ipc_enabled() ? 10 : 1);
 
-		timeout -= cfg.min_timeout_len;
+	(void)gettimeofday(&start, NULL);
+	(void)WaitForSingleObject(GetStdHandle(STD_INPUT_HANDLE),
+			min_period(timeout, period));
+	(void)gettimeofday(&end, NULL);
+#endif
+
+	if(timeout < 0)
+	{
+		return timeout;
+	}
+
+	elapsed = (end.tv_sec - start.tv_sec)*1000
+	        + (end.tv_usec - start.tv_usec)/1000;
+	return MAX(0, timeout - elapsed);
+}
+
+#ifndef _WIN32
+
+/* Adds file descriptor to the list of descriptors to wait on.  Returns non-zero
+ * if descriptor was added, otherwise (fd is -1 or there is no free space) zero
+ * is returned. */
+static int
+add_wait_fd(struct pollfd fds[], int *nfds, int fd)
+{
+	if(fd == -1 || *nfds == MAX_WAIT_FDS)
+	{
+		return 0;
 	}
-	while(timeout > 0);
 
-	return ERR;
+	fds[*nfds].fd = fd;
+	fds[*nfds].events = POLLIN;
+	fds[*nfds].revents = 0;
+	++*nfds;
+	return 1;
+}
+
+/* Adds file descriptor that reports changes of the view to the list of
+ * descriptors to wait on.  Returns zero if the view has to be polled, otherwise
+ * non-zero is returned. */
+static int
+add_view_fd(struct pollfd fds[], int *nfds, const FileView *view)
+{
+	if(!window_shows_dirlist(view))
+	{
+		return 1;
+	}
+
+	if(flist_needs_polling(view))
+	{
+		return 0;
+	}
+
+	return add_wait_fd(fds, nfds, flist_get_watch_fd(view));
+}
+
+/* Adds file descriptors provided by the function to the list of descriptors to
+ * wait on.  Returns zero if their source has to be polled, otherwise non-zero
+ * is returned. */
+static int
+add_wait_fds(struct pollfd fds[], int *nfds, get_fds_func get_fds)
+{
+	int new_fds[MAX_WAIT_FDS];
+	int i;
+
+	const int count = get_fds(new_fds, MAX_WAIT_FDS - *nfds);
+	if(count < 0)
+	{
+		return 0;
+	}
+
+	for(i = 0; i < count; ++i)
+	{
+		(void)add_wait_fd(fds, nfds, new_fds[i]);
+	}
+	return 1;
+}
+
+#endif
+
+/* Computes minimum of two periods, negative values of which mean infinity.
+ * Returns the minimum. */
+static int
+min_period(int a, int b)
+{
+	if(a < 0)
+	{
+		return b;
+	}
+	if(b < 0)
+	{
+		return a;
+	}
+	return MIN(a, b);
 }
 
 /* Updates TUI or its elements if something is scheduled. */
@@ -398,7 +598,7 @@ should_check_views_for_changes(void)
 static void
 check_view_for_changes(FileView *view)
 {
-	if(window_shows_dirlist(view))
+	if(window_shows_dirlist(view) && !view->load_deferred)
 	{
 		check_if_filelist_have_changed(view);
 	}
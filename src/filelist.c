@@ -32,6 +32,7 @@
 #include <unistd.h> /* close() fork() pipe() */
 
 #include <assert.h> /* assert() */
+#include <ctype.h> /* tolower() */
 #include <errno.h> /* errno */
 #include <stddef.h> /* NULL size_t */
 #include <stdint.h> /* uint64_t */
@@ -63,6 +64,7 @@
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/path.h"
+#include "utils/profiler.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
@@ -99,6 +101,14 @@ static void correct_list_pos_down(FileView *view, size_t pos_delta);
 static void correct_list_pos_up(FileView *view, size_t pos_delta);
 static void move_cursor_out_of_scope(FileView *view, predicate_func pred);
 static void navigate_to_history_pos(FileView *view, int pos);
+static int sel_size_is_valid(const FileView *view);
+static int find_in_history(const FileView *view, const char dir[], int from);
+static int hist_ring_pos(const FileView *view, int pos);
+static void hist_index_alloc(FileView *view, int size);
+static void hist_index_refill(FileView *view);
+static void hist_index_remove(FileView *view, int ring_pos);
+static int * hist_index_find(const FileView *view, const char dir[]);
+static size_t hash_path(const char path[]);
 static const char * get_last_ext(const char name[]);
 static void save_selection(FileView *view);
 static int navigate_to_file_in_custom_view(FileView *view, const char dir[],
@@ -119,22 +129,26 @@ static void revert_very_custom(FileView *view);
 static int is_in_list(FileView *view, const dir_entry_t *entry, void *arg);
 static void load_dir_list_internal(FileView *view, int reload, int draw_only);
 static int populate_dir_list_internal(FileView *view, int reload);
+static int fill_dir_list(FileView *view, int reload);
 static int update_dir_watcher(FileView *view);
+static int is_checked_for_changes(const FileView *view);
 static int custom_list_is_incomplete(const FileView *view);
 static int is_dead_or_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static void update_entries_data(FileView *view);
 static int is_dir_big(const char path[]);
 static void free_view_entries(FileView *view);
-static int update_dir_list(FileView *view, int reload);
+static int update_dir_list(FileView *view, int reload, int *kept_layout);
 static int add_file_entry_to_view(const char name[], const void *data,
 		void *param);
 static void sort_dir_list(int msg, FileView *view);
-static void merge_lists(FileView *view, dir_entry_t *entries, int len);
+static int merge_lists(FileView *view, dir_entry_t *entries, int len);
 static void add_to_trie(trie_t trie, FileView *view, dir_entry_t *entry);
 static int is_in_trie(trie_t trie, FileView *view, dir_entry_t *entry,
 		void **data);
 static void merge_entries(dir_entry_t *new, const dir_entry_t *prev);
+static int entry_looks_different(const dir_entry_t *new,
+		const dir_entry_t *prev);
 static int correct_pos(FileView *view, int pos, int dist, int closes);
 static int rescue_from_empty_filelist(FileView *view);
 static void init_dir_entry(FileView *view, dir_entry_t *entry,
@@ -237,6 +251,8 @@ init_view_history(FileView *view)
 		cfg.history_len /= 2;
 		view->history = calloc(cfg.history_len, sizeof(history_t));
 	}
+
+	hist_index_alloc(view, cfg.history_len);
 }
 
 void
@@ -296,6 +312,65 @@ recount_selected_files(FileView *view)
 	{
 		view->selected_files += (view->dir_entry[i].selected != 0);
 	}
+	view->selected_size_known = 0;
+}
+
+void
+flist_sel_entry(FileView *view, int pos, int select)
+{
+	dir_entry_t *const entry = &view->dir_entry[pos];
+
+	select = (select != 0);
+	if((entry->selected != 0) == select)
+	{
+		return;
+	}
+
+	if(sel_size_is_valid(view))
+	{
+		const uint64_t size = get_file_size_by_entry(view, pos);
+		view->selected_size = select ? view->selected_size + size
+		                             : view->selected_size - size;
+	}
+
+	entry->selected = select;
+	view->selected_files += select ? 1 : -1;
+	fview_damage_entry(view, pos);
+}
+
+uint64_t
+flist_sel_size(FileView *view)
+{
+	int i;
+
+	if(sel_size_is_valid(view))
+	{
+		return view->selected_size;
+	}
+
+	view->selected_size = 0U;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(view->dir_entry[i].selected)
+		{
+			view->selected_size += get_file_size_by_entry(view, i);
+		}
+	}
+
+	view->selected_size_known = 1;
+	view->selected_size_list_gen = view->list_generation;
+	view->selected_size_dcache_gen = dcache_generation();
+	return view->selected_size;
+}
+
+/* Checks whether total size of selected files of the view is up to date.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+sel_size_is_valid(const FileView *view)
+{
+	return view->selected_size_known
+	    && view->selected_size_list_gen == view->list_generation
+	    && view->selected_size_dcache_gen == dcache_generation();
 }
 
 int
@@ -454,7 +529,7 @@ navigate_backward_in_history(FileView *view)
 
 	while(pos >= 0)
 	{
-		const char *const dir = view->history[pos].dir;
+		const char *const dir = flist_hist_get(view, pos)->dir;
 		if(is_valid_dir(dir) && !paths_are_equal(view->curr_dir, dir))
 		{
 			break;
@@ -476,7 +551,7 @@ navigate_forward_in_history(FileView *view)
 
 	while(pos <= view->history_num - 1)
 	{
-		const char *const dir = view->history[pos].dir;
+		const char *const dir = flist_hist_get(view, pos)->dir;
 		if(is_valid_dir(dir) && !paths_are_equal(view->curr_dir, dir))
 		{
 			break;
@@ -496,8 +571,10 @@ navigate_forward_in_history(FileView *view)
 static void
 navigate_to_history_pos(FileView *view, int pos)
 {
+	const history_t *const item = flist_hist_get(view, pos);
+
 	curr_stats.drop_new_dir_hist = 1;
-	if(change_directory(view, view->history[pos].dir) < 0)
+	if(change_directory(view, item->dir) < 0)
 	{
 		curr_stats.drop_new_dir_hist = 0;
 		return;
@@ -505,7 +582,7 @@ navigate_to_history_pos(FileView *view, int pos)
 	curr_stats.drop_new_dir_hist = 0;
 
 	load_dir_list(view, 0);
-	flist_set_pos(view, find_file_pos_in_list(view, view->history[pos].file));
+	flist_set_pos(view, find_file_pos_in_list(view, item->file));
 
 	view->history_pos = pos;
 }
@@ -516,7 +593,7 @@ clean_positions_in_history(FileView *view)
 	int i;
 	for(i = 0; i <= view->history_pos && i < view->history_num; ++i)
 	{
-		view->history[i].file[0] = '\0';
+		flist_hist_get(view, i)->file[0] = '\0';
 	}
 }
 
@@ -529,6 +606,10 @@ save_view_history(FileView *view, const char path[], const char file[], int pos)
 	if(view->list_rows <= 0 && file == NULL)
 		return;
 
+	/* List of the view is a placeholder until it's loaded. */
+	if(view->load_deferred && file == NULL)
+		return;
+
 	if(cfg.history_len <= 0)
 		return;
 
@@ -543,13 +624,14 @@ save_view_history(FileView *view, const char path[], const char file[], int pos)
 		pos = view->list_pos;
 
 	if(view->history_num > 0 &&
-			stroscmp(view->history[view->history_pos].dir, path) == 0)
+			stroscmp(flist_hist_get(view, view->history_pos)->dir, path) == 0)
 	{
+		history_t *item;
 		if(curr_stats.load_stage < 2 || file[0] == '\0')
 			return;
-		x = view->history_pos;
-		(void)replace_string(&view->history[x].file, file);
-		view->history[x].rel_pos = pos - view->top_line;
+		item = flist_hist_get(view, view->history_pos);
+		(void)replace_string(&item->file, file);
+		item->rel_pos = pos - view->top_line;
 		return;
 	}
 
@@ -560,25 +642,36 @@ save_view_history(FileView *view, const char path[], const char file[], int pos)
 
 	if(view->history_num > 0 && view->history_pos != view->history_num - 1)
 	{
-		x = view->history_num - 1;
-		while(x > view->history_pos)
-			view->history[x--].dir[0] = '\0';
+		/* Forget locations that were visited after the current one. */
+		for(x = view->history_pos + 1; x < view->history_num; ++x)
+		{
+			history_t *const item = flist_hist_get(view, x);
+			cfg_free_history_items(item, 1);
+			item->dir = NULL;
+			item->file = NULL;
+		}
 		view->history_num = view->history_pos + 1;
+		hist_index_refill(view);
 	}
-	x = view->history_num;
 
-	if(x == cfg.history_len)
+	if(view->history_num == cfg.history_len)
 	{
-		cfg_free_history_items(view->history, 1);
-		memmove(view->history, view->history + 1,
-				sizeof(history_t)*(cfg.history_len - 1));
-
-		x--;
-		view->history_num = x;
+		/* The oldest item gives its place in the ring to the new one. */
+		hist_index_remove(view, view->history_head);
+		cfg_free_history_items(&view->history[view->history_head], 1);
+		view->history_head = (view->history_head + 1)%cfg.history_len;
+		--view->history_num;
 	}
+
+	x = hist_ring_pos(view, view->history_num);
 	view->history[x].dir = strdup(path);
 	view->history[x].file = strdup(file);
 	view->history[x].rel_pos = pos - view->top_line;
+	if(view->history_index != NULL && view->history[x].dir != NULL)
+	{
+		*hist_index_find(view, path) = x + 1;
+	}
+
 	view->history_num++;
 	view->history_pos = view->history_num - 1;
 }
@@ -586,17 +679,297 @@ save_view_history(FileView *view, const char path[], const char file[], int pos)
 int
 is_in_view_history(FileView *view, const char *path)
 {
-	int i;
-	if(view->history == NULL || view->history_num <= 0)
+	if(view->history == NULL)
 		return 0;
-	for(i = view->history_pos; i >= 0; i--)
+	return find_in_history(view, path, view->history_pos) >= 0;
+}
+
+/* Looks up the most recent item of directory history of the view for the dir
+ * that is located not after the from position.  Returns position of the item
+ * or -1 if there is no such item. */
+static int
+find_in_history(const FileView *view, const char dir[], int from)
+{
+	int pos;
+
+	if(view->history_num <= 0 || from < 0)
+	{
+		return -1;
+	}
+
+	if(view->history_index != NULL)
+	{
+		const int ring_pos = *hist_index_find(view, dir) - 1;
+		if(ring_pos < 0)
+		{
+			return -1;
+		}
+
+		pos = (ring_pos - view->history_head + cfg.history_len)%cfg.history_len;
+		if(pos <= from)
+		{
+			return pos;
+		}
+	}
+
+	/* Index knows only the most recent item, older ones are searched for
+	 * directly. */
+	for(pos = MIN(from, view->history_num - 1); pos >= 0; --pos)
 	{
-		if(strlen(view->history[i].dir) < 1)
+		if(stroscmp(flist_hist_get(view, pos)->dir, dir) == 0)
+		{
+			return pos;
+		}
+	}
+	return -1;
+}
+
+history_t *
+flist_hist_get(const FileView *view, int pos)
+{
+	return &view->history[hist_ring_pos(view, pos)];
+}
+
+void
+flist_hist_resize(FileView *view, int new_size)
+{
+	const int drop = MAX(view->history_num - new_size, 0);
+	const int drop_old = MIN(drop, view->history_pos);
+	history_t *history;
+	int i;
+
+	if(new_size <= 0)
+	{
+		flist_hist_clear(view);
+		free(view->history);
+		view->history = NULL;
+		hist_index_alloc(view, 0);
+		return;
+	}
+
+	history = calloc(new_size, sizeof(*history));
+	if(history == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < view->history_num; ++i)
+	{
+		history_t *const item = flist_hist_get(view, i);
+		if(i < drop_old || i - drop_old >= new_size)
+		{
+			cfg_free_history_items(item, 1);
+		}
+		else
+		{
+			history[i - drop_old] = *item;
+		}
+	}
+
+	free(view->history);
+	view->history = history;
+	view->history_head = 0;
+	view->history_num -= drop;
+	view->history_pos -= drop_old;
+
+	hist_index_alloc(view, new_size);
+}
+
+void
+flist_hist_clear(FileView *view)
+{
+	int i;
+	for(i = 0; i < view->history_num; ++i)
+	{
+		history_t *const item = flist_hist_get(view, i);
+		cfg_free_history_items(item, 1);
+		item->dir = NULL;
+		item->file = NULL;
+	}
+
+	view->history_num = 0;
+	view->history_pos = 0;
+	view->history_head = 0;
+	hist_index_refill(view);
+}
+
+void
+flist_hist_compact(FileView *view)
+{
+	int i, j;
+
+	j = 0;
+	for(i = 0; i < view->history_num; ++i)
+	{
+		history_t *const item = flist_hist_get(view, i);
+
+		if(item->dir == NULL)
+		{
+			free(item->file);
+			item->file = NULL;
+			continue;
+		}
+
+		if(j != i)
+		{
+			*flist_hist_get(view, j) = *item;
+
+			item->dir = NULL;
+			item->file = NULL;
+			item->rel_pos = -1;
+		}
+
+		if(view->history_pos == i)
+		{
+			view->history_pos = j;
+		}
+
+		++j;
+	}
+	view->history_num = j;
+
+	hist_index_refill(view);
+}
+
+/* Maps position of directory history item to its index in the ring.  Returns
+ * the index. */
+static int
+hist_ring_pos(const FileView *view, int pos)
+{
+	return (view->history_head + pos)%cfg.history_len;
+}
+
+/* Replaces index of directory history with a new one suitable for history of
+ * specified size.  Lookups fall back to scanning the history if index can't be
+ * allocated. */
+static void
+hist_index_alloc(FileView *view, int size)
+{
+	size_t index_size = 16U;
+
+	free(view->history_index);
+	view->history_index = NULL;
+	view->history_index_size = 0U;
+
+	if(size <= 0)
+	{
+		return;
+	}
+
+	while(index_size < (size_t)size*2U)
+	{
+		index_size *= 2U;
+	}
+
+	view->history_index = calloc(index_size, sizeof(*view->history_index));
+	if(view->history_index != NULL)
+	{
+		view->history_index_size = index_size;
+		hist_index_refill(view);
+	}
+}
+
+/* Fills index of directory history with its items discarding previous contents
+ * of the index. */
+static void
+hist_index_refill(FileView *view)
+{
+	int i;
+
+	if(view->history_index == NULL)
+	{
+		return;
+	}
+
+	memset(view->history_index, 0,
+			sizeof(*view->history_index)*view->history_index_size);
+	for(i = 0; i < view->history_num; ++i)
+	{
+		const int ring_pos = hist_ring_pos(view, i);
+		if(view->history[ring_pos].dir != NULL)
+		{
+			*hist_index_find(view, view->history[ring_pos].dir) = ring_pos + 1;
+		}
+	}
+}
+
+/* Removes item of directory history at specified index of the ring from the
+ * index of the history if it's the most recent item for its directory, moving
+ * slots that follow it closer to their preferred places so that they remain
+ * reachable. */
+static void
+hist_index_remove(FileView *view, int ring_pos)
+{
+	const size_t mask = view->history_index_size - 1U;
+	int *slot;
+	size_t hole, i;
+
+	if(view->history_index == NULL || view->history[ring_pos].dir == NULL)
+	{
+		return;
+	}
+
+	slot = hist_index_find(view, view->history[ring_pos].dir);
+	if(*slot != ring_pos + 1)
+	{
+		return;
+	}
+
+	hole = slot - view->history_index;
+	i = hole;
+	while(1)
+	{
+		size_t home;
+
+		i = (i + 1U) & mask;
+		if(view->history_index[i] == 0)
+		{
 			break;
-		if(stroscmp(view->history[i].dir, path) == 0)
-			return 1;
+		}
+
+		/* Slot can fill the hole only if the hole lies on its probing path. */
+		home = hash_path(view->history[view->history_index[i] - 1].dir) & mask;
+		if(((i - home) & mask) >= ((i - hole) & mask))
+		{
+			view->history_index[hole] = view->history_index[i];
+			hole = i;
+		}
 	}
-	return 0;
+	view->history_index[hole] = 0;
+}
+
+/* Looks up directory in index of directory history, which must be allocated.
+ * Returns pointer to the slot that corresponds to the directory or to empty
+ * slot where it should be put. */
+static int *
+hist_index_find(const FileView *view, const char dir[])
+{
+	const size_t mask = view->history_index_size - 1U;
+	size_t i = hash_path(dir) & mask;
+	while(view->history_index[i] != 0 &&
+			stroscmp(view->history[view->history_index[i] - 1].dir, dir) != 0)
+	{
+		i = (i + 1U) & mask;
+	}
+	return &view->history_index[i];
+}
+
+/* Computes FNV-1a hash of the path consistently with how paths are compared by
+ * stroscmp().  Returns the hash. */
+static size_t
+hash_path(const char path[])
+{
+	size_t hash = 2166136261U;
+	while(*path != '\0')
+	{
+#ifndef _WIN32
+		const unsigned char c = *path++;
+#else
+		const unsigned char c = tolower((unsigned char)*path++);
+#endif
+		hash = (hash ^ c)*16777619U;
+	}
+	return hash;
 }
 
 static void
@@ -607,26 +980,15 @@ check_view_dir_history(FileView *view)
 
 	if(cfg.history_len > 0 && view->history_num > 0 && curr_stats.ch_pos)
 	{
-		int x;
-		int found = 0;
-		x = view->history_pos;
-		if(stroscmp(view->history[x].dir, view->curr_dir) == 0 &&
-				view->history[x].file[0] == '\0')
+		const history_t *const item = flist_hist_get(view, view->history_pos);
+		int x = view->history_pos;
+		if(stroscmp(item->dir, view->curr_dir) == 0 && item->file[0] == '\0')
 			x--;
-		for(; x >= 0; x--)
-		{
-			if(view->history[x].dir[0] == '\0')
-				break;
-			if(stroscmp(view->history[x].dir, view->curr_dir) == 0)
-			{
-				found = 1;
-				break;
-			}
-		}
-		if(found)
+		x = find_in_history(view, view->curr_dir, x);
+		if(x >= 0)
 		{
-			pos = find_file_pos_in_list(view, view->history[x].file);
-			rel_pos = view->history[x].rel_pos;
+			pos = find_file_pos_in_list(view, flist_hist_get(view, x)->file);
+			rel_pos = flist_hist_get(view, x)->rel_pos;
 		}
 		else if(path_starts_with(view->last_dir, view->curr_dir) &&
 				stroscmp(view->last_dir, view->curr_dir) != 0 &&
@@ -933,7 +1295,7 @@ save_selection(FileView *view)
 
 		if(is_parent_dir(entry->name))
 		{
-			entry->selected = 0;
+			flist_sel_entry(view, entry - view->dir_entry, 0);
 			continue;
 		}
 
@@ -956,9 +1318,19 @@ erase_selection(FileView *view)
 	int i;
 	for(i = 0; i < view->list_rows; ++i)
 	{
-		view->dir_entry[i].selected = 0;
+		if(view->dir_entry[i].selected)
+		{
+			view->dir_entry[i].selected = 0;
+			fview_damage_entry(view, i);
+		}
 	}
 	view->selected_files = 0;
+
+	/* Empty selection has known size. */
+	view->selected_size = 0U;
+	view->selected_size_known = 1;
+	view->selected_size_list_gen = view->list_generation;
+	view->selected_size_dcache_gen = dcache_generation();
 }
 
 void
@@ -974,6 +1346,7 @@ invert_selection(FileView *view)
 		}
 	}
 	view->selected_files = view->list_rows - view->selected_files;
+	view->selected_size_known = 0;
 }
 
 void
@@ -1010,8 +1383,7 @@ flist_sel_restore(FileView *view, reg_t *reg)
 		get_full_path_of(entry, sizeof(full_path), full_path);
 		if(trie_get(selection_trie, full_path, &ignored_data) == 0)
 		{
-			entry->selected = 1;
-			++view->selected_files;
+			flist_sel_entry(view, i, 1);
 
 			/* Assuming that selection is usually contiguous it makes sense to quit
 			 * when we found all elements to optimize this operation. */
@@ -1882,7 +2254,12 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 		return;
 	}
 
-	if(draw_only)
+	if(reload)
+	{
+		/* Reloading might have changed only some of the entries. */
+		fview_draw_damaged(view);
+	}
+	else if(draw_only)
 	{
 		draw_dir_list_only(view);
 	}
@@ -1901,11 +2278,28 @@ load_dir_list_internal(FileView *view, int reload, int draw_only)
 	}
 }
 
+/* Loads filelist for the view and records time it took for startup profile.
+ * The reload parameter should be set in case of view refresh operation.
+ * Returns non-zero on error. */
+static int
+populate_dir_list_internal(FileView *view, int reload)
+{
+	const int prof_id = prof_enter(reload ? "reload" : "load", view->curr_dir);
+	int result;
+
+	view->load_deferred = 0;
+	result = fill_dir_list(view, reload);
+	prof_leave(prof_id);
+	return result;
+}
+
 /* Loads filelist for the view.  The reload parameter should be set in case of
  * view refresh operation.  Returns non-zero on error. */
 static int
-populate_dir_list_internal(FileView *view, int reload)
+fill_dir_list(FileView *view, int reload)
 {
+	int kept_layout = 0;
+
 	view->filtered = 0;
 
 	if(flist_custom_active(view))
@@ -1945,7 +2339,7 @@ populate_dir_list_internal(FileView *view, int reload)
 		return 1;
 	}
 
-	if(update_dir_list(view, reload) != 0)
+	if(update_dir_list(view, reload, &kept_layout) != 0)
 	{
 		/* We don't have read access, only execute, or there were other problems. */
 		free_view_entries(view);
@@ -1976,9 +2370,17 @@ populate_dir_list_internal(FileView *view, int reload)
 		}
 
 		add_parent_dir(view);
+		kept_layout = 0;
 	}
 
-	fview_list_updated(view);
+	if(kept_layout)
+	{
+		fview_entries_updated(view);
+	}
+	else
+	{
+		fview_list_updated(view);
+	}
 
 	if(update_dir_watcher(view) != 0 && !is_unc_root(view->curr_dir))
 	{
@@ -2109,6 +2511,11 @@ zap_entries(FileView *view, dir_entry_t *entries, int *count, zap_filter filter,
 		add_parent_dir(view);
 	}
 
+	if(i != j && entries == view->dir_entry)
+	{
+		fview_list_updated(view);
+	}
+
 	return i - j;
 }
 
@@ -2138,10 +2545,11 @@ free_view_entries(FileView *view)
 	free_dir_entries(view, &view->dir_entry, &view->list_rows);
 }
 
-/* Updates file list with files from current directory.  Returns zero on
- * success, otherwise non-zero is returned. */
+/* Updates file list with files from current directory.  On reload,
+ * *kept_layout is set to whether the list consists of the same files in the
+ * same order.  Returns zero on success, otherwise non-zero is returned. */
 static int
-update_dir_list(FileView *view, int reload)
+update_dir_list(FileView *view, int reload, int *kept_layout)
 {
 	dir_entry_t *prev_dir_entries = NULL;
 	int prev_list_rows = 0;
@@ -2183,15 +2591,21 @@ update_dir_list(FileView *view, int reload)
 		add_parent_dir(view);
 	}
 
-	sort_dir_list(!reload, view);
-
 	if(reload)
 	{
+		/* Notification about list update is left to the caller, because it's
+		 * unknown at this point whether list actually changed. */
+		sort_view(view);
+
 		/* Merging must be performed after sorting so that list position remains
 		 * fixed (sorting doesn't preserve it). */
-		merge_lists(view, prev_dir_entries, prev_list_rows);
+		*kept_layout = merge_lists(view, prev_dir_entries, prev_list_rows);
 		free_dir_entries(view, &prev_dir_entries, &prev_list_rows);
 	}
+	else
+	{
+		sort_dir_list(1, view);
+	}
 
 	view->dir_entry = dynarray_shrink(view->dir_entry);
 
@@ -2275,6 +2689,7 @@ sort_dir_list(int msg, FileView *view)
 	}
 
 	sort_view(view);
+	fview_list_updated(view);
 
 	if(msg && !vle_mode_is(CMDLINE_MODE))
 	{
@@ -2282,11 +2697,15 @@ sort_dir_list(int msg, FileView *view)
 	}
 }
 
-/* Merges elements from previous list into the new one. */
-static void
+/* Merges elements from previous list into the new one.  Entries that remained
+ * at the same position, but look differently, are marked as damaged.  Returns
+ * non-zero if the list consists of the same files in the same order as
+ * before, otherwise zero is returned. */
+static int
 merge_lists(FileView *view, dir_entry_t *entries, int len)
 {
 	int i;
+	int kept_layout = (len == view->list_rows);
 	int closes_dist;
 	const int prev_pos = view->list_pos;
 	trie_t prev_names = trie_create();
@@ -2307,9 +2726,21 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 		dir_entry_t *const entry = &view->dir_entry[i];
 		if(!is_in_trie(prev_names, view, entry, &data))
 		{
+			kept_layout = 0;
 			continue;
 		}
 
+		/* Type affects width of file name decorations. */
+		if((dir_entry_t *)data - entries != i ||
+				entry->type != ((dir_entry_t *)data)->type)
+		{
+			kept_layout = 0;
+		}
+		else if(entry_looks_different(entry, data))
+		{
+			fview_damage_entry(view, i);
+		}
+
 		/* Transfer information from previous entry to the new one. */
 		merge_entries(entry, data);
 
@@ -2322,6 +2753,7 @@ merge_lists(FileView *view, dir_entry_t *entries, int len)
 	}
 
 	trie_free(prev_names);
+	return kept_layout;
 }
 
 /* Adds view entry into the trie mapping its name to entry structure. */
@@ -2383,6 +2815,27 @@ merge_entries(dir_entry_t *new, const dir_entry_t *prev)
 	}
 }
 
+/* Checks whether new entry of the same type might be displayed differently
+ * than the previous one for the same file.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+entry_looks_different(const dir_entry_t *new, const dir_entry_t *prev)
+{
+	return new->size != prev->size
+#ifndef _WIN32
+	    || new->uid != prev->uid
+	    || new->gid != prev->gid
+	    || new->mode != prev->mode
+#else
+	    || new->attrs != prev->attrs
+#endif
+	    || new->mtime != prev->mtime
+	    || new->atime != prev->atime
+	    || new->ctime != prev->ctime
+	    || new->nlinks != prev->nlinks
+	    || prev->search_match != 0;
+}
+
 /* Corrects selected item position in the list.  Returns updated value of the
  * closes variable, which initially should be INT_MIN. */
 static int
@@ -2606,8 +3059,7 @@ check_if_filelist_have_changed(FileView *view)
 {
 	int failed, changed;
 
-	if(view->on_slow_fs || flist_custom_active(view) ||
-			is_unc_root(view->curr_dir))
+	if(!is_checked_for_changes(view))
 	{
 		return;
 	}
@@ -2648,6 +3100,33 @@ check_if_filelist_have_changed(FileView *view)
 	}
 }
 
+int
+flist_get_watch_fd(const FileView *view)
+{
+	if(!is_checked_for_changes(view) || view->watch == NULL)
+	{
+		return -1;
+	}
+	return fswatch_get_fd(view->watch);
+}
+
+int
+flist_needs_polling(const FileView *view)
+{
+	return is_checked_for_changes(view)
+	    && (view->watch == NULL || fswatch_get_fd(view->watch) == -1);
+}
+
+/* Checks whether directory of the view is to be checked for external changes.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_checked_for_changes(const FileView *view)
+{
+	return !view->on_slow_fs
+	    && !flist_custom_active(view)
+	    && !is_unc_root(view->curr_dir);
+}
+
 int
 cd_is_possible(const char *path)
 {
@@ -3171,8 +3650,7 @@ mark_selection_or_current(FileView *view)
 {
 	if(view->selected_files == 0)
 	{
-		view->dir_entry[view->list_pos].selected = 1;
-		view->selected_files = 1;
+		flist_sel_entry(view, view->list_pos, 1);
 	}
 	mark_selected(view);
 }
@@ -154,8 +154,18 @@ void invert_selection(FileView *view);
  * restored, otherwise list of files to restore is taken from the register. */
 void flist_sel_restore(FileView *view, reg_t *reg);
 /* Counts number of selected files and writes saves the number in
- * view->selected_files. */
+ * view->selected_files.  Should be called after changing selection of multiple
+ * entries directly. */
 void recount_selected_files(FileView *view);
+/* Selects (when select is non-zero) or unselects entry of the view at specified
+ * position keeping number and size of selected files up to date and marking
+ * the entry for redraw. */
+void flist_sel_entry(FileView *view, int pos, int select);
+/* Computes total size of selected files of the view.  The size is maintained
+ * on changing selection of single entries, so it's recomputed only after bulk
+ * changes of selection, changes of the list or of sizes of directories.
+ * Returns the size. */
+uint64_t flist_sel_size(FileView *view);
 /* Remove dot and regexp filters if it's needed to make file visible.  Returns
  * non-zero if file was found. */
 int ensure_file_is_selected(FileView *view, const char name[]);
@@ -177,6 +187,19 @@ void save_view_history(FileView *view, const char path[], const char file[],
 		int pos);
 int is_in_view_history(FileView *view, const char *path);
 void clean_positions_in_history(FileView *view);
+/* Retrieves item of directory history of the view by its position, which
+ * should be in the [0; history_num) range.  The first item is the oldest one.
+ * Returns pointer to the item. */
+history_t * flist_hist_get(const FileView *view, int pos);
+/* Changes capacity of directory history of the view from cfg.history_len to
+ * new_size dropping items that don't fit, the oldest ones first unless they
+ * precede current position.  Zero new_size frees the history. */
+void flist_hist_resize(FileView *view, int new_size);
+/* Removes all items of directory history of the view. */
+void flist_hist_clear(FileView *view);
+/* Removes items of directory history of the view that have NULL dir field
+ * keeping order of the rest of them. */
+void flist_hist_compact(FileView *view);
 
 /* Typed (with trailing slash for directories) file name function. */
 
@@ -223,6 +246,13 @@ dir_entry_t * get_current_entry(FileView *view);
 /* Checks whether content in the current directory of the view changed and
  * reloads the view if so. */
 void check_if_filelist_have_changed(FileView *view);
+/* Retrieves file descriptor that signals about changes in the current directory
+ * of the view.  Returns the descriptor or -1 if there is none. */
+int flist_get_watch_fd(const FileView *view);
+/* Checks whether the view has to be checked for changes periodically as there
+ * is no way to get notified about them.  Returns non-zero if so, otherwise zero
+ * is returned. */
+int flist_needs_polling(const FileView *view);
 /* Checks whether cd'ing into path is possible. Shows cd errors to a user.
  * Returns non-zero if it's possible, zero otherwise. */
 int cd_is_possible(const char *path);
@@ -63,6 +63,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trie.h"
 #include "utils/utils.h"
 #include "background.h"
 #include "cmd_completion.h"
@@ -154,6 +155,10 @@ static int prepare_register(int reg);
 static void delete_files_in_bg(bg_op_t *bg_op, void *arg);
 static void delete_file_in_bg(ops_t *ops, const char path[], int use_trash);
 TSTATIC int is_name_list_ok(int count, int nlines, char *list[], char *files[]);
+static int add_new_name(trie_t names, const char name[]);
+static trie_t index_entries(dir_entry_t entries[], int count);
+static void rename_indexed_entry(trie_t index, const char path[],
+		const char new_name[]);
 TSTATIC int is_rename_list_ok(char *files[], int *is_dup, int len,
 		char *list[]);
 TSTATIC const char * incdec_name(const char fname[], int k);
@@ -188,7 +193,7 @@ static void reset_put_confirm(OPS main_op, const char descr[],
 static int put_files_i(FileView *view, int start);
 static int put_next(int force);
 static RenameAction check_rename(const char old_fname[], const char new_fname[],
-		char **dest, int ndest);
+		trie_t dest_names);
 static int rename_marked(FileView *view, const char desc[], const char lhs[],
 		const char rhs[], char **dest);
 static void fixup_entry_after_rename(FileView *view, dir_entry_t *entry,
@@ -579,7 +584,7 @@ yank_files(FileView *view, int reg)
 		char full_path[PATH_MAX];
 		get_full_path_of(entry, sizeof(full_path), full_path);
 
-		if(regs_append(reg, full_path) == 0)
+		if(regs_append_listed(reg, full_path) == 0)
 		{
 			++nyanked_files;
 		}
@@ -960,6 +965,7 @@ TSTATIC int
 is_name_list_ok(int count, int nlines, char *list[], char *files[])
 {
 	int i;
+	trie_t names;
 
 	if(nlines < count)
 	{
@@ -975,6 +981,13 @@ is_name_list_ok(int count, int nlines, char *list[], char *files[])
 		return 0;
 	}
 
+	names = trie_create();
+	if(names == NULL_TRIE)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 0;
+	}
+
 	for(i = 0; i < count; ++i)
 	{
 		chomp(list[i]);
@@ -993,19 +1006,40 @@ is_name_list_ok(int count, int nlines, char *list[], char *files[])
 					else
 						status_bar_errorf("Won't move \"%s\" file", files[i]);
 					curr_stats.save_msg = 1;
+					trie_free(names);
 					return 0;
 				}
 			}
 		}
 
-		if(list[i][0] != '\0' && is_in_string_array(list, i, list[i]))
+		if(list[i][0] != '\0' && !add_new_name(names, list[i]))
 		{
-			status_bar_errorf("Name \"%s\" duplicates", list[i]);
 			curr_stats.save_msg = 1;
+			trie_free(names);
 			return 0;
 		}
 	}
 
+	trie_free(names);
+	return 1;
+}
+
+/* Remembers new name in the set of names checking that it's unique.  Returns
+ * non-zero on success, otherwise zero is returned and error is reported. */
+static int
+add_new_name(trie_t names, const char name[])
+{
+	const int result = trie_put(names, name);
+	if(result < 0)
+	{
+		status_bar_error("Not enough memory");
+		return 0;
+	}
+	if(result > 0)
+	{
+		status_bar_errorf("Name \"%s\" duplicates", name);
+		return 0;
+	}
 	return 1;
 }
 
@@ -1019,6 +1053,8 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 	int i;
 	int renamed = 0;
 	const char *const curr_dir = flist_get_dir(view);
+	char curr_path[PATH_MAX];
+	trie_t entries = NULL_TRIE, custom_entries = NULL_TRIE;
 
 	buf_len = snprintf(buf, sizeof(buf), "rename in %s: ",
 			replace_home_part(curr_dir));
@@ -1034,6 +1070,17 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 				files[i], list[i]);
 	}
 
+	/* For regular views only entry under the cursor is of interest, while custom
+	 * views need all renamed entries to be found, so index them to avoid
+	 * searching through the whole list for every file. */
+	get_current_full_path(view, sizeof(curr_path), curr_path);
+	if(flist_custom_active(view))
+	{
+		entries = index_entries(view->dir_entry, view->list_rows);
+		custom_entries = index_entries(view->custom.entries,
+				view->custom.entry_count);
+	}
+
 	cmd_group_begin(buf);
 
 	for(i = 0; i < len; i++)
@@ -1058,6 +1105,8 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 			}
 			show_error_msg("Rename", "Failed to perform temporary rename");
 			curr_stats.save_msg = 1;
+			trie_free(entries);
+			trie_free(custom_entries);
 			return 0;
 		}
 		(void)replace_string(&files[i], unique_name);
@@ -1074,46 +1123,70 @@ perform_renaming(FileView *view, char **files, int *is_dup, int len,
 				is_dup[i] ? OP_MOVETMP1 : OP_MOVE, 1, NULL) == 0)
 		{
 			char path[PATH_MAX];
-			dir_entry_t *entry;
-			int pos;
+			const char *const new_name = get_last_path_component(list[i]);
 
 			++renamed;
 
 			make_full_path(curr_dir, files[i], path, sizeof(path));
-			entry = entry_from_path(view->dir_entry, view->list_rows, path);
-			if(entry == NULL)
+
+			/* For regular views rename file in internal structures for correct
+			 * positioning of cursor after reloading. For custom views rename to
+			 * prevent files from disappearing. */
+			if(flist_custom_active(view))
 			{
-				continue;
+				rename_indexed_entry(entries, path, new_name);
+				rename_indexed_entry(custom_entries, path, new_name);
 			}
-
-			pos = entry_to_pos(view, entry);
-			if(pos == view->list_pos || flist_custom_active(view))
+			else if(paths_are_equal(path, curr_path))
 			{
-				const char *const new_name = get_last_path_component(list[i]);
-
-				/* For regular views rename file in internal structures for correct
-				 * positioning of cursor after reloading. For custom views rename to
-				 * prevent files from disappearing. */
-				fentry_rename(entry, new_name);
-
-				if(flist_custom_active(view))
-				{
-					entry = entry_from_path(view->custom.entries,
-							view->custom.entry_count, path);
-					if(entry != NULL)
-					{
-						fentry_rename(entry, new_name);
-					}
-				}
+				fentry_rename(get_current_entry(view), new_name);
 			}
 		}
 	}
 
 	cmd_group_end();
 
+	trie_free(entries);
+	trie_free(custom_entries);
 	return renamed;
 }
 
+/* Builds index of entries by their full paths.  Returns the index, which is
+ * NULL_TRIE on error. */
+static trie_t
+index_entries(dir_entry_t entries[], int count)
+{
+	int i;
+	trie_t index = trie_create();
+
+	for(i = 0; i < count && index != NULL_TRIE; ++i)
+	{
+		char full_path[PATH_MAX];
+		get_full_path_of(&entries[i], sizeof(full_path), full_path);
+		if(trie_set(index, full_path, &entries[i]) < 0)
+		{
+			trie_free(index);
+			index = NULL_TRIE;
+		}
+	}
+
+	return index;
+}
+
+/* Renames entry found by its path in the index built by index_entries(). */
+static void
+rename_indexed_entry(trie_t index, const char path[], const char new_name[])
+{
+	char canonic_path[PATH_MAX];
+	void *entry;
+
+	if(to_canonic_path(path, canonic_path, sizeof(canonic_path)) == 0 &&
+			trie_get(index, canonic_path, &entry) == 0)
+	{
+		fentry_rename(entry, new_name);
+	}
+}
+
 static void
 rename_files_ind(FileView *view, char **files, int *is_dup, int len)
 {
@@ -1256,9 +1329,30 @@ TSTATIC int
 is_rename_list_ok(char *files[], int *is_dup, int len, char *list[])
 {
 	int i;
+	trie_t dup_marks;
+
+	dup_marks = trie_create();
+	if(dup_marks == NULL_TRIE)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+		return 0;
+	}
+
+	/* Map each original name to its duplication mark.  Going backwards makes the
+	 * first of equal names win. */
+	for(i = len - 1; i >= 0; --i)
+	{
+		if(trie_set(dup_marks, files[i], &is_dup[i]) < 0)
+		{
+			show_error_msg("Memory Error", "Unable to allocate enough memory");
+			trie_free(dup_marks);
+			return 0;
+		}
+	}
+
 	for(i = 0; i < len; i++)
 	{
-		int j;
+		void *data;
 
 		const int check_result =
 			check_file_rename(curr_view->curr_dir, files[i], list[i], ST_NONE);
@@ -1267,19 +1361,17 @@ is_rename_list_ok(char *files[], int *is_dup, int len, char *list[])
 			continue;
 		}
 
-		for(j = 0; j < len; j++)
+		if(trie_get(dup_marks, list[i], &data) == 0 && !*(int *)data)
 		{
-			if(strcmp(list[i], files[j]) == 0 && !is_dup[j])
-			{
-				is_dup[j] = 1;
-				break;
-			}
+			*(int *)data = 1;
 		}
-		if(j >= len && check_result == 0)
+		else if(check_result == 0)
 		{
 			break;
 		}
 	}
+
+	trie_free(dup_marks);
 	return i >= len;
 }
 
@@ -2835,6 +2927,7 @@ substitute_in_names(FileView *view, const char pattern[], const char sub[],
 	regex_t re;
 	char **dest;
 	int ndest;
+	trie_t dest_names;
 	int cflags;
 	dir_entry_t *entry;
 	int err, save_msg;
@@ -2864,6 +2957,14 @@ substitute_in_names(FileView *view, const char pattern[], const char sub[],
 		return 1;
 	}
 
+	dest_names = trie_create();
+	if(dest_names == NULL_TRIE)
+	{
+		status_bar_error("Not enough memory");
+		regfree(&re);
+		return 1;
+	}
+
 	entry = NULL;
 	ndest = 0;
 	dest = NULL;
@@ -2889,7 +2990,7 @@ substitute_in_names(FileView *view, const char pattern[], const char sub[],
 			new_fname = substitute_regexp(entry->name, sub, matches, NULL);
 		}
 
-		action = check_rename(entry->name, new_fname, dest, ndest);
+		action = check_rename(entry->name, new_fname, dest_names);
 		switch(action)
 		{
 			case RA_SKIP:
@@ -2900,6 +3001,11 @@ substitute_in_names(FileView *view, const char pattern[], const char sub[],
 				break;
 			case RA_RENAME:
 				ndest = add_to_string_array(&dest, ndest, 1, new_fname);
+				if(trie_put(dest_names, new_fname) < 0)
+				{
+					status_bar_error("Not enough memory");
+					err = 1;
+				}
 				break;
 
 			default:
@@ -2920,6 +3026,7 @@ substitute_in_names(FileView *view, const char pattern[], const char sub[],
 	}
 
 	free_string_array(dest, ndest);
+	trie_free(dest_names);
 
 	return save_msg;
 }
@@ -2947,6 +3054,7 @@ tr_in_names(FileView *view, const char from[], const char to[])
 {
 	char **dest;
 	int ndest;
+	trie_t dest_names;
 	dir_entry_t *entry;
 	int err, save_msg;
 
@@ -2957,6 +3065,13 @@ tr_in_names(FileView *view, const char from[], const char to[])
 		return 0;
 	}
 
+	dest_names = trie_create();
+	if(dest_names == NULL_TRIE)
+	{
+		status_bar_error("Not enough memory");
+		return 1;
+	}
+
 	entry = NULL;
 	ndest = 0;
 	dest = NULL;
@@ -2968,7 +3083,7 @@ tr_in_names(FileView *view, const char from[], const char to[])
 
 		new_fname = substitute_tr(entry->name, from, to);
 
-		action = check_rename(entry->name, new_fname, dest, ndest);
+		action = check_rename(entry->name, new_fname, dest_names);
 		switch(action)
 		{
 			case RA_SKIP:
@@ -2979,6 +3094,11 @@ tr_in_names(FileView *view, const char from[], const char to[])
 				break;
 			case RA_RENAME:
 				ndest = add_to_string_array(&dest, ndest, 1, new_fname);
+				if(trie_put(dest_names, new_fname) < 0)
+				{
+					status_bar_error("Not enough memory");
+					err = 1;
+				}
 				break;
 
 			default:
@@ -2997,6 +3117,7 @@ tr_in_names(FileView *view, const char from[], const char to[])
 	}
 
 	free_string_array(dest, ndest);
+	trie_free(dest_names);
 
 	return save_msg;
 }
@@ -3004,9 +3125,10 @@ tr_in_names(FileView *view, const char from[], const char to[])
 /* Evaluates possibility of renaming old_fname to new_fname.  Returns
  * resolution. */
 static RenameAction
-check_rename(const char old_fname[], const char new_fname[], char **dest,
-		int ndest)
+check_rename(const char old_fname[], const char new_fname[], trie_t dest_names)
 {
+	void *data;
+
 	/* Compare case sensitive strings even on Windows to let user rename file
 	 * changing only case of some characters. */
 	if(strcmp(old_fname, new_fname) == 0)
@@ -3014,7 +3136,7 @@ check_rename(const char old_fname[], const char new_fname[], char **dest,
 		return RA_SKIP;
 	}
 
-	if(is_in_string_array(dest, ndest, new_fname))
+	if(trie_get(dest_names, new_fname, &data) == 0)
 	{
 		status_bar_errorf("Name \"%s\" duplicates", new_fname);
 		return RA_FAIL;
@@ -3043,6 +3165,7 @@ change_case(FileView *view, int to_upper)
 {
 	char **dest;
 	int ndest;
+	trie_t dest_names;
 	dir_entry_t *entry;
 	int save_msg;
 	int err;
@@ -3052,6 +3175,13 @@ change_case(FileView *view, int to_upper)
 		return 0;
 	}
 
+	dest_names = trie_create();
+	if(dest_names == NULL_TRIE)
+	{
+		status_bar_error("Not enough memory");
+		return 1;
+	}
+
 	entry = NULL;
 	ndest = 0;
 	dest = NULL;
@@ -3060,6 +3190,7 @@ change_case(FileView *view, int to_upper)
 	{
 		const char *const old_fname = entry->name;
 		char new_fname[NAME_MAX];
+		void *data;
 
 		/* Ignore too small buffer errors by not caring about part that didn't
 		 * fit. */
@@ -3078,7 +3209,7 @@ change_case(FileView *view, int to_upper)
 			continue;
 		}
 
-		if(is_in_string_array(dest, ndest, new_fname))
+		if(trie_get(dest_names, new_fname, &data) == 0)
 		{
 			status_bar_errorf("Name \"%s\" duplicates", new_fname);
 			err = 1;
@@ -3092,6 +3223,12 @@ change_case(FileView *view, int to_upper)
 		}
 
 		ndest = add_to_string_array(&dest, ndest, 1, new_fname);
+		if(trie_put(dest_names, new_fname) < 0)
+		{
+			status_bar_error("Not enough memory");
+			err = 1;
+			break;
+		}
 	}
 
 	if(err)
@@ -3104,6 +3241,7 @@ change_case(FileView *view, int to_upper)
 	}
 
 	free_string_array(dest, ndest);
+	trie_free(dest_names);
 
 	return save_msg;
 }
@@ -23,12 +23,13 @@
 #include <ctype.h> /* isspace() */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strchr() strdup() strcasecmp() */
+#include <string.h> /* strchr() strcmp() strdup() strcasecmp() */
 
 #include "compat/fs_limits.h"
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "utils/matcher.h"
+#include "utils/matcher_index.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 
@@ -51,6 +52,8 @@ static external_command_exists_t external_command_exists_func;
 
 static const char * find_existing_cmd(const assoc_list_t *record_list,
 		const char file[]);
+static int find_next_match(const assoc_list_t *record_list, const char file[],
+		int from);
 static assoc_record_t find_existing_cmd_record(const assoc_records_t *records);
 static void assoc_programs(matcher_t *matcher, const assoc_records_t *programs,
 		int for_x, int in_x);
@@ -59,6 +62,7 @@ static void register_assoc(assoc_t assoc, int for_x, int in_x);
 static assoc_records_t clone_all_matching_records(const char file[],
 		const assoc_list_t *record_list);
 static void add_assoc(assoc_list_t *assoc_list, assoc_t assoc);
+static void update_assoc_index(assoc_list_t *assoc_list);
 static void assoc_viewers(matcher_t *matcher, const assoc_records_t *viewers);
 static assoc_records_t clone_assoc_records(const assoc_records_t *records,
 		const char pattern[], const assoc_list_t *dst);
@@ -95,19 +99,12 @@ ft_get_viewer(const char file[])
 static const char *
 find_existing_cmd(const assoc_list_t *record_list, const char file[])
 {
-	int i;
+	int i = -1;
 
-	for(i = 0; i < record_list->count; ++i)
+	while((i = find_next_match(record_list, file, i + 1)) >= 0)
 	{
-		assoc_record_t prog;
-		assoc_t *const assoc = &record_list->list[i];
-
-		if(!matcher_matches(assoc->matcher, file))
-		{
-			continue;
-		}
-
-		prog = find_existing_cmd_record(&assoc->records);
+		const assoc_record_t prog =
+				find_existing_cmd_record(&record_list->list[i].records);
 		if(!is_assoc_record_empty(&prog))
 		{
 			return prog.command;
@@ -117,6 +114,29 @@ find_existing_cmd(const assoc_list_t *record_list, const char file[])
 	return NULL;
 }
 
+/* Finds association at position not less than from which pattern matches given
+ * file.  Returns the position or -1 if there is no such association. */
+static int
+find_next_match(const assoc_list_t *record_list, const char file[], int from)
+{
+	int i;
+
+	if(record_list->index != NULL)
+	{
+		return matcher_index_find(record_list->index, file, from);
+	}
+
+	for(i = from; i < record_list->count; ++i)
+	{
+		if(matcher_matches(record_list->list[i].matcher, file))
+		{
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 /* Finds record that corresponds to an external command that is available.
  * Returns the record on success or an empty record on failure. */
 static assoc_record_t
@@ -230,16 +250,12 @@ ft_get_all_viewers(const char file[])
 static assoc_records_t
 clone_all_matching_records(const char file[], const assoc_list_t *record_list)
 {
-	int i;
+	int i = -1;
 	assoc_records_t result = {};
 
-	for(i = 0; i < record_list->count; ++i)
+	while((i = find_next_match(record_list, file, i + 1)) >= 0)
 	{
-		assoc_t *const assoc = &record_list->list[i];
-		if(matcher_matches(assoc->matcher, file))
-		{
-			ft_assoc_record_add_all(&result, &assoc->records);
-		}
+		ft_assoc_record_add_all(&result, &record_list->list[i].records);
 	}
 
 	return result;
@@ -300,6 +316,40 @@ add_assoc(assoc_list_t *assoc_list, assoc_t assoc)
 	assoc_list->list = p;
 	assoc_list->list[assoc_list->count] = assoc;
 	assoc_list->count++;
+
+	update_assoc_index(assoc_list);
+}
+
+/* Brings index of associations up to date by either adding the last element to
+ * it or building it from scratch.  Index is dropped on failure. */
+static void
+update_assoc_index(assoc_list_t *assoc_list)
+{
+	int i;
+
+	if(assoc_list->index != NULL)
+	{
+		i = assoc_list->count - 1;
+	}
+	else
+	{
+		i = 0;
+		assoc_list->index = matcher_index_alloc();
+		if(assoc_list->index == NULL)
+		{
+			return;
+		}
+	}
+
+	for(; i < assoc_list->count; ++i)
+	{
+		if(matcher_index_add(assoc_list->index, assoc_list->list[i].matcher) != 0)
+		{
+			matcher_index_free(assoc_list->index);
+			assoc_list->index = NULL;
+			break;
+		}
+	}
 }
 
 void
@@ -349,6 +399,9 @@ reset_list_head(assoc_list_t *assoc_list)
 	free(assoc_list->list);
 	assoc_list->list = NULL;
 	assoc_list->count = 0;
+
+	matcher_index_free(assoc_list->index);
+	assoc_list->index = NULL;
 }
 
 static void
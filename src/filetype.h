@@ -22,6 +22,7 @@
 
 #define VIFM_PSEUDO_CMD "vifm"
 
+struct matcher_index_t;
 struct matcher_t;
 
 /* Type of file association by it's source. */
@@ -60,6 +61,8 @@ typedef struct
 {
 	assoc_t *list;
 	int count;
+	/* Index of matchers of the list for faster lookup, can be NULL. */
+	struct matcher_index_t *index;
 }
 assoc_list_t;
 
@@ -19,26 +19,47 @@
 
 #include "filtering.h"
 
+#include <regex.h> /* REG_ICASE */
+
 #include <assert.h> /* assert() */
-#include <string.h> /* strdup() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strdup() strlen() strncmp() */
 
 #include "cfg/config.h"
 #include "compat/reallocarray.h"
+#include "ui/fileview.h"
 #include "ui/ui.h"
 #include "utils/dynarray.h"
+#include "utils/filter.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "filelist.h"
 
+/* Description of matching unfiltered list for parallel processing. */
+typedef struct
+{
+	const dir_entry_t *entries; /* List of entries to match. */
+	filter_t *filter;           /* Filter to use in the calling thread. */
+	char *matches;              /* Results of matching for each entry. */
+}
+match_job_t;
+
 static void reset_filter(filter_t *filter);
 static int is_newly_filtered(FileView *view, const dir_entry_t *entry,
 		void *arg);
 static int get_unfiltered_pos(const FileView *const view, int pos);
 static int load_unfiltered_list(FileView *const view);
 static void store_local_filter_position(FileView *const view, int pos);
+static int can_narrow_filter(const char prev[], int prev_cflags,
+		const filter_t *filter);
+static void narrow_filtered_list(FileView *view);
 static void update_filtering_lists(FileView *view, int add, int clear);
+static char * match_unfiltered_list(FileView *view);
+static void match_chunk(int from, int to, int chunk, void *arg);
+static int entry_matches(filter_t *filter, const dir_entry_t *entry);
 static void ensure_filtered_list_not_empty(FileView *view,
 		dir_entry_t *parent_entry);
 static int extract_previously_selected_pos(FileView *const view);
@@ -158,19 +179,7 @@ static int
 is_newly_filtered(FileView *view, const dir_entry_t *entry, void *arg)
 {
 	filter_t *const filter = arg;
-
-	/* FIXME: some very long file names won't be matched against some
-	 * regexps. */
-	char name_with_slash[NAME_MAX + 1 + 1];
-	const char *filename = entry->name;
-
-	if(is_directory_entry(entry))
-	{
-		append_slash(filename, name_with_slash, sizeof(name_with_slash));
-		filename = name_with_slash;
-	}
-
-	return filter_matches(filter, filename) == 0;
+	return entry_matches(filter, entry) == 0;
 }
 
 void
@@ -268,7 +277,11 @@ filters_dir_updated(FileView *view)
 void
 local_filter_set(FileView *view, const char filter[])
 {
-	const int current_file_pos = view->local_filter.in_progress
+	const int in_progress = view->local_filter.in_progress;
+	const int prev_cflags = view->local_filter.filter.cflags;
+	char *const prev = strdup(view->local_filter.filter.raw);
+
+	const int current_file_pos = in_progress
 		? get_unfiltered_pos(view, view->list_pos)
 		: load_unfiltered_list(view);
 
@@ -280,7 +293,95 @@ local_filter_set(FileView *view, const char filter[])
 	(void)filter_change(&view->local_filter.filter, filter,
 			!regexp_should_ignore_case(filter));
 
-	update_filtering_lists(view, 1, 0);
+	if(in_progress && prev != NULL &&
+			can_narrow_filter(prev, prev_cflags, &view->local_filter.filter))
+	{
+		narrow_filtered_list(view);
+	}
+	else
+	{
+		/* Entries of the list are shallow copies of unfiltered ones. */
+		dynarray_free(view->dir_entry);
+		view->dir_entry = NULL;
+		view->list_rows = 0;
+
+		update_filtering_lists(view, 1, 0);
+	}
+
+	fview_list_updated(view);
+
+	free(prev);
+}
+
+/* Checks whether list filtered with prev filter value can be narrowed down with
+ * the new value of the filter, which is the case when the new value just
+ * extends plain string of the old one.  Returns non-zero if so, otherwise zero
+ * is returned. */
+static int
+can_narrow_filter(const char prev[], int prev_cflags, const filter_t *filter)
+{
+	/* Switching from case sensitive to case insensitive matching can extend the
+	 * set of matches. */
+	if((filter->cflags & REG_ICASE) && !(prev_cflags & REG_ICASE))
+	{
+		return 0;
+	}
+
+	return prev[0] != '\0'
+	    && filter->is_regex_valid
+	    && strncmp(filter->raw, prev, strlen(prev)) == 0
+	    && regexp_is_literal(prev)
+	    && regexp_is_literal(filter->raw);
+}
+
+/* Removes entries that don't match local filter from the list of the view
+ * without looking at unfiltered entries. */
+static void
+narrow_filtered_list(FileView *view)
+{
+	int i;
+	size_t list_size = 0U;
+	dir_entry_t *parent_entry = NULL;
+	const int parent_visible = cfg_parent_dir_is_visible(
+			is_root_dir(view->curr_dir));
+
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		dir_entry_t *const entry = &view->dir_entry[i];
+
+		if(is_parent_dir(entry->name))
+		{
+			if(!parent_visible)
+			{
+				continue;
+			}
+		}
+		else if(entry_matches(&view->local_filter.filter, entry) == 0)
+		{
+			continue;
+		}
+
+		view->dir_entry[list_size++] = *entry;
+	}
+
+	view->list_rows = list_size;
+	view->filtered = view->local_filter.prefiltered_count
+	               + view->local_filter.unfiltered_count - list_size;
+
+	if(list_size == 0U)
+	{
+		size_t j;
+		for(j = 0U; j < view->local_filter.unfiltered_count; ++j)
+		{
+			if(is_parent_dir(view->local_filter.unfiltered[j].name))
+			{
+				parent_entry = &view->local_filter.unfiltered[j];
+				break;
+			}
+		}
+	}
+
+	ensure_filtered_list_not_empty(view, parent_entry);
 }
 
 /* Gets position of an item in dir_entry list at position pos in the unfiltered
@@ -374,17 +475,13 @@ update_filtering_lists(FileView *view, int add, int clear)
 	size_t i;
 	size_t list_size = 0U;
 	dir_entry_t *parent_entry = NULL;
+	char *const matches = match_unfiltered_list(view);
 
 	for(i = 0; i < view->local_filter.unfiltered_count; i++)
 	{
-		/* FIXME: some very long file names won't be matched against some
-		 * regexps. */
-		char name_with_slash[NAME_MAX + 1 + 1];
-
 		dir_entry_t *const entry = &view->local_filter.unfiltered[i];
-		const char *name = entry->name;
 
-		if(is_parent_dir(name))
+		if(is_parent_dir(entry->name))
 		{
 			parent_entry = entry;
 			if(add && cfg_parent_dir_is_visible(is_root_dir(view->curr_dir)))
@@ -394,13 +491,9 @@ update_filtering_lists(FileView *view, int add, int clear)
 			continue;
 		}
 
-		if(is_directory_entry(entry))
-		{
-			append_slash(name, name_with_slash, sizeof(name_with_slash));
-			name = name_with_slash;
-		}
-
-		if(filter_matches(&view->local_filter.filter, name) != 0)
+		if(matches != NULL
+		   ? matches[i]
+		   : entry_matches(&view->local_filter.filter, entry) != 0)
 		{
 			if(add)
 			{
@@ -416,6 +509,8 @@ update_filtering_lists(FileView *view, int add, int clear)
 		}
 	}
 
+	free(matches);
+
 	if(add)
 	{
 		view->list_rows = list_size;
@@ -425,6 +520,79 @@ update_filtering_lists(FileView *view, int add, int clear)
 	}
 }
 
+/* Matches all unfiltered entries against local filter using several threads
+ * for large lists.  Returns newly allocated array of flags that specify whether
+ * corresponding entry matches or NULL on memory allocation error. */
+static char *
+match_unfiltered_list(FileView *view)
+{
+	const size_t count = view->local_filter.unfiltered_count;
+	match_job_t job = {
+		.entries = view->local_filter.unfiltered,
+		.filter = &view->local_filter.filter,
+		.matches = malloc(count + 1U),
+	};
+
+	if(job.matches != NULL)
+	{
+		parallel_for(count, PARALLEL_MIN_CHUNK, &match_chunk, &job);
+	}
+	return job.matches;
+}
+
+/* Matches part of entries of the job against the filter.  Implements
+ * parallel_range_func. */
+static void
+match_chunk(int from, int to, int chunk, void *arg)
+{
+	const match_job_t *const job = arg;
+	filter_t local_filter;
+	filter_t *filter = job->filter;
+	int i;
+
+	/* Other threads can't share regular expression with the calling one. */
+	if(chunk != 0 && filter_init(&local_filter, 1) == 0)
+	{
+		if(filter_assign(&local_filter, job->filter) == 0)
+		{
+			filter = &local_filter;
+		}
+		else
+		{
+			filter_dispose(&local_filter);
+		}
+	}
+
+	for(i = from; i < to; ++i)
+	{
+		job->matches[i] = (entry_matches(filter, &job->entries[i]) != 0);
+	}
+
+	if(filter == &local_filter)
+	{
+		filter_dispose(&local_filter);
+	}
+}
+
+/* Matches entry against the filter adding trailing slash to names of
+ * directories.  Returns result of filter_matches(). */
+static int
+entry_matches(filter_t *filter, const dir_entry_t *entry)
+{
+	/* FIXME: some very long file names won't be matched against some
+	 * regexps. */
+	char name_with_slash[NAME_MAX + 1 + 1];
+	const char *filename = entry->name;
+
+	if(is_directory_entry(entry))
+	{
+		append_slash(filename, name_with_slash, sizeof(name_with_slash));
+		filename = name_with_slash;
+	}
+
+	return filter_matches(filter, filename);
+}
+
 /* Use parent_entry to make filtered list not empty, or create such entry (if
  * parent_entry is NULL) and put it to original list. */
 static void
@@ -577,6 +745,7 @@ local_filter_cancel(FileView *view)
 	view->list_rows = 0;
 
 	update_filtering_lists(view, 1, 1);
+	fview_list_updated(view);
 	local_filter_finish(view);
 }
 
@@ -611,17 +780,7 @@ local_filter_restore(FileView *view)
 int
 local_filter_matches(FileView *view, const dir_entry_t *entry)
 {
-	/* FIXME: some very long file names won't be matched against some
-	 * regexps. */
-	char name_with_slash[NAME_MAX + 1 + 1];
-	const char *filename = entry->name;
-	if(is_directory_entry(entry))
-	{
-		append_slash(filename, name_with_slash, sizeof(name_with_slash));
-		filename = name_with_slash;
-	}
-
-	return filter_matches(&view->local_filter.filter, filename) != 0;
+	return entry_matches(&view->local_filter.filter, entry) != 0;
 }
 
 /* Appends slash to the name and stores result in the buffer. */
@@ -18,8 +18,12 @@
 
 #include "path_env.h"
 
+#ifndef _WIN32
+#include <poll.h> /* POLLIN poll() pollfd */
+#endif
+
 #include <stdio.h> /* snprintf() sprintf() */
-#include <stdlib.h> /* malloc() free() */
+#include <stdlib.h> /* calloc() malloc() free() */
 #include <string.h> /* strchr() strlen() */
 
 #include "../cfg/config.h"
@@ -29,19 +33,63 @@
 #include "../engine/variables.h"
 #include "../utils/env.h"
 #include "../utils/fs.h"
+#include "../utils/fswatch.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
+#include "../utils/trie.h"
+#include "../utils/utils.h"
+
+#ifndef _WIN32
+
+/* Maximum number of directories of PATH that are indexed.  Each of them is
+ * watched for changes, which can take system resources (like inotify
+ * instances) that are limited per user, so directories past this limit are
+ * just probed for commands. */
+#define MAX_INDEXED_DIRS 16
+
+/* Index of entries of a single directory listed in PATH. */
+typedef struct
+{
+	fswatch_t *watch; /* Watcher of the directory or NULL if it's not indexed. */
+	trie_t names;     /* Names of entries of the directory mapped to &exec_mark,
+	                     &non_exec_mark or NULL if it's unknown yet.  NULL_TRIE
+	                     if the directory wasn't read yet. */
+}
+dir_index_t;
+
+#endif
 
 static int path_env_was_changed(int force);
 static void append_scripts_dirs(void);
 static void add_dirs_to_path(const char *path);
 static void add_to_path(const char *path);
 static void split_path_list(void);
+static int dir_has_cmd(int i, const char cmd[]);
+#ifndef _WIN32
+static int indexed_dir_has_cmd(dir_index_t *index, int i, const char cmd[]);
+static void read_dir_index(dir_index_t *index, const char path[]);
+static void refresh_dir_index(void);
+static void check_dir_index(dir_index_t *index);
+static void disable_dir_index(dir_index_t *index);
+static void drop_dir_index(void);
+#endif
 
 static char **paths;
 static int paths_count;
 
+#ifndef _WIN32
+/* Indexes of directories of paths, has paths_count elements when not NULL. */
+static dir_index_t *dir_index;
+
+/* Address of this variable marks executable entries in the index. */
+static char exec_mark;
+
+/* Address of this variable marks entries of the index which aren't
+ * executable. */
+static char non_exec_mark;
+#endif
+
 static char *clean_path;
 static char *real_path;
 
@@ -63,6 +111,227 @@ update_path_env(int force)
 	}
 }
 
+int
+find_cmd_dir(const char cmd[])
+{
+	int i;
+
+	update_path_env(0);
+#ifndef _WIN32
+	refresh_dir_index();
+#endif
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		if(dir_has_cmd(i, cmd))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Checks whether i-th directory of paths contains executable named cmd.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+dir_has_cmd(int i, const char cmd[])
+{
+	char path[PATH_MAX];
+
+#ifndef _WIN32
+	/* The index contains only names of immediate children. */
+	if(dir_index != NULL && strchr(cmd, '/') == NULL)
+	{
+		dir_index_t *const index = &dir_index[i];
+		if(index->watch != NULL)
+		{
+			return indexed_dir_has_cmd(index, i, cmd);
+		}
+	}
+#endif
+
+	snprintf(path, sizeof(path), "%s/%s", paths[i], cmd);
+	/* Need to check for executable, not just a file, as this additionally checks
+	 * for path with different executable extensions on Windows. */
+	return executable_exists(path);
+}
+
+#ifndef _WIN32
+
+/* Checks whether i-th directory of paths contains executable named cmd using
+ * its index.  Returns non-zero if so, otherwise zero is returned. */
+static int
+indexed_dir_has_cmd(dir_index_t *index, int i, const char cmd[])
+{
+	void *data;
+
+	if(index->names == NULL_TRIE)
+	{
+		read_dir_index(index, paths[i]);
+		if(index->names == NULL_TRIE)
+		{
+			char path[PATH_MAX];
+			snprintf(path, sizeof(path), "%s/%s", paths[i], cmd);
+			return executable_exists(path);
+		}
+	}
+
+	if(trie_get(index->names, cmd, &data) != 0)
+	{
+		return 0;
+	}
+
+	/* Entries are checked for being executable on the first lookup. */
+	if(data == NULL)
+	{
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/%s", paths[i], cmd);
+		data = executable_exists(path) ? &exec_mark : &non_exec_mark;
+		(void)trie_set(index->names, cmd, data);
+	}
+
+	return (data == &exec_mark);
+}
+
+/* Fills index with names of entries of the directory.  Disables the index on
+ * error. */
+static void
+read_dir_index(dir_index_t *index, const char path[])
+{
+	struct dirent *dentry;
+	DIR *const dir = os_opendir(path);
+	if(dir == NULL)
+	{
+		disable_dir_index(index);
+		return;
+	}
+
+	index->names = trie_create();
+	while(index->names != NULL_TRIE && (dentry = os_readdir(dir)) != NULL)
+	{
+		if(!is_builtin_dir(dentry->d_name) &&
+				trie_put(index->names, dentry->d_name) < 0)
+		{
+			disable_dir_index(index);
+		}
+	}
+
+	os_closedir(dir);
+}
+
+/* Creates index of directories of paths if it doesn't exist yet or forgets
+ * contents of directories that have changed since the last call. */
+static void
+refresh_dir_index(void)
+{
+	int i;
+	int nfds = 0;
+	struct pollfd fds[paths_count + 1];
+	int idxs[paths_count + 1];
+
+	if(dir_index == NULL)
+	{
+		dir_index = calloc(paths_count + 1, sizeof(*dir_index));
+		if(dir_index == NULL)
+		{
+			return;
+		}
+
+		/* Watchers are created before reading directories, so changes made during
+		 * reading aren't lost. */
+		for(i = 0; i < paths_count; ++i)
+		{
+			dir_index[i].watch = (i < MAX_INDEXED_DIRS)
+			                   ? fswatch_create(paths[i])
+			                   : NULL;
+			dir_index[i].names = NULL_TRIE;
+		}
+		return;
+	}
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		dir_index_t *const index = &dir_index[i];
+		if(index->watch == NULL || index->names == NULL_TRIE)
+		{
+			continue;
+		}
+
+		fds[nfds].fd = fswatch_get_fd(index->watch);
+		if(fds[nfds].fd == -1)
+		{
+			check_dir_index(index);
+			continue;
+		}
+
+		fds[nfds].events = POLLIN;
+		idxs[nfds++] = i;
+	}
+
+	/* Single poll() call tells which of the watchers need to be queried. */
+	if(nfds == 0 || poll(fds, nfds, 0) <= 0)
+	{
+		return;
+	}
+
+	for(i = 0; i < nfds; ++i)
+	{
+		if(fds[i].revents != 0)
+		{
+			check_dir_index(&dir_index[idxs[i]]);
+		}
+	}
+}
+
+/* Forgets contents of the directory if it has changed. */
+static void
+check_dir_index(dir_index_t *index)
+{
+	int error;
+	const int changed = fswatch_changed(index->watch, &error);
+
+	if(error)
+	{
+		disable_dir_index(index);
+	}
+	else if(changed)
+	{
+		trie_free(index->names);
+		index->names = NULL_TRIE;
+	}
+}
+
+/* Makes lookups in the directory bypass its index. */
+static void
+disable_dir_index(dir_index_t *index)
+{
+	fswatch_free(index->watch);
+	index->watch = NULL;
+	trie_free(index->names);
+	index->names = NULL_TRIE;
+}
+
+/* Frees index of directories of paths. */
+static void
+drop_dir_index(void)
+{
+	int i;
+
+	if(dir_index == NULL)
+	{
+		return;
+	}
+
+	for(i = 0; i < paths_count; ++i)
+	{
+		disable_dir_index(&dir_index[i]);
+	}
+	free(dir_index);
+	dir_index = NULL;
+}
+
+#endif
+
 /* Checks if PATH environment variable was changed. Returns non-zero if path was
  * altered since last call. */
 static int
@@ -160,6 +429,10 @@ split_path_list(void)
 
 	path = env_get("PATH");
 
+#ifndef _WIN32
+	drop_dir_index();
+#endif
+
 	if(paths != NULL)
 		free_string_array(paths, paths_count);
 
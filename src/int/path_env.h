@@ -29,6 +29,12 @@ void update_path_env(int force);
  * the count argument. */
 char ** get_paths(size_t *count);
 
+/* Looks up executable in directories of PATH using index of their contents
+ * that's updated on changes in file system.  Returns position of the first
+ * directory that contains the executable in the list returned by get_paths()
+ * or -1 if there is no such directory. */
+int find_cmd_dir(const char cmd[]);
+
 /* Sets PATH to its value that was set by user or another program. Use
  * load_real_path_env() function to revert this effect. */
 void load_clean_path_env(void);
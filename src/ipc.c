@@ -16,6 +16,11 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* For SO_PEERCRED. */
+#define _GNU_SOURCE
+#endif
+
 #include "ipc.h"
 
 #ifndef ENABLE_REMOTE_CMDS
@@ -46,7 +51,13 @@ ipc_check(void)
 }
 
 int
-ipc_send(const char whom[], char *data[])
+ipc_get_fds(int fds[], int len)
+{
+	return 0;
+}
+
+int
+ipc_send(const char whom[], char *data[], int *status, char **output)
 {
 	return 1;
 }
@@ -54,8 +65,11 @@ ipc_send(const char whom[], char *data[])
 #else
 
 #ifndef _WIN32
-#include <sys/types.h>
-#include <sys/select.h> /* FD_* select() */
+#include <sys/socket.h> /* AF_UNIX SOCK_STREAM accept() bind() connect()
+                           getsockopt() listen() recv() send() socket() */
+#include <sys/types.h> /* gid_t mode_t pid_t uid_t */
+#include <sys/un.h> /* sockaddr_un */
+#include <poll.h> /* POLLIN poll() pollfd */
 #else
 #define O_NONBLOCK 0
 #define REQUIRED_WINVER 0x0600 /* To get PIPE_REJECT_REMOTE_CLIENTS. */
@@ -65,17 +79,19 @@ ipc_send(const char whom[], char *data[])
 #endif
 #include <windows.h>
 #endif
-#include <sys/stat.h> /* mkfifo() stat() */
+#include <sys/stat.h> /* stat() umask() */
 #include <dirent.h> /* DIR closedir() opendir() readdir() */
 #include <fcntl.h>
-#include <unistd.h> /* close() open() select() unlink() */
+#include <unistd.h> /* close() geteuid() open() unlink() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* EEXIST ENXIO errno */
+#include <errno.h> /* EADDRINUSE EAGAIN EINTR ENXIO EWOULDBLOCK errno */
 #include <stddef.h> /* NULL size_t ssize_t */
+#include <stdint.h> /* int32_t uint32_t */
 #include <stdio.h> /* FILE fclose() fdopen() fread() fwrite() */
-#include <stdlib.h> /* atexit() free() malloc() qsort() snprintf() */
-#include <string.h> /* strcmp() strcpy() strlen() */
+#include <stdlib.h> /* atexit() free() malloc() qsort() realloc() snprintf() */
+#include <string.h> /* memcpy() memmove() memset() strcmp() strcpy()
+                      strlen() */
 
 #include "utils/fs.h"
 #include "utils/log.h"
@@ -89,6 +105,42 @@ ipc_send(const char whom[], char *data[])
 /* Prefix for names of all pipes to distinguish them from other pipes. */
 #define PREFIX "vifm-ipc-"
 
+#ifndef _WIN32
+
+/* Not all systems have a way of suppressing SIGPIPE per send() call. */
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/* Maximum number of simultaneously connected clients. */
+#define MAX_CLIENTS 64
+
+/* Maximum length of a single message, longer ones are considered to be a
+ * protocol violation. */
+#define MAX_MSG_LEN (1024U*1024U)
+
+/* Maximum amount of data read from a single client per check, limits time
+ * spent on processing requests of a single busy client. */
+#define MAX_READ_LEN (64U*1024U)
+
+/* Maximum time in milliseconds to wait for the next piece of a reply. */
+#define REPLY_TIMEOUT (30*1000)
+
+/* Connection with a client, which can send any number of requests and receives
+ * a reply for each of them in the same order. */
+typedef struct
+{
+	int fd;         /* Socket of the connection or -1 for unused slot. */
+	char *in;       /* Received data that is yet to be processed. */
+	size_t in_len;  /* Length of received data. */
+	char *out;      /* Replies that are yet to be sent. */
+	size_t out_len; /* Length of the replies. */
+	int eof;        /* Whether client won't send anything else. */
+}
+client_t;
+
+#endif
+
 /* Holds list information for add_to_list(). */
 typedef struct
 {
@@ -99,16 +151,38 @@ typedef struct
 list_data_t;
 
 static void clean_at_exit(void);
+#ifndef _WIN32
+static int create_socket(const char name[], char path_buf[], size_t len);
+static int try_use_socket(const char path[]);
+static int fill_address(struct sockaddr_un *addr, const char path[]);
+static int bind_private(int fd, const struct sockaddr_un *addr);
+static void setup_fd(int fd);
+static void accept_clients(void);
+static int accept_trusted(void);
+static int peer_is_trusted(int fd);
+static void serve_client(client_t *client);
+static int read_requests(client_t *client);
+static int process_requests(client_t *client);
+static int add_reply(client_t *client, int status, const char output[]);
+static int send_replies(client_t *client);
+static void drop_client(client_t *client);
+static void reply_before_exit(void);
+static int connect_to(const char path[]);
+static int write_all(int fd, const char data[], size_t len);
+static int read_all(int fd, char data[], size_t len);
+static int receive_reply(int fd, int *status, char **output);
+static int path_is_in_use(const char path[]);
+static int socket_is_in_use(const char path[]);
+#else
 static FILE * create_pipe(const char name[], char path_buf[], size_t len);
 static char * receive_pkg(void);
 static FILE * try_use_pipe(const char path[]);
-static void handle_pkg(const char pkg[]);
-static int send_pkg(const char whom[], const char what[], size_t len);
+#endif
+static int handle_pkg(const char pkg[], char **output);
+static int send_pkg(const char whom[], const char what[], size_t len,
+		int *status, char **output);
 static char * get_the_only_target(void);
 static int add_to_list(const char name[], const void *data, void *param);
-#ifndef _WIN32
-static int pipe_is_in_use(const char path[]);
-#endif
 static const char * get_ipc_dir(void);
 static int sorter(const void *first, const void *second);
 
@@ -119,8 +193,20 @@ static ipc_callback callback;
 static int initialized;
 /* Path to the pipe used by this instance. */
 static char pipe_path[PATH_MAX];
+#ifndef _WIN32
+/* Listening socket of this instance. */
+static int server_fd = -1;
+/* Currently connected clients. */
+static client_t clients[MAX_CLIENTS];
+/* Whether requests are being processed at the moment, used to prevent
+ * processing them out of order by nested invocations of ipc_check(). */
+static int processing;
+/* Client whose request is being processed or NULL. */
+static client_t *current_client;
+#else
 /* Opened file of the pipe. */
 static FILE *pipe_file;
+#endif
 
 int
 ipc_enabled(void)
@@ -131,6 +217,10 @@ ipc_enabled(void)
 void
 ipc_init(const char name[], ipc_callback callback_func)
 {
+#ifndef _WIN32
+	int i;
+#endif
+
 	assert(!initialized && "Repeated initialization?");
 
 	callback = callback_func;
@@ -140,12 +230,26 @@ ipc_init(const char name[], ipc_callback callback_func)
 		name = "vifm";
 	}
 
+#ifndef _WIN32
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		clients[i].fd = -1;
+	}
+
+	server_fd = create_socket(name, pipe_path, sizeof(pipe_path));
+	if(server_fd == -1)
+	{
+		initialized = -1;
+		return;
+	}
+#else
 	pipe_file = create_pipe(name, pipe_path, sizeof(pipe_path));
 	if(pipe_file == NULL)
 	{
 		initialized = -1;
 		return;
 	}
+#endif
 
 	atexit(&clean_at_exit);
 	initialized = 1;
@@ -155,14 +259,33 @@ ipc_init(const char name[], ipc_callback callback_func)
 static void
 clean_at_exit(void)
 {
+#ifndef _WIN32
+	int i;
+
+	reply_before_exit();
+
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(clients[i].fd != -1)
+		{
+			drop_client(&clients[i]);
+		}
+	}
+	close(server_fd);
+#else
 	fclose(pipe_file);
+#endif
 	unlink(pipe_path);
 }
 
 void
 ipc_check(void)
 {
+#ifndef _WIN32
+	int i;
+#else
 	char *pkg;
+#endif
 
 	assert(initialized != 0 && "Wrong IPC unit state.");
 	if(initialized < 0)
@@ -170,16 +293,486 @@ ipc_check(void)
 		return;
 	}
 
+#ifndef _WIN32
+	if(processing)
+	{
+		return;
+	}
+
+	accept_clients();
+
+	/* All requests that are available at the moment are processed as a batch. */
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(clients[i].fd != -1)
+		{
+			serve_client(&clients[i]);
+		}
+	}
+#else
 	pkg = receive_pkg();
 	if(pkg == NULL)
 	{
 		return;
 	}
 
-	handle_pkg(pkg);
+	(void)handle_pkg(pkg, NULL);
 	free(pkg);
+#endif
+}
+
+int
+ipc_get_fds(int fds[], int len)
+{
+#ifndef _WIN32
+	int i;
+	int count;
+
+	int has_free_slots = 0;
+
+	/* Nothing can be processed until current requests are processed. */
+	if(initialized <= 0 || processing)
+	{
+		return 0;
+	}
+
+	count = 0;
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		const client_t *const client = &clients[i];
+		if(client->fd == -1)
+		{
+			has_free_slots = 1;
+			continue;
+		}
+
+		/* Replies that are waiting for client to read them require retrying, which
+		 * can't be signaled by readiness for reading. */
+		if(client->out_len != 0U || count == len)
+		{
+			return -1;
+		}
+
+		if(!client->eof)
+		{
+			fds[count++] = client->fd;
+		}
+	}
+
+	/* Pending connections can't be accepted without a free slot. */
+	if(has_free_slots)
+	{
+		if(count == len)
+		{
+			return -1;
+		}
+		fds[count++] = server_fd;
+	}
+
+	return count;
+#else
+	return (initialized > 0) ? -1 : 0;
+#endif
+}
+
+#ifndef _WIN32
+
+/* Creates socket for serving clients.  Returns the socket or -1 on error. */
+static int
+create_socket(const char name[], char path_buf[], size_t len)
+{
+	int id = 0;
+	int fd;
+
+	/* Try to use name as is at first. */
+	snprintf(path_buf, len, "%s/" PREFIX "%s", get_ipc_dir(), name);
+	fd = try_use_socket(path_buf);
+	while(fd == -1)
+	{
+		snprintf(path_buf, len, "%s/" PREFIX "%s%d", get_ipc_dir(), name, ++id);
+
+		if(id == 0)
+		{
+			return -1;
+		}
+
+		fd = try_use_socket(path_buf);
+	}
+
+	return fd;
+}
+
+/* Either creates a socket at the path or reuses path of previously abandoned
+ * one.  Returns listening socket or -1 on error. */
+static int
+try_use_socket(const char path[])
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if(fill_address(&addr, path) != 0)
+	{
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd == -1)
+	{
+		return -1;
+	}
+
+	if(bind_private(fd, &addr) != 0)
+	{
+		/* Fail fast if the error is not related to existence of the file or the
+		 * file is in use. */
+		if(errno != EADDRINUSE || path_is_in_use(path))
+		{
+			close(fd);
+			return -1;
+		}
+
+		/* Take over path of an abandoned socket or pipe of older versions. */
+		if(unlink(path) != 0 || bind_private(fd, &addr) != 0)
+		{
+			close(fd);
+			return -1;
+		}
+	}
+
+	if(listen(fd, MAX_CLIENTS) != 0)
+	{
+		close(fd);
+		(void)unlink(path);
+		return -1;
+	}
+
+	setup_fd(fd);
+	return fd;
+}
+
+/* Fills socket address structure.  Returns zero on success or non-zero if path
+ * is too long. */
+static int
+fill_address(struct sockaddr_un *addr, const char path[])
+{
+	if(strlen(path) >= sizeof(addr->sun_path))
+	{
+		LOG_ERROR_MSG("IPC path is too long: %s", path);
+		return 1;
+	}
+
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	strcpy(addr->sun_path, path);
+	return 0;
+}
+
+/* Binds socket to the address making the socket accessible only by its owner.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+bind_private(int fd, const struct sockaddr_un *addr)
+{
+	const mode_t old_umask = umask(077);
+	const int result = bind(fd, (const struct sockaddr *)addr, sizeof(*addr));
+	(void)umask(old_umask);
+	return result;
+}
+
+/* Makes server side socket non-blocking and not inherited by child
+ * processes. */
+static void
+setup_fd(int fd)
+{
+	(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+	{
+		const int on = 1;
+		(void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif
+}
+
+/* Accepts pending connections while there are free slots for them. */
+static void
+accept_clients(void)
+{
+	int i;
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		int fd;
+
+		if(clients[i].fd != -1)
+		{
+			continue;
+		}
+
+		fd = accept_trusted();
+		if(fd == -1)
+		{
+			break;
+		}
+
+		setup_fd(fd);
+		clients[i] = (client_t){ .fd = fd };
+	}
 }
 
+/* Accepts next pending connection skipping those of other users.  Returns
+ * connected socket or -1 if there are no more pending connections. */
+static int
+accept_trusted(void)
+{
+	while(1)
+	{
+		const int fd = accept(server_fd, NULL, NULL);
+		if(fd == -1 || peer_is_trusted(fd))
+		{
+			return fd;
+		}
+
+		LOG_ERROR_MSG("Rejected IPC connection from another user");
+		close(fd);
+	}
+}
+
+/* Checks whether process on the other end of the connection runs as the same
+ * user.  Returns non-zero if so, otherwise zero is returned. */
+static int
+peer_is_trusted(int fd)
+{
+#if defined(__linux__) && defined(SO_PEERCRED)
+	/* Layout of struct ucred, which isn't always declared along with
+	 * SO_PEERCRED. */
+	struct { pid_t pid; uid_t uid; gid_t gid; } cred;
+	socklen_t len = sizeof(cred);
+	if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) != 0)
+	{
+		return 0;
+	}
+	return cred.uid == geteuid();
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__DragonFly__)
+	uid_t uid;
+	gid_t gid;
+	if(getpeereid(fd, &uid, &gid) != 0)
+	{
+		return 0;
+	}
+	return uid == geteuid();
+#else
+	/* Rely on permissions of the socket, which is accessible only by its
+	 * owner. */
+	(void)fd;
+	return 1;
+#endif
+}
+
+/* Receives requests of the client, processes them and sends back replies.
+ * Drops the client on errors or when it's done. */
+static void
+serve_client(client_t *client)
+{
+	if(read_requests(client) != 0 || process_requests(client) != 0 ||
+			send_replies(client) != 0)
+	{
+		drop_client(client);
+		return;
+	}
+
+	if(client->eof && client->out_len == 0U)
+	{
+		drop_client(client);
+	}
+}
+
+/* Reads data available from the client.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+read_requests(client_t *client)
+{
+	size_t total = 0U;
+
+	/* Don't accept new requests until client reads replies to previous ones. */
+	while(!client->eof && client->out_len == 0U && total < MAX_READ_LEN)
+	{
+		char buf[4096];
+		char *in;
+
+		const ssize_t nread = recv(client->fd, buf, sizeof(buf), 0);
+		if(nread == 0)
+		{
+			client->eof = 1;
+			break;
+		}
+		if(nread < 0)
+		{
+			return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+			     ? 0
+			     : 1;
+		}
+
+		in = realloc(client->in, client->in_len + nread);
+		if(in == NULL)
+		{
+			return 1;
+		}
+
+		memcpy(in + client->in_len, buf, nread);
+		client->in = in;
+		client->in_len += nread;
+		total += nread;
+	}
+
+	return 0;
+}
+
+/* Processes all complete requests received from the client.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+process_requests(client_t *client)
+{
+	size_t pos = 0U;
+
+	while(client->in_len - pos >= sizeof(uint32_t))
+	{
+		uint32_t size;
+		char *pkg;
+		char *output;
+		int status;
+
+		memcpy(&size, client->in + pos, sizeof(size));
+		if(size > MAX_MSG_LEN)
+		{
+			return 1;
+		}
+		if(client->in_len - pos - sizeof(size) < size)
+		{
+			break;
+		}
+		pos += sizeof(size);
+
+		pkg = malloc(size + 2U);
+		if(pkg == NULL)
+		{
+			return 1;
+		}
+
+		/* Make sure we have two trailing zeroes. */
+		memcpy(pkg, client->in + pos, size);
+		pkg[size] = '\0';
+		pkg[size + 1U] = '\0';
+		pos += size;
+
+		output = NULL;
+		processing = 1;
+		current_client = client;
+		status = handle_pkg(pkg, &output);
+		current_client = NULL;
+		processing = 0;
+		free(pkg);
+
+		if(add_reply(client, status, output) != 0)
+		{
+			free(output);
+			return 1;
+		}
+		free(output);
+	}
+
+	memmove(client->in, client->in + pos, client->in_len - pos);
+	client->in_len -= pos;
+	return 0;
+}
+
+/* Queues reply for sending to the client.  Reply consists of its size, exit
+ * status and output.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+add_reply(client_t *client, int status, const char output[])
+{
+	const size_t output_len = (output == NULL) ? 0U : strlen(output);
+	const uint32_t size = sizeof(int32_t) + output_len;
+	const int32_t status32 = status;
+	char *out;
+
+	out = realloc(client->out, client->out_len + sizeof(size) + size);
+	if(out == NULL)
+	{
+		return 1;
+	}
+	client->out = out;
+
+	out += client->out_len;
+	memcpy(out, &size, sizeof(size));
+	memcpy(out + sizeof(size), &status32, sizeof(status32));
+	memcpy(out + sizeof(size) + sizeof(status32), output, output_len);
+	client->out_len += sizeof(size) + size;
+	return 0;
+}
+
+/* Sends as much of pending replies as possible without blocking.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+send_replies(client_t *client)
+{
+	size_t pos = 0U;
+
+	while(pos < client->out_len)
+	{
+		const ssize_t nsent = send(client->fd, client->out + pos,
+				client->out_len - pos, MSG_NOSIGNAL);
+		if(nsent < 0)
+		{
+			if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+			{
+				break;
+			}
+			return 1;
+		}
+		pos += nsent;
+	}
+
+	memmove(client->out, client->out + pos, client->out_len - pos);
+	client->out_len -= pos;
+	return 0;
+}
+
+/* Closes connection with the client and frees its slot. */
+static void
+drop_client(client_t *client)
+{
+	close(client->fd);
+	free(client->in);
+	free(client->out);
+	*client = (client_t){ .fd = -1 };
+}
+
+/* Replies to request that causes exit of the application (e.g., :quit) as well
+ * as sends replies that weren't sent yet, so that clients waiting for them
+ * don't report a failure. */
+static void
+reply_before_exit(void)
+{
+	int i;
+
+	if(current_client != NULL)
+	{
+		(void)add_reply(current_client, 0, NULL);
+		current_client = NULL;
+	}
+
+	for(i = 0; i < MAX_CLIENTS; ++i)
+	{
+		if(clients[i].fd != -1 && clients[i].out_len != 0U)
+		{
+			(void)send_replies(&clients[i]);
+		}
+	}
+}
+
+#else
+
 /* Receives message addressed to this instance.  Returns NULL if there was no
  * message or on failure to read it, otherwise newly allocated string is
  * returned. */
@@ -190,12 +783,6 @@ receive_pkg(void)
 	char *pkg;
 	char *p;
 
-#ifndef _WIN32
-	fd_set ready;
-	int max_fd;
-	struct timeval ts = { .tv_sec = 0, .tv_usec = 10000 };
-#endif
-
 	if(fread(&size, sizeof(size), 1U, pipe_file) != 1U || size >= 4294967294U)
 	{
 		return NULL;
@@ -207,26 +794,14 @@ receive_pkg(void)
 		return NULL;
 	}
 
-#ifndef _WIN32
-	max_fd = fileno(pipe_file);
-	FD_ZERO(&ready);
-	FD_SET(max_fd, &ready);
-#endif
-
 	p = pkg;
-	while(size != 0U
-#ifndef _WIN32
-			&& select(max_fd + 1, &ready, NULL, NULL, &ts) > 0
-#endif
-			)
+	while(size != 0U)
 	{
 		size_t read;
 
-#ifdef _WIN32
 		/* TODO: maybe use OVERLAPPED I/O on Windows instead, it's just so
 		 *       inconvenient... */
 		usleep(10000);
-#endif
 
 		read = fread(p, 1U, size, pipe_file);
 		size -= read;
@@ -236,14 +811,8 @@ receive_pkg(void)
 		{
 			break;
 		}
-
-#ifndef _WIN32
-		ts.tv_sec = 0;
-		ts.tv_usec = 10000;
-#endif
 	}
 
-#ifdef _WIN32
 	{
 		/* Weird requirement for named pipes, need to break and set connection every
 		 * time. */
@@ -251,7 +820,6 @@ receive_pkg(void)
 		DisconnectNamedPipe(pipe_handle);
 		ConnectNamedPipe(pipe_handle, NULL);
 	}
-#endif
 
 	if(size != 0U)
 	{
@@ -298,32 +866,6 @@ static FILE *
 try_use_pipe(const char path[])
 {
 	FILE *f;
-
-#ifndef _WIN32
-	int fd;
-
-	/* Try to create a pipe. */
-	if(mkfifo(path, 0600) == 0)
-	{
-		/* Open if created. */
-		int fd = open(path, O_RDONLY | O_NONBLOCK);
-		if(fd == -1)
-		{
-			return NULL;
-		}
-		return fdopen(fd, "r");
-	}
-
-	/* Fail fast if the error is not related to existence of the file or pipe
-	 * exists and is in use. */
-	if(errno != EEXIST || pipe_is_in_use(path))
-	{
-		return NULL;
-	}
-
-	/* Use this file if we're the only one willing to read from it. */
-	fd = open(path, O_RDONLY | O_NONBLOCK);
-#else
 	HANDLE h;
 	int fd;
 
@@ -340,11 +882,6 @@ try_use_pipe(const char path[])
 	if(fd == -1)
 	{
 		CloseHandle(h);
-	}
-#endif
-
-	if(fd == -1)
-	{
 		return NULL;
 	}
 
@@ -356,12 +893,18 @@ try_use_pipe(const char path[])
 	return f;
 }
 
-/* Parses pkg into array of strings and invokes callback. */
-static void
-handle_pkg(const char pkg[])
+#endif
+
+/* Parses pkg into array of strings and invokes callback.  Output of the
+ * callback is stored in *output unless it's NULL.  Returns exit status of the
+ * request. */
+static int
+handle_pkg(const char pkg[], char **output)
 {
 	char **array = NULL;
 	size_t len = 0U;
+	char *out = NULL;
+	int status = 1;
 
 	while(*pkg != '\0')
 	{
@@ -372,14 +915,25 @@ handle_pkg(const char pkg[])
 
 	if(len != 0U)
 	{
-		callback(array);
+		status = callback(array, &out);
 	}
 
 	free_string_array(array, len);
+
+	if(output != NULL)
+	{
+		*output = out;
+	}
+	else
+	{
+		free(out);
+	}
+
+	return status;
 }
 
 int
-ipc_send(const char whom[], char *data[])
+ipc_send(const char whom[], char *data[], int *status, char **output)
 {
 	/* FIXME: this shouldn't have fixed size.  Or maybe it should be PIPE_BUF to
 	 * guarantee atomic operation. */
@@ -403,8 +957,15 @@ ipc_send(const char whom[], char *data[])
 
 	while(*data != NULL)
 	{
+		const size_t data_len = strlen(*data) + 1;
+		if(len + data_len >= sizeof(pkg))
+		{
+			LOG_ERROR_MSG("Too much data to send");
+			return 1;
+		}
+
 		strcpy(pkg + len, *data);
-		len += strlen(*data) + 1;
+		len += data_len;
 		data++;
 	}
 	pkg[len++] = '\0';
@@ -419,21 +980,51 @@ ipc_send(const char whom[], char *data[])
 		whom = name;
 	}
 
-	ret = send_pkg(whom, pkg, len);
+	ret = send_pkg(whom, pkg, len, status, output);
 
 	free(name);
 	return ret;
 }
 
-/* Performs actual sending of package to another instance.  Returns zero on
- * success and non-zero otherwise. */
+/* Performs actual sending of package to another instance and waits for a
+ * reply unless status is NULL.  Returns zero on success and non-zero
+ * otherwise. */
 static int
-send_pkg(const char whom[], const char what[], size_t len)
+send_pkg(const char whom[], const char what[], size_t len, int *status,
+		char **output)
 {
 	char path[PATH_MAX];
+	uint32_t size;
+
+#ifndef _WIN32
+	int fd;
+	int result;
+
+	snprintf(path, sizeof(path), "%s/" PREFIX "%s", get_ipc_dir(), whom);
+
+	fd = connect_to(path);
+	if(fd == -1)
+	{
+		return 1;
+	}
+
+	if(!peer_is_trusted(fd))
+	{
+		LOG_ERROR_MSG("IPC server is run by another user: %s", path);
+		close(fd);
+		return 1;
+	}
+
+	size = len;
+	result = write_all(fd, (const char *)&size, sizeof(size)) != 0
+	      || write_all(fd, what, len) != 0
+	      || (status != NULL && receive_reply(fd, status, output) != 0);
+
+	close(fd);
+	return result;
+#else
 	int fd;
 	FILE *dst;
-	uint32_t size;
 
 	snprintf(path, sizeof(path), "%s/" PREFIX "%s", get_ipc_dir(), whom);
 
@@ -459,9 +1050,158 @@ send_pkg(const char whom[], const char what[], size_t len)
 	}
 
 	fclose(dst);
+
+	/* Named pipes are one-way, so there is no reply. */
+	if(status != NULL)
+	{
+		*status = 0;
+		*output = NULL;
+	}
 	return 0;
+#endif
 }
 
+#ifndef _WIN32
+
+/* Connects to a server at the path.  Returns connected socket or -1 on
+ * error. */
+static int
+connect_to(const char path[])
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	if(fill_address(&addr, path) != 0)
+	{
+		return -1;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd == -1)
+	{
+		return -1;
+	}
+
+	if(connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+#ifdef SO_NOSIGPIPE
+	{
+		const int on = 1;
+		(void)setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+	}
+#endif
+
+	return fd;
+}
+
+/* Writes whole buffer to blocking socket.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+write_all(int fd, const char data[], size_t len)
+{
+	while(len != 0U)
+	{
+		const ssize_t nsent = send(fd, data, len, MSG_NOSIGNAL);
+		if(nsent < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+		data += nsent;
+		len -= nsent;
+	}
+	return 0;
+}
+
+/* Reads exactly len bytes from blocking socket waiting for at most
+ * REPLY_TIMEOUT for each piece of data.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+read_all(int fd, char data[], size_t len)
+{
+	while(len != 0U)
+	{
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		ssize_t nread;
+
+		const int nready = poll(&pfd, 1, REPLY_TIMEOUT);
+		if(nready == 0)
+		{
+			LOG_ERROR_MSG("Timed out waiting for reply of IPC server");
+			return 1;
+		}
+		if(nready < 0)
+		{
+			if(errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+
+		nread = recv(fd, data, len, 0);
+		if(nread <= 0)
+		{
+			if(nread < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			return 1;
+		}
+		data += nread;
+		len -= nread;
+	}
+	return 0;
+}
+
+/* Receives reply to a request.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+receive_reply(int fd, int *status, char **output)
+{
+	uint32_t size;
+	int32_t status32;
+	char *out;
+
+	if(read_all(fd, (char *)&size, sizeof(size)) != 0 || size > MAX_MSG_LEN ||
+			size < sizeof(status32))
+	{
+		return 1;
+	}
+
+	if(read_all(fd, (char *)&status32, sizeof(status32)) != 0)
+	{
+		return 1;
+	}
+	size -= sizeof(status32);
+
+	out = malloc(size + 1U);
+	if(out == NULL || read_all(fd, out, size) != 0)
+	{
+		free(out);
+		return 1;
+	}
+	out[size] = '\0';
+
+	*status = status32;
+	if(size == 0U)
+	{
+		free(out);
+		out = NULL;
+	}
+	*output = out;
+	return 0;
+}
+
+#endif
+
 /* Automatically picks target instance to send data to.  Returns newly allocated
  * string or NULL on error (no other instances or memory allocation failure). */
 static char *
@@ -524,8 +1264,8 @@ add_to_list(const char name[], const void *data, void *param)
 		char path[PATH_MAX];
 		struct stat statbuf;
 		snprintf(path, sizeof(path), "%s/%s", list_data->ipc_dir, name);
-		if(stat(path, &statbuf) != 0 || !S_ISFIFO(statbuf.st_mode) ||
-				!pipe_is_in_use(path))
+		if(stat(path, &statbuf) != 0 || !S_ISSOCK(statbuf.st_mode) ||
+				statbuf.st_uid != geteuid() || !socket_is_in_use(path))
 		{
 			return 0;
 		}
@@ -539,13 +1279,32 @@ add_to_list(const char name[], const void *data, void *param)
 
 #ifndef _WIN32
 
-/* Tries to open a pipe to check whether it has any readers or it's
- * abandoned.  Returns non-zero if somebody is reading from the pipe and zero
- * otherwise. */
+/* Checks whether file at the path is used for IPC by another instance (also
+ * pipes of older versions are recognized).  Returns non-zero if so, otherwise
+ * zero is returned. */
 static int
-pipe_is_in_use(const char path[])
+path_is_in_use(const char path[])
 {
-	const int fd = open(path, O_WRONLY | O_NONBLOCK);
+	struct stat statbuf;
+	int fd;
+
+	if(stat(path, &statbuf) != 0)
+	{
+		return 0;
+	}
+
+	if(S_ISSOCK(statbuf.st_mode))
+	{
+		return socket_is_in_use(path);
+	}
+
+	if(!S_ISFIFO(statbuf.st_mode))
+	{
+		/* Don't touch files of unknown kind. */
+		return 1;
+	}
+
+	fd = open(path, O_WRONLY | O_NONBLOCK);
 	if(fd != -1 || errno != ENXIO)
 	{
 		if(fd != -1)
@@ -557,9 +1316,24 @@ pipe_is_in_use(const char path[])
 	return 0;
 }
 
+/* Tries to connect to a socket to check whether it has a server or it's
+ * abandoned.  Returns non-zero if somebody is listening on the socket and zero
+ * otherwise. */
+static int
+socket_is_in_use(const char path[])
+{
+	const int fd = connect_to(path);
+	if(fd == -1)
+	{
+		return 0;
+	}
+	close(fd);
+	return 1;
+}
+
 #endif
 
-/* Retrieves directory where FIFO objects are created.  Returns the path. */
+/* Retrieves directory where IPC objects are created.  Returns the path. */
 static const char *
 get_ipc_dir(void)
 {
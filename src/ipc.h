@@ -21,8 +21,9 @@
 
 /* Type of function that is invoked on IPC receive.  args is NULL terminated
  * array of arguments, args[0] is absolute path at which they should be
- * processed. */
-typedef void (*ipc_callback)(char *args[]);
+ * processed.  *output can be set to newly allocated string to be sent back.
+ * Should return exit status for the sender. */
+typedef int (*ipc_callback)(char *args[], char **output);
 
 /* Checks whether IPC is in use.  Returns non-zero if so, otherwise zero is
  * returned. */
@@ -36,12 +37,21 @@ char ** ipc_list(int *len);
  * one (VIFM).  The callback_func will be called by ipc_check(). */
 void ipc_init(const char name[], ipc_callback callback_func);
 
-/* Checks for incoming messages.  Calls callback passed to ipc_init(). */
+/* Checks for incoming messages.  Calls callback passed to ipc_init() for all
+ * requests that are available at the moment. */
 void ipc_check(void);
 
-/* Sends data to server.  The data array should end with NULL.  Returns zero on
- * successful send and non-zero otherwise. */
-int ipc_send(const char whom[], char *data[]);
+/* Fills fds array of length len with file descriptors that become readable on
+ * incoming messages.  Returns number of descriptors or -1 if ipc_check() needs
+ * to be called periodically. */
+int ipc_get_fds(int fds[], int len);
+
+/* Sends data to server and waits for its reply.  The data array should end
+ * with NULL.  *status receives exit status reported by the server and *output
+ * receives its output (newly allocated string or NULL).  If status and output
+ * are NULL, the data is only sent without waiting for it to be processed.
+ * Returns zero on successful exchange and non-zero otherwise. */
+int ipc_send(const char whom[], char *data[], int *status, char **output);
 
 #endif /* VIFM__IPC_H__ */
 
@@ -23,15 +23,19 @@
 #include <ctype.h> /* tolower() */
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* snprintf() */
-#include <stdlib.h> /* realloc() free() calloc() */
-#include <string.h> /* memset() strncat() strcpy() strlen() strdup() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() strlen() strdup() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "ui/ui.h"
+#include "utils/macros.h"
 #include "utils/path.h"
 #include "utils/str.h"
+#include "utils/strbuf.h"
+#include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
 #include "filelist.h"
@@ -54,25 +58,38 @@ typedef char (*macro_filter_func)(int *quoted, char c, char data);
 
 static char filter_all(int *quoted, char c, char data);
 static char filter_single(int *quoted, char c, char data);
+static char * expand_batch(const char command[], const char args[],
+		MacroFlags *flags, int for_shell, int first, int count);
 static char * expand_macros_i(const char command[], const char args[],
 		MacroFlags *flags, int for_shell, macro_filter_func filter);
+static char * finish_expansion(strbuf_t *expanded);
 static void set_flags(MacroFlags *flags, MacroFlags value);
-TSTATIC char * append_selected_files(FileView *view, char expanded[],
+TSTATIC void append_selected_files(FileView *view, strbuf_t *expanded,
 		int under_cursor, int quotes, const char mod[], int for_shell);
-static char * append_entry(FileView *view, char expanded[], PathType type,
+static void append_entry(FileView *view, strbuf_t *expanded, PathType type,
 		dir_entry_t *entry, int quotes, const char mod[], int for_shell);
-static char * expand_directory_path(FileView *view, char *expanded, int quotes,
-		const char *mod, int for_shell);
-static char * expand_register(const char curr_dir[], char expanded[],
+static void expand_directory_path(FileView *view, strbuf_t *expanded,
+		int quotes, const char mod[], int for_shell);
+static void expand_register(const char curr_dir[], strbuf_t *expanded,
 		int quotes, const char mod[], int key, int *well_formed, int for_shell);
-static char * expand_preview(char expanded[], int key, int *well_formed);
+static void expand_preview(strbuf_t *expanded, int key, int *well_formed);
 static FileView * get_preview_view(FileView *view);
-static char * append_path_to_expanded(char expanded[], int quotes,
+static void append_path_to_expanded(strbuf_t *expanded, int quotes,
 		const char path[]);
-static char * append_to_expanded(char expanded[], const char str[]);
 static char * add_missing_macros(char expanded[], size_t len, size_t nmacros,
 		custom_macro_t macros[]);
 
+/* Selected entries of the current view that are split into batches or NULL if
+ * all selected entries should be expanded. */
+static dir_entry_t **batch_entries;
+/* Index of the first element of batch_entries to expand. */
+static int batch_first;
+/* Number of elements of batch_entries to expand. */
+static int batch_count;
+/* Whether ma_expand_batched() is running, in which case %x doesn't set flags
+ * so that other flags (like %n) are reported to the caller. */
+static int expanding_batched;
+
 char *
 expand_macros(const char command[], const char args[], MacroFlags *flags,
 		int for_shell)
@@ -80,6 +97,114 @@ expand_macros(const char command[], const char args[], MacroFlags *flags,
 	return expand_macros_i(command, args, flags, for_shell, &filter_all);
 }
 
+char **
+ma_expand_batched(const char command[], const char args[], MacroFlags *flags,
+		size_t limit, int for_shell, int *count)
+{
+	char **cmds = NULL;
+	int ncmds = 0;
+	int nselected = 0;
+	int first;
+	dir_entry_t *entry = NULL;
+
+	if(curr_view->selected_files == 0)
+	{
+		char *cmd;
+
+		expanding_batched = 1;
+		cmd = expand_macros(command, args, flags, for_shell);
+		expanding_batched = 0;
+		if(cmd == NULL)
+		{
+			*count = 0;
+			return NULL;
+		}
+		*count = put_into_string_array(&cmds, ncmds, cmd);
+		return cmds;
+	}
+
+	batch_entries = reallocarray(NULL, curr_view->selected_files,
+			sizeof(*batch_entries));
+	if(batch_entries == NULL)
+	{
+		*count = 0;
+		return NULL;
+	}
+	while(iter_selected_entries(curr_view, &entry))
+	{
+		batch_entries[nselected++] = entry;
+	}
+
+	expanding_batched = 1;
+	for(first = 0; first < nselected; )
+	{
+		/* Batch always includes at least one file, even if it doesn't fit. */
+		int fits = 1;
+		int exceeds = 0;
+		char *cmd = expand_batch(command, args, flags, for_shell, first, fits);
+
+		/* Find the largest number of files that fits by doubling it until the
+		 * command becomes too long and then bisecting the range. */
+		while(cmd != NULL && first + fits < nselected)
+		{
+			const int n = (exceeds == 0) ? MIN(fits*2, nselected - first)
+			                             : fits + (exceeds - fits)/2;
+			char *const longer = expand_batch(command, args, flags, for_shell,
+					first, n);
+			if(longer != NULL && strlen(longer) <= limit)
+			{
+				free(cmd);
+				cmd = longer;
+				fits = n;
+			}
+			else
+			{
+				free(longer);
+				exceeds = n;
+			}
+
+			if(exceeds != 0 && exceeds - fits <= 1)
+			{
+				break;
+			}
+		}
+
+		if(cmd == NULL)
+		{
+			break;
+		}
+
+		ncmds = put_into_string_array(&cmds, ncmds, cmd);
+		first += fits;
+	}
+
+	expanding_batched = 0;
+	free(batch_entries);
+	batch_entries = NULL;
+
+	if(first < nselected)
+	{
+		free_string_array(cmds, ncmds);
+		*count = 0;
+		return NULL;
+	}
+
+	*count = ncmds;
+	return cmds;
+}
+
+/* Expands macros limiting list of selected files of the current view to count
+ * elements of batch_entries starting at the first one.  Returns expanded
+ * string or NULL on error. */
+static char *
+expand_batch(const char command[], const char args[], MacroFlags *flags,
+		int for_shell, int first, int count)
+{
+	batch_first = first;
+	batch_count = count;
+	return expand_macros(command, args, flags, for_shell);
+}
+
 /* macro_filter_func instantiation that allows all macros.  Returns the
  * argument. */
 static char
@@ -137,14 +262,12 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 		int for_shell, macro_filter_func filter)
 {
 	/* TODO: refactor this function expand_macros() */
-	/* FIXME: repetitive len = strlen(expanded) could be optimized. */
 
 	static const char MACROS_WITH_QUOTING[] = "cCfFbdDr";
 
 	size_t cmd_len;
-	char *expanded;
+	strbuf_t expanded = STRBUF_INITIALIZER;
 	size_t x;
-	int len = 0;
 
 	set_flags(flags, MF_NONE);
 
@@ -159,15 +282,12 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 		return strdup(command);
 	}
 
-	expanded = calloc(cmd_len + 1, sizeof(char));
-	strncat(expanded, command, x);
+	(void)strbuf_appendn(&expanded, command, x);
 	x++;
-	len = strlen(expanded);
 
 	do
 	{
 		size_t y;
-		char *p;
 
 		int quotes = 0;
 		if(command[x] == '"' && char_is_one_of(MACROS_WITH_QUOTING, command[x + 1]))
@@ -181,47 +301,39 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 			case 'a': /* user arguments */
 				if(args != NULL)
 				{
-					expanded = append_to_expanded(expanded, args);
-					len = strlen(expanded);
+					(void)strbuf_append(&expanded, args);
 				}
 				break;
 			case 'b': /* selected files of both dirs */
-				expanded = append_selected_files(curr_view, expanded, 0, quotes,
+				append_selected_files(curr_view, &expanded, 0, quotes,
 						command + x + 1, for_shell);
-				expanded = append_to_expanded(expanded, " ");
-				expanded = append_selected_files(other_view, expanded, 0, quotes,
+				(void)strbuf_append(&expanded, " ");
+				append_selected_files(other_view, &expanded, 0, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'c': /* current dir file under the cursor */
-				expanded = append_selected_files(curr_view, expanded, 1, quotes,
+				append_selected_files(curr_view, &expanded, 1, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'C': /* other dir file under the cursor */
-				expanded = append_selected_files(other_view, expanded, 1, quotes,
+				append_selected_files(other_view, &expanded, 1, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'f': /* current dir selected files */
-				expanded = append_selected_files(curr_view, expanded, 0, quotes,
+				append_selected_files(curr_view, &expanded, 0, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'F': /* other dir selected files */
-				expanded = append_selected_files(other_view, expanded, 0, quotes,
+				append_selected_files(other_view, &expanded, 0, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'd': /* current directory */
-				expanded = expand_directory_path(curr_view, expanded, quotes,
+				expand_directory_path(curr_view, &expanded, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'D': /* Directory of the other view. */
-				expanded = expand_directory_path(other_view, expanded, quotes,
+				expand_directory_path(other_view, &expanded, quotes,
 						command + x + 1, for_shell);
-				len = strlen(expanded);
 				break;
 			case 'n': /* Forbid using of terminal multiplexer, even if active. */
 				set_flags(flags, MF_NO_TERM_MUX);
@@ -247,12 +359,17 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 			case 'i': /* Ignore output. */
 				set_flags(flags, MF_IGNORE);
 				break;
+			case 'x': /* Split list of files into several commands if needed. */
+				if(!expanding_batched)
+				{
+					set_flags(flags, MF_BATCHED);
+				}
+				break;
 			case 'r': /* Registers' content. */
 				{
 					int well_formed;
-					expanded = expand_register(flist_get_dir(curr_view), expanded, quotes,
+					expand_register(flist_get_dir(curr_view), &expanded, quotes,
 							command + x + 2, command[x + 1], &well_formed, for_shell);
-					len = strlen(expanded);
 					if(well_formed)
 					{
 						x++;
@@ -265,11 +382,10 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 					const char key = command[x + 1];
 					if(key == 'c')
 					{
-						return expanded;
+						return finish_expansion(&expanded);
 					}
 
-					expanded = expand_preview(expanded, key, &well_formed);
-					len = strlen(expanded);
+					expand_preview(&expanded, key, &well_formed);
 					if(well_formed)
 					{
 						++x;
@@ -277,8 +393,7 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 				}
 				break;
 			case '%':
-				expanded = append_to_expanded(expanded, "%");
-				len = strlen(expanded);
+				(void)strbuf_append(&expanded, "%");
 				break;
 
 			case '\0':
@@ -314,21 +429,26 @@ expand_macros_i(const char command[], const char args[], MacroFlags *flags,
 		assert(x >= y);
 		assert(y <= cmd_len);
 
-		p = realloc(expanded, len + (x - y) + 1);
-		if(p == NULL)
-		{
-			free(expanded);
-			return NULL;
-		}
-		expanded = p;
-		strncat(expanded, command + y, x - y);
-		len = strlen(expanded);
+		(void)strbuf_appendn(&expanded, command + y, x - y);
 
 		++x;
 	}
 	while(x < cmd_len);
 
-	return expanded;
+	return finish_expansion(&expanded);
+}
+
+/* Takes result of expansion out of the buffer reporting memory error if there
+ * was one.  Returns the result or NULL on error. */
+static char *
+finish_expansion(strbuf_t *expanded)
+{
+	char *const result = strbuf_finish(expanded);
+	if(result == NULL)
+	{
+		show_error_msg("Memory Error", "Unable to allocate enough memory");
+	}
+	return result;
 }
 
 /* Sets *flags to the value, if flags isn't NULL. */
@@ -341,53 +461,62 @@ set_flags(MacroFlags *flags, MacroFlags value)
 	}
 }
 
-TSTATIC char *
-append_selected_files(FileView *view, char expanded[], int under_cursor,
+TSTATIC void
+append_selected_files(FileView *view, strbuf_t *expanded, int under_cursor,
 		int quotes, const char mod[], int for_shell)
 {
 	const PathType type = (view == other_view)
 	                    ? PT_FULL
 	                    : (flist_custom_active(view) ? PT_REL : PT_NAME);
 #ifdef _WIN32
-	size_t old_len = strlen(expanded);
+	const size_t old_len = expanded->len;
 #endif
 
-	if(view->selected_files && !under_cursor)
+	if(view == curr_view && batch_entries != NULL && !under_cursor)
+	{
+		int i;
+		for(i = 0; i < batch_count; ++i)
+		{
+			if(i != 0)
+			{
+				(void)strbuf_append(expanded, " ");
+			}
+			append_entry(view, expanded, type, batch_entries[batch_first + i], quotes,
+					mod, for_shell);
+		}
+	}
+	else if(view->selected_files && !under_cursor)
 	{
 		int n = 0;
 		dir_entry_t *entry = NULL;
 		while(iter_selected_entries(view, &entry))
 		{
-			expanded = append_entry(view, expanded, type, entry, quotes, mod,
-					for_shell);
+			append_entry(view, expanded, type, entry, quotes, mod, for_shell);
 
 			if(++n != view->selected_files)
 			{
-				expanded = append_to_expanded(expanded, " ");
+				(void)strbuf_append(expanded, " ");
 			}
 		}
 	}
 	else
 	{
-		expanded = append_entry(view, expanded, type, get_current_entry(view),
-				quotes, mod, for_shell);
+		append_entry(view, expanded, type, get_current_entry(view), quotes, mod,
+				for_shell);
 	}
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && expanded->data != NULL)
 	{
-		to_back_slash(expanded + old_len);
+		to_back_slash(expanded->data + old_len);
 	}
 #endif
-
-	return expanded;
 }
 
-/* Appends path to the entry to the expanded string.  Returns new value of
- * expanded string. */
-static char *
-append_entry(FileView *view, char expanded[], PathType type, dir_entry_t *entry,
-		int quotes, const char mod[], int for_shell)
+/* Appends path to the entry to the expanded string. */
+static void
+append_entry(FileView *view, strbuf_t *expanded, PathType type,
+		dir_entry_t *entry, int quotes, const char mod[], int for_shell)
 {
 	char path[PATH_MAX];
 	const char *modified;
@@ -411,34 +540,31 @@ append_entry(FileView *view, char expanded[], PathType type, dir_entry_t *entry,
 	}
 
 	modified = apply_mods(path, flist_get_dir(view), mod, for_shell);
-	expanded = append_path_to_expanded(expanded, quotes, modified);
-
-	return expanded;
+	append_path_to_expanded(expanded, quotes, modified);
 }
 
-static char *
-expand_directory_path(FileView *view, char *expanded, int quotes,
-		const char *mod, int for_shell)
+static void
+expand_directory_path(FileView *view, strbuf_t *expanded, int quotes,
+		const char mod[], int for_shell)
 {
-	const char *const modified = apply_mods(flist_get_dir(view), "/", mod, for_shell);
-	char *const result = append_path_to_expanded(expanded, quotes, modified);
+	const char *const modified = apply_mods(flist_get_dir(view), "/", mod,
+			for_shell);
+
+	append_path_to_expanded(expanded, quotes, modified);
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && expanded->data != NULL)
 	{
-		to_back_slash(result);
+		to_back_slash(expanded->data);
 	}
 #endif
-
-	return result;
 }
 
 /* Expands content of a register specified by the key argument considering
  * filename-modifiers.  If key is unknown, fallbacks to the default register.
- * Sets *well_formed to non-zero for valid value of the key.  Reallocates the
- * expanded string and returns result (possibly NULL). */
-static char *
-expand_register(const char curr_dir[], char expanded[], int quotes,
+ * Sets *well_formed to non-zero for valid value of the key. */
+static void
+expand_register(const char curr_dir[], strbuf_t *expanded, int quotes,
 		const char mod[], int key, int *well_formed, int for_shell)
 {
 	int i;
@@ -458,29 +584,26 @@ expand_register(const char curr_dir[], char expanded[], int quotes,
 	{
 		const char *const modified = apply_mods(reg->files[i], curr_dir, mod,
 				for_shell);
-		expanded = append_path_to_expanded(expanded, quotes, modified);
+		append_path_to_expanded(expanded, quotes, modified);
 		if(i != reg->nfiles - 1)
 		{
-			expanded = append_to_expanded(expanded, " ");
+			(void)strbuf_append(expanded, " ");
 		}
 	}
 
 #ifdef _WIN32
-	if(for_shell && curr_stats.shell_type == ST_CMD)
+	if(for_shell && curr_stats.shell_type == ST_CMD && expanded->data != NULL)
 	{
-		to_back_slash(expanded);
+		to_back_slash(expanded->data);
 	}
 #endif
-
-	return expanded;
 }
 
 /* Expands preview parameter macros specified by the key argument.  If key is
  * unknown, skips the macro.  Sets *well_formed to non-zero for valid value of
- * the key.  Reallocates the expanded string and returns result (possibly
- * NULL). */
-static char *
-expand_preview(char expanded[], int key, int *well_formed)
+ * the key. */
+static void
+expand_preview(strbuf_t *expanded, int key, int *well_formed)
 {
 	FileView *view;
 	char num_str[32];
@@ -491,7 +614,7 @@ expand_preview(char expanded[], int key, int *well_formed)
 	if(!char_is_one_of("hwxy", key))
 	{
 		*well_formed = 0;
-		return expanded;
+		return;
 	}
 
 	*well_formed = 1;
@@ -516,7 +639,7 @@ expand_preview(char expanded[], int key, int *well_formed)
 
 	snprintf(num_str, sizeof(num_str), "%d", param);
 
-	return append_to_expanded(expanded, num_str);
+	(void)strbuf_append(expanded, num_str);
 }
 
 /* Applies heuristics to determine which view is going to be used for preview.
@@ -542,49 +665,27 @@ get_preview_view(FileView *view)
 }
 
 /* Appends the path to the expanded string with either proper escaping or
- * quoting.  Returns NULL on not enough memory error. */
-static char *
-append_path_to_expanded(char expanded[], int quotes, const char path[])
+ * quoting. */
+static void
+append_path_to_expanded(strbuf_t *expanded, int quotes, const char path[])
 {
 	if(quotes)
 	{
 		const char *const dquoted = enclose_in_dquotes(path);
-		expanded = append_to_expanded(expanded, dquoted);
+		(void)strbuf_append(expanded, dquoted);
 	}
 	else
 	{
 		char *const escaped = shell_like_escape(path, 0);
 		if(escaped == NULL)
 		{
-			show_error_msg("Memory Error", "Unable to allocate enough memory");
-			free(expanded);
-			return NULL;
+			expanded->failed = 1;
+			return;
 		}
 
-		expanded = append_to_expanded(expanded, escaped);
+		(void)strbuf_append(expanded, escaped);
 		free(escaped);
 	}
-
-	return expanded;
-}
-
-/* Appends str to expanded with reallocation.  Returns address of the new
- * string or NULL on reallocation error. */
-static char *
-append_to_expanded(char expanded[], const char str[])
-{
-	char *t;
-	const size_t len = strlen(expanded);
-
-	t = realloc(expanded, len + strlen(str) + 1);
-	if(t == NULL)
-	{
-		show_error_msg("Memory Error", "Unable to allocate enough memory");
-		free(expanded);
-		return NULL;
-	}
-	strcpy(t + len, str);
-	return t;
 }
 
 const char *
@@ -697,6 +798,7 @@ macros_to_str(MacroFlags flags)
 		case MF_SPLIT: return "%s";
 		case MF_IGNORE: return "%i";
 		case MF_NO_TERM_MUX: return "%n";
+		case MF_BATCHED: return "%x";
 	}
 
 	assert(0 && "Unhandled MacroFlags item.");
@@ -23,6 +23,7 @@
 #include <stddef.h> /* size_t */
 
 #include "ui/ui.h"
+#include "utils/strbuf.h"
 #include "utils/test_helpers.h"
 
 /* Macros that affect running of commands and processing their output. */
@@ -39,6 +40,7 @@ typedef enum
 	MF_SPLIT,       /* Run command in a new screen region. */
 	MF_IGNORE,      /* Completely ignore command output. */
 	MF_NO_TERM_MUX, /* Forbid using terminal multiplexer, even if active. */
+	MF_BATCHED,     /* Split command with many files into several ones. */
 }
 MacroFlags;
 
@@ -59,6 +61,14 @@ custom_macro_t;
 char * expand_macros(const char command[], const char args[], MacroFlags *flags,
 		int for_shell);
 
+/* Like expand_macros(), but splits list of selected files of the current view
+ * into several batches, so that each expanded command is at most limit bytes
+ * long (unless single file doesn't fit).  %x macro doesn't affect *flags here,
+ * so they reflect the rest of flag macros.  Returns array of *count commands
+ * or NULL on error. */
+char ** ma_expand_batched(const char command[], const char args[],
+		MacroFlags *flags, size_t limit, int for_shell, int *count);
+
 /* Like expand_macros(), but expands only single element macros and aims for
  * single string, so escaping is disabled. */
 char * ma_expand_single(const char command[]);
@@ -81,7 +91,7 @@ const char * macros_to_str(MacroFlags flags);
 #endif
 
 TSTATIC_DEFS(
-	char * append_selected_files(FileView *view, char expanded[],
+	void append_selected_files(FileView *view, strbuf_t *expanded,
 		int under_cursor, int quotes, const char mod[], int for_shell);
 )
 
@@ -47,64 +47,38 @@ show_history_menu(FileView *view)
 	need_cleanup = 0;
 	for(i = 0; i < view->history_num && i < cfg.history_len; i++)
 	{
+		history_t *const item = flist_hist_get(view, i);
 		int j;
-		if(view->history[i].dir[0] == '\0')
+		if(item->dir[0] == '\0')
 			break;
 		for(j = i + 1; j < view->history_num && j < cfg.history_len; j++)
-			if(stroscmp(view->history[i].dir, view->history[j].dir) == 0)
+			if(stroscmp(item->dir, flist_hist_get(view, j)->dir) == 0)
 				break;
 		if(j < view->history_num && j < cfg.history_len)
 			continue;
-		if(!is_valid_dir(view->history[i].dir))
+		if(!is_valid_dir(item->dir))
 		{
 			/* "Mark" directory as non-existent. */
-			free(view->history[i].dir);
-			view->history[i].dir = NULL;
+			free(item->dir);
+			item->dir = NULL;
 			need_cleanup = 1;
 			continue;
 		}
 
 		/* Change the current dir to reflect the current file. */
-		if(stroscmp(view->history[i].dir, view->curr_dir) == 0)
+		if(stroscmp(item->dir, view->curr_dir) == 0)
 		{
-			(void)replace_string(&view->history[i].file, get_current_file_name(view));
+			(void)replace_string(&item->file, get_current_file_name(view));
 			m.pos = m.len;
 		}
 
-		m.len = add_to_string_array(&m.items, m.len, 1, view->history[i].dir);
+		m.len = add_to_string_array(&m.items, m.len, 1, item->dir);
 	}
 
 	if(need_cleanup)
 	{
-		int i, j;
-
 		/* Erase non existing directories from history. */
-		j = 0;
-		for(i = 0; i < view->history_num && i < cfg.history_len; ++i)
-		{
-			if(view->history[i].dir == NULL)
-			{
-				free(view->history[i].file);
-				continue;
-			}
-
-			if(j != i)
-			{
-				view->history[j] = view->history[i];
-
-				view->history[i].dir = NULL;
-				view->history[i].file = NULL;
-				view->history[i].rel_pos = -1;
-			}
-
-			if(view->history_pos == i)
-			{
-				view->history_pos = j;
-			}
-
-			++j;
-		}
-		view->history_num = j;
+		flist_hist_compact(view);
 	}
 
 	/* Reverse order in which items appear. */
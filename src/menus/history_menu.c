@@ -90,7 +90,7 @@ show_history(FileView *view, HistoryType type, hist_t *hist, const char title[])
 
 	for(i = 0; i <= hist->pos; ++i)
 	{
-		m.len = add_to_string_array(&m.items, m.len, 1, hist->items[i]);
+		m.len = add_to_string_array(&m.items, m.len, 1, hist_get(hist, i));
 	}
 
 	return display_menu(&m, view);
@@ -1490,7 +1490,7 @@ hist_next(line_stats_t *stat, const hist_t *hist, size_t len)
 		int len = stat->hist_search_len;
 		while(--pos >= 0)
 		{
-			wchar_t *const buf = to_wide(hist->items[pos]);
+			wchar_t *const buf = to_wide(hist_get(hist, pos));
 			if(wcsncmp(stat->line, buf, len) == 0)
 			{
 				free(buf);
@@ -1506,7 +1506,7 @@ hist_next(line_stats_t *stat, const hist_t *hist, size_t len)
 		stat->cmd_pos = pos;
 	}
 
-	(void)replace_input_line(stat, hist->items[stat->cmd_pos]);
+	(void)replace_input_line(stat, hist_get(hist, stat->cmd_pos));
 
 	update_cmdline(stat);
 
@@ -1930,7 +1930,8 @@ next_dot_completion(void)
 
 	if(input_stat.dot_pos <= cfg.cmd_hist.pos)
 	{
-		last = get_last_argument(cfg.cmd_hist.items[input_stat.dot_pos++], 1, &len);
+		last = get_last_argument(hist_get(&cfg.cmd_hist, input_stat.dot_pos++), 1,
+				&len);
 	}
 	else
 	{
@@ -2180,7 +2181,7 @@ hist_prev(line_stats_t *stat, const hist_t *hist, size_t len)
 		 * changed. */
 		if(stat->cmd_pos == 0 && hist->pos != 0)
 		{
-			wchar_t *const wide_item = to_wide(hist->items[0]);
+			wchar_t *const wide_item = to_wide(hist_get(hist, 0));
 			if(wcscmp(stat->line, wide_item) == 0)
 			{
 				++stat->cmd_pos;
@@ -2194,7 +2195,7 @@ hist_prev(line_stats_t *stat, const hist_t *hist, size_t len)
 		int len = stat->hist_search_len;
 		while(++pos <= hist->pos)
 		{
-			wchar_t *const wide_item = to_wide(hist->items[pos]);
+			wchar_t *const wide_item = to_wide(hist_get(hist, pos));
 			if(wcsncmp(stat->line, wide_item, len) == 0)
 			{
 				free(wide_item);
@@ -2207,7 +2208,7 @@ hist_prev(line_stats_t *stat, const hist_t *hist, size_t len)
 		stat->cmd_pos = pos;
 	}
 
-	(void)replace_input_line(stat, hist->items[stat->cmd_pos]);
+	(void)replace_input_line(stat, hist_get(hist, stat->cmd_pos));
 
 	update_cmdline(stat);
 
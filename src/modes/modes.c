@@ -142,6 +142,12 @@ modes_periodic(void)
 	view_check_for_updates();
 }
 
+int
+modes_needs_periodic(void)
+{
+	return view_needs_updates_check();
+}
+
 void
 modes_post(void)
 {
@@ -472,7 +472,7 @@ cmd_ctrl_c(key_info_t key_info, keys_info_t *keys_info)
 {
 	ui_view_reset_search_highlight(curr_view);
 	clean_selected_files(curr_view);
-	redraw_current_view();
+	fview_redraw_damaged(curr_view);
 }
 
 /* Scroll view down by half of its height. */
@@ -1752,22 +1752,14 @@ cmd_q_equals(key_info_t key_info, keys_info_t *keys_info)
 static void
 cmd_t(key_info_t key_info, keys_info_t *keys_info)
 {
-	if(curr_view->dir_entry[curr_view->list_pos].selected == 0)
-	{
-		/* The ../ dir cannot be selected */
-		if(is_parent_dir(curr_view->dir_entry[curr_view->list_pos].name))
-			return;
+	const dir_entry_t *const entry = &curr_view->dir_entry[curr_view->list_pos];
 
-		curr_view->dir_entry[curr_view->list_pos].selected = 1;
-		curr_view->selected_files++;
-	}
-	else
-	{
-		curr_view->dir_entry[curr_view->list_pos].selected = 0;
-		curr_view->selected_files--;
-	}
+	/* The ../ dir cannot be selected */
+	if(!entry->selected && is_parent_dir(entry->name))
+		return;
 
-	fview_cursor_redraw(curr_view);
+	flist_sel_entry(curr_view, curr_view->list_pos, !entry->selected);
+	fview_redraw_damaged(curr_view);
 }
 
 /* Undo last command group. */
@@ -1541,6 +1541,14 @@ view_check_for_updates(void)
 	}
 }
 
+int
+view_needs_updates_check(void)
+{
+	return view_info[VI_QV].auto_forward
+	    || view_info[VI_LWIN].auto_forward
+	    || view_info[VI_RWIN].auto_forward;
+}
+
 /* Forwards the view if underlying file changed.  Returns non-zero if reload
  * occurred, otherwise zero is returned. */
 static int
@@ -148,6 +148,7 @@ static void apply_selection(int pos);
 static void revert_selection(int pos);
 static int is_parent_dir_at(int pos);
 static void update(void);
+static void update_damaged(void);
 static int find_update(FileView *view, int backward);
 static void goto_pos_force_update(int pos);
 static void goto_pos(int pos);
@@ -341,17 +342,12 @@ static void
 restore_selection_flags(FileView *view)
 {
 	int i;
-
-	view->selected_files = 0;
 	for(i = 0; i < view->list_rows; ++i)
 	{
 		dir_entry_t *const entry = &view->dir_entry[i];
 		entry->selected = entry->was_selected;
-		if(entry->selected)
-		{
-			++view->selected_files;
-		}
 	}
+	recount_selected_files(view);
 }
 
 /* Increments first number in names of marked files of the view [count=1]
@@ -1226,34 +1222,18 @@ select_down_one(FileView *view, int start_pos)
 static void
 apply_selection(int pos)
 {
-	dir_entry_t *const entry = &view->dir_entry[pos];
+	const dir_entry_t *const entry = &view->dir_entry[pos];
 	switch(amend_type)
 	{
 		case AT_NONE:
 		case AT_APPEND:
-			if(!entry->selected)
-			{
-				++view->selected_files;
-				entry->selected = 1;
-			}
+			flist_sel_entry(view, pos, 1);
 			break;
 		case AT_REMOVE:
-			if(entry->selected)
-			{
-				--view->selected_files;
-				entry->selected = 0;
-			}
+			flist_sel_entry(view, pos, 0);
 			break;
 		case AT_INVERT:
-			if(entry->selected && entry->was_selected)
-			{
-				--view->selected_files;
-			}
-			else if(!entry->selected && !entry->was_selected)
-			{
-				++view->selected_files;
-			}
-			entry->selected = !entry->was_selected;
+			flist_sel_entry(view, pos, !entry->was_selected);
 			break;
 
 		default:
@@ -1266,34 +1246,19 @@ apply_selection(int pos)
 static void
 revert_selection(int pos)
 {
-	dir_entry_t *const entry = &view->dir_entry[pos];
+	const dir_entry_t *const entry = &view->dir_entry[pos];
 	switch(amend_type)
 	{
 		case AT_NONE:
 		case AT_APPEND:
-			if(entry->selected && !entry->was_selected)
-			{
-				--view->selected_files;
-			}
-			entry->selected = entry->was_selected;
+		case AT_INVERT:
+			flist_sel_entry(view, pos, entry->was_selected);
 			break;
 		case AT_REMOVE:
-			if(!entry->selected && entry->was_selected)
-			{
-				++view->selected_files;
-				entry->selected = 1;
-			}
-			break;
-		case AT_INVERT:
-			if(entry->selected && !entry->was_selected)
-			{
-				--view->selected_files;
-			}
-			else if(!entry->selected && entry->was_selected)
+			if(entry->was_selected)
 			{
-				++view->selected_files;
+				flist_sel_entry(view, pos, 1);
 			}
-			entry->selected = entry->was_selected;
 			break;
 
 		default:
@@ -1318,14 +1283,23 @@ update(void)
 	ui_ruler_update(view);
 }
 
+/* Same as update(), but redraws only entries which selection has changed and
+ * the cursor. */
+static void
+update_damaged(void)
+{
+	fview_redraw_damaged(view);
+	ui_ruler_update(view);
+}
+
 void
 update_visual_mode(void)
 {
 	int pos = view->list_pos;
 
 	clean_selected_files(view);
-	view->dir_entry[start_pos].selected = 1;
-	view->selected_files = 1;
+	flist_sel_entry(view, start_pos, 1);
+	ui_view_invalidate(view);
 
 	view->list_pos = start_pos;
 	goto_pos(pos);
@@ -1345,6 +1319,8 @@ find_vpattern(FileView *view, const char *pattern, int backward,
 	cfg.hl_search = 0;
 	result = find_pattern(view, pattern, backward, 0, &found, interactive);
 	cfg.hl_search = hls;
+	/* Search can change state of any entry. */
+	ui_view_invalidate(view);
 	for(i = 0; i < search_repeat; i++)
 		find_update(view, backward);
 	return result;
@@ -1368,7 +1344,7 @@ static void
 goto_pos_force_update(int pos)
 {
 	(void)move_pos(pos);
-	update();
+	update_damaged();
 }
 
 /* Moves cursor from its current position to specified pos selecting or
@@ -1378,7 +1354,7 @@ goto_pos(int pos)
 {
 	if(move_pos(pos))
 	{
-		update();
+		update_damaged();
 	}
 }
 
@@ -21,13 +21,16 @@
 
 #include <stddef.h> /* NULL size_t */
 #include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
 #include <string.h>
 
+#include "compat/fs_limits.h"
 #include "compat/reallocarray.h"
 #include "utils/fs.h"
 #include "utils/macros.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
+#include "utils/trie.h"
 #include "utils/utils.h"
 #include "trash.h"
 
@@ -40,6 +43,14 @@
 /* Number of all available registers (excludes 26 uppercase letters). */
 #define NUM_REGISTERS (2 + NUM_LETTER_REGISTERS)
 
+static int append_file(reg_t *reg, const char file[]);
+static int is_duplicate(reg_t *reg, const char file[]);
+static int build_index(reg_t *reg);
+static void drop_index(reg_t *reg);
+static const char * get_index_key(const char file[], char buf[],
+		size_t buf_len);
+static int check_for_duplicate_file_names(reg_t *reg, const char file[]);
+
 /* Data of all registers. */
 static reg_t registers[NUM_REGISTERS];
 
@@ -66,6 +77,8 @@ regs_init(void)
 		registers[i].name = valid_registers[i];
 		registers[i].nfiles = 0;
 		registers[i].files = NULL;
+		registers[i].capacity = 0;
+		registers[i].index = NULL_TRIE;
 	}
 }
 
@@ -97,22 +110,18 @@ regs_find(int reg_name)
 	return NULL;
 }
 
-static int
-check_for_duplicate_file_names(reg_t *reg, const char file[])
+int
+regs_append(int reg_name, const char file[])
 {
-	int i;
-	for(i = 0; i < reg->nfiles; ++i)
+	if(reg_name != BLACKHOLE_REG_NAME && !path_exists(file, NODEREF))
 	{
-		if(stroscmp(file, reg->files[i]) == 0)
-		{
-			return 1;
-		}
+		return 1;
 	}
-	return 0;
+	return regs_append_listed(reg_name, file);
 }
 
 int
-regs_append(int reg_name, const char file[])
+regs_append_listed(int reg_name, const char file[])
 {
 	reg_t *reg;
 
@@ -124,16 +133,130 @@ regs_append(int reg_name, const char file[])
 	{
 		return 1;
 	}
-	if(!path_exists(file, NODEREF))
+	return append_file(reg, file);
+}
+
+/* Adds file to the list of the register unless it's already there.  Returns
+ * zero when file is added, otherwise non-zero is returned. */
+static int
+append_file(reg_t *reg, const char file[])
+{
+	char *copy;
+
+	if(reg->nfiles == reg->capacity)
+	{
+		const int new_capacity = (reg->capacity == 0) ? 16 : reg->capacity*2;
+		char **const files = reallocarray(reg->files, new_capacity,
+				sizeof(*files));
+		if(files == NULL)
+		{
+			return 1;
+		}
+		reg->files = files;
+		reg->capacity = new_capacity;
+	}
+
+	copy = strdup(file);
+	if(copy == NULL)
 	{
 		return 1;
 	}
-	if(check_for_duplicate_file_names(reg, file))
+	if(is_duplicate(reg, copy))
 	{
+		free(copy);
 		return 1;
 	}
 
-	reg->nfiles = add_to_string_array(&reg->files, reg->nfiles, 1, file);
+	reg->files[reg->nfiles++] = copy;
+	return 0;
+}
+
+/* Checks whether file is in the register and records it in the index if it's
+ * not.  Returns non-zero if file is a duplicate, otherwise zero is returned. */
+static int
+is_duplicate(reg_t *reg, const char file[])
+{
+	char key[PATH_MAX];
+	int result;
+
+	if(reg->index == NULL_TRIE && build_index(reg) != 0)
+	{
+		return check_for_duplicate_file_names(reg, file);
+	}
+
+	result = trie_put(reg->index, get_index_key(file, key, sizeof(key)));
+	if(result < 0)
+	{
+		drop_index(reg);
+		return check_for_duplicate_file_names(reg, file);
+	}
+	return result > 0;
+}
+
+/* Fills index of the register with its files.  Returns zero on success,
+ * otherwise non-zero is returned. */
+static int
+build_index(reg_t *reg)
+{
+	char key[PATH_MAX];
+	int i;
+
+	reg->index = trie_create();
+	if(reg->index == NULL_TRIE)
+	{
+		return 1;
+	}
+
+	for(i = 0; i < reg->nfiles; ++i)
+	{
+		const char *file = reg->files[i];
+		if(file != NULL && trie_put(reg->index, get_index_key(file, key,
+						sizeof(key))) < 0)
+		{
+			drop_index(reg);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Frees index of the register, it will be rebuilt when needed again.  Must be
+ * called whenever files are removed or renamed. */
+static void
+drop_index(reg_t *reg)
+{
+	trie_free(reg->index);
+	reg->index = NULL_TRIE;
+}
+
+/* Makes key of the index for the file, which accounts for case insensitivity of
+ * paths on some systems.  Returns pointer to the key. */
+static const char *
+get_index_key(const char file[], char buf[], size_t buf_len)
+{
+#ifndef _WIN32
+	(void)buf;
+	(void)buf_len;
+	return file;
+#else
+	(void)str_to_lower(file, buf, buf_len);
+	return buf;
+#endif
+}
+
+/* Checks whether file is in the register by comparing it with each of its
+ * files.  Returns non-zero if so, otherwise zero is returned. */
+static int
+check_for_duplicate_file_names(reg_t *reg, const char file[])
+{
+	int i;
+	for(i = 0; i < reg->nfiles; ++i)
+	{
+		if(reg->files[i] != NULL && stroscmp(file, reg->files[i]) == 0)
+		{
+			return 1;
+		}
+	}
 	return 0;
 }
 
@@ -159,6 +282,8 @@ regs_clear(int reg_name)
 	free_string_array(reg->files, reg->nfiles);
 	reg->files = NULL;
 	reg->nfiles = 0;
+	reg->capacity = 0;
+	drop_index(reg);
 }
 
 void
@@ -180,6 +305,8 @@ regs_pack(int reg_name)
 		}
 	}
 	reg->nfiles = j;
+
+	drop_index(reg);
 }
 
 char **
@@ -227,6 +354,7 @@ regs_rename_contents(const char old[], const char new[])
 				continue;
 
 			(void)replace_string(&registers[i].files[j], new);
+			drop_index(&registers[i]);
 			/* Registers don't contain duplicates, so exit this loop. */
 			break;
 		}
@@ -275,9 +403,15 @@ regs_update_unnamed(int reg_name)
 
 	regs_clear(UNNAMED_REG_NAME);
 
+	/* Just copy the list, index for duplicates is built if it's ever needed. */
+	unnamed->files = reallocarray(NULL, reg->nfiles, sizeof(char *));
+	if(unnamed->files == NULL)
+	{
+		return;
+	}
+
 	unnamed->nfiles = reg->nfiles;
-	unnamed->files = reallocarray(unnamed->files, unnamed->nfiles,
-			sizeof(char *));
+	unnamed->capacity = reg->nfiles;
 	for(i = 0; i < unnamed->nfiles; ++i)
 	{
 		unnamed->files[i] = strdup(reg->files[i]);
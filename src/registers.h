@@ -20,6 +20,8 @@
 #ifndef VIFM__REGISTERS_H__
 #define VIFM__REGISTERS_H__
 
+#include "utils/trie.h"
+
 /* Name of the default register. */
 #define DEFAULT_REG_NAME '"'
 
@@ -29,6 +31,8 @@ typedef struct
 	int name;     /* Name of the register. */
 	int nfiles;   /* Number of files in the register. */
 	char **files; /* List of full paths of files. */
+	int capacity; /* Number of elements allocated for the files array. */
+	trie_t index; /* Set of files for checking duplicates, built on demand. */
 }
 reg_t;
 
@@ -51,6 +55,10 @@ reg_t * regs_find(int reg_name);
  * is added, otherwise non-zero is returned. */
 int regs_append(int reg_name, const char file[]);
 
+/* Same as regs_append(), but doesn't check whether file exists.  Meant for
+ * paths that were just obtained from a listing of a directory. */
+int regs_append_listed(int reg_name, const char file[]);
+
 /* Clears all registers.  Pair of regs_init(). */
 void regs_reset(void);
 
@@ -22,22 +22,47 @@
 #include <regex.h> /* regmatch_t regcomp() regexec() regfree() */
 
 #include <assert.h> /* assert() */
+#include <stddef.h> /* NULL */
 #include <stdio.h> /* snprintf() */
-#include <string.h>
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strlen() strncasecmp() strncmp() strstr() */
 
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
+#include "compat/reallocarray.h"
 #include "ui/fileview.h"
 #include "ui/statusbar.h"
 #include "ui/ui.h"
+#include "utils/parallel.h"
 #include "utils/path.h"
 #include "utils/regexp.h"
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "filelist.h"
 
+/* Description of list matching for parallel processing. */
+typedef struct
+{
+	dir_entry_t *entries; /* List of entries. */
+	const int *indexes;   /* Indexes of entries to check or NULL for a range. */
+
+	const char *pattern; /* Pattern to match against. */
+	int cflags;          /* Flags for regcomp(). */
+	int literal;         /* Whether pattern can be matched as plain string. */
+	const regex_t *re;   /* Compiled pattern for the calling thread. */
+}
+match_job_t;
+
 static int find_and_goto_pattern(FileView *view, int wrap_start, int backward);
 static int find_and_goto_match(FileView *view, int start, int backward);
+static int * get_narrowing_candidates(const FileView *view,
+		const char pattern[], int cflags, int *count);
+static void match_entries(dir_entry_t entries[], const int indexes[], int count,
+		const char pattern[], int cflags, const regex_t *re);
+static void match_chunk(int from, int to, int chunk, void *arg);
+static int is_literal_pattern(const char pattern[], int cflags);
+static const char * find_literal(const char str[], const char pattern[],
+		int icase);
 static void print_result(const FileView *const view, int found, int backward);
 
 int
@@ -118,10 +143,9 @@ find_pattern(FileView *view, const char pattern[], int backward, int move,
 		clean_selected_files(view);
 	}
 
-	reset_search_results(view);
-
 	if(pattern[0] == '\0')
 	{
+		reset_search_results(view);
 		*found = 1;
 		return 0;
 	}
@@ -132,32 +156,41 @@ find_pattern(FileView *view, const char pattern[], int backward, int move,
 	if((err = regcomp(&re, pattern, cflags)) == 0)
 	{
 		int i;
+		int count;
+		int *const candidates = get_narrowing_candidates(view, pattern, cflags,
+				&count);
+
+		reset_search_results(view);
+
+		if(candidates == NULL)
+		{
+			match_entries(view->dir_entry, NULL, view->list_rows, pattern, cflags,
+					&re);
+		}
+		else
+		{
+			match_entries(view->dir_entry, candidates, count, pattern, cflags, &re);
+			free(candidates);
+		}
+		regfree(&re);
+
+		/* Numbering matches and selecting them requires sequential pass. */
 		for(i = 0; i < view->list_rows; ++i)
 		{
-			regmatch_t matches[1];
 			dir_entry_t *const entry = &view->dir_entry[i];
-
-			if(is_parent_dir(entry->name))
-			{
-				continue;
-			}
-
-			if(regexec(&re, entry->name, 1, matches, 0) != 0)
+			if(!entry->search_match)
 			{
 				continue;
 			}
 
 			entry->search_match = nmatches + 1;
-			entry->match_left = matches[0].rm_so;
-			entry->match_right = matches[0].rm_eo;
+			fview_damage_entry(view, i);
 			if(cfg.hl_search)
 			{
-				entry->selected = 1;
-				++view->selected_files;
+				flist_sel_entry(view, i, 1);
 			}
 			++nmatches;
 		}
-		regfree(&re);
 	}
 	else
 	{
@@ -166,6 +199,7 @@ find_pattern(FileView *view, const char pattern[], int backward, int move,
 			status_bar_errorf("Regexp error: %s", get_regexp_error(err, &re));
 		}
 		regfree(&re);
+		reset_search_results(view);
 		return 1;
 	}
 
@@ -177,9 +211,10 @@ find_pattern(FileView *view, const char pattern[], int backward, int move,
 	}
 	view->matches = nmatches;
 	copy_str(view->last_search, sizeof(view->last_search), pattern);
+	view->last_search_cflags = cflags;
 
 	/* Need to redraw the list so that the matching files are highlighted */
-	draw_dir_list(view);
+	fview_draw_damaged(view);
 
 	view->matches = nmatches;
 	if(nmatches > 0)
@@ -214,6 +249,196 @@ find_pattern(FileView *view, const char pattern[], int backward, int move,
 	}
 }
 
+/* Checks whether results of previous search can be narrowed down instead of
+ * matching the whole list, which is the case when both patterns are literal and
+ * new one extends the previous one.  Returns NULL if full pass is needed,
+ * otherwise newly allocated array of indexes of entries to check is returned
+ * and *count is set to its length. */
+static int *
+get_narrowing_candidates(const FileView *view, const char pattern[],
+		int cflags, int *count)
+{
+	int i;
+	int *candidates;
+	const size_t prev_len = strlen(view->last_search);
+
+	/* Too long pattern might have been truncated. */
+	if(view->matches == 0 || prev_len == 0 ||
+			prev_len >= sizeof(view->last_search) - 1U)
+	{
+		return NULL;
+	}
+
+	/* Switching from case sensitive to case insensitive matching can extend the
+	 * set of matches. */
+	if((cflags & REG_ICASE) && !(view->last_search_cflags & REG_ICASE))
+	{
+		return NULL;
+	}
+
+	if(strncmp(pattern, view->last_search, prev_len) != 0 ||
+			!is_literal_pattern(view->last_search, view->last_search_cflags) ||
+			!is_literal_pattern(pattern, cflags))
+	{
+		return NULL;
+	}
+
+	candidates = reallocarray(NULL, view->matches, sizeof(*candidates));
+	if(candidates == NULL)
+	{
+		return NULL;
+	}
+
+	*count = 0;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		if(view->dir_entry[i].search_match)
+		{
+			if(*count == view->matches)
+			{
+				break;
+			}
+			candidates[(*count)++] = i;
+		}
+	}
+
+	/* The list might have changed since the last search, in which case previous
+	 * results are of no use. */
+	if(i != view->list_rows || *count != view->matches)
+	{
+		free(candidates);
+		return NULL;
+	}
+
+	return candidates;
+}
+
+/* Marks entries that match the pattern by setting their search_match field to
+ * non-zero value, other entries are left untouched.  Entries to check are
+ * either specified via array of their indexes or, if indexes is NULL, count of
+ * first entries of the list.  Large lists are processed in parallel. */
+static void
+match_entries(dir_entry_t entries[], const int indexes[], int count,
+		const char pattern[], int cflags, const regex_t *re)
+{
+	match_job_t job = {
+		.entries = entries,
+		.indexes = indexes,
+		.pattern = pattern,
+		.cflags = cflags,
+		.literal = is_literal_pattern(pattern, cflags),
+		.re = re,
+	};
+
+	parallel_for(count, PARALLEL_MIN_CHUNK, &match_chunk, &job);
+}
+
+/* Matches part of entries of the job against its pattern.  Implements
+ * parallel_range_func. */
+static void
+match_chunk(int from, int to, int chunk, void *arg)
+{
+	const match_job_t *const job = arg;
+	regex_t local_re;
+	const regex_t *re = job->re;
+	int i;
+
+	/* Other threads can't share regular expression with the calling one. */
+	if(!job->literal && chunk != 0)
+	{
+		if(regcomp(&local_re, job->pattern, job->cflags) != 0)
+		{
+			regfree(&local_re);
+			return;
+		}
+		re = &local_re;
+	}
+
+	for(i = from; i < to; ++i)
+	{
+		const int idx = (job->indexes == NULL) ? i : job->indexes[i];
+		dir_entry_t *const entry = &job->entries[idx];
+		regmatch_t match;
+
+		if(is_parent_dir(entry->name))
+		{
+			continue;
+		}
+
+		if(job->literal)
+		{
+			const char *const pos = find_literal(entry->name, job->pattern,
+					job->cflags & REG_ICASE);
+			if(pos == NULL)
+			{
+				continue;
+			}
+			match.rm_so = pos - entry->name;
+			match.rm_eo = match.rm_so + strlen(job->pattern);
+		}
+		else if(regexec(re, entry->name, 1, &match, 0) != 0)
+		{
+			continue;
+		}
+
+		entry->search_match = 1;
+		entry->match_left = match.rm_so;
+		entry->match_right = match.rm_eo;
+	}
+
+	if(re == &local_re)
+	{
+		regfree(&local_re);
+	}
+}
+
+/* Checks whether pattern can be matched as a plain string.  Case insensitive
+ * matching is performed this way only for ASCII patterns.  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+is_literal_pattern(const char pattern[], int cflags)
+{
+	if(!regexp_is_literal(pattern))
+	{
+		return 0;
+	}
+
+	if(cflags & REG_ICASE)
+	{
+		const unsigned char *p = (const unsigned char *)pattern;
+		while(*p != '\0' && *p < 0x80)
+		{
+			++p;
+		}
+		return *p == '\0';
+	}
+
+	return 1;
+}
+
+/* Finds first occurrence of the pattern in the string.  Returns pointer to the
+ * occurrence or NULL if there is none. */
+static const char *
+find_literal(const char str[], const char pattern[], int icase)
+{
+	size_t len;
+
+	if(!icase)
+	{
+		return strstr(str, pattern);
+	}
+
+	len = strlen(pattern);
+	for(; *str != '\0'; ++str)
+	{
+		if(strncasecmp(str, pattern, len) == 0)
+		{
+			return str;
+		}
+	}
+	return NULL;
+}
+
 /* Prints success or error message, determined by the found argument, about
  * search results to a user. */
 static void
@@ -300,7 +525,11 @@ reset_search_results(FileView *view)
 	int i;
 	for(i = 0; i < view->list_rows; ++i)
 	{
-		view->dir_entry[i].search_match = 0;
+		if(view->dir_entry[i].search_match)
+		{
+			view->dir_entry[i].search_match = 0;
+			fview_damage_entry(view, i);
+		}
 	}
 	view->matches = 0;
 }
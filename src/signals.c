@@ -42,7 +42,10 @@ static void _gnuc_noreturn shutdown_nicely(int sig, const char descr[]);
 #ifndef _WIN32
 
 #include <sys/types.h> /* pid_t */
-#include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() waitpid() */
+#include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() WIFSIGNALED() WTERMSIG()
+                         waitpid() */
+#include <fcntl.h> /* FD_CLOEXEC F_GETFL F_SETFD F_SETFL O_NONBLOCK fcntl() */
+#include <unistd.h> /* pipe() read() write() */
 
 #include <stdlib.h> /* EXIT_FAILURE _Exit() */
 
@@ -50,6 +53,13 @@ static void _gnuc_noreturn shutdown_nicely(int sig, const char descr[]);
 #include "background.h"
 #include "status.h"
 
+static void setup_wakeup_pipe(void);
+static void setup_wakeup_fd(int fd);
+static void wake_up_main_loop(void);
+
+/* Pipe that is written to on signals to wake up the main loop. */
+static int wakeup_pipe[2] = { -1, -1 };
+
 /* Handle term resizing in X */
 static void
 received_sigwinch(void)
@@ -87,6 +97,11 @@ received_sigchld(void)
 		{
 			add_finished_job(pid, WEXITSTATUS(status));
 		}
+		else if(WIFSIGNALED(status))
+		{
+			/* Otherwise killed process would be listed as a running job forever. */
+			add_finished_job(pid, 128 + WTERMSIG(status));
+		}
 	}
 }
 
@@ -118,9 +133,53 @@ handle_signal(int sig)
 			break;
 	}
 
+	if(sig == SIGCHLD || sig == SIGWINCH || sig == SIGCONT)
+	{
+		wake_up_main_loop();
+	}
+
 	errno = saved_errno;
 }
 
+/* Creates pipe used to wake up the main loop.  Failure to do so is not fatal,
+ * the main loop falls back to periodic checks in this case. */
+static void
+setup_wakeup_pipe(void)
+{
+	if(pipe(wakeup_pipe) != 0)
+	{
+		wakeup_pipe[0] = -1;
+		wakeup_pipe[1] = -1;
+		return;
+	}
+
+	setup_wakeup_fd(wakeup_pipe[0]);
+	setup_wakeup_fd(wakeup_pipe[1]);
+}
+
+/* Makes file descriptor of the wake up pipe non-blocking and not inherited by
+ * child processes. */
+static void
+setup_wakeup_fd(int fd)
+{
+	(void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	(void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+}
+
+/* Makes the main loop process results of signal handling. */
+static void
+wake_up_main_loop(void)
+{
+	if(wakeup_pipe[1] != -1)
+	{
+		/* Full pipe is fine, the main loop will wake up anyway. */
+		if(write(wakeup_pipe[1], "", 1) < 0)
+		{
+			return;
+		}
+	}
+}
+
 #else
 BOOL WINAPI
 ctrl_handler(DWORD dwCtrlType)
@@ -174,6 +233,8 @@ setup_signals(void)
 #ifndef _WIN32
 	struct sigaction handle_signal_action;
 
+	setup_wakeup_pipe();
+
 	handle_signal_action.sa_handler = &handle_signal;
 	sigemptyset(&handle_signal_action.sa_mask);
 	handle_signal_action.sa_flags = SA_RESTART;
@@ -203,5 +264,31 @@ setup_signals(void)
 #endif
 }
 
+int
+signals_get_wakeup_fd(void)
+{
+#ifndef _WIN32
+	return wakeup_pipe[0];
+#else
+	return -1;
+#endif
+}
+
+void
+signals_clear_wakeup(void)
+{
+#ifndef _WIN32
+	char buf[64];
+
+	if(wakeup_pipe[0] != -1)
+	{
+		while(read(wakeup_pipe[0], buf, sizeof(buf)) > 0)
+		{
+			/* Just drain the pipe. */
+		}
+	}
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -22,6 +22,14 @@
 
 void setup_signals(void);
 
+/* Retrieves file descriptor that becomes readable after receiving a signal
+ * that might require some processing in the main loop.  Returns the descriptor
+ * or -1 if there is none. */
+int signals_get_wakeup_fd(void);
+
+/* Resets readiness state of descriptor returned by signals_get_wakeup_fd(). */
+void signals_clear_wakeup(void);
+
 #endif /* VIFM__SIGNALS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
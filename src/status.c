@@ -83,6 +83,8 @@ static pthread_mutex_t dcache_nitems_mutex = PTHREAD_MUTEX_INITIALIZER;
 static fsdata_t *dcache_size;
 /* Cache for directory item count. */
 static fsdata_t *dcache_nitems;
+/* Number of updates of dcache_size. */
+static unsigned int dcache_size_gen;
 
 int
 init_status(config_t *config)
@@ -402,6 +404,7 @@ dcache_set_at(const char path[], uint64_t size, uint64_t nitems)
 
 		pthread_mutex_lock(&dcache_size_mutex);
 		ret |= fsdata_set(dcache_size, path, &data, sizeof(data));
+		++dcache_size_gen;
 		pthread_mutex_unlock(&dcache_size_mutex);
 	}
 
@@ -417,5 +420,17 @@ dcache_set_at(const char path[], uint64_t size, uint64_t nitems)
 	return ret;
 }
 
+unsigned int
+dcache_generation(void)
+{
+	unsigned int gen;
+
+	pthread_mutex_lock(&dcache_size_mutex);
+	gen = dcache_size_gen;
+	pthread_mutex_unlock(&dcache_size_mutex);
+
+	return gen;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -131,6 +131,7 @@ const char *tags[] = {
 	"vifm---no-configs",
 	"vifm---on-choose",
 	"vifm---remote",
+	"vifm---remote-wait",
 	"vifm---select",
 	"vifm---server-list",
 	"vifm---server-name",
@@ -38,6 +38,7 @@
 #include "../utils/fsddata.h"
 #include "../utils/macros.h"
 #include "../utils/matcher.h"
+#include "../utils/matcher_index.h"
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/utils.h"
@@ -369,6 +370,7 @@ static void restore_primary_color_scheme(const col_scheme_t *cs);
 static void reset_to_default_color_scheme(col_scheme_t *cs);
 static void free_color_scheme_highlights(col_scheme_t *cs);
 static file_hi_t * clone_color_scheme_highlights(const col_scheme_t *from);
+static void update_file_hi_index(col_scheme_t *cs);
 static void reset_color_scheme_colors(col_scheme_t *cs);
 static int source_cs(const char name[]);
 static void get_cs_path(const char name[], char buf[], size_t buf_size);
@@ -703,6 +705,8 @@ assign_color_scheme(col_scheme_t *to, const col_scheme_t *from)
 	free_color_scheme_highlights(to);
 	*to = *from;
 	to->file_hi = clone_color_scheme_highlights(from);
+	to->file_hi_index = NULL;
+	update_file_hi_index(to);
 }
 
 /* Resets color scheme to default builtin values. */
@@ -730,9 +734,11 @@ free_color_scheme_highlights(col_scheme_t *cs)
 	}
 
 	free(cs->file_hi);
+	matcher_index_free(cs->file_hi_index);
 
 	cs->file_hi = NULL;
 	cs->file_hi_count = 0;
+	cs->file_hi_index = NULL;
 }
 
 /* Clones filename specific highlight array of the *from color scheme and
@@ -974,9 +980,44 @@ add_file_hi(struct matcher_t *matcher, const col_attr_t *hi)
 
 	++cs->file_hi_count;
 
+	update_file_hi_index(cs);
+
 	return 0;
 }
 
+/* Brings index of file highlights up to date by either adding the last element
+ * to it or building it from scratch.  Index is dropped on failure, which makes
+ * lookups slower, but doesn't affect their results. */
+static void
+update_file_hi_index(col_scheme_t *cs)
+{
+	int i;
+
+	if(cs->file_hi_index != NULL)
+	{
+		i = cs->file_hi_count - 1;
+	}
+	else
+	{
+		i = 0;
+		cs->file_hi_index = matcher_index_alloc();
+		if(cs->file_hi_index == NULL)
+		{
+			return;
+		}
+	}
+
+	for(; i < cs->file_hi_count; ++i)
+	{
+		if(matcher_index_add(cs->file_hi_index, cs->file_hi[i].matcher) != 0)
+		{
+			matcher_index_free(cs->file_hi_index);
+			cs->file_hi_index = NULL;
+			break;
+		}
+	}
+}
+
 const col_attr_t *
 get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 {
@@ -989,6 +1030,17 @@ get_file_hi(const col_scheme_t *cs, const char fname[], int *hi_hint)
 		return &cs->file_hi[*hi_hint].hi;
 	}
 
+	if(cs->file_hi_index != NULL)
+	{
+		i = matcher_index_find(cs->file_hi_index, fname, 0);
+		if(i < 0)
+		{
+			return NULL;
+		}
+		*hi_hint = i;
+		return &cs->file_hi[i].hi;
+	}
+
 	for(i = 0; i < cs->file_hi_count; ++i)
 	{
 		const file_hi_t *const file_hi = &cs->file_hi[i];
@@ -41,6 +41,7 @@ typedef enum
 ColorSchemeState;
 
 struct matcher_t;
+struct matcher_index_t;
 
 /* Single file highlight description. */
 typedef struct
@@ -61,6 +62,8 @@ typedef struct
 
 	file_hi_t *file_hi; /* List of file highlight preferences. */
 	int file_hi_count;  /* Number of file highlight definitions. */
+	/* Index of matchers of file_hi for faster lookup, can be NULL. */
+	struct matcher_index_t *file_hi_index;
 }
 col_scheme_t;
 
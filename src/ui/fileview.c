@@ -30,8 +30,8 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* abs() */
-#include <string.h> /* strcpy() strlen() */
+#include <stdlib.h> /* abs() free() realloc() */
+#include <string.h> /* memset() strcpy() strlen() */
 
 #include "../cfg/config.h"
 #include "../utils/fs.h"
@@ -73,8 +73,17 @@ static int calculate_top_position(FileView *view, int top);
 static int get_line_color(const FileView *view, int pos);
 static size_t calculate_print_width(const FileView *view, int i,
 		size_t max_width);
+static int calculate_list_layout(FileView *view, size_t *col_count,
+		size_t *col_width);
+static void draw_cells(FileView *view, int top, size_t col_count,
+		size_t col_width, int damaged_only);
+static void remember_drawn_state(FileView *view, int top, size_t col_count,
+		size_t col_width);
+static int can_redraw_damaged(FileView *view);
+static int draw_damaged(FileView *view);
 static void draw_cell(const FileView *view, const column_data_t *cdt,
 		size_t col_width, size_t print_width);
+static void draw_load_placeholder(FileView *view);
 static void consider_scroll_bind(FileView *view);
 static int prepare_inactive_color(FileView *view, dir_entry_t *entry,
 		int line_color);
@@ -193,6 +202,11 @@ fview_view_reset(FileView *view)
 
 	view->postponed_redraw = 0;
 	view->postponed_reload = 0;
+
+	free(view->drawn.damaged);
+	view->drawn.damaged = NULL;
+	view->drawn.cell_count = 0U;
+	view->drawn.valid = 0;
 }
 
 void
@@ -203,6 +217,8 @@ fview_view_cs_reset(FileView *view)
 	{
 		view->dir_entry[i].hi_num = -1;
 	}
+
+	ui_view_invalidate(view);
 }
 
 void
@@ -219,27 +235,19 @@ draw_dir_list(FileView *view)
 void
 draw_dir_list_only(FileView *view)
 {
-	int x;
-	size_t cell;
 	size_t col_width;
 	size_t col_count;
-	int coll_pad;
-	int top = view->top_line;
+	int top;
 
 	if(curr_stats.load_stage < 2)
 	{
 		return;
 	}
 
-	calculate_table_conf(view, &col_count, &col_width);
-
-	if(top + view->window_rows > view->list_rows)
+	if(view->load_deferred)
 	{
-		top = view->list_rows - view->window_rows;
-	}
-	if(top < 0)
-	{
-		top = 0;
+		draw_load_placeholder(view);
+		return;
 	}
 
 	ui_view_title_update(view);
@@ -251,43 +259,203 @@ draw_dir_list_only(FileView *view)
 		--view->curr_line;
 	}
 
-	top = calculate_top_position(view, top);
+	top = calculate_list_layout(view, &col_count, &col_width);
 
 	ui_view_erase(view);
+	draw_cells(view, top, col_count, col_width, 0);
+	remember_drawn_state(view, top, col_count, col_width);
 
-	cell = 0U;
-	coll_pad = (view->ls_view && cfg.extra_padding) ? 1 : 0;
-	for(x = top; x < view->list_rows; ++x)
-	{
-		const column_data_t cdt = {
-			.view = view,
-			.line_pos = x,
-			.line_hi_group = get_line_color(view, x),
-			.is_current = (view == curr_view) ? x == view->list_pos : 0,
-			.current_line = cell/col_count,
-			.column_offset = (cell%col_count)*col_width,
-		};
+	view->top_line = top;
+	view->curr_line = view->list_pos - view->top_line;
 
-		const size_t print_width = calculate_print_width(view, x, col_width);
+	if(view == curr_view)
+	{
+		consider_scroll_bind(view);
+	}
 
-		draw_cell(view, &cdt, col_width - coll_pad, print_width);
+	ui_view_win_changed(view);
+}
 
-		++cell;
-		if(cell >= view->window_cells)
-		{
-			break;
-		}
+void
+fview_damage_entry(FileView *view, int pos)
+{
+	const int cell = pos - view->drawn.top;
+	if(view->drawn.valid && cell >= 0 && (size_t)cell < view->drawn.cell_count)
+	{
+		view->drawn.damaged[cell] = 1;
 	}
+}
+
+void
+fview_draw_damaged(FileView *view)
+{
+	if(draw_damaged(view) != 0)
+	{
+		draw_dir_list(view);
+	}
+	else if(view != curr_view)
+	{
+		put_inactive_mark(view);
+	}
+}
+
+void
+fview_redraw_damaged(FileView *view)
+{
+	if(draw_damaged(view) != 0)
+	{
+		redraw_view(view);
+	}
+	else if(view == curr_view)
+	{
+		fview_cursor_redraw(view);
+	}
+	else
+	{
+		put_inactive_mark(view);
+	}
+}
+
+/* Draws entries marked as damaged along with previous and current cursor
+ * positions.  Returns zero on success and non-zero if the whole list needs to
+ * be redrawn instead. */
+static int
+draw_damaged(FileView *view)
+{
+	size_t col_width;
+	size_t col_count;
+	int top;
+
+	if(!can_redraw_damaged(view))
+	{
+		return 1;
+	}
+
+	top = calculate_list_layout(view, &col_count, &col_width);
+	if(top != view->drawn.top || col_count != view->drawn.col_count ||
+			col_width != view->drawn.col_width)
+	{
+		return 1;
+	}
+
+	fview_damage_entry(view, view->top_line + view->curr_line);
+	fview_damage_entry(view, view->list_pos);
+
+	draw_cells(view, top, col_count, col_width, 1);
+	memset(view->drawn.damaged, 0, view->drawn.cell_count);
 
 	view->top_line = top;
 	view->curr_line = view->list_pos - view->top_line;
 
-	if(view == curr_view)
+	ui_view_win_changed(view);
+	return 0;
+}
+
+/* Calculates layout of the file list: number of columns, their width and
+ * position of the first visible entry.  Returns the position. */
+static int
+calculate_list_layout(FileView *view, size_t *col_count, size_t *col_width)
+{
+	int top = view->top_line;
+
+	calculate_table_conf(view, col_count, col_width);
+
+	if(top + view->window_rows > view->list_rows)
 	{
-		consider_scroll_bind(view);
+		top = view->list_rows - view->window_rows;
+	}
+	if(top < 0)
+	{
+		top = 0;
 	}
 
-	ui_view_win_changed(view);
+	return calculate_top_position(view, top);
+}
+
+/* Draws cells of the file list starting with the one at top position.  When
+ * damaged_only is set, only cells marked as damaged are drawn. */
+static void
+draw_cells(FileView *view, int top, size_t col_count, size_t col_width,
+		int damaged_only)
+{
+	const int coll_pad = (view->ls_view && cfg.extra_padding) ? 1 : 0;
+	size_t cell = 0U;
+	int x;
+
+	for(x = top; x < view->list_rows && cell < view->window_cells; ++x, ++cell)
+	{
+		if(!damaged_only || view->drawn.damaged[cell])
+		{
+			const column_data_t cdt = {
+				.view = view,
+				.line_pos = x,
+				.line_hi_group = get_line_color(view, x),
+				.is_current = (view == curr_view) ? x == view->list_pos : 0,
+				.current_line = cell/col_count,
+				.column_offset = (cell%col_count)*col_width,
+			};
+
+			const size_t print_width = calculate_print_width(view, x, col_width);
+			draw_cell(view, &cdt, col_width - coll_pad, print_width);
+		}
+	}
+}
+
+/* Remembers parameters of the file list that was just drawn in full and resets
+ * damage of its cells. */
+static void
+remember_drawn_state(FileView *view, int top, size_t col_count,
+		size_t col_width)
+{
+	view->drawn.valid = 0;
+
+	if(view->drawn.cell_count < view->window_cells)
+	{
+		char *const damaged = realloc(view->drawn.damaged, view->window_cells);
+		if(damaged == NULL)
+		{
+			return;
+		}
+		view->drawn.damaged = damaged;
+		view->drawn.cell_count = view->window_cells;
+	}
+	memset(view->drawn.damaged, 0, view->drawn.cell_count);
+
+	view->drawn.valid = 1;
+	view->drawn.top = top;
+	view->drawn.col_count = col_count;
+	view->drawn.col_width = col_width;
+	view->drawn.list_rows = view->list_rows;
+	view->drawn.window_cells = view->window_cells;
+	view->drawn.is_current = (view == curr_view);
+}
+
+/* Checks whether contents of the view can be updated by redrawing only its
+ * damaged cells.  Returns non-zero if so, otherwise zero is returned. */
+static int
+can_redraw_damaged(FileView *view)
+{
+	if(curr_stats.need_update != UT_NONE || curr_stats.restart_in_progress ||
+			!window_shows_dirlist(view))
+	{
+		return 0;
+	}
+
+	if(curr_stats.load_stage < 2 || view->load_deferred)
+	{
+		return 0;
+	}
+
+	/* Relative line numbers of all cells depend on cursor position. */
+	if(view->num_type & NT_REL)
+	{
+		return 0;
+	}
+
+	return view->drawn.valid
+	    && view->drawn.list_rows == view->list_rows
+	    && view->drawn.window_cells == view->window_cells
+	    && view->drawn.is_current == (view == curr_view);
 }
 
 /* Calculates number of columns and maximum width of column in a view. */
@@ -449,6 +617,16 @@ draw_cell(const FileView *view, const column_data_t *cdt, size_t col_width,
 	}
 }
 
+/* Displays note in place of file list, which loading was postponed. */
+static void
+draw_load_placeholder(FileView *view)
+{
+	ui_view_title_update(view);
+	ui_view_erase(view);
+	checked_wmove(view->win, 0, 1);
+	wprint(view->win, "Loading...");
+}
+
 /* Corrects top of the other view to synchronize it with the current view if
  * 'scrollbind' option is set. */
 static void
@@ -555,7 +733,7 @@ put_inactive_mark(FileView *view)
 
 	(void)clear_current_line_bar(view, 1);
 
-	if(!cfg.extra_padding)
+	if(!cfg.extra_padding || view->load_deferred)
 	{
 		return;
 	}
@@ -667,6 +845,12 @@ clear_current_line_bar(FileView *view, int is_current)
 		return 0;
 	}
 
+	/* There is no cursor in place of file list that isn't loaded yet. */
+	if(view->load_deferred)
+	{
+		return 0;
+	}
+
 	if(old_cursor < 0)
 	{
 		return 0;
@@ -1341,6 +1525,15 @@ fview_list_updated(FileView *view)
 {
 	/* Invalidate maximum file name widths cache. */
 	view->max_filename_width = 0;
+
+	++view->list_generation;
+	ui_view_invalidate(view);
+}
+
+void
+fview_entries_updated(FileView *view)
+{
+	++view->list_generation;
 }
 
 /* Finds maximum filename width (length in character positions on the screen)
@@ -58,6 +58,19 @@ void redraw_view_imm(FileView *view);
  * cursor) */
 void redraw_current_view(void);
 
+/* Marks entry at position pos as the one that needs to be redrawn by
+ * fview_redraw_damaged(). */
+void fview_damage_entry(FileView *view, int pos);
+
+/* Updates view on the screen by redrawing only entries marked as damaged and
+ * the cursor.  Falls back to redraw_view() if anything else might have changed
+ * since the last redraw. */
+void fview_redraw_damaged(FileView *view);
+
+/* Counterpart of draw_dir_list() that redraws only damaged entries when
+ * possible like fview_redraw_damaged() does. */
+void fview_draw_damaged(FileView *view);
+
 /* Restores normal appearance of item under the cursor. */
 void erase_current_line_bar(FileView *view);
 
@@ -144,6 +157,12 @@ void fview_dir_updated(FileView *view);
  * of files changes. */
 void fview_list_updated(FileView *view);
 
+/* Callback-like function which triggers some view-specific updates after data
+ * of entries changed while the list itself (set of files and their order)
+ * remained the same.  Changed entries are expected to be marked with
+ * fview_damage_entry(). */
+void fview_entries_updated(FileView *view);
+
 /* Callback-like function which triggers some view-specific updates after cursor
  * position in the list changed. */
 void fview_position_updated(FileView *view);
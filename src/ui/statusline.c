@@ -20,9 +20,12 @@
 
 #include <curses.h> /* mvwin() wbkgdset() werase() */
 
+#include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
 #include <stddef.h> /* NULL size_t */
-#include <string.h> /* strcat() strdup() strlen() */
+#include <stdint.h> /* uint64_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strcat() strcmp() strdup() strlen() */
 #include <unistd.h>
 
 #include "../cfg/config.h"
@@ -37,16 +40,57 @@
 #include "../utils/utils.h"
 #include "../background.h"
 #include "../filelist.h"
+#include "../status.h"
 #include "ui.h"
 
 #include "../utils/str.h"
 
+/* Number of compiled formats that are kept. */
+#define FORMAT_CACHE_SIZE 4
+
+/* Element of compiled format. */
+typedef struct
+{
+	char macro;                /* Macro character or '\0' for literal text. */
+	char *text;                /* Literal text. */
+	size_t width;              /* Width of the field. */
+	int left_align;            /* Whether field is aligned to the left. */
+	struct format_t *opt;      /* Contents of optional part for '[' macro. */
+}
+format_item_t;
+
+/* Format string parsed into a list of items. */
+typedef struct format_t
+{
+	format_item_t *items; /* List of items. */
+	size_t nitems;        /* Number of items. */
+	int unclosed;         /* Whether this is optional part without closing %]. */
+}
+format_t;
+
+/* Format string along with its compiled form. */
+typedef struct
+{
+	char *format;      /* Format string. */
+	char *macros;      /* Macros that were allowed during compilation. */
+	format_t *compiled; /* Compiled format. */
+}
+compiled_format_t;
+
 static void update_stat_window_old(FileView *view);
 TSTATIC char * expand_status_line_macros(FileView *view, const char format[]);
 char * expand_view_macros(FileView *view, const char format[],
 		const char macros[]);
-static char * parse_view_macros(FileView *view, const char **format,
-		const char macros[], int opt);
+static const format_t * get_compiled_format(const char format[],
+		const char macros[]);
+static format_t * compile_format(const char **format, const char macros[],
+		int opt);
+static int add_text_item(format_t *fmt, char **text);
+static format_item_t * add_item(format_t *fmt);
+static void free_format(format_t *fmt);
+static char * expand_format(FileView *view, const format_t *fmt, int opt);
+static int expand_macro(FileView *view, const format_item_t *item, char buf[],
+		size_t buf_len);
 static int expand_num(char buf[], size_t buf_len, int val);
 static void check_expanded_str(const char buf[], int skip, int *nexpansions);
 static int is_job_bar_visible(void);
@@ -58,6 +102,10 @@ static char ** take_job_descr_snapshot(void);
 static size_t nbar_jobs;
 /* Array of jobs. */
 static bg_op_t **bar_jobs;
+/* Cache of compiled formats.  Slots are reused in round-robin fashion. */
+static compiled_format_t format_cache[FORMAT_CACHE_SIZE];
+/* Index of the slot of format_cache to use for the next format. */
+static int next_format_slot;
 /* Whether list of jobs needs to be redrawn. */
 static int job_bar_changed;
 
@@ -183,34 +231,76 @@ expand_status_line_macros(FileView *view, const char format[])
 char *
 expand_view_macros(FileView *view, const char format[], const char macros[])
 {
-	return parse_view_macros(view, &format, macros, 0);
+	const format_t *const fmt = get_compiled_format(format, macros);
+	if(fmt == NULL)
+	{
+		return NULL;
+	}
+	return expand_format(view, fmt, 0);
 }
 
-/* Expands macros in the *format string advancing the pointer as it goes.  The
+/* Retrieves compiled form of the format string compiling it if it wasn't seen
+ * recently.  Returns the compiled format or NULL on error. */
+static const format_t *
+get_compiled_format(const char format[], const char macros[])
+{
+	compiled_format_t *entry;
+	int i;
+
+	for(i = 0; i < FORMAT_CACHE_SIZE; ++i)
+	{
+		entry = &format_cache[i];
+		if(entry->compiled != NULL && strcmp(entry->format, format) == 0 &&
+				strcmp(entry->macros, macros) == 0)
+		{
+			return entry->compiled;
+		}
+	}
+
+	entry = &format_cache[next_format_slot];
+	next_format_slot = (next_format_slot + 1)%FORMAT_CACHE_SIZE;
+
+	free(entry->format);
+	free(entry->macros);
+	free_format(entry->compiled);
+
+	entry->format = strdup(format);
+	entry->macros = strdup(macros);
+	entry->compiled = compile_format(&format, macros, 0);
+	if(entry->format == NULL || entry->macros == NULL || entry->compiled == NULL)
+	{
+		free_format(entry->compiled);
+		entry->compiled = NULL;
+		return NULL;
+	}
+	return entry->compiled;
+}
+
+/* Parses macros in the *format string advancing the pointer as it goes.  The
  * opt represents conditional expression state, should be zero for non-recursive
- * calls.  Returns newly allocated string, which should be freed by the
- * caller. */
-static char *
-parse_view_macros(FileView *view, const char **format, const char macros[],
-		int opt)
+ * calls.  Returns newly allocated format or NULL on error. */
+static format_t *
+compile_format(const char **format, const char macros[], int opt)
 {
-	const dir_entry_t *const entry = &view->dir_entry[view->list_pos];
-	char *result = strdup("");
-	size_t len = 0;
 	char c;
-	int nexpansions = 0;
+	char *text = NULL;
+	size_t len = 0U;
+	format_t *const fmt = calloc(1U, sizeof(*fmt));
+	if(fmt == NULL)
+	{
+		return NULL;
+	}
 
 	while((c = **format) != '\0')
 	{
 		size_t width = 0;
 		int left_align = 0;
-		char buf[PATH_MAX];
 		const char *const next = ++*format;
-		int skip, ok;
+		format_item_t *item;
 
 		if(c != '%' || (!char_is_one_of(macros, *next) && !isdigit(*next)))
 		{
-			if(strappendch(&result, &len, c) != 0)
+			if(strappendch(&text, &len, c) != 0)
 			{
 				break;
 			}
@@ -229,114 +319,161 @@ parse_view_macros(FileView *view, const char **format, const char macros[],
 		}
 		c = *(*format)++;
 
-		skip = 0;
-		ok = 1;
-		switch(c)
+		if(c == ']' && opt)
 		{
-			case 't':
-				format_entry_name(entry, sizeof(buf), buf);
-				break;
-			case 'A':
-#ifndef _WIN32
-				get_perm_string(buf, sizeof(buf), entry->mode);
-#else
-				snprintf(buf, sizeof(buf), "%s", attr_str_long(entry->attrs));
-#endif
-				break;
-			case 'u':
-				get_uid_string(entry, 0, sizeof(buf), buf);
-				break;
-			case 'g':
-				get_gid_string(entry, 0, sizeof(buf), buf);
-				break;
-			case 's':
-				friendly_size_notation(entry->size, sizeof(buf), buf);
-				break;
-			case 'E':
-				{
-					uint64_t size = 0;
-					if(view->selected_files > 0)
-					{
-						int i;
-						for(i = 0; i < view->list_rows; i++)
-						{
-							if(view->dir_entry[i].selected)
-							{
-								size += get_file_size_by_entry(view, i);
-							}
-						}
-					}
-					/* Make exception for VISUAL_MODE, since it can contain empty
-					 * selection when cursor is on ../ directory. */
-					else if(!vle_mode_is(VISUAL_MODE))
-					{
-						size = get_file_size_by_entry(view, view->list_pos);
-					}
-					friendly_size_notation(size, sizeof(buf), buf);
-				}
-				break;
-			case 'd':
-				{
-					struct tm *tm_ptr = localtime(&entry->mtime);
-					strftime(buf, sizeof(buf), cfg.time_format, tm_ptr);
-				}
-				break;
-			case '-':
-				skip = expand_num(buf, sizeof(buf), view->filtered);
-				break;
-			case 'l':
-				skip = expand_num(buf, sizeof(buf), view->list_pos + 1);
-				break;
-			case 'L':
-				skip = expand_num(buf, sizeof(buf), view->list_rows + view->filtered);
-				break;
-			case 'S':
-				skip = expand_num(buf, sizeof(buf), view->list_rows);
-				break;
-			case '%':
-				snprintf(buf, sizeof(buf), "%%");
-				break;
-			case '[':
-				{
-					char *const opt_str = parse_view_macros(view, format, macros, 1);
-					copy_str(buf, sizeof(buf), opt_str);
-					free(opt_str);
-					break;
-				}
-			case ']':
-				if(opt)
-				{
-					if(nexpansions == 0)
-					{
-						replace_string(&result, "");
-					}
-					return result;
-				}
-				else
-				{
-					LOG_INFO_MSG("Unmatched %]", c);
-					ok = 0;
-				}
+			if(add_text_item(fmt, &text) != 0)
+			{
 				break;
+			}
+			return fmt;
+		}
 
-			default:
+		if(c == '\0' || !char_is_one_of("tAugsEd-lLS%[", c))
+		{
+			if(c == ']')
+			{
+				LOG_INFO_MSG("Unmatched %]", c);
+			}
+			else
+			{
 				LOG_INFO_MSG("Unexpected %%-sequence: %%%c", c);
-				ok = 0;
+			}
+
+			*format = next;
+			if(strappendch(&text, &len, '%') != 0)
+			{
 				break;
+			}
+			continue;
 		}
 
-		if(!ok)
+		if(add_text_item(fmt, &text) != 0 || (item = add_item(fmt)) == NULL)
 		{
-			*format = next;
-			if(strappendch(&result, &len, '%') != 0)
+			break;
+		}
+		len = 0U;
+
+		item->macro = c;
+		item->width = width;
+		item->left_align = left_align;
+		if(c == '[')
+		{
+			item->opt = compile_format(format, macros, 1);
+			if(item->opt == NULL)
+			{
+				break;
+			}
+		}
+	}
+
+	if(**format == '\0' && add_text_item(fmt, &text) == 0)
+	{
+		fmt->unclosed = opt;
+		return fmt;
+	}
+
+	free(text);
+	free_format(fmt);
+	return NULL;
+}
+
+/* Appends accumulated literal text (if any) to the format taking ownership of
+ * it.  Returns zero on success, otherwise non-zero is returned. */
+static int
+add_text_item(format_t *fmt, char **text)
+{
+	format_item_t *item;
+
+	if(*text == NULL)
+	{
+		return 0;
+	}
+
+	item = add_item(fmt);
+	if(item == NULL)
+	{
+		return 1;
+	}
+
+	item->text = *text;
+	*text = NULL;
+	return 0;
+}
+
+/* Appends empty item to the format.  Returns pointer to the item or NULL on
+ * error. */
+static format_item_t *
+add_item(format_t *fmt)
+{
+	format_item_t *item;
+
+	void *const p = reallocarray(fmt->items, fmt->nitems + 1U,
+			sizeof(*fmt->items));
+	if(p == NULL)
+	{
+		return NULL;
+	}
+	fmt->items = p;
+
+	item = &fmt->items[fmt->nitems++];
+	item->macro = '\0';
+	item->text = NULL;
+	item->width = 0U;
+	item->left_align = 0;
+	item->opt = NULL;
+	return item;
+}
+
+/* Frees compiled format.  NULL fmt is OK. */
+static void
+free_format(format_t *fmt)
+{
+	size_t i;
+
+	if(fmt == NULL)
+	{
+		return;
+	}
+
+	for(i = 0U; i < fmt->nitems; ++i)
+	{
+		free(fmt->items[i].text);
+		free_format(fmt->items[i].opt);
+	}
+	free(fmt->items);
+	free(fmt);
+}
+
+/* Expands compiled format.  The opt represents conditional expression state,
+ * should be zero for non-recursive calls.  Returns newly allocated string,
+ * which should be freed by the caller. */
+static char *
+expand_format(FileView *view, const format_t *fmt, int opt)
+{
+	char *result = strdup("");
+	size_t len = 0;
+	int nexpansions = 0;
+	size_t i;
+
+	for(i = 0U; i < fmt->nitems; ++i)
+	{
+		const format_item_t *const item = &fmt->items[i];
+		char buf[PATH_MAX];
+		int skip;
+
+		if(item->macro == '\0')
+		{
+			if(strappend(&result, &len, item->text) != 0)
 			{
 				break;
 			}
 			continue;
 		}
 
+		skip = expand_macro(view, item, buf, sizeof(buf));
+
 		check_expanded_str(buf, skip, &nexpansions);
-		stralign(buf, width, ' ', left_align);
+		stralign(buf, item->width, ' ', item->left_align);
 
 		if(strappend(&result, &len, buf) != 0)
 		{
@@ -344,15 +481,100 @@ parse_view_macros(FileView *view, const char **format, const char macros[],
 		}
 	}
 
-	/* Unmatched %[. */
 	if(opt)
 	{
-		(void)strprepend(&result, &len, "%[");
+		/* Unmatched %[. */
+		if(fmt->unclosed)
+		{
+			(void)strprepend(&result, &len, "%[");
+		}
+		else if(nexpansions == 0)
+		{
+			replace_string(&result, "");
+		}
 	}
 
 	return result;
 }
 
+/* Expands single macro into the buffer.  Returns non-zero if numeric value is
+ * "empty" (zero). */
+static int
+expand_macro(FileView *view, const format_item_t *item, char buf[],
+		size_t buf_len)
+{
+	const dir_entry_t *const entry = &view->dir_entry[view->list_pos];
+
+	switch(item->macro)
+	{
+		case 't':
+			format_entry_name(entry, buf_len, buf);
+			break;
+		case 'A':
+#ifndef _WIN32
+			get_perm_string(buf, buf_len, entry->mode);
+#else
+			snprintf(buf, buf_len, "%s", attr_str_long(entry->attrs));
+#endif
+			break;
+		case 'u':
+			get_uid_string(entry, 0, buf_len, buf);
+			break;
+		case 'g':
+			get_gid_string(entry, 0, buf_len, buf);
+			break;
+		case 's':
+			friendly_size_notation(entry->size, buf_len, buf);
+			break;
+		case 'E':
+			{
+				uint64_t size = 0;
+				if(view->selected_files > 0)
+				{
+					size = flist_sel_size(view);
+				}
+				/* Make exception for VISUAL_MODE, since it can contain empty
+				 * selection when cursor is on ../ directory. */
+				else if(!vle_mode_is(VISUAL_MODE))
+				{
+					size = get_file_size_by_entry(view, view->list_pos);
+				}
+				friendly_size_notation(size, buf_len, buf);
+			}
+			break;
+		case 'd':
+			{
+				struct tm *tm_ptr = localtime(&entry->mtime);
+				strftime(buf, buf_len, cfg.time_format, tm_ptr);
+			}
+			break;
+		case '-':
+			return expand_num(buf, buf_len, view->filtered);
+		case 'l':
+			return expand_num(buf, buf_len, view->list_pos + 1);
+		case 'L':
+			return expand_num(buf, buf_len, view->list_rows + view->filtered);
+		case 'S':
+			return expand_num(buf, buf_len, view->list_rows);
+		case '%':
+			snprintf(buf, buf_len, "%%");
+			break;
+		case '[':
+			{
+				char *const opt_str = expand_format(view, item->opt, 1);
+				copy_str(buf, buf_len, opt_str);
+				free(opt_str);
+				break;
+			}
+
+		default:
+			assert(0 && "Unexpected macro in compiled format.");
+			buf[0] = '\0';
+			break;
+	}
+	return 0;
+}
+
 /* Prints number into the buffer.  Returns non-zero if numeric value is
  * "empty" (zero). */
 static int
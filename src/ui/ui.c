@@ -84,6 +84,7 @@ static void clear_border(WINDOW *border);
 static void update_views(int reload);
 static void reload_lists(void);
 static void reload_list(FileView *view);
+static int load_deferred_view(FileView *view);
 static void update_view(FileView *view);
 static void update_window_lazy(WINDOW *win);
 static void update_term_size(void);
@@ -543,6 +544,11 @@ update_screen(UpdateType update_kind)
 
 	curr_stats.need_update = UT_NONE;
 
+	/* Screen update can be caused by things that aren't tracked as damage of
+	 * file list cells, so don't try to skip redrawing of any of them. */
+	ui_view_invalidate(&lwin);
+	ui_view_invalidate(&rwin);
+
 	update_views(update_kind == UT_FULL);
 	/* Redraw message dialog over updated panes.  It's not very nice to do it
 	 * here, but for sure better then blocking pane updates by checking for
@@ -646,7 +652,17 @@ reload_lists(void)
 		}
 		else if(!other_view->explore_mode)
 		{
-			reload_list(other_view);
+			if(curr_stats.load_stage < 3)
+			{
+				/* Make current view interactive as soon as possible by loading the
+				 * other one when there is nothing else to do. */
+				other_view->load_deferred = 1;
+				draw_dir_list(other_view);
+			}
+			else
+			{
+				reload_list(other_view);
+			}
 		}
 	}
 }
@@ -667,6 +683,7 @@ change_window(void)
 {
 	swap_view_roles();
 
+	(void)load_deferred_view(curr_view);
 	load_view_options(curr_view);
 
 	if(curr_stats.number_of_windows != 1)
@@ -1203,6 +1220,9 @@ switch_panes_content(void)
 	lwin.win = rwin.win;
 	rwin.win = tmp;
 
+	ui_view_invalidate(&lwin);
+	ui_view_invalidate(&rwin);
+
 	t = lwin.window_rows;
 	lwin.window_rows = rwin.window_rows;
 	rwin.window_rows = t;
@@ -1380,8 +1400,17 @@ ui_view_reset_search_highlight(FileView *view)
 {
 	if(view->matches != 0)
 	{
+		int i;
+		for(i = 0; i < view->list_rows; ++i)
+		{
+			if(view->dir_entry[i].search_match)
+			{
+				fview_damage_entry(view, i);
+			}
+		}
+
 		view->matches = 0;
-		ui_view_schedule_redraw(view);
+		fview_redraw_damaged(view);
 	}
 }
 
@@ -1593,14 +1622,6 @@ ui_view_is_visible(const FileView *const view)
 	return curr_stats.number_of_windows == 2 || curr_view == view;
 }
 
-void
-ui_view_clear_history(FileView *const view)
-{
-	cfg_free_history_items(view->history, view->history_num);
-	view->history_num = 0;
-	view->history_pos = 0;
-}
-
 int
 ui_view_displays_columns(const FileView *const view)
 {
@@ -1667,6 +1688,14 @@ ui_view_erase(FileView *view)
 	const int bg = COLOR_PAIR(cs->pair[WIN_COLOR]) | cs->color[WIN_COLOR].attr;
 	wbkgdset(view->win, bg);
 	werase(view->win);
+
+	ui_view_invalidate(view);
+}
+
+void
+ui_view_invalidate(FileView *view)
+{
+	view->drawn.valid = 0;
 }
 
 void
@@ -1692,6 +1721,8 @@ ui_view_wipe(FileView *view)
 	}
 	redrawwin(view->win);
 	wrefresh(view->win);
+
+	ui_view_invalidate(view);
 }
 
 void
@@ -1731,6 +1762,32 @@ get_updated_time(uint64_t prev)
 	return new;
 }
 
+int
+ui_views_load_deferred(void)
+{
+	int loaded = 0;
+	loaded |= load_deferred_view(curr_view);
+	loaded |= load_deferred_view(other_view);
+	return loaded;
+}
+
+/* Loads file list of the view if its loading was postponed.  Returns non-zero
+ * if the view was loaded. */
+static int
+load_deferred_view(FileView *view)
+{
+	if(!view->load_deferred)
+	{
+		return 0;
+	}
+
+	/* Load the list the same way as on startup to restore position in the
+	 * directory from history. */
+	load_dir_list(view,
+			!(cfg.vifm_info&VIFMINFO_SAVEDIRS) || view->list_pos != 0);
+	return 1;
+}
+
 UiUpdateEvent
 ui_view_query_scheduled_event(FileView *view)
 {
@@ -218,6 +218,8 @@ typedef struct
 	int matches;
 	/* Last used search pattern, empty if none. */
 	char last_search[NAME_MAX];
+	/* Compilation flags (REG_*) of the last search pattern. */
+	int last_search_cflags;
 
 	int hide_dot;
 	int prev_invert;
@@ -230,8 +232,19 @@ typedef struct
 	unsigned int window_width;
 	int filtered;  /* number of files filtered out and not shown in list */
 	int selected_files; /* Number of currently selected files. */
+	/* Total size of selected files, see flist_sel_size().  It's valid only when
+	 * selected_size_known is set and generations of the list and of dcache are
+	 * the same as the ones it was computed for. */
+	uint64_t selected_size;
+	int selected_size_known;
+	unsigned int selected_size_list_gen;
+	unsigned int selected_size_dcache_gen;
 	int local_cs; /* Whether directory-specific color scheme is in use. */
 	dir_entry_t *dir_entry;
+	/* Incremented on every change of the list of entries (reloading, sorting,
+	 * filtering) to make it possible to detect that data about entries that was
+	 * derived earlier is outdated. */
+	unsigned int list_generation;
 
 	int nsaved_selection;   /* Number of items in saved_selection. */
 	char **saved_selection; /* Names of selected files. */
@@ -288,9 +301,19 @@ typedef struct
 	/* Primary group in compiled form. */
 	regex_t primary_group;
 
+	/* Directory history.  Items are kept in a ring buffer of cfg.history_len
+	 * elements that starts with the oldest item at history_head, so use
+	 * flist_hist_get() to access them by position. */
 	int history_num;
 	int history_pos;
+	int history_head;
 	history_t *history;
+	/* Open addressing hash table that maps directories to ring indexes (plus
+	 * one, zero marks free slot) of their most recent history items.  Can be
+	 * NULL. */
+	int *history_index;
+	/* Number of slots in the index, which is zero or a power of two. */
+	size_t history_index_size;
 
 	col_scheme_t cs;
 
@@ -305,6 +328,22 @@ typedef struct
 	size_t column_count; /* number of columns in the view, used for list view */
 	size_t window_cells; /* max number of files that can be displayed */
 
+	/* State of the last full drawing of the file list, which allows redrawing
+	 * only cells that were explicitly marked as damaged since then. */
+	struct
+	{
+		int valid;           /* Whether fields below match the window. */
+		int top;             /* Position of the first drawn entry. */
+		size_t col_count;    /* Number of columns of cells. */
+		size_t col_width;    /* Width of a column of cells. */
+		int list_rows;       /* Number of entries in the list at that moment. */
+		size_t window_cells; /* Number of cells in the window at that moment. */
+		int is_current;      /* Whether the view was the current one. */
+		char *damaged;       /* Flags of cells that need to be redrawn. */
+		size_t cell_count;   /* Number of elements in the damaged array. */
+	}
+	drawn;
+
 	/* Whether and how line numbers are displayed. */
 	NumberingType num_type, num_type_g;
 	/* Min number of characters reserved for number field. */
@@ -322,6 +361,10 @@ typedef struct
 	uint64_t last_redraw; /* Time of last redraw. */
 	uint64_t last_reload; /* Time of last [full] reload. */
 
+	/* Whether loading of file list is postponed until there is no input to
+	 * process. */
+	int load_deferred;
+
 	int on_slow_fs; /* Whether current directory has access penalties. */
 }
 FileView;
@@ -497,8 +540,6 @@ int ui_view_displays_numbers(const FileView *const view);
  * otherwise zero is returned. */
 int ui_view_is_visible(const FileView *const view);
 
-/* Cleans directory history of the view. */
-void ui_view_clear_history(FileView *const view);
 
 /* Checks whether view displays column view.  Returns non-zero if so, otherwise
  * zero is returned. */
@@ -533,6 +574,10 @@ const col_scheme_t * ui_view_get_cs(const FileView *view);
 /* Erases view window by filling it with the background color. */
 void ui_view_erase(FileView *view);
 
+/* Makes next redraw of the view repaint all of its cells even if only some of
+ * them were marked as damaged. */
+void ui_view_invalidate(FileView *view);
+
 /* Same as erase, but ensures that view is updated in all its size on the
  * screen (e.g. to clear anything put there by other programs as well). */
 void ui_view_wipe(FileView *view);
@@ -558,6 +603,10 @@ void ui_view_redrawn(FileView *view);
  * scheduled event. */
 UiUpdateEvent ui_view_query_scheduled_event(FileView *view);
 
+/* Loads file lists of views which loading was postponed on startup.  Returns
+ * non-zero if anything was loaded. */
+int ui_views_load_deferred(void);
+
 #endif /* VIFM__UI__UI_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -22,7 +22,8 @@
 #include <stddef.h> /* size_t */
 #include <stdio.h>
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strcpy() strdup() */
+#include <string.h> /* memcpy() strcpy() strdup() strlen() strncmp()
+                       strrchr() */
 
 #include "compat/fs_limits.h"
 #include "compat/reallocarray.h"
@@ -35,6 +36,24 @@
 #include "registers.h"
 #include "trash.h"
 
+/* Size of the first block of memory of a group.  Each next block is twice as
+ * large as the previous one up to ARENA_MAX_BLOCK_SIZE, larger allocations get
+ * blocks of their own size. */
+#define ARENA_MIN_BLOCK_SIZE 512U
+
+/* Limit on growth of size of blocks of memory of a group. */
+#define ARENA_MAX_BLOCK_SIZE (64U*1024U)
+
+/* Block of memory that holds commands of a group and their paths. */
+typedef struct arena_t
+{
+	struct arena_t *next; /* Previously allocated block. */
+	size_t size;          /* Size of the data. */
+	size_t used;          /* Number of bytes of data that are in use. */
+	void *data;           /* Memory for allocations. */
+}
+arena_t;
+
 typedef struct
 {
 	char *msg;
@@ -42,9 +61,13 @@ typedef struct
 	int balance;
 	int can_undone;
 	int incomplete;
+
+	arena_t *arena;      /* Memory of commands of the group, freed with it. */
+	const char *dirs[2]; /* Recently stored directories, shared by paths. */
 }
 group_t;
 
+/* Operation in form suitable for performing it. */
 typedef struct
 {
 	OPS op;
@@ -56,12 +79,23 @@ typedef struct
 }
 op_t;
 
+/* Path split at the last slash to share directory part between commands. */
+typedef struct
+{
+	const char *dir;  /* Directory part or NULL if there is no slash. */
+	const char *name; /* Part of the path after the last slash. */
+}
+cmd_path_t;
+
+/* Single command of a group.  All commands of a group and their paths are
+ * allocated in memory of the group. */
 typedef struct cmd_t
 {
-	char *buf1;
-	char *buf2;
-	op_t do_op;
-	op_t undo_op;
+	OPS op;             /* Operation to redo, undo one is undo_op[op]. */
+	void *do_data;      /* Data of the operation to redo. */
+	void *undo_data;    /* Data of the operation to undo. */
+	cmd_path_t buf1;    /* First path of the command. */
+	cmd_path_t buf2;    /* Second path of the command. */
 
 	group_t *group;
 	struct cmd_t *prev;
@@ -219,14 +253,22 @@ static char *group_msg;
 static int command_count;
 
 static int no_function(void);
-static void init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data);
-static void init_entry(cmd_t *cmd, const char **e, int type);
+static group_t * alloc_group(void);
+static void free_group(group_t *group);
+static void * arena_alloc(group_t *group, size_t size);
+static int store_path(group_t *group, cmd_path_t *path, const char str[]);
+static const char * store_dir(group_t *group, const char dir[], size_t len);
+static void expand_cmd_path(const cmd_path_t *path, char buf[], size_t buf_len);
+static void get_op(const cmd_t *cmd, int undo, char buf1[], char buf2[],
+		op_t *op);
+static const char * get_entry(int type, const char buf1[], const char buf2[]);
+static int path_is_in_trash(const cmd_path_t *path, const char trash_dir[],
+		const char **last_dir, int *last_result);
 static void remove_cmd(cmd_t *cmd);
 static int is_undo_group_possible(void);
 static int is_redo_group_possible(void);
 static int is_op_possible(const op_t *op);
 static void change_filename_in_trash(cmd_t *cmd, const char *filename);
-static void update_entry(const char **e, const char old[], const char new[]);
 static char ** fill_undolist_detail(char **list);
 static const char * get_op_desc(op_t op);
 static char **fill_undolist_nondetail(char **list);
@@ -303,8 +345,8 @@ int
 add_operation(OPS op, void *do_data, void *undo_data, const char *buf1,
 		const char *buf2)
 {
-	int mem_error;
 	cmd_t *cmd;
+	group_t *group;
 
 	assert(group_opened);
 	assert(buf1 != NULL);
@@ -330,73 +372,239 @@ add_operation(OPS op, void *do_data, void *undo_data, const char *buf1,
 		return 0;
 	}
 
-	command_count++;
+	group = (last_group != NULL) ? last_group : alloc_group();
 
 	/* add operation to the list */
-	cmd = calloc(1, sizeof(*cmd));
-	if(cmd == NULL)
+	cmd = (group == NULL) ? NULL : arena_alloc(group, sizeof(*cmd));
+	if(cmd == NULL || store_path(group, &cmd->buf1, buf1) != 0 ||
+			store_path(group, &cmd->buf2, buf2) != 0)
+	{
+		if(group != NULL && group != last_group)
+			free_group(group);
+		if(data_is_ptr[op])
+			free(do_data);
+		if(data_is_ptr[undo_op[op]])
+			free(undo_data);
 		return -1;
+	}
+	last_group = group;
+
+	command_count++;
 
-	cmd->buf1 = strdup(buf1);
-	cmd->buf2 = strdup(buf2);
+	cmd->op = op;
+	cmd->do_data = do_data;
+	cmd->undo_data = undo_data;
+	cmd->group = group;
 	cmd->prev = current;
-	init_cmd(cmd, op, do_data, undo_data);
-	if(last_group != NULL)
+	cmd->next = NULL;
+
+	if(undo_op[op] == OP_NONE)
+		cmd->group->can_undone = 0;
+
+	current->next = cmd;
+	current = cmd;
+	cmds.prev = cmd;
+
+	return 0;
+}
+
+/* Allocates new group for commands.  Returns the group or NULL on error. */
+static group_t *
+alloc_group(void)
+{
+	group_t *const group = malloc(sizeof(*group));
+	if(group == NULL)
+		return NULL;
+
+	group->msg = strdup(group_msg);
+	group->error = 0;
+	group->balance = 0;
+	group->can_undone = 1;
+	group->incomplete = 0;
+	group->arena = NULL;
+	group->dirs[0] = NULL;
+	group->dirs[1] = NULL;
+
+	if(group->msg == NULL)
 	{
-		cmd->group = last_group;
+		free(group);
+		return NULL;
 	}
-	else if((cmd->group = malloc(sizeof(group_t))) != NULL)
+	return group;
+}
+
+/* Frees group along with all of its commands. */
+static void
+free_group(group_t *group)
+{
+	while(group->arena != NULL)
 	{
-		cmd->group->msg = strdup(group_msg);
-		cmd->group->error = 0;
-		cmd->group->balance = 0;
-		cmd->group->can_undone = 1;
-		cmd->group->incomplete = 0;
+		arena_t *const next = group->arena->next;
+		free(group->arena);
+		group->arena = next;
 	}
-	mem_error = cmd->group == NULL || cmd->buf1 == NULL || cmd->buf2 == NULL;
-	if(mem_error)
+
+	free(group->msg);
+	free(group);
+}
+
+/* Allocates memory in storage of the group, which is freed along with the
+ * group.  Returns pointer to the memory or NULL on error. */
+static void *
+arena_alloc(group_t *group, size_t size)
+{
+	/* Commands contain only pointers and enumerations. */
+	const size_t align = sizeof(void *);
+	arena_t *arena = group->arena;
+	void *p;
+
+	size = (size + align - 1U)/align*align;
+
+	if(arena == NULL || arena->size - arena->used < size)
 	{
-		remove_cmd(cmd);
-		return -1;
+		const size_t block_size = (arena == NULL)
+		                        ? ARENA_MIN_BLOCK_SIZE
+		                        : MIN(arena->size*2U, ARENA_MAX_BLOCK_SIZE);
+		const size_t data_size = MAX(size, block_size);
+		const size_t header_size = (sizeof(*arena) + align - 1U)/align*align;
+
+		arena = malloc(header_size + data_size);
+		if(arena == NULL)
+			return NULL;
+
+		arena->data = (char *)arena + header_size;
+		arena->size = data_size;
+		arena->used = 0U;
+		arena->next = group->arena;
+		group->arena = arena;
 	}
-	last_group = cmd->group;
 
-	if(undo_op[op] == OP_NONE)
-		cmd->group->can_undone = 0;
+	p = (char *)arena->data + arena->used;
+	arena->used += size;
+	return p;
+}
 
-	current->next = cmd;
-	current = cmd;
-	cmds.prev = cmd;
+/* Stores path in memory of the group.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+store_path(group_t *group, cmd_path_t *path, const char str[])
+{
+	const char *const slash = strrchr(str, '/');
+	const char *const name = (slash == NULL) ? str : (slash + 1);
+	const size_t len = strlen(name);
+	char *copy;
+
+	path->dir = NULL;
+	if(slash != NULL)
+	{
+		path->dir = store_dir(group, str, slash - str);
+		if(path->dir == NULL)
+			return 1;
+	}
+
+	copy = arena_alloc(group, len + 1U);
+	if(copy == NULL)
+		return 1;
 
+	memcpy(copy, name, len + 1U);
+	path->name = copy;
 	return 0;
 }
 
+/* Stores directory path of specified length reusing one of recently stored
+ * directories if possible.  Returns pointer to the stored string or NULL on
+ * error. */
+static const char *
+store_dir(group_t *group, const char dir[], size_t len)
+{
+	char *copy;
+	size_t i;
+
+	for(i = 0U; i < ARRAY_LEN(group->dirs); ++i)
+	{
+		const char *const d = group->dirs[i];
+		if(d != NULL && strncmp(d, dir, len) == 0 && d[len] == '\0')
+		{
+			return d;
+		}
+	}
+
+	copy = arena_alloc(group, len + 1U);
+	if(copy == NULL)
+		return NULL;
+
+	memcpy(copy, dir, len);
+	copy[len] = '\0';
+
+	group->dirs[1] = group->dirs[0];
+	group->dirs[0] = copy;
+	return copy;
+}
+
+/* Composes full path from its parts. */
 static void
-init_cmd(cmd_t *cmd, OPS op, void *do_data, void *undo_data)
-{
-	cmd->do_op.op = op;
-	cmd->do_op.data = do_data;
-	cmd->undo_op.op = undo_op[op];
-	cmd->undo_op.data = undo_data;
-	init_entry(cmd, &cmd->do_op.src, opers[op][0]);
-	init_entry(cmd, &cmd->do_op.dst, opers[op][1]);
-	init_entry(cmd, &cmd->do_op.exists, opers[op][2]);
-	init_entry(cmd, &cmd->do_op.dont_exist, opers[op][3]);
-	init_entry(cmd, &cmd->undo_op.src, opers[op][4]);
-	init_entry(cmd, &cmd->undo_op.dst, opers[op][5]);
-	init_entry(cmd, &cmd->undo_op.exists, opers[op][6]);
-	init_entry(cmd, &cmd->undo_op.dont_exist, opers[op][7]);
+expand_cmd_path(const cmd_path_t *path, char buf[], size_t buf_len)
+{
+	size_t dir_len = 0U;
+	size_t name_len;
+
+	if(path->dir != NULL)
+	{
+		dir_len = strlen(path->dir);
+		if(dir_len + 1U >= buf_len)
+		{
+			copy_str(buf, buf_len, path->dir);
+			return;
+		}
+
+		memcpy(buf, path->dir, dir_len);
+		buf[dir_len++] = '/';
+	}
+
+	name_len = MIN(strlen(path->name), buf_len - dir_len - 1U);
+	memcpy(buf + dir_len, path->name, name_len);
+	buf[dir_len + name_len] = '\0';
 }
 
+/* Fills *op with operation of the command to redo or to undo.  buf1 and buf2
+ * should be at least PATH_MAX long and are used to store paths.  Only paths
+ * that are operands of the operation are composed. */
 static void
-init_entry(cmd_t *cmd, const char **e, int type)
+get_op(const cmd_t *cmd, int undo, char buf1[], char buf2[], op_t *op)
+{
+	const int base = undo ? 4 : 0;
+	int need_1st = 0, need_2nd = 0;
+	int i;
+
+	for(i = 0; i < 4; ++i)
+	{
+		need_1st |= (opers[cmd->op][base + i] == OPER_1ST);
+		need_2nd |= (opers[cmd->op][base + i] == OPER_2ND);
+	}
+
+	if(need_1st)
+		expand_cmd_path(&cmd->buf1, buf1, PATH_MAX);
+	if(need_2nd)
+		expand_cmd_path(&cmd->buf2, buf2, PATH_MAX);
+
+	op->op = undo ? undo_op[cmd->op] : cmd->op;
+	op->data = undo ? cmd->undo_data : cmd->do_data;
+	op->src = get_entry(opers[cmd->op][base + 0], buf1, buf2);
+	op->dst = get_entry(opers[cmd->op][base + 1], buf1, buf2);
+	op->exists = get_entry(opers[cmd->op][base + 2], buf1, buf2);
+	op->dont_exist = get_entry(opers[cmd->op][base + 3], buf1, buf2);
+}
+
+/* Maps type of an operand to its value.  Returns the value. */
+static const char *
+get_entry(int type, const char buf1[], const char buf2[])
 {
 	if(type == OPER_NON)
-		*e = NULL;
+		return NULL;
 	else if(type == OPER_1ST)
-		*e = cmd->buf1;
+		return buf1;
 	else
-		*e = cmd->buf2;
+		return buf2;
 }
 
 static void
@@ -424,25 +632,22 @@ remove_cmd(cmd_t *cmd)
 		cmds.prev = cmd->prev;
 	}
 
+	if(data_is_ptr[cmd->op])
+		free(cmd->do_data);
+	if(data_is_ptr[undo_op[cmd->op]])
+		free(cmd->undo_data);
+
+	/* Memory of the command belongs to the group. */
 	if(last_cmd_in_group)
 	{
-		free(cmd->group->msg);
-		free(cmd->group);
 		if(last_group == cmd->group)
 			last_group = NULL;
+		free_group(cmd->group);
 	}
 	else
 	{
 		cmd->group->incomplete = 1;
 	}
-	free(cmd->buf1);
-	free(cmd->buf2);
-	if(data_is_ptr[cmd->do_op.op])
-		free(cmd->do_op.data);
-	if(data_is_ptr[cmd->undo_op.op])
-		free(cmd->undo_op.data);
-
-	free(cmd);
 
 	command_count--;
 }
@@ -501,8 +706,12 @@ undo_group(void)
 	{
 		if(!skip)
 		{
-			int err = do_func(current->undo_op.op, current->undo_op.data,
-					current->undo_op.src, current->undo_op.dst);
+			char buf1[PATH_MAX], buf2[PATH_MAX];
+			op_t op;
+			int err;
+
+			get_op(current, 1, buf1, buf2, &op);
+			err = do_func(op.op, op.data, op.src, op.dst);
 			if(err == SKIP_UNDO_REDO_OPERATION)
 			{
 				skip = 1;
@@ -539,12 +748,16 @@ is_undo_group_possible(void)
 	cmd_t *cmd = current;
 	do
 	{
+		char buf1[PATH_MAX], buf2[PATH_MAX];
+		op_t op;
 		int ret;
-		ret = is_op_possible(&cmd->undo_op);
+
+		get_op(cmd, 1, buf1, buf2, &op);
+		ret = is_op_possible(&op);
 		if(ret == 0)
 			return 0;
 		else if(ret < 0)
-			change_filename_in_trash(cmd, cmd->undo_op.dst);
+			change_filename_in_trash(cmd, op.dst);
 		cmd = cmd->prev;
 	}
 	while(cmd != &cmds && cmd->group == cmd->next->group);
@@ -585,8 +798,12 @@ redo_group(void)
 		current = current->next;
 		if(!skip)
 		{
-			int err = do_func(current->do_op.op, current->do_op.data,
-					current->do_op.src, current->do_op.dst);
+			char buf1[PATH_MAX], buf2[PATH_MAX];
+			op_t op;
+			int err;
+
+			get_op(current, 0, buf1, buf2, &op);
+			err = do_func(op.op, op.data, op.src, op.dst);
 			if(err == SKIP_UNDO_REDO_OPERATION)
 			{
 				current->next->group->balance--;
@@ -622,13 +839,17 @@ is_redo_group_possible(void)
 	cmd_t *cmd = current;
 	do
 	{
+		char buf1[PATH_MAX], buf2[PATH_MAX];
+		op_t op;
 		int ret;
+
 		cmd = cmd->next;
-		ret = is_op_possible(&cmd->do_op);
+		get_op(cmd, 0, buf1, buf2, &op);
+		ret = is_op_possible(&op);
 		if(ret == 0)
 			return 0;
 		else if(ret < 0)
-			change_filename_in_trash(cmd, cmd->do_op.dst);
+			change_filename_in_trash(cmd, op.dst);
 	}
 	while(cmd->next != NULL && cmd->group == cmd->next->group);
 	return 1;
@@ -669,7 +890,6 @@ change_filename_in_trash(cmd_t *cmd, const char *filename)
 {
 	const char *name_tail;
 	char *new;
-	char *old;
 	char *const base_dir = strdup(filename);
 
 	remove_last_path_component(base_dir);
@@ -680,31 +900,13 @@ change_filename_in_trash(cmd_t *cmd, const char *filename)
 
 	free(base_dir);
 
-	old = cmd->buf2;
-	cmd->buf2 = new;
-
-	regs_rename_contents(filename, new);
-
-	update_entry(&cmd->do_op.src, old, cmd->buf2);
-	update_entry(&cmd->do_op.dst, old, cmd->buf2);
-	update_entry(&cmd->do_op.exists, old, cmd->buf2);
-	update_entry(&cmd->do_op.dont_exist, old, cmd->buf2);
-	update_entry(&cmd->undo_op.src, old, cmd->buf2);
-	update_entry(&cmd->undo_op.dst, old, cmd->buf2);
-	update_entry(&cmd->undo_op.exists, old, cmd->buf2);
-	update_entry(&cmd->undo_op.dont_exist, old, cmd->buf2);
-
-	free(old);
-}
-
-/* Checks whether *e equals old and updates it to new if so. */
-static void
-update_entry(const char **e, const char old[], const char new[])
-{
-	if(*e == old)
+	/* Old path remains in memory of the group until it's freed. */
+	if(store_path(cmd->group, &cmd->buf2, new) == 0)
 	{
-		*e = new;
+		regs_rename_contents(filename, new);
 	}
+
+	free(new);
 }
 
 char **
@@ -759,15 +961,19 @@ fill_undolist_detail(char **list)
 		list++;
 		do
 		{
+			char buf1[PATH_MAX], buf2[PATH_MAX];
+			op_t op;
 			const char *p;
 
-			p = get_op_desc(cmd->do_op);
+			get_op(cmd, 0, buf1, buf2, &op);
+			p = get_op_desc(op);
 			if((*list = malloc(4 + strlen(p) + 1)) == NULL)
 				return list;
 			sprintf(*list, "do: %s", p);
 			list++;
 
-			p = get_op_desc(cmd->undo_op);
+			get_op(cmd, 1, buf1, buf2, &op);
+			p = get_op_desc(op);
 			if((*list = malloc(6 + strlen(p) + 1)) == NULL)
 				return list;
 			sprintf(*list, "undo: %s", p);
@@ -903,32 +1109,55 @@ void
 clean_cmds_with_trash(const char trash_dir[])
 {
 	cmd_t *cur = cmds.prev;
+	/* Commands of a group share directories, so result of the last check is
+	 * reused for them. */
+	const char *last_dir = NULL;
+	int last_result = 0;
 
 	assert(!group_opened);
 
 	while(cur != &cmds)
 	{
 		cmd_t *prev = cur->prev;
+		const int base = (cur->group->balance >= 0) ? 4 : 0;
+		const int type = opers[cur->op][base + 2];
 
-		if(cur->group->balance < 0)
+		if(type != OPER_NON)
 		{
-			if(cur->do_op.exists != NULL &&
-					trash_contains(trash_dir, cur->do_op.exists))
-			{
-				remove_cmd(cur);
-			}
-		}
-		else
-		{
-			if(cur->undo_op.exists != NULL &&
-					trash_contains(trash_dir, cur->undo_op.exists))
+			const cmd_path_t *const exists = (type == OPER_1ST) ? &cur->buf1
+			                                                    : &cur->buf2;
+			if(path_is_in_trash(exists, trash_dir, &last_dir, &last_result))
 			{
 				remove_cmd(cur);
+				/* The directory might have been freed along with the group. */
+				last_dir = NULL;
 			}
 		}
 		cur = prev;
 	}
 }
 
+/* Checks whether path of a command is inside of specified trash directory
+ * (NULL means any of them) without composing full path.  Files are put into
+ * trash directories rather than being ones, so it's enough to check directory
+ * part of the path.  *last_dir and *last_result cache result for the last
+ * checked directory.  Returns non-zero if so, otherwise zero is returned. */
+static int
+path_is_in_trash(const cmd_path_t *path, const char trash_dir[],
+		const char **last_dir, int *last_result)
+{
+	if(path->dir == NULL)
+	{
+		return trash_contains(trash_dir, path->name);
+	}
+
+	if(path->dir != *last_dir)
+	{
+		*last_dir = path->dir;
+		*last_result = trash_contains(trash_dir, path->dir);
+	}
+	return *last_result;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -36,6 +36,10 @@ void fswatch_free(fswatch_t *w);
  * non-zero if so, otherwise zero is returned. */
 int fswatch_changed(fswatch_t *w, int *error);
 
+/* Retrieves file descriptor that becomes readable when there might be changes
+ * to report.  Returns the descriptor or -1 if the watcher has to be polled. */
+int fswatch_get_fd(const fswatch_t *w);
+
 #endif /* VIFM__UTILS__FSWATCH_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -165,6 +165,12 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	return w->fd;
+}
+
 /* Updates information about a file event is about.  Returns non-zero if this is
  * an interesting event that's worth attention (e.g. re-reading information from
  * file system), otherwise zero is returned. */
@@ -299,6 +305,12 @@ fswatch_changed(fswatch_t *w, int *error)
 	return changed;
 }
 
+int
+fswatch_get_fd(const fswatch_t *w)
+{
+	return -1;
+}
+
 #endif
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
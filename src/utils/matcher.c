@@ -20,9 +20,10 @@
 
 #include <regex.h> /* regex_t regcomp() regexec() regfree() */
 
+#include <ctype.h> /* tolower() */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strlen() strrchr() strspn() */
+#include <string.h> /* strcspn() strlen() strrchr() strspn() */
 
 #include "globs.h"
 #include "path.h"
@@ -45,6 +46,8 @@ static int compile_expr(matcher_t *m, int strip, int cs_by_def, char **error);
 static int parse_glob(matcher_t *m, int strip, char **error);
 static int parse_re(matcher_t *m, int strip, int cs_by_def, char **error);
 static void free_matcher_items(matcher_t *matcher);
+static int visit_literals(char globs[], matcher_literal_func cb, void *arg);
+static int is_plain_glob(const char glob[]);
 static int is_re_expr(const char expr[]);
 static int is_globs_expr(const char expr[]);
 
@@ -296,6 +299,89 @@ matcher_includes(const matcher_t *like, const matcher_t *m)
 	return 0;
 }
 
+int
+matcher_literals(const matcher_t *matcher, matcher_literal_func cb,
+		void *arg)
+{
+	char *globs;
+	int result;
+
+	if(!matcher->globs || matcher->full_path)
+	{
+		return 0;
+	}
+
+	/* Globs might have been specified without curly braces. */
+	globs = is_globs_expr(matcher->expr)
+	      ? format_str("%.*s", (int)strlen(matcher->expr) - 2, matcher->expr + 1)
+	      : strdup(matcher->expr);
+	if(globs == NULL)
+	{
+		return 0;
+	}
+
+	result = visit_literals(globs, NULL, NULL)
+	      && visit_literals(globs, cb, arg);
+
+	free(globs);
+	return result;
+}
+
+/* Checks whether all comma-separated globs are plain names or suffixes and
+ * passes them to the callback (if it's not NULL).  Returns non-zero if all
+ * globs are of that form, otherwise zero is returned. */
+static int
+visit_literals(char globs[], matcher_literal_func cb, void *arg)
+{
+	char *glob = globs, *state = NULL;
+	int count = 0;
+
+	while((glob = split_and_get(glob, ',', &state)) != NULL)
+	{
+		const int is_suffix = (glob[0] == '*' && glob[1] == '.');
+		char *const lit = is_suffix ? glob + 1 : glob;
+
+		if(!is_plain_glob(lit))
+		{
+			return 0;
+		}
+
+		if(cb != NULL)
+		{
+			char *p;
+			/* Globs are matched case insensitively. */
+			for(p = lit; *p != '\0'; ++p)
+			{
+				*p = tolower((unsigned char)*p);
+			}
+			cb(lit, is_suffix, arg);
+		}
+		++count;
+	}
+
+	return count != 0;
+}
+
+/* Checks whether glob matches only itself ignoring case of ASCII characters.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_plain_glob(const char glob[])
+{
+	const unsigned char *p = (const unsigned char *)glob;
+
+	if(glob[strcspn(glob, "*?[]\\")] != '\0')
+	{
+		return 0;
+	}
+
+	/* Case folding of non-ASCII characters is left to regular expressions. */
+	while(*p != '\0' && *p < 0x80)
+	{
+		++p;
+	}
+	return *p == '\0';
+}
+
 int
 matcher_is_expr(const char str[])
 {
@@ -27,6 +27,12 @@
 /* Opaque matcher type. */
 typedef struct matcher_t matcher_t;
 
+/* Callback for matcher_literals().  The name is in lower case and is either a
+ * complete file name or, if is_suffix is set, a suffix that starts with a dot
+ * (".ext" for "*.ext" glob). */
+typedef void (*matcher_literal_func)(const char name[], int is_suffix,
+		void *arg);
+
 /* Parses matcher expression and allocates matcher.  Returns matcher on success,
  * otherwise NULL is returned and *error is initialized with newly allocated
  * string describing the error. */
@@ -50,6 +56,13 @@ const char * matcher_get_expr(const matcher_t *matcher);
  * Returns non-zero if so, otherwise zero is returned. */
 int matcher_includes(const matcher_t *like, const matcher_t *m);
 
+/* Checks whether the matcher is a list of globs each of which is either a plain
+ * file name or a star followed by a plain suffix that starts with a dot.  If
+ * so, invokes the callback for each of them.  Returns non-zero if the matcher
+ * was decomposed this way, otherwise zero is returned. */
+int matcher_literals(const matcher_t *matcher, matcher_literal_func cb,
+		void *arg);
+
 /* Checks whether given string is a match expression.  Returns non-zero if so,
  * otherwise zero is returned. */
 int matcher_is_expr(const char str[]);
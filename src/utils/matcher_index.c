@@ -0,0 +1,264 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "matcher_index.h"
+
+#include <ctype.h> /* tolower() */
+#include <limits.h> /* INT_MAX */
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
+
+#include "../compat/fs_limits.h"
+#include "../compat/reallocarray.h"
+#include "matcher.h"
+#include "path.h"
+#include "trie.h"
+
+/* Index of matchers.  Positions are stored in lists of integers, whose first
+ * element is number of positions that follow it. */
+struct matcher_index_t
+{
+	struct matcher_t **matchers; /* All matchers in order of addition. */
+	int count;                   /* Number of elements in matchers array. */
+
+	trie_t names;    /* Maps lower case file names to lists of positions. */
+	trie_t suffixes; /* Maps lower case name suffixes to lists of positions. */
+
+	int *residual;      /* Positions of matchers that need to be run. */
+	int residual_count; /* Number of elements in residual array. */
+	int failed;         /* Whether literals of last matcher weren't added. */
+};
+
+static void add_literal(const char name[], int is_suffix, void *arg);
+static int add_position(trie_t trie, const char key[], int pos);
+static int lookup(trie_t trie, const char key[], int from);
+static int find_linearly(matcher_index_t *index, const char path[], int from);
+
+matcher_index_t *
+matcher_index_alloc(void)
+{
+	matcher_index_t *const index = calloc(1U, sizeof(*index));
+	if(index == NULL)
+	{
+		return NULL;
+	}
+
+	index->names = trie_create();
+	index->suffixes = trie_create();
+	if(index->names == NULL_TRIE || index->suffixes == NULL_TRIE)
+	{
+		matcher_index_free(index);
+		return NULL;
+	}
+
+	return index;
+}
+
+void
+matcher_index_free(matcher_index_t *index)
+{
+	if(index != NULL)
+	{
+		trie_free_with_data(index->names);
+		trie_free_with_data(index->suffixes);
+		free(index->matchers);
+		free(index->residual);
+		free(index);
+	}
+}
+
+int
+matcher_index_add(matcher_index_t *index, struct matcher_t *matcher)
+{
+	struct matcher_t **const matchers = reallocarray(index->matchers,
+			index->count + 1, sizeof(*matchers));
+	if(matchers == NULL)
+	{
+		return 1;
+	}
+	index->matchers = matchers;
+	index->matchers[index->count] = matcher;
+
+	index->failed = 0;
+	if(!matcher_literals(matcher, &add_literal, index) || index->failed)
+	{
+		/* A matcher might end up being both in residual list and in tries, that's
+		 * fine as results are the same. */
+		int *const residual = reallocarray(index->residual,
+				index->residual_count + 1, sizeof(*residual));
+		if(residual == NULL)
+		{
+			return 1;
+		}
+		index->residual = residual;
+		index->residual[index->residual_count++] = index->count;
+	}
+
+	++index->count;
+	return 0;
+}
+
+/* Adds literal of currently added matcher to the index.  Implements
+ * matcher_literal_func. */
+static void
+add_literal(const char name[], int is_suffix, void *arg)
+{
+	matcher_index_t *const index = arg;
+	trie_t trie = is_suffix ? index->suffixes : index->names;
+	if(add_position(trie, name, index->count) != 0)
+	{
+		index->failed = 1;
+	}
+}
+
+/* Appends position to the list associated with the key.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+add_position(trie_t trie, const char key[], int pos)
+{
+	void *data = NULL;
+	int *list;
+	int count;
+
+	(void)trie_get(trie, key, &data);
+	list = data;
+	count = (list == NULL) ? 0 : list[0];
+
+	/* The same literal might be repeated within a single matcher. */
+	if(count != 0 && list[count] == pos)
+	{
+		return 0;
+	}
+
+	list = reallocarray(list, count + 2, sizeof(*list));
+	if(list == NULL)
+	{
+		return 1;
+	}
+
+	list[0] = count + 1;
+	list[count + 1] = pos;
+	if(trie_set(trie, key, list) < 0)
+	{
+		free(list);
+		return 1;
+	}
+	return 0;
+}
+
+int
+matcher_index_find(matcher_index_t *index, const char path[], int from)
+{
+	char name[NAME_MAX + 1];
+	const char *const last = get_last_path_component(path);
+	int best = INT_MAX;
+	size_t len;
+	int i;
+
+	for(len = 0U; last[len] != '\0'; ++len)
+	{
+		if(len == sizeof(name) - 1U)
+		{
+			return find_linearly(index, path, from);
+		}
+		name[len] = tolower((unsigned char)last[len]);
+	}
+	name[len] = '\0';
+
+	best = lookup(index->names, name, from);
+
+	/* Leading star of a glob doesn't match leading dot of a name. */
+	if(name[0] != '.')
+	{
+		size_t j;
+		for(j = 1U; j < len; ++j)
+		{
+			if(name[j] == '.')
+			{
+				const int pos = lookup(index->suffixes, &name[j], from);
+				if(pos < best)
+				{
+					best = pos;
+				}
+			}
+		}
+	}
+
+	for(i = 0; i < index->residual_count; ++i)
+	{
+		const int pos = index->residual[i];
+		if(pos < from)
+		{
+			continue;
+		}
+		if(pos >= best)
+		{
+			break;
+		}
+		if(matcher_matches(index->matchers[pos], path))
+		{
+			return pos;
+		}
+	}
+
+	return (best == INT_MAX) ? -1 : best;
+}
+
+/* Finds the first position in the list associated with the key that isn't less
+ * than from.  Returns the position or INT_MAX if there is none. */
+static int
+lookup(trie_t trie, const char key[], int from)
+{
+	void *data;
+	const int *list;
+	int i;
+
+	if(trie_get(trie, key, &data) != 0)
+	{
+		return INT_MAX;
+	}
+
+	list = data;
+	for(i = 1; i <= list[0]; ++i)
+	{
+		if(list[i] >= from)
+		{
+			return list[i];
+		}
+	}
+	return INT_MAX;
+}
+
+/* Runs all matchers starting at from position one by one.  Returns position of
+ * the first matcher that matches or -1. */
+static int
+find_linearly(matcher_index_t *index, const char path[], int from)
+{
+	int i;
+	for(i = from; i < index->count; ++i)
+	{
+		if(matcher_matches(index->matchers[i], path))
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,48 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__MATCHER_INDEX_H__
+#define VIFM__UTILS__MATCHER_INDEX_H__
+
+/* Ordered list of matchers that finds first matching one without running
+ * regular expressions of globs that consist of plain names and extensions. */
+
+struct matcher_t;
+
+/* Opaque matcher index type. */
+typedef struct matcher_index_t matcher_index_t;
+
+/* Allocates empty index.  Returns the index or NULL on error. */
+matcher_index_t * matcher_index_alloc(void);
+
+/* Frees the index, but not matchers added to it.  index can be NULL. */
+void matcher_index_free(matcher_index_t *index);
+
+/* Appends matcher to the index.  Position of the matcher is the number of
+ * previously added ones.  The matcher should be alive while it's in the index.
+ * Returns zero on success, otherwise non-zero is returned. */
+int matcher_index_add(matcher_index_t *index, struct matcher_t *matcher);
+
+/* Looks for the first matcher at position not less than from that matches the
+ * path.  Returns the position or -1 if there is no match. */
+int matcher_index_find(matcher_index_t *index, const char path[], int from);
+
+#endif /* VIFM__UTILS__MATCHER_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
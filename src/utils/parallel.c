@@ -0,0 +1,104 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "parallel.h"
+
+#include <pthread.h> /* pthread_t pthread_create() pthread_join() */
+
+#include "macros.h"
+#include "utils.h"
+
+/* Description of a single chunk of a range. */
+typedef struct
+{
+	int from;                    /* First item of the chunk. */
+	int to;                      /* Item past the last one of the chunk. */
+	int index;                   /* Index of the chunk. */
+	parallel_range_func handler; /* Processor of the chunk. */
+	void *arg;                   /* Argument for the handler. */
+}
+chunk_t;
+
+static void * chunk_thread(void *arg);
+static void process_chunk(const chunk_t *chunk);
+
+void
+parallel_for(int count, int min_chunk, parallel_range_func handler,
+		void *arg)
+{
+	chunk_t chunks[PARALLEL_MAX_CHUNKS];
+	pthread_t threads[PARALLEL_MAX_CHUNKS];
+	int started[PARALLEL_MAX_CHUNKS];
+	int nchunks;
+	int i;
+
+	nchunks = MIN(get_cpu_count(), PARALLEL_MAX_CHUNKS);
+	if(min_chunk > 0)
+	{
+		nchunks = MIN(nchunks, count/min_chunk);
+	}
+	nchunks = MAX(nchunks, 1);
+
+	for(i = 0; i < nchunks; ++i)
+	{
+		chunks[i].from = (long long)count*i/nchunks;
+		chunks[i].to = (long long)count*(i + 1)/nchunks;
+		chunks[i].index = i;
+		chunks[i].handler = handler;
+		chunks[i].arg = arg;
+	}
+
+	for(i = 1; i < nchunks; ++i)
+	{
+		started[i] = (pthread_create(&threads[i], NULL, &chunk_thread,
+					&chunks[i]) == 0);
+	}
+
+	process_chunk(&chunks[0]);
+
+	for(i = 1; i < nchunks; ++i)
+	{
+		if(started[i])
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+		else
+		{
+			/* Failed to start a thread, do its job here. */
+			process_chunk(&chunks[i]);
+		}
+	}
+}
+
+/* pthreads entry point for processing a chunk. */
+static void *
+chunk_thread(void *arg)
+{
+	process_chunk(arg);
+	return NULL;
+}
+
+/* Invokes handler of the chunk. */
+static void
+process_chunk(const chunk_t *chunk)
+{
+	chunk->handler(chunk->from, chunk->to, chunk->index, chunk->arg);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,48 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PARALLEL_H__
+#define VIFM__UTILS__PARALLEL_H__
+
+/* Processing of independent items of a range by several threads. */
+
+/* Maximum number of chunks a range can be split into. */
+#define PARALLEL_MAX_CHUNKS 16
+
+/* Minimal size of a chunk for cheap processing of items like matching a file
+ * name against a pattern.  Smaller ranges aren't worth the overhead of starting
+ * threads. */
+#define PARALLEL_MIN_CHUNK 4096
+
+/* Processes items of [from, to) range.  chunk is index of the chunk, which is
+ * zero for the part that is processed by the calling thread.  Note that glibc
+ * serializes regexec() calls on the same regex_t, so handlers of non-zero
+ * chunks should match against their own copy of a regular expression. */
+typedef void (*parallel_range_func)(int from, int to, int chunk, void *arg);
+
+/* Splits [0, count) range into chunks of at least min_chunk items (one per
+ * available processor) and invokes the handler for each of them concurrently.
+ * The handler must not touch data outside of its range without
+ * synchronization.  Returns after all chunks are processed. */
+void parallel_for(int count, int min_chunk, parallel_range_func handler,
+		void *arg);
+
+#endif /* VIFM__UTILS__PARALLEL_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,233 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "profiler.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h> /* CLOCK_MONOTONIC clock_gettime() timespec */
+#endif
+
+#include <stdio.h> /* FILE ferror() fprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "../compat/reallocarray.h"
+#include "str.h"
+
+/* Single recorded phase or span. */
+typedef struct
+{
+	char *name;   /* Name of the record with optional details. */
+	int depth;    /* Nesting level, zero for top-level phases. */
+	int open;     /* Whether the record is still being timed. */
+	double start; /* Start time in milliseconds since prof_start(). */
+	double end;   /* End time in milliseconds since prof_start(). */
+}
+record_t;
+
+static int add_record(const char name[], const char what[]);
+static void close_records(int from);
+static double get_self_time(int idx);
+static double get_time(void);
+
+/* Whether profiler is recording. */
+static int enabled;
+/* Time at which recording was started. */
+static double start_time;
+/* List of records in order of their start. */
+static record_t *records;
+/* Number of elements in the records array. */
+static int nrecords;
+/* Number of open records, which is also depth of next nested record. */
+static int nopen;
+
+void
+prof_start(void)
+{
+	if(!enabled)
+	{
+		enabled = 1;
+		start_time = get_time();
+	}
+}
+
+void
+prof_phase(const char name[])
+{
+	if(enabled)
+	{
+		close_records(0);
+		(void)add_record(name, NULL);
+	}
+}
+
+int
+prof_enter(const char name[], const char what[])
+{
+	return enabled ? add_record(name, what) : -1;
+}
+
+void
+prof_leave(int id)
+{
+	if(enabled && id >= 0)
+	{
+		close_records(id);
+	}
+}
+
+/* Appends new open record nested into the last open one.  Returns index of the
+ * record or -1 on error. */
+static int
+add_record(const char name[], const char what[])
+{
+	record_t *record;
+	char *const full_name = (what == NULL)
+	                      ? strdup(name)
+	                      : format_str("%s %s", name, what);
+
+	void *const ptr = reallocarray(records, nrecords + 1, sizeof(*records));
+	if(ptr != NULL)
+	{
+		records = ptr;
+	}
+	if(full_name == NULL || ptr == NULL)
+	{
+		free(full_name);
+		return -1;
+	}
+
+	record = &records[nrecords];
+	record->name = full_name;
+	record->depth = nopen;
+	record->open = 1;
+	record->start = get_time() - start_time;
+	record->end = record->start;
+
+	++nopen;
+	return nrecords++;
+}
+
+/* Finishes all open records starting with the one at from index. */
+static void
+close_records(int from)
+{
+	const double now = get_time() - start_time;
+	int i;
+	for(i = from; i < nrecords; ++i)
+	{
+		if(records[i].open)
+		{
+			records[i].open = 0;
+			records[i].end = now;
+			--nopen;
+		}
+	}
+}
+
+void
+prof_finish(void)
+{
+	close_records(0);
+	enabled = 0;
+}
+
+int
+prof_report(FILE *fp)
+{
+	int i;
+	double total = 0.0;
+
+	close_records(0);
+
+	fprintf(fp, "%10s %10s %10s  %s\n", "start, ms", "total, ms", "self, ms",
+			"phase");
+	for(i = 0; i < nrecords; ++i)
+	{
+		const record_t *const record = &records[i];
+		fprintf(fp, "%10.3f %10.3f %10.3f  %*s%s\n", record->start,
+				record->end - record->start, get_self_time(i), record->depth*2, "",
+				record->name);
+		if(record->end > total)
+		{
+			total = record->end;
+		}
+	}
+	fprintf(fp, "%10s %10.3f %10s  %s\n", "", total, "", "total");
+
+	return ferror(fp);
+}
+
+/* Computes time spent in the record at idx excluding its nested records.
+ * Returns the time. */
+static double
+get_self_time(int idx)
+{
+	const record_t *const record = &records[idx];
+	double self = record->end - record->start;
+	int i;
+	for(i = idx + 1; i < nrecords && records[i].depth > record->depth; ++i)
+	{
+		if(records[i].depth == record->depth + 1)
+		{
+			self -= records[i].end - records[i].start;
+		}
+	}
+	return self;
+}
+
+void
+prof_stop(void)
+{
+	int i;
+	for(i = 0; i < nrecords; ++i)
+	{
+		free(records[i].name);
+	}
+	free(records);
+	records = NULL;
+	nrecords = 0;
+	nopen = 0;
+	enabled = 0;
+}
+
+/* Retrieves value of monotonic clock.  Returns the value in milliseconds. */
+static double
+get_time(void)
+{
+#ifndef _WIN32
+	struct timespec ts;
+	if(clock_gettime(CLOCK_MONOTONIC, &ts) != 0)
+	{
+		return 0.0;
+	}
+	return ts.tv_sec*1000.0 + ts.tv_nsec/1e6;
+#else
+	LARGE_INTEGER freq, counter;
+	if(!QueryPerformanceFrequency(&freq) || !QueryPerformanceCounter(&counter))
+	{
+		return 0.0;
+	}
+	return counter.QuadPart*1000.0/freq.QuadPart;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,59 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__PROFILER_H__
+#define VIFM__UTILS__PROFILER_H__
+
+#include <stdio.h> /* FILE */
+
+/* Simple profiler that records timings of phases (e.g. of initialization)
+ * using monotonic clock.  Top-level phases follow each other, while spans can
+ * be nested within them.  Functions that record timings do nothing unless
+ * profiler is started. */
+
+/* Starts recording.  Does nothing if the profiler is already started. */
+void prof_start(void);
+
+/* Finishes all open spans and previous phase and starts new top-level phase
+ * named by the name. */
+void prof_phase(const char name[]);
+
+/* Starts new span nested into currently open one.  The what parameter can be
+ * NULL and is used to provide details (like path) of the span.  Returns id to
+ * be passed to prof_leave() or -1 if recording is off. */
+int prof_enter(const char name[], const char what[]);
+
+/* Finishes span started by prof_enter() along with all spans nested in it.
+ * Does nothing for negative id. */
+void prof_leave(int id);
+
+/* Finishes all open spans and stops recording, but keeps recorded data for
+ * prof_report(). */
+void prof_finish(void);
+
+/* Finishes all open spans and writes report of recorded timings into the fp.
+ * Returns zero on success, otherwise non-zero is returned. */
+int prof_report(FILE *fp);
+
+/* Stops recording and frees all recorded data. */
+void prof_stop(void);
+
+#endif /* VIFM__UTILS__PROFILER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -20,6 +20,8 @@
 
 #include <regex.h> /* regex_t regmatch_t regerror() regexec() */
 
+#include <string.h> /* strpbrk() */
+
 #include "../cfg/config.h"
 #include "str.h"
 
@@ -48,6 +50,12 @@ regexp_should_ignore_case(const char pattern[])
 	return ignore_case;
 }
 
+int
+regexp_is_literal(const char pattern[])
+{
+	return strpbrk(pattern, ".[]()*+?{}|^$\\") == NULL;
+}
+
 const char *
 get_regexp_error(int err, const regex_t *re)
 {
@@ -32,6 +32,11 @@ int get_regexp_cflags(const char pattern[]);
  * ignored, otherwise zero is returned. */
 int regexp_should_ignore_case(const char pattern[]);
 
+/* Checks whether pattern contains no characters that are special in extended
+ * regular expressions, so it matches itself as a plain string.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int regexp_is_literal(const char pattern[]);
+
 /* Turns error code into error message.  Returns pointer to a statically
  * allocated buffer. */
 const char * get_regexp_error(int err, const regex_t *re);
@@ -0,0 +1,114 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "strbuf.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* free() realloc() */
+#include <string.h> /* memcpy() strdup() strlen() */
+
+/* Minimal size of memory allocated for a buffer. */
+#define MIN_CAPACITY 64U
+
+static int reserve(strbuf_t *buf, size_t len);
+
+int
+strbuf_appendn(strbuf_t *buf, const char str[], size_t len)
+{
+	if(buf->failed)
+	{
+		return 1;
+	}
+
+	if(reserve(buf, buf->len + len + 1U) != 0)
+	{
+		buf->failed = 1;
+		return 1;
+	}
+
+	memcpy(buf->data + buf->len, str, len);
+	buf->len += len;
+	buf->data[buf->len] = '\0';
+	return 0;
+}
+
+int
+strbuf_append(strbuf_t *buf, const char str[])
+{
+	return strbuf_appendn(buf, str, strlen(str));
+}
+
+/* Makes sure that buffer has at least size bytes of memory.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+reserve(strbuf_t *buf, size_t size)
+{
+	size_t new_capacity;
+	char *new_data;
+
+	if(size <= buf->capacity)
+	{
+		return 0;
+	}
+
+	new_capacity = (buf->capacity < MIN_CAPACITY) ? MIN_CAPACITY : buf->capacity;
+	while(new_capacity < size)
+	{
+		new_capacity *= 2U;
+	}
+
+	new_data = realloc(buf->data, new_capacity);
+	if(new_data == NULL)
+	{
+		return 1;
+	}
+
+	buf->data = new_data;
+	buf->capacity = new_capacity;
+	return 0;
+}
+
+char *
+strbuf_finish(strbuf_t *buf)
+{
+	char *result;
+
+	if(buf->failed)
+	{
+		strbuf_free(buf);
+		return NULL;
+	}
+
+	result = (buf->data == NULL) ? strdup("") : buf->data;
+	buf->data = NULL;
+	strbuf_free(buf);
+	return result;
+}
+
+void
+strbuf_free(strbuf_t *buf)
+{
+	free(buf->data);
+	buf->data = NULL;
+	buf->len = 0U;
+	buf->capacity = 0U;
+	buf->failed = 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
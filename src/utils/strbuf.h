@@ -0,0 +1,59 @@
+/* vifm
+ * Copyright (C) 2016 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__STRBUF_H__
+#define VIFM__UTILS__STRBUF_H__
+
+#include <stddef.h> /* size_t */
+
+/* Growable string that keeps track of its length and allocates memory in
+ * chunks of increasing size, which makes appending to it take amortized
+ * constant time. */
+typedef struct
+{
+	char *data;      /* Null-terminated contents or NULL if nothing is there. */
+	size_t len;      /* Length of the string. */
+	size_t capacity; /* Size of memory allocated for the data. */
+	int failed;      /* Whether memory allocation has failed. */
+}
+strbuf_t;
+
+/* Initializer of empty buffer. */
+#define STRBUF_INITIALIZER { NULL, 0U, 0U, 0 }
+
+/* Appends first len characters of the str to the buffer.  All appends after
+ * memory error are ignored.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int strbuf_appendn(strbuf_t *buf, const char str[], size_t len);
+
+/* Appends the str to the buffer.  All appends after memory error are ignored.
+ * Returns zero on success, otherwise non-zero is returned. */
+int strbuf_append(strbuf_t *buf, const char str[]);
+
+/* Takes the string out of the buffer and resets the buffer.  Returns the
+ * string (empty if nothing was appended) or NULL if there was a memory error
+ * while building it. */
+char * strbuf_finish(strbuf_t *buf);
+
+/* Frees memory of the buffer and resets it. */
+void strbuf_free(strbuf_t *buf);
+
+#endif /* VIFM__UTILS__STRBUF_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -102,6 +102,14 @@ const char * make_name_unique(const char filename[]);
 /* Returns process identification in a portable way. */
 unsigned int get_pid(void);
 
+/* Queries number of processors available to the application.  Returns the
+ * number, which is always positive. */
+int get_cpu_count(void);
+
+/* Estimates maximum length of a command that can be passed to a shell
+ * accounting for size of environment.  Returns the length. */
+size_t get_max_cmd_len(void);
+
 /* Finds command name in the command line and writes it to the buf.
  * Raw mode will preserve quotes on Windows.
  * Returns a pointer to the argument list. */
@@ -230,6 +238,12 @@ int reopen_term_stdin(void);
  * NULL on error, otherwise stream valid for reading is returned. */
 FILE * read_cmd_output(const char cmd[]);
 
+/* Same as read_cmd_output(), but runs the command via the specified shell in
+ * the cwd directory (current one if it's NULL).  Doesn't access configuration,
+ * so can be called from background threads. */
+FILE * read_cmd_output_at(const char cmd[], const char shell[],
+		const char cwd[]);
+
 /* Gets path to directory where files bundled with Vifm are stored.  Returns
  * pointer to a statically allocated buffer. */
 const char * get_installed_data_dir(void);
@@ -26,20 +26,22 @@
 #include <sys/user.h>
 #endif
 
+#include <poll.h> /* POLLERR POLLPRI poll() pollfd */
 #include <sys/select.h> /* select() FD_SET FD_ZERO */
 #include <sys/stat.h> /* O_* S_* */
 #include <sys/time.h> /* timeval futimens() utimes() */
 #include <sys/types.h> /* gid_t mode_t pid_t uid_t */
 #include <sys/wait.h> /* waitpid */
-#include <fcntl.h> /* open() close() */
+#include <fcntl.h> /* FD_CLOEXEC F_SETFD O_RDONLY fcntl() open() close() */
 #include <grp.h> /* getgrnam() getgrgid_r() */
 #include <pwd.h> /* getpwnam() getpwuid_r() */
-#include <unistd.h> /* X_OK dup() dup2() getpid() isatty() pause() sysconf()
-                       ttyname() */
+#include <unistd.h> /* X_OK chdir() dup() dup2() getpid() isatty() pause()
+                       sysconf() ttyname() */
 
 #include <assert.h> /* assert() */
 #include <ctype.h> /* isdigit() */
 #include <errno.h> /* EINTR errno */
+#include <limits.h> /* _POSIX_ARG_MAX */
 #include <signal.h> /* SIGINT SIGTSTP SIGCHLD SIG_DFL SIG_BLOCK SIG_UNBLOCK
                        sigset_t kill() sigaddset() sigemptyset() signal()
                        sigprocmask() */
@@ -64,28 +66,25 @@
 #include "macros.h"
 #include "path.h"
 #include "str.h"
+#include "trie.h"
 #include "utils.h"
 
-/* Types of mount point information for get_mount_point_traverser_state. */
-typedef enum
-{
-	MI_MOUNT_POINT, /* Path to the mount point. */
-	MI_FS_TYPE,     /* File system name. */
-}
-mntinfo;
-
-/* State for get_mount_point() traverser. */
+/* Cached mount table along with data for detecting its changes. */
 typedef struct
 {
-	mntinfo type;     /* Type of information to put into the buffer. */
-	const char *path; /* Path whose mount point we're looking for. */
-	size_t buf_len;   /* Output buffer length. */
-	char *buf;        /* Output buffer. */
-	size_t curr_len;  /* Max length among all found points (len of buf string). */
+	struct mntent *entries; /* Mount entries in the order of the mount table. */
+	unsigned int nentries;  /* Number of elements in the entries array. */
+	trie_t index;           /* Mount point -> first entry for it. */
+	int valid;              /* Whether entries and index are initialized. */
+	int fd;                 /* Descriptor of /proc/self/mountinfo or -1. */
+	int no_mountinfo;       /* Whether /proc/self/mountinfo can't be opened. */
+	filemon_t mtab_mon;     /* State of /etc/mtab for fallback detection. */
 }
-get_mount_point_traverser_state;
+mount_cache_t;
 
-static int get_mount_info_traverser(struct mntent *entry, void *arg);
+static const struct mntent * find_mount(const char path[]);
+static void update_mounts(void);
+static int mounts_changed(void);
 static void free_mnt_entries(struct mntent *entries, unsigned int nentries);
 struct mntent * read_mnt_entries(unsigned int *nentries);
 static int clone_mnt_entry(struct mntent *lhs, const struct mntent *rhs);
@@ -93,6 +92,11 @@ static void free_mnt_entry(struct mntent *entry);
 static int starts_with_list_item(const char str[], const char list[]);
 static int find_path_prefix_index(const char path[], const char list[]);
 static int open_tty(void);
+static void _gnuc_noreturn exec_from_fork(int pipe[2], int err_only,
+		char shell[], const char cwd[], char cmd[]);
+
+/* Process-wide cache of mount table. */
+static mount_cache_t mounts = { .fd = -1 };
 
 void
 pause_shell(void)
@@ -223,6 +227,16 @@ get_proc_exit_status(pid_t pid)
 
 void _gnuc_noreturn
 run_from_fork(int pipe[2], int err_only, char cmd[])
+{
+	exec_from_fork(pipe, err_only, cfg.shell, NULL, cmd);
+}
+
+/* Sets up standard streams of a forked process like run_from_fork() does,
+ * changes directory to cwd unless it's NULL and runs the command via the
+ * shell.  Never returns. */
+static void _gnuc_noreturn
+exec_from_fork(int pipe[2], int err_only, char shell[], const char cwd[],
+		char cmd[])
 {
 	int nullfd;
 
@@ -261,7 +275,12 @@ run_from_fork(int pipe[2], int err_only, char cmd[])
 		}
 	}
 
-	execvp(get_execv_path(cfg.shell), make_execv_array(cfg.shell, cmd));
+	if(cwd != NULL && chdir(cwd) != 0)
+	{
+		_Exit(127);
+	}
+
+	execvp(get_execv_path(shell), make_execv_array(shell, cmd));
 	_Exit(127);
 }
 
@@ -404,14 +423,7 @@ refers_to_slower_fs(const char from[], const char to[])
 int
 is_on_slow_fs(const char full_path[])
 {
-	char fs_name[PATH_MAX];
-	get_mount_point_traverser_state state = {
-		.type = MI_FS_TYPE,
-		.path = full_path,
-		.buf_len = sizeof(fs_name),
-		.buf = fs_name,
-		.curr_len = 0UL,
-	};
+	const struct mntent *mount;
 
 	/* Empty list optimization. */
 	if(cfg.slow_fs_list[0] == '\0')
@@ -427,15 +439,10 @@ is_on_slow_fs(const char full_path[])
 		return 1;
 	}
 
-	if(traverse_mount_points(&get_mount_info_traverser, &state) == 0)
+	mount = find_mount(full_path);
+	if(mount != NULL && starts_with_list_item(mount->mnt_type, cfg.slow_fs_list))
 	{
-		if(state.curr_len > 0)
-		{
-			if(starts_with_list_item(fs_name, cfg.slow_fs_list))
-			{
-				return 1;
-			}
-		}
+		return 1;
 	}
 
 	return find_path_prefix_index(full_path, cfg.slow_fs_list) != -1;
@@ -444,75 +451,152 @@ is_on_slow_fs(const char full_path[])
 int
 get_mount_point(const char path[], size_t buf_len, char buf[])
 {
-	get_mount_point_traverser_state state = {
-		.type = MI_MOUNT_POINT,
-		.path = path,
-		.buf_len = buf_len,
-		.buf = buf,
-		.curr_len = 0UL,
-	};
-	return traverse_mount_points(&get_mount_info_traverser, &state);
+	const struct mntent *const mount = find_mount(path);
+	if(mount == NULL)
+	{
+		return 1;
+	}
+
+	copy_str(buf, buf_len, mount->mnt_dir);
+	return 0;
 }
 
-/* traverse_mount_points client that gets mount point info for a given path. */
-static int
-get_mount_info_traverser(struct mntent *entry, void *arg)
+int
+traverse_mount_points(mptraverser client, void *arg)
 {
-	get_mount_point_traverser_state *const state = arg;
-	if(path_starts_with(state->path, entry->mnt_dir))
+	unsigned int i;
+
+	update_mounts();
+
+	if(mounts.nentries == 0U)
 	{
-		const size_t new_len = strlen(entry->mnt_dir);
-		if(new_len > state->curr_len)
-		{
-			state->curr_len = new_len;
-			switch(state->type)
-			{
-				case MI_MOUNT_POINT:
-					copy_str(state->buf, state->buf_len, entry->mnt_dir);
-					break;
-				case MI_FS_TYPE:
-					copy_str(state->buf, state->buf_len, entry->mnt_type);
-					break;
-
-				default:
-					assert(0 && "Unknown mount information type.");
-					break;
-			}
-		}
+		return 1;
+	}
+
+	for(i = 0U; i < mounts.nentries; ++i)
+	{
+		client(&mounts.entries[i], arg);
 	}
+
 	return 0;
 }
 
-int
-traverse_mount_points(mptraverser client, void *arg)
+/* Finds mount entry of the closest mount point that contains the path by
+ * looking up the path and its parents in the index.  Returns the entry or NULL
+ * if there is no such mount point. */
+static const struct mntent *
+find_mount(const char path[])
 {
-	/* Cached mount entries, updated only when /etc/mtab changes. */
-	static filemon_t mtab_mon;
-	static struct mntent *entries;
-	static unsigned int nentries;
+	char prefix[strlen(path) + 1];
+	size_t len;
 
-	filemon_t mon;
+	update_mounts();
+
+	strcpy(prefix, path);
+	len = strlen(prefix);
+	while(len > 1U && prefix[len - 1U] == '/')
+	{
+		prefix[--len] = '\0';
+	}
+
+	while(prefix[0] != '\0')
+	{
+		void *data;
+		char *slash;
+
+		if(trie_get(mounts.index, prefix, &data) == 0)
+		{
+			return data;
+		}
+
+		slash = strrchr(prefix, '/');
+		if(slash == NULL || (slash == prefix && prefix[1] == '\0'))
+		{
+			break;
+		}
+		slash[slash == prefix] = '\0';
+	}
+
+	return NULL;
+}
+
+/* Re-reads mount table if it has changed since it was read last time. */
+static void
+update_mounts(void)
+{
 	unsigned int i;
 
-	/* Check for cache validity. */
-	if(filemon_from_file("/etc/mtab", &mon) != 0 ||
-			!filemon_equal(&mon, &mtab_mon))
+	/* Change detection is set up before reading the table to not miss changes
+	 * that happen in between. */
+	if(!mounts_changed() && mounts.valid)
 	{
-		filemon_assign(&mtab_mon, &mon);
-		free_mnt_entries(entries, nentries);
-		entries = read_mnt_entries(&nentries);
+		return;
 	}
 
-	if(nentries == 0U)
+	free_mnt_entries(mounts.entries, mounts.nentries);
+	trie_free(mounts.index);
+
+	mounts.entries = read_mnt_entries(&mounts.nentries);
+	mounts.index = trie_create();
+	mounts.valid = 1;
+
+	for(i = 0U; i < mounts.nentries; ++i)
 	{
-		return 1;
+		char *const dir = mounts.entries[i].mnt_dir;
+		void *data;
+
+		/* Mount points are compared with paths that have no trailing slash. */
+		chosp(dir);
+		if(dir[0] == '\0')
+		{
+			strcpy(dir, "/");
+		}
+
+		/* The first entry for a mount point wins. */
+		if(trie_get(mounts.index, dir, &data) != 0)
+		{
+			(void)trie_set(mounts.index, dir, &mounts.entries[i]);
+		}
 	}
+}
 
-	for(i = 0; i < nentries; ++i)
+/* Checks whether mount table might have changed since the last check.  Uses
+ * notifications of /proc/self/mountinfo, which are delivered via POLLPRI, and
+ * falls back to checking modification time of /etc/mtab where that file isn't
+ * available.  Returns non-zero if so, otherwise zero is returned. */
+static int
+mounts_changed(void)
+{
+	filemon_t mon;
+
+	if(mounts.fd == -1 && !mounts.no_mountinfo)
 	{
-		client(&entries[i], arg);
+		mounts.fd = open("/proc/self/mountinfo", O_RDONLY);
+		if(mounts.fd == -1)
+		{
+			mounts.no_mountinfo = 1;
+		}
+		else
+		{
+			(void)fcntl(mounts.fd, F_SETFD, FD_CLOEXEC);
+			/* The table was read without watching it for changes. */
+			return 1;
+		}
 	}
 
+	if(mounts.fd != -1)
+	{
+		/* Each poll() call acknowledges pending change. */
+		struct pollfd pfd = { .fd = mounts.fd, .events = POLLPRI };
+		return poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR));
+	}
+
+	if(filemon_from_file("/etc/mtab", &mon) != 0 ||
+			!filemon_equal(&mon, &mounts.mtab_mon))
+	{
+		filemon_assign(&mounts.mtab_mon, &mon);
+		return 1;
+	}
 	return 0;
 }
 
@@ -646,6 +730,44 @@ get_pid(void)
 	return getpid();
 }
 
+int
+get_cpu_count(void)
+{
+	const long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0) ? count : 1;
+}
+
+size_t
+get_max_cmd_len(void)
+{
+	/* Leave room for the shell and its arguments like xargs does. */
+	enum { HEADROOM = 2048 };
+
+	extern char **environ;
+	long arg_max = sysconf(_SC_ARG_MAX);
+	size_t env_size = 0U;
+	char **env;
+
+	if(arg_max <= 0)
+	{
+		arg_max = _POSIX_ARG_MAX;
+	}
+
+	for(env = environ; *env != NULL; ++env)
+	{
+		env_size += strlen(*env) + 1U + sizeof(*env);
+	}
+
+	if((size_t)arg_max < env_size + 2U*HEADROOM)
+	{
+		return HEADROOM;
+	}
+	/* Command is passed to shell as a single argument, which Linux limits to
+	 * 128 KiB, so stay well below that like xargs does by default.  Longer
+	 * commands won't run faster anyway. */
+	return MIN(arg_max - env_size - HEADROOM, 128U*1024U - 4096U - HEADROOM);
+}
+
 int
 get_uid(const char user[], uid_t *uid)
 {
@@ -954,6 +1076,12 @@ open_tty(void)
 
 FILE *
 read_cmd_output(const char cmd[])
+{
+	return read_cmd_output_at(cmd, cfg.shell, NULL);
+}
+
+FILE *
+read_cmd_output_at(const char cmd[], const char shell[], const char cwd[])
 {
 	FILE *fp;
 	pid_t pid;
@@ -972,7 +1100,7 @@ read_cmd_output(const char cmd[])
 
 	if(pid == 0)
 	{
-		run_from_fork(out_pipe, 0, (char *)cmd);
+		exec_from_fork(out_pipe, 0, (char *)shell, cwd, (char *)cmd);
 		return NULL;
 	}
 
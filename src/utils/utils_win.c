@@ -139,6 +139,21 @@ get_pid(void)
 	return GetCurrentProcessId();
 }
 
+int
+get_cpu_count(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+}
+
+size_t
+get_max_cmd_len(void)
+{
+	/* Limit of cmd.exe with some room left for the shell invocation. */
+	return 8191U - 1024U;
+}
+
 int
 wcwidth(wchar_t c)
 {
@@ -665,6 +680,13 @@ reopen_term_stdin(void)
 FILE *
 read_cmd_output(const char cmd[])
 {
+	return read_cmd_output_at(cmd, cfg.shell, NULL);
+}
+
+FILE *
+read_cmd_output_at(const char cmd[], const char shell[], const char cwd[])
+{
+	char *cd_cmd = NULL;
 	int out_fd, err_fd;
 	int out_pipe[2];
 	FILE *result;
@@ -674,10 +696,25 @@ read_cmd_output(const char cmd[])
 		return NULL;
 	}
 
+	/* Shell is always cmd here, so it's only the directory that matters. */
+	(void)shell;
+	if(cwd != NULL)
+	{
+		cd_cmd = format_str("cd /d \"%s\" && %s", cwd, cmd);
+		if(cd_cmd == NULL)
+		{
+			close(out_pipe[0]);
+			close(out_pipe[1]);
+			return NULL;
+		}
+		cmd = cd_cmd;
+	}
+
 	out_fd = dup(_fileno(stdout));
 	err_fd = dup(_fileno(stderr));
 
 	result = use_info_prog_internal(cmd, out_pipe);
+	free(cd_cmd);
 
 	_dup2(out_fd, _fileno(stdout));
 	_dup2(err_fd, _fileno(stderr));
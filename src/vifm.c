@@ -31,7 +31,8 @@
 #include <errno.h> /* errno */
 #include <locale.h> /* setlocale */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* fprintf() fputs() puts() snprintf() */
+#include <stdio.h> /* FILE fclose() fflush() fprintf() fputs() puts()
+                      snprintf() */
 #include <stdlib.h> /* EXIT_FAILURE EXIT_SUCCESS exit() system() */
 #include <string.h>
 
@@ -39,6 +40,7 @@
 #include "cfg/info.h"
 #include "engine/autocmds.h"
 #include "compat/fs_limits.h"
+#include "compat/os.h"
 #include "engine/cmds.h"
 #include "engine/keys.h"
 #include "engine/mode.h"
@@ -62,6 +64,7 @@
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/path.h"
+#include "utils/profiler.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/utils.h"
@@ -92,13 +95,16 @@ static int pair_in_use(short int pair);
 static void move_pair(short int from, short int to);
 static int undo_perform_func(OPS op, void *data, const char src[],
 		const char dst[]);
-static void parse_received_arguments(char *args[]);
+static int parse_received_arguments(char *args[], char **output);
+static char * get_messages_since(int tail);
 static void remote_cd(FileView *view, const char *path, int handle);
 static void check_path_for_file(FileView *view, const char path[], int handle);
 static int need_to_switch_active_pane(const char lwin_path[],
 		const char rwin_path[]);
 static void load_scheme(void);
-static void exec_startup_commands(const args_t *args);
+static int exec_startup_commands(const args_t *args);
+static void finish_startup_profile(void);
+static void write_startup_profile(void);
 static void _gnuc_noreturn vifm_leave(int exit_code, int cquit);
 
 /* Command-line arguments in parsed form. */
@@ -123,6 +129,10 @@ main(int argc, char *argv[])
 
 	(void)vifm_chdir(dir);
 	args_parse(&vifm_args, argc, argv, dir);
+	if(vifm_args.startup_profile[0] != '\0')
+	{
+		prof_start();
+	}
 	args_process(&vifm_args, 1);
 
 	if(strcmp(vifm_args.lwin_path, "-") == 0 ||
@@ -137,6 +147,7 @@ main(int argc, char *argv[])
 
 	(void)setlocale(LC_ALL, "");
 
+	prof_phase("cfg_init");
 	cfg_init();
 
 	if(vifm_args.logging)
@@ -144,31 +155,41 @@ main(int argc, char *argv[])
 		init_logger(1, vifm_args.startup_log_path);
 	}
 
+	prof_phase("init_filelists");
 	init_filelists();
+	prof_phase("regs_init");
 	regs_init();
+	prof_phase("cfg_discover_paths");
 	cfg_discover_paths();
 	reinit_logger(cfg.log_file);
 
+	prof_phase("init_commands");
 	/* Commands module also initializes bracket notation and variables. */
 	init_commands();
 
+	prof_phase("init_builtin_functions");
 	init_builtin_functions();
+	prof_phase("update_path_env");
 	update_path_env(1);
 
+	prof_phase("init_status");
 	if(init_status(&cfg) != 0)
 	{
 		puts("Error during session status initialization.");
 		return -1;
 	}
 
+	prof_phase("ft_init");
 	/* Tell file type module what function to use to check availability of
 	 * external programs. */
 	ft_init(&external_command_exists);
 	/* This should be called before loading any configuration file. */
 	ft_reset(curr_stats.exec_env_type == EET_EMULATOR_WITH_X);
 
+	prof_phase("init_option_handlers");
 	init_option_handlers();
 
+	prof_phase("read_info_file");
 	if(!vifm_args.no_configs)
 	{
 		/* vifminfo must be processed this early so that it can restore last visited
@@ -176,13 +197,17 @@ main(int argc, char *argv[])
 		read_info_file(0);
 	}
 
+	prof_phase("ipc_init");
 	ipc_init(vifm_args.server_name, &parse_received_arguments);
 	args_process(&vifm_args, 0);
 
+	prof_phase("init_background");
 	init_background();
 
+	prof_phase("init_fileops");
 	init_fileops(&enter_prompt_mode, &prompt_msg_custom);
 
+	prof_phase("load_initial_directory");
 	set_view_path(&lwin, vifm_args.lwin_path);
 	set_view_path(&rwin, vifm_args.rwin_path);
 
@@ -200,6 +225,7 @@ main(int argc, char *argv[])
 		curr_stats.number_of_windows = 2;
 	}
 
+	prof_phase("setup_ncurses_interface");
 	/* Prepare terminal for further operations. */
 	curr_stats.original_stdout = reopen_term_stdout();
 	if(curr_stats.original_stdout == NULL)
@@ -212,6 +238,7 @@ main(int argc, char *argv[])
 		return -1;
 	}
 
+	prof_phase("colmgr_init");
 	{
 		const colmgr_conf_t colmgr_conf = {
 			.max_color_pairs = COLOR_PAIRS,
@@ -224,6 +251,7 @@ main(int argc, char *argv[])
 		colmgr_init(&colmgr_conf);
 	}
 
+	prof_phase("init_modes");
 	init_modes();
 	init_undo_list(&undo_perform_func, NULL, &ui_cancellation_requested,
 			&cfg.undo_levels);
@@ -233,7 +261,9 @@ main(int argc, char *argv[])
 
 	if(!vifm_args.no_configs)
 	{
+		prof_phase("load_scheme");
 		load_scheme();
+		prof_phase("cfg_load");
 		cfg_load();
 
 		if(strcmp(vifm_args.lwin_path, "-") == 0)
@@ -245,21 +275,26 @@ main(int argc, char *argv[])
 			flist_set(&rwin, "-", dir, files, nfiles);
 		}
 	}
+	prof_phase("load_color_scheme_colors");
 	/* Load colors in any case to load color pairs. */
 	load_color_scheme_colors();
 
+	prof_phase("write_color_scheme_file");
 	write_color_scheme_file();
 	setup_signals();
 
+	prof_phase("set_trash_dir");
 	/* Ensure trash directories exist, it might not have been called during
 	 * configuration file sourcing if there is no `set trashdir=...` command. */
 	(void)set_trash_dir(cfg.trash_dir);
 
+	prof_phase("check_path_for_file");
 	check_path_for_file(&lwin, vifm_args.lwin_path, vifm_args.lwin_handle);
 	check_path_for_file(&rwin, vifm_args.rwin_path, vifm_args.rwin_handle);
 
 	curr_stats.load_stage = 2;
 
+	prof_phase("save_view_history");
 	/* Update histories of the views to ensure that their current directories,
 	 * which might have been set using command-line parameters, are stored in the
 	 * history.  This is not done automatically as history manipulation should be
@@ -268,16 +303,20 @@ main(int argc, char *argv[])
 	save_view_history(&lwin, NULL, NULL, -1);
 	save_view_history(&rwin, NULL, NULL, -1);
 
+	prof_phase("DirEnter");
 	/* Trigger auto-commands for initial directories. */
 	vle_aucmd_execute("DirEnter", lwin.curr_dir, &lwin);
 	vle_aucmd_execute("DirEnter", rwin.curr_dir, &rwin);
 
-	exec_startup_commands(&vifm_args);
+	prof_phase("exec_startup_commands");
+	(void)exec_startup_commands(&vifm_args);
 
+	prof_phase("update_screen");
 	update_screen(UT_FULL);
 	modes_update();
 
 	curr_stats.load_stage = 3;
+	finish_startup_profile();
 
 	event_loop(&quit);
 
@@ -332,29 +371,42 @@ undo_perform_func(OPS op, void *data, const char src[], const char dst[])
 	return perform_operation(op, NULL, data, src, dst);
 }
 
-/* Handles arguments received from remote instance. */
-static void
-parse_received_arguments(char *argv[])
+/* Handles arguments received from remote instance.  Messages printed during
+ * processing are returned via *output.  Returns zero on success and non-zero if
+ * any of commands failed. */
+static int
+parse_received_arguments(char *argv[], char **output)
 {
 	int argc = 0;
 	args_t args = {};
+	const int msg_tail = curr_stats.msg_tail;
+	int status;
 
 	while(argv[argc] != NULL)
 	{
 		argc++;
 	}
 
+	/* Commands can refer to files of any view, so load lists that weren't loaded
+	 * yet. */
+	if(ui_views_load_deferred())
+	{
+		modes_redraw();
+	}
+
 	(void)vifm_chdir(argv[0]);
 	opterr = 0;
 	args_parse(&args, argc, argv, argv[0]);
 	args_process(&args, 0);
 
-	exec_startup_commands(&args);
+	status = exec_startup_commands(&args);
 	args_free(&args);
 
+	*output = get_messages_since(msg_tail);
+
 	if(NONE(vle_mode_is, NORMAL_MODE, VIEW_MODE))
 	{
-		return;
+		return status;
 	}
 
 #ifdef _WIN32
@@ -380,6 +432,29 @@ parse_received_arguments(char *argv[])
 
 	clean_status_bar();
 	curr_stats.save_msg = 0;
+	return status;
+}
+
+/* Joins messages added to the list of messages after the specified position
+ * with new lines.  Returns newly allocated string or NULL if there are no
+ * messages. */
+static char *
+get_messages_since(int tail)
+{
+	char *messages = NULL;
+	size_t len = 0U;
+
+	while(tail != curr_stats.msg_tail)
+	{
+		tail = (tail + 1) % ARRAY_LEN(curr_stats.msgs);
+		if(len != 0U)
+		{
+			(void)strappendch(&messages, &len, '\n');
+		}
+		(void)strappend(&messages, &len, curr_stats.msgs[tail]);
+	}
+
+	return messages;
 }
 
 static void
@@ -473,14 +548,14 @@ vifm_restart(void)
 	vle_aucmd_remove(NULL, NULL);
 
 	/* Directory histories. */
-	ui_view_clear_history(&lwin);
-	ui_view_clear_history(&rwin);
+	flist_hist_clear(&lwin);
+	flist_hist_clear(&rwin);
 
 	/* All kinds of history. */
-	(void)hist_reset(&cfg.search_hist, cfg.history_len);
-	(void)hist_reset(&cfg.cmd_hist, cfg.history_len);
-	(void)hist_reset(&cfg.prompt_hist, cfg.history_len);
-	(void)hist_reset(&cfg.filter_hist, cfg.history_len);
+	hist_reset(&cfg.search_hist);
+	hist_reset(&cfg.cmd_hist);
+	hist_reset(&cfg.prompt_hist);
+	hist_reset(&cfg.filter_hist);
 	cfg.history_len = 0;
 
 	/* Session status.  Must be reset _before_ options, because options take some
@@ -539,7 +614,7 @@ vifm_restart(void)
 	load_color_scheme_colors();
 
 	cfg_load();
-	exec_startup_commands(&vifm_args);
+	(void)exec_startup_commands(&vifm_args);
 
 	curr_stats.restart_in_progress = 0;
 
@@ -550,15 +625,18 @@ vifm_restart(void)
 	update_screen(UT_REDRAW);
 }
 
-/* Executes list of startup commands. */
-static void
+/* Executes list of startup commands.  Returns zero on success and non-zero if
+ * any of the commands failed. */
+static int
 exec_startup_commands(const args_t *args)
 {
 	size_t i;
+	int failed = 0;
 	for(i = 0; i < args->ncmds; ++i)
 	{
-		(void)exec_commands(args->cmds[i], curr_view, CIT_COMMAND);
+		failed |= (exec_commands(args->cmds[i], curr_view, CIT_COMMAND) < 0);
 	}
+	return failed;
 }
 
 void
@@ -618,12 +696,59 @@ vifm_choose_files(const FileView *view, int nfiles, char *files[])
 	vifm_leave(exit_code, 0);
 }
 
+/* Stops measuring startup and writes the report unless it should be printed
+ * on exit. */
+static void
+finish_startup_profile(void)
+{
+	prof_finish();
+	if(strcmp(vifm_args.startup_profile, "-") != 0)
+	{
+		write_startup_profile();
+	}
+}
+
+/* Writes report of startup profile if it was requested and not yet written. */
+static void
+write_startup_profile(void)
+{
+	FILE *fp;
+
+	if(vifm_args.startup_profile[0] == '\0')
+	{
+		return;
+	}
+
+	if(strcmp(vifm_args.startup_profile, "-") == 0)
+	{
+		fp = (curr_stats.original_stdout != NULL)
+		   ? curr_stats.original_stdout
+		   : stdout;
+		(void)prof_report(fp);
+		fflush(fp);
+	}
+	else if((fp = os_fopen(vifm_args.startup_profile, "w")) != NULL)
+	{
+		(void)prof_report(fp);
+		fclose(fp);
+	}
+	else
+	{
+		LOG_SERROR_MSG(errno, "Can't write startup profile to %s",
+				vifm_args.startup_profile);
+	}
+
+	prof_stop();
+	vifm_args.startup_profile[0] = '\0';
+}
+
 /* Single exit point for leaving vifm, performs only minimum common
  * deinitialization steps. */
 static void _gnuc_noreturn
 vifm_leave(int exit_code, int cquit)
 {
 	vim_write_dir(cquit ? "" : flist_get_dir(curr_view));
+	write_startup_profile();
 
 	if(cquit && exit_code == EXIT_SUCCESS)
 	{
@@ -1,16 +1,21 @@
 #include <stic.h>
 
 #include <stddef.h> /* NULL */
+#include <string.h> /* strcat() */
 
 #include "../../src/engine/autocmds.h"
 
 static void handler(const char action[], void *arg);
+static void appending_handler(const char action[], void *arg);
+static void registering_handler(const char action[], void *arg);
 
 static const char *action;
+static char actions[64];
 
 TEARDOWN()
 {
 	action = NULL;
+	actions[0] = '\0';
 }
 
 TEST(different_path_does_not_match)
@@ -163,11 +168,91 @@ TEST(sub_tree_star)
 	assert_string_equal("action", action);
 }
 
+TEST(literal_paths_match_ignoring_case)
+{
+	assert_success(vle_aucmd_on_execute("cd", "/Path/To", "action", &handler));
+
+	vle_aucmd_execute("CD", "/path/to", NULL);
+	assert_string_equal("action", action);
+}
+
+TEST(recursive_prefix_matches_only_sub_tree)
+{
+	assert_success(vle_aucmd_on_execute("cd", "/etc/**", "action", &handler));
+
+	vle_aucmd_execute("cd", "/etc", NULL);
+	assert_string_equal(NULL, action);
+	vle_aucmd_execute("cd", "/etcetera/x", NULL);
+	assert_string_equal(NULL, action);
+
+	vle_aucmd_execute("cd", "/etc/X11/conf.d", NULL);
+	assert_string_equal("action", action);
+}
+
+TEST(autocommands_are_executed_in_order_of_registration)
+{
+	assert_success(vle_aucmd_on_execute("cd", "/a/**", "1", &appending_handler));
+	assert_success(vle_aucmd_on_execute("cd", "b", "2", &appending_handler));
+	assert_success(vle_aucmd_on_execute("cd", "!/x", "3", &appending_handler));
+	assert_success(vle_aucmd_on_execute("cd", "/a/b", "4", &appending_handler));
+	assert_success(vle_aucmd_on_execute("cd", "/a/*", "5", &appending_handler));
+	assert_success(vle_aucmd_on_execute("cd", "/a/**", "6", &appending_handler));
+
+	vle_aucmd_execute("cd", "/a/b", NULL);
+	assert_string_equal("123456", actions);
+
+	actions[0] = '\0';
+	vle_aucmd_execute("cd", "/a/b", NULL);
+	assert_string_equal("123456", actions);
+}
+
+TEST(changes_of_autocommands_are_picked_up)
+{
+	vle_aucmd_execute("cd", "/path", NULL);
+	assert_string_equal(NULL, action);
+
+	assert_success(vle_aucmd_on_execute("cd", "/path", "action", &handler));
+	vle_aucmd_execute("cd", "/path", NULL);
+	assert_string_equal("action", action);
+
+	action = NULL;
+	vle_aucmd_remove("cd", "/path");
+	vle_aucmd_execute("cd", "/path", NULL);
+	assert_string_equal(NULL, action);
+}
+
+TEST(autocommands_registered_by_handlers_are_executed)
+{
+	assert_success(vle_aucmd_on_execute("cd", "/path", "1",
+				&registering_handler));
+	assert_success(vle_aucmd_on_execute("cd", "/path", "2",
+				&appending_handler));
+
+	vle_aucmd_execute("cd", "/path", NULL);
+	assert_string_equal("123", actions);
+}
+
 static void
 handler(const char a[], void *arg)
 {
 	action = a;
 }
 
+/* Appends action to the list of actions. */
+static void
+appending_handler(const char a[], void *arg)
+{
+	strcat(actions, a);
+}
+
+/* Appends action to the list of actions and registers new autocommand. */
+static void
+registering_handler(const char a[], void *arg)
+{
+	strcat(actions, a);
+	assert_success(vle_aucmd_on_execute("cd", "/path", "3",
+				&appending_handler));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -60,5 +60,42 @@ TEST(cant_redefine_builtin_with_suffix)
 	assert_failure(execute_cmd("command move? a"));
 }
 
+TEST(abbreviations_follow_changes_of_user_commands)
+{
+	assert_success(execute_cmd("command udfa a"));
+	assert_success(execute_cmd("command udfb b"));
+	assert_success(execute_cmd("udfa"));
+	assert_string_equal("a", user_cmd_info.cmd);
+
+	assert_success(execute_cmd("delcommand udf"));
+	assert_int_equal(CMDS_ERR_UDF_IS_AMBIGUOUS, execute_cmd("udf"));
+	assert_int_equal(CMDS_ERR_UDF_IS_AMBIGUOUS, execute_cmd("ud"));
+
+	assert_success(execute_cmd("delcommand udfa"));
+	assert_success(execute_cmd("ud"));
+	assert_string_equal("b", user_cmd_info.cmd);
+
+	assert_success(execute_cmd("command! udfb c"));
+	assert_success(execute_cmd("u"));
+	assert_string_equal("c", user_cmd_info.cmd);
+}
+
+TEST(builtins_are_found_after_removing_user_commands)
+{
+	assert_success(execute_cmd("command! mo a"));
+	assert_success(execute_cmd("command mka a"));
+
+	move_cmd_called = 0;
+	assert_success(execute_cmd("mo"));
+	assert_false(move_cmd_called);
+
+	assert_success(execute_cmd("comclear"));
+	assert_int_equal(CMDS_ERR_INVALID_CMD, execute_cmd("mk"));
+
+	move_cmd_called = 0;
+	assert_success(execute_cmd("mo"));
+	assert_true(move_cmd_called);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
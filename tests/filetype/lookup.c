@@ -0,0 +1,75 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strcmp() */
+
+#include "../../src/filetype.h"
+#include "test.h"
+
+static int counting_exists(const char name[]);
+
+static int nchecks;
+
+SETUP()
+{
+	nchecks = 0;
+	ft_init(&counting_exists);
+}
+
+TEST(first_matching_rule_wins_among_many)
+{
+	int i;
+
+	for(i = 0; i < 500; ++i)
+	{
+		char pattern[32];
+		char prog[32];
+		snprintf(pattern, sizeof(pattern), "*.ext%d", i);
+		snprintf(prog, sizeof(prog), "prog%d", i);
+		set_programs(pattern, prog, 0, 0);
+	}
+	set_programs("/^special/", "special", 0, 0);
+	set_programs("*.EXT7", "late", 0, 0);
+
+	assert_string_equal("prog7", ft_get_program("file.ext7"));
+	assert_string_equal("prog499", ft_get_program("SPECIAL.EXT499"));
+	assert_string_equal("special", ft_get_program("special.ext500"));
+	assert_null(ft_get_program("file.ext500"));
+}
+
+TEST(all_matching_records_are_listed_in_order)
+{
+	assoc_records_t records;
+
+	set_programs("*.gz", "gz", 0, 0);
+	set_programs("/\\.tar/", "tar", 0, 0);
+	set_programs("*.tar.gz", "tgz", 0, 0);
+
+	records = ft_get_all_programs("a.tar.gz");
+	assert_int_equal(3, records.count);
+	assert_string_equal("gz", records.list[0].command);
+	assert_string_equal("tar", records.list[1].command);
+	assert_string_equal("tgz", records.list[2].command);
+	ft_assoc_records_free(&records);
+}
+
+TEST(existence_of_commands_is_not_remembered)
+{
+	set_viewers("*.c", "missing,viewer");
+
+	assert_string_equal("viewer", ft_get_viewer("a.c"));
+	assert_int_equal(2, nchecks);
+
+	assert_string_equal("viewer", ft_get_viewer("b.c"));
+	assert_int_equal(4, nchecks);
+}
+
+static int
+counting_exists(const char name[])
+{
+	++nchecks;
+	return strcmp(name, "missing") != 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
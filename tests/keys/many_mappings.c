@@ -0,0 +1,66 @@
+#include <stic.h>
+
+#include <stddef.h> /* wchar_t */
+
+#include "../../src/engine/keys.h"
+#include "../../src/modes/modes.h"
+
+TEST(all_of_many_sibling_mappings_are_found)
+{
+	wchar_t lhs[] = L",?";
+	int i;
+
+	for(i = 0; i < 500; ++i)
+	{
+		lhs[1] = L'a' + i;
+		assert_success(add_user_keys(lhs, L"j", NORMAL_MODE, 0));
+	}
+
+	for(i = 0; i < 500; ++i)
+	{
+		lhs[1] = L'a' + i;
+		assert_success(execute_keys(lhs));
+	}
+
+	lhs[1] = L'a' + 500;
+	assert_int_equal(KEYS_UNKNOWN, execute_keys(lhs));
+}
+
+TEST(lookup_is_updated_after_changes)
+{
+	assert_success(add_user_keys(L",b", L"j", NORMAL_MODE, 0));
+	assert_success(execute_keys(L",b"));
+	assert_int_equal(KEYS_UNKNOWN, execute_keys(L",a"));
+
+	assert_success(add_user_keys(L",a", L"j", NORMAL_MODE, 0));
+	assert_success(add_user_keys(L",c", L"j", NORMAL_MODE, 0));
+	assert_success(execute_keys(L",a"));
+	assert_success(execute_keys(L",c"));
+
+	assert_success(remove_user_keys(L",b", NORMAL_MODE));
+	assert_int_equal(KEYS_UNKNOWN, execute_keys(L",b"));
+	assert_success(execute_keys(L",a"));
+	assert_success(execute_keys(L",c"));
+
+	clear_user_keys();
+	assert_int_equal(KEYS_UNKNOWN, execute_keys(L",a"));
+}
+
+TEST(long_sequence_of_mappings_is_executed)
+{
+	wchar_t keys[2*2000 + 1];
+	int i;
+
+	for(i = 0; i < 2000; ++i)
+	{
+		keys[i*2] = L',';
+		keys[i*2 + 1] = L'a' + i;
+		keys[i*2 + 2] = L'\0';
+		assert_success(add_user_keys(&keys[i*2], L"j", NORMAL_MODE, 0));
+	}
+
+	assert_success(execute_keys(keys));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0: */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -7,6 +7,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/strbuf.h"
 #include "../../src/macros.h"
 
 #ifdef _WIN32
@@ -88,54 +89,50 @@ TEARDOWN()
 
 TEST(f)
 {
-	char *expanded;
+	strbuf_t expanded = STRBUF_INITIALIZER;
 
-	expanded = strdup("");
-	expanded = append_selected_files(&lwin, expanded, 0, 0, "", 1);
-	assert_string_equal("lfile0 lfile2", expanded);
-	free(expanded);
+	append_selected_files(&lwin, &expanded, 0, 0, "", 1);
+	assert_string_equal("lfile0 lfile2", expanded.data);
+	strbuf_free(&expanded);
 
-	expanded = strdup("/");
-	expanded = append_selected_files(&lwin, expanded, 0, 0, "", 1);
-	assert_string_equal("/lfile0 lfile2", expanded);
-	free(expanded);
+	(void)strbuf_append(&expanded, "/");
+	append_selected_files(&lwin, &expanded, 0, 0, "", 1);
+	assert_string_equal("/lfile0 lfile2", expanded.data);
+	strbuf_free(&expanded);
 
-	expanded = strdup("");
-	expanded = append_selected_files(&rwin, expanded, 0, 0, "", 1);
+	append_selected_files(&rwin, &expanded, 0, 0, "", 1);
 	assert_string_equal(SL "rwin" SL "rfile1 " SL "rwin" SL "rfile3 " SL "rwin" SL "rfile5 " SL "rwin" SL "rdir6",
-			expanded);
-	free(expanded);
+			expanded.data);
+	strbuf_free(&expanded);
 
-	expanded = strdup("/");
-	expanded = append_selected_files(&rwin, expanded, 0, 0, "", 1);
+	(void)strbuf_append(&expanded, "/");
+	append_selected_files(&rwin, &expanded, 0, 0, "", 1);
 	assert_string_equal("/" SL "rwin" SL "rfile1 " SL "rwin" SL "rfile3 " SL "rwin" SL "rfile5 " SL "rwin" SL "rdir6",
-			expanded);
-	free(expanded);
+			expanded.data);
+	strbuf_free(&expanded);
 }
 
 TEST(c)
 {
-	char *expanded;
-
-	expanded = strdup("");
-	expanded = append_selected_files(&lwin, expanded, 1, 0, "", 1);
-	assert_string_equal("lfile2", expanded);
-	free(expanded);
-
-	expanded = strdup("/");
-	expanded = append_selected_files(&lwin, expanded, 1, 0, "", 1);
-	assert_string_equal("/lfile2", expanded);
-	free(expanded);
-
-	expanded = strdup("");
-	expanded = append_selected_files(&rwin, expanded, 1, 0, "", 1);
-	assert_string_equal("" SL "rwin" SL "rfile5", expanded);
-	free(expanded);
-
-	expanded = strdup("/");
-	expanded = append_selected_files(&rwin, expanded, 1, 0, "", 1);
-	assert_string_equal("/" SL "rwin" SL "rfile5", expanded);
-	free(expanded);
+	strbuf_t expanded = STRBUF_INITIALIZER;
+
+	append_selected_files(&lwin, &expanded, 1, 0, "", 1);
+	assert_string_equal("lfile2", expanded.data);
+	strbuf_free(&expanded);
+
+	(void)strbuf_append(&expanded, "/");
+	append_selected_files(&lwin, &expanded, 1, 0, "", 1);
+	assert_string_equal("/lfile2", expanded.data);
+	strbuf_free(&expanded);
+
+	append_selected_files(&rwin, &expanded, 1, 0, "", 1);
+	assert_string_equal("" SL "rwin" SL "rfile5", expanded.data);
+	strbuf_free(&expanded);
+
+	(void)strbuf_append(&expanded, "/");
+	append_selected_files(&rwin, &expanded, 1, 0, "", 1);
+	assert_string_equal("/" SL "rwin" SL "rfile5", expanded.data);
+	strbuf_free(&expanded);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
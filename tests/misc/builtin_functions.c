@@ -1,13 +1,17 @@
 #include <stic.h>
 
+#include <unistd.h> /* chdir() unlink() usleep() */
+
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <string.h> /* strcmp() strdup() */
 
 #include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/engine/functions.h"
 #include "../../src/engine/parsing.h"
 #include "../../src/utils/env.h"
+#include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
 #include "../../src/builtin_functions.h"
 #include "../../src/filelist.h"
@@ -16,6 +20,13 @@
 
 #include "utils.h"
 
+#define LOCAL_COUNTER_CMD "echo a >> counter; cat counter"
+
+#define COUNTER_CMD "echo a >> " SANDBOX_PATH "/counter; cat " SANDBOX_PATH \
+                    "/counter"
+
+static int not_windows(void);
+
 SETUP()
 {
 	update_string(&cfg.shell, "sh");
@@ -82,6 +93,95 @@ TEST(system_catches_stdout_and_err)
 #endif
 }
 
+TEST(system_output_is_reused_within_ttl, IF(not_windows))
+{
+	ASSERT_OK("system('" COUNTER_CMD "', 100)", "a");
+	ASSERT_OK("system('" COUNTER_CMD "', 100)", "a");
+	ASSERT_OK("system('" COUNTER_CMD "')", "a\na");
+
+	assert_success(unlink(SANDBOX_PATH "/counter"));
+}
+
+TEST(expired_system_output_is_not_reused, IF(not_windows))
+{
+	ASSERT_OK("system('" COUNTER_CMD "', 0)", "a");
+	ASSERT_OK("system('" COUNTER_CMD "', 0)", "a\na");
+
+	assert_success(unlink(SANDBOX_PATH "/counter"));
+}
+
+TEST(expired_system_output_is_updated_in_background, IF(not_windows))
+{
+	int i;
+	char *output = NULL;
+
+	ASSERT_OK("system('" COUNTER_CMD "', 0, 1)", "a");
+	ASSERT_OK("system('" COUNTER_CMD "', 0, 1)", "a");
+
+	/* Large TTL doesn't start another update. */
+	for(i = 0; i < 500; ++i)
+	{
+		var_t res = var_false();
+		assert_int_equal(PE_NO_ERROR,
+				parse("system('" COUNTER_CMD "', 1000, 1)", &res));
+		free(output);
+		output = var_to_string(res);
+		var_free(res);
+
+		if(strcmp(output, "a") != 0)
+		{
+			break;
+		}
+		usleep(10000);
+	}
+	assert_string_equal("a\na", output);
+	free(output);
+
+	assert_success(unlink(SANDBOX_PATH "/counter"));
+}
+
+TEST(background_update_runs_where_it_was_requested, IF(not_windows))
+{
+	int i;
+	char cwd[PATH_MAX];
+	char *output = NULL;
+
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	assert_success(chdir(SANDBOX_PATH));
+
+	ASSERT_OK("system('" LOCAL_COUNTER_CMD "', 0, 1)", "a");
+	ASSERT_OK("system('" LOCAL_COUNTER_CMD "', 0, 1)", "a");
+
+	/* Update must still happen in the sandbox after leaving it. */
+	assert_success(chdir(cwd));
+	for(i = 0; i < 500 && get_file_size(SANDBOX_PATH "/counter") < 4U; ++i)
+	{
+		usleep(10000);
+	}
+
+	assert_success(chdir(SANDBOX_PATH));
+	for(i = 0; i < 500; ++i)
+	{
+		var_t res = var_false();
+		assert_int_equal(PE_NO_ERROR,
+				parse("system('" LOCAL_COUNTER_CMD "', 1000, 1)", &res));
+		free(output);
+		output = var_to_string(res);
+		var_free(res);
+
+		if(strcmp(output, "a") != 0)
+		{
+			break;
+		}
+		usleep(10000);
+	}
+	assert_string_equal("a\na", output);
+	free(output);
+
+	assert_success(unlink("counter"));
+	assert_success(chdir(cwd));
+}
+
 TEST(layoutis_is_correct_for_single_pane)
 {
 	curr_stats.number_of_windows = 1;
@@ -190,5 +290,15 @@ TEST(getpanetype_for_very_custom_view)
 	opt_handlers_teardown();
 }
 
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
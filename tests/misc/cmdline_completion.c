@@ -20,6 +20,7 @@
 #include "../../src/utils/str.h"
 #include "../../src/bmarks.h"
 #include "../../src/builtin_functions.h"
+#include "../../src/cmd_completion.h"
 #include "../../src/cmd_core.h"
 
 #if defined(__CYGWIN__) || defined(_WIN32)
@@ -32,6 +33,8 @@
 
 static void dummy_handler(OPT_OP op, optval_t val);
 static void create_executable(const char file[]);
+static void create_file(const char file[]);
+static int not_windows(void);
 static int dquotes_allowed_in_paths(void);
 
 static line_stats_t stats;
@@ -559,6 +562,86 @@ TEST(autocmd_name_completion_is_case_insensitive)
 	assert_wstring_equal(L"autocmd DirEnter", stats.line);
 }
 
+TEST(completion_notices_new_files)
+{
+	restore_cwd(saved_cwd);
+	saved_cwd = save_cwd();
+	assert_success(chdir(SANDBOX_PATH));
+
+	create_file("abc");
+
+	vle_compl_reset();
+	filename_completion("a", CT_ALL);
+	assert_int_equal(2, vle_compl_get_count());
+
+	create_file("abd");
+
+	vle_compl_reset();
+	filename_completion("a", CT_ALL);
+	assert_int_equal(3, vle_compl_get_count());
+
+	vle_compl_reset();
+	filename_completion("abd", CT_ALL);
+	assert_int_equal(2, vle_compl_get_count());
+	assert_string_equal("abd", vle_compl_get_list()[0]);
+
+	assert_success(unlink("abc"));
+	assert_success(unlink("abd"));
+}
+
+TEST(completion_notices_permission_changes, IF(not_windows))
+{
+	restore_cwd(saved_cwd);
+	saved_cwd = save_cwd();
+	assert_success(chdir(SANDBOX_PATH));
+
+	create_file("abc");
+
+	vle_compl_reset();
+	filename_completion("a", CT_EXECONLY);
+	assert_int_equal(0, vle_compl_get_count());
+
+	assert_success(chmod("abc", 0755));
+
+	vle_compl_reset();
+	filename_completion("a", CT_EXECONLY);
+	assert_int_equal(1, vle_compl_get_count());
+	assert_string_equal("abc", vle_compl_get_list()[0]);
+
+	assert_success(unlink("abc"));
+}
+
+TEST(dot_files_are_completed_after_empty_prefix)
+{
+	restore_cwd(saved_cwd);
+	saved_cwd = save_cwd();
+	assert_success(chdir(SANDBOX_PATH));
+
+	create_file(".hidden");
+
+	vle_compl_reset();
+	filename_completion("", CT_ALL);
+	assert_int_equal(1, vle_compl_get_count());
+
+	vle_compl_reset();
+	filename_completion(".h", CT_ALL);
+	assert_int_equal(2, vle_compl_get_count());
+	assert_string_equal(".hidden", vle_compl_get_list()[0]);
+
+	assert_success(unlink(".hidden"));
+}
+
+static void
+create_file(const char file[])
+{
+	FILE *const f = fopen(file, "w");
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+	assert_success(access(file, F_OK));
+}
+
 static void
 create_executable(const char file[])
 {
@@ -572,6 +655,16 @@ create_executable(const char file[])
 	assert_success(access(file, X_OK));
 }
 
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 static int
 dquotes_allowed_in_paths(void)
 {
@@ -30,15 +30,15 @@ TEST(yank_works_with_ranges)
 	hist_t hist;
 	assert_success(hist_init(&hist, 10U));
 
-	assert_success(hist_add(&hist, "older", 10U));
-	assert_success(hist_add(&hist, "newer", 10U));
+	assert_success(hist_add(&hist, "older"));
+	assert_success(hist_add(&hist, "newer"));
 
 	stats.line = wcsdup(L"newer");
 	stats.history_search = HIST_GO;
 	hist_prev(&stats, &hist, 10U);
 	assert_wstring_equal(L"older", stats.line);
 
-	hist_reset(&hist, 10U);
+	hist_reset(&hist);
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -9,6 +9,7 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
 #include "../../src/filelist.h"
 #include "../../src/macros.h"
 #include "../../src/registers.h"
@@ -451,5 +452,87 @@ TEST(singly_not_expanded_multiple_files_register)
 	regs_reset();
 }
 
+TEST(x_splits_selection_into_batches)
+{
+	MacroFlags flags;
+	int count;
+	char **cmds;
+
+	curr_view = &rwin;
+	other_view = &lwin;
+
+	cmds = ma_expand_batched("cmd %f%x", NULL, &flags, 17U, 1, &count);
+	assert_int_equal(MF_NONE, flags);
+	assert_int_equal(2, count);
+	if(count == 2)
+	{
+		assert_string_equal("cmd rfile1 rfile3", cmds[0]);
+		assert_string_equal("cmd rfile5", cmds[1]);
+	}
+	free_string_array(cmds, count);
+
+	cmds = ma_expand_batched("cmd %f%x", NULL, &flags, 1U, 1, &count);
+	assert_int_equal(3, count);
+	if(count == 3)
+	{
+		assert_string_equal("cmd rfile1", cmds[0]);
+		assert_string_equal("cmd rfile3", cmds[1]);
+		assert_string_equal("cmd rfile5", cmds[2]);
+	}
+	free_string_array(cmds, count);
+
+	cmds = ma_expand_batched("cmd %f%x", NULL, &flags, 1000U, 1, &count);
+	assert_int_equal(1, count);
+	if(count == 1)
+	{
+		assert_string_equal("cmd rfile1 rfile3 rfile5", cmds[0]);
+	}
+	free_string_array(cmds, count);
+
+	curr_view = &lwin;
+	other_view = &rwin;
+}
+
+TEST(x_keeps_other_flags_in_batches)
+{
+	MacroFlags flags;
+	int count;
+	char **cmds;
+	char *cmd;
+
+	curr_view = &rwin;
+	other_view = &lwin;
+
+	cmds = ma_expand_batched("cmd %n%f%x", NULL, &flags, 1U, 1, &count);
+	assert_int_equal(MF_NO_TERM_MUX, flags);
+	assert_int_equal(3, count);
+	free_string_array(cmds, count);
+
+	cmd = expand_macros("cmd %n%f%x", NULL, &flags, 1);
+	assert_int_equal(MF_BATCHED, flags);
+	free(cmd);
+
+	curr_view = &lwin;
+	other_view = &rwin;
+}
+
+TEST(x_without_selection_produces_single_command)
+{
+	int count;
+	char **cmds;
+
+	lwin.dir_entry[0].selected = 0;
+	lwin.dir_entry[2].selected = 0;
+	lwin.selected_files = 0;
+
+	cmds = ma_expand_batched("cmd %f%x", NULL, NULL, 1U, 1, &count);
+	assert_int_equal(1, count);
+	if(count == 1)
+	{
+		assert_string_equal("cmd lfile\\\"2", cmds[0]);
+	}
+	free_string_array(cmds, count);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
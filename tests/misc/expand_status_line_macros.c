@@ -4,9 +4,12 @@
 #include <string.h> /* strchr() strcmp() */
 
 #include "../../src/cfg/config.h"
+#include "../../src/ui/fileview.h"
 #include "../../src/ui/statusline.h"
 #include "../../src/utils/dynarray.h"
 #include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
+#include "../../src/filelist.h"
 
 /* Checks that expanded string isn't equal to format string. */
 #define ASSERT_EXPANDED(format) \
@@ -206,5 +209,61 @@ TEST(ignore_mismatched_closing_bracket)
 	ASSERT_EXPANDED_TO("%]", "%]");
 }
 
+TEST(format_is_reexpanded_with_new_values)
+{
+	lwin.filtered = 0;
+	ASSERT_EXPANDED_TO("%[%0-%]-%0S", "-1");
+	lwin.filtered = 2;
+	ASSERT_EXPANDED_TO("%[%0-%]-%0S", "2-1");
+}
+
+TEST(E_macro_follows_changes_of_selection_and_list)
+{
+	char expected[64];
+	int i;
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		free(lwin.dir_entry[i].name);
+	}
+	dynarray_free(lwin.dir_entry);
+
+	lwin.list_rows = 3;
+	lwin.dir_entry = dynarray_cextend(NULL,
+			lwin.list_rows*sizeof(*lwin.dir_entry));
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		lwin.dir_entry[i].name = format_str("file%d", i);
+		lwin.dir_entry[i].origin = &lwin.curr_dir[0];
+		lwin.dir_entry[i].type = FT_REG;
+		lwin.dir_entry[i].size = 1000U*(i + 1);
+	}
+	fview_list_updated(&lwin);
+
+	flist_sel_entry(&lwin, 0, 1);
+	flist_sel_entry(&lwin, 2, 1);
+	assert_int_equal(2, lwin.selected_files);
+	friendly_size_notation(4000U, sizeof(expected), expected);
+	ASSERT_EXPANDED_TO("%E", expected);
+
+	flist_sel_entry(&lwin, 1, 1);
+	assert_int_equal(3, lwin.selected_files);
+	friendly_size_notation(6000U, sizeof(expected), expected);
+	ASSERT_EXPANDED_TO("%E", expected);
+
+	lwin.dir_entry[1].size = 5000U;
+	fview_list_updated(&lwin);
+	friendly_size_notation(9000U, sizeof(expected), expected);
+	ASSERT_EXPANDED_TO("%E", expected);
+
+	flist_sel_entry(&lwin, 0, 0);
+	flist_sel_entry(&lwin, 0, 0);
+	assert_int_equal(2, lwin.selected_files);
+	friendly_size_notation(8000U, sizeof(expected), expected);
+	ASSERT_EXPANDED_TO("%E", expected);
+
+	erase_selection(&lwin);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -1,7 +1,59 @@
 #include <stic.h>
 
+#include <sys/stat.h> /* chmod() */
+#include <unistd.h> /* rmdir() unlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcat() strdup() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/int/path_env.h"
+#include "../../src/utils/env.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
 #include "../../src/cmd_completion.h"
 
+static void create_file(const char file[]);
+static int not_windows(void);
+
+static char bin_dir[PATH_MAX];
+static char prog[PATH_MAX];
+static char *saved_path;
+
+SETUP()
+{
+	char cwd[PATH_MAX];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+
+	if(is_path_absolute(SANDBOX_PATH))
+	{
+		snprintf(bin_dir, sizeof(bin_dir), "%s/bin", SANDBOX_PATH);
+	}
+	else
+	{
+		snprintf(bin_dir, sizeof(bin_dir), "%s/%s/bin", cwd, SANDBOX_PATH);
+	}
+	snprintf(prog, sizeof(prog), "%s/prog", bin_dir);
+
+	assert_success(os_mkdir(bin_dir, 0700));
+
+	saved_path = strdup(env_get("PATH"));
+	env_set("PATH", bin_dir);
+	update_path_env(1);
+}
+
+TEARDOWN()
+{
+	env_set("PATH", saved_path);
+	update_path_env(1);
+	free(saved_path);
+
+	(void)unlink(prog);
+	assert_success(rmdir(bin_dir));
+}
+
 TEST(system_shell_exists)
 {
 #ifdef _WIN32
@@ -9,9 +61,104 @@ TEST(system_shell_exists)
 #else
 	const char *const shell = "sh";
 #endif
-	const int exists = external_command_exists(shell);
+	int exists;
+
+	env_set("PATH", saved_path);
+	update_path_env(1);
+
+	exists = external_command_exists(shell);
 	assert_true(exists);
 }
 
+TEST(new_commands_are_found, IF(not_windows))
+{
+	assert_false(external_command_exists("prog"));
+
+	create_file(prog);
+	assert_false(external_command_exists("prog"));
+
+	assert_success(chmod(prog, 0755));
+	assert_true(external_command_exists("prog"));
+	assert_true(external_command_exists("!!prog"));
+}
+
+TEST(removed_commands_are_not_found, IF(not_windows))
+{
+	create_file(prog);
+	assert_success(chmod(prog, 0755));
+	assert_true(external_command_exists("prog"));
+
+	assert_success(unlink(prog));
+	assert_false(external_command_exists("prog"));
+}
+
+TEST(commands_are_looked_up_by_path, IF(not_windows))
+{
+	create_file(prog);
+	assert_success(chmod(prog, 0755));
+
+	assert_true(external_command_exists(prog));
+	assert_false(external_command_exists("bin/prog"));
+	assert_false(external_command_exists("bin"));
+}
+
+TEST(commands_in_directories_that_are_not_indexed_are_found, IF(not_windows))
+{
+	enum { NDIRS = 20 };
+
+	char path_env[NDIRS*PATH_MAX];
+	char dir[PATH_MAX];
+	int i;
+
+	path_env[0] = '\0';
+	for(i = 0; i < NDIRS; ++i)
+	{
+		snprintf(dir, sizeof(dir), "%s/dir%d", bin_dir, i);
+		assert_success(os_mkdir(dir, 0700));
+		strcat(path_env, dir);
+		strcat(path_env, ":");
+	}
+	strcat(path_env, bin_dir);
+
+	env_set("PATH", path_env);
+	update_path_env(1);
+
+	assert_false(external_command_exists("prog"));
+
+	create_file(prog);
+	assert_success(chmod(prog, 0755));
+	assert_true(external_command_exists("prog"));
+
+	assert_success(unlink(prog));
+	assert_false(external_command_exists("prog"));
+
+	for(i = 0; i < NDIRS; ++i)
+	{
+		snprintf(dir, sizeof(dir), "%s/dir%d", bin_dir, i);
+		assert_success(rmdir(dir));
+	}
+}
+
+static void
+create_file(const char file[])
+{
+	FILE *const f = fopen(file, "w");
+	if(f != NULL)
+	{
+		fclose(f);
+	}
+	assert_success(access(file, F_OK));
+}
+
+static int
+not_windows(void)
+{
+#ifdef _WIN32
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
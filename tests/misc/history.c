@@ -1,5 +1,6 @@
 #include <stic.h>
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -12,15 +13,15 @@
 
 /* This should be a macro to see what test have failed. */
 #define VALIDATE_HISTORY(i, str) \
-	assert_string_equal(str, cfg.cmd_hist.items[i]); \
-	assert_string_equal(str, cfg.search_hist.items[i]); \
-	assert_string_equal(str, cfg.prompt_hist.items[i]); \
+	assert_string_equal(str, hist_get(&cfg.cmd_hist, i)); \
+	assert_string_equal(str, hist_get(&cfg.search_hist, i)); \
+	assert_string_equal(str, hist_get(&cfg.prompt_hist, i)); \
 	\
-	assert_string_equal(str, lwin.history[(i) + 1].dir); \
-	assert_string_equal((str) + 1, lwin.history[(i) + 1].file); \
+	assert_string_equal(str, flist_hist_get(&lwin, (i) + 1)->dir); \
+	assert_string_equal((str) + 1, flist_hist_get(&lwin, (i) + 1)->file); \
 	\
-	assert_string_equal(str, rwin.history[(i) + 1].dir); \
-	assert_string_equal((str) + 1, rwin.history[(i) + 1].file);
+	assert_string_equal(str, flist_hist_get(&rwin, (i) + 1)->dir); \
+	assert_string_equal((str) + 1, flist_hist_get(&rwin, (i) + 1)->file);
 
 SETUP()
 {
@@ -75,11 +76,11 @@ save_to_history(const char str[])
 
 TEST(view_history_after_reset_contains_valid_data)
 {
-	assert_string_equal("/lwin", lwin.history[0].dir);
-	assert_string_equal("lfile0", lwin.history[0].file);
+	assert_string_equal("/lwin", flist_hist_get(&lwin, 0)->dir);
+	assert_string_equal("lfile0", flist_hist_get(&lwin, 0)->file);
 
-	assert_string_equal("/rwin", rwin.history[0].dir);
-	assert_string_equal("rfile0", rwin.history[0].file);
+	assert_string_equal("/rwin", flist_hist_get(&rwin, 0)->dir);
+	assert_string_equal("rfile0", flist_hist_get(&rwin, 0)->file);
 }
 
 TEST(view_history_avoids_duplicates)
@@ -137,5 +138,141 @@ TEST(add_after_increasing_ok)
 	}
 }
 
+TEST(view_history_drops_oldest_items_on_overflow)
+{
+	char dir[16];
+	int i;
+
+	for(i = 0; i < INITIAL_SIZE*2 + 3; ++i)
+	{
+		snprintf(dir, sizeof(dir), "/%d", i);
+		save_view_history(&lwin, dir, "file", 0);
+	}
+
+	assert_int_equal(INITIAL_SIZE, lwin.history_num);
+	assert_int_equal(INITIAL_SIZE - 1, lwin.history_pos);
+	assert_string_equal("/13", flist_hist_get(&lwin, 0)->dir);
+	assert_string_equal("/22", flist_hist_get(&lwin, INITIAL_SIZE - 1)->dir);
+
+	assert_true(is_in_view_history(&lwin, "/13"));
+	assert_true(is_in_view_history(&lwin, "/22"));
+	assert_false(is_in_view_history(&lwin, "/12"));
+	assert_false(is_in_view_history(&lwin, "/lwin"));
+}
+
+TEST(view_history_lookup_ignores_items_after_current_one)
+{
+	save_view_history(&lwin, "/a", "file", 0);
+	save_view_history(&lwin, "/b", "file", 0);
+	save_view_history(&lwin, "/a", "file", 0);
+	save_view_history(&lwin, "/c", "file", 0);
+
+	lwin.history_pos = 1;
+	assert_true(is_in_view_history(&lwin, "/a"));
+	assert_false(is_in_view_history(&lwin, "/b"));
+	assert_false(is_in_view_history(&lwin, "/c"));
+
+	save_view_history(&lwin, "/d", "file", 0);
+	assert_int_equal(3, lwin.history_num);
+	assert_true(is_in_view_history(&lwin, "/a"));
+	assert_false(is_in_view_history(&lwin, "/b"));
+	assert_true(is_in_view_history(&lwin, "/d"));
+}
+
+TEST(view_history_shrinking_keeps_current_item)
+{
+	char dir[16];
+	int i;
+
+	for(i = 0; i < INITIAL_SIZE + 3; ++i)
+	{
+		snprintf(dir, sizeof(dir), "/%d", i);
+		save_view_history(&lwin, dir, "file", 0);
+	}
+	lwin.history_pos = 1;
+
+	cfg_resize_histories(INITIAL_SIZE/2);
+
+	assert_int_equal(INITIAL_SIZE/2, lwin.history_num);
+	assert_int_equal(0, lwin.history_pos);
+	assert_string_equal("/4", flist_hist_get(&lwin, 0)->dir);
+	assert_string_equal("/8", flist_hist_get(&lwin, INITIAL_SIZE/2 - 1)->dir);
+	assert_true(is_in_view_history(&lwin, "/4"));
+	assert_false(is_in_view_history(&lwin, "/3"));
+	assert_false(is_in_view_history(&lwin, "/5"));
+}
+
+TEST(duplicates_are_moved_to_front)
+{
+	hist_t hist;
+	assert_success(hist_init(&hist, INITIAL_SIZE));
+
+	assert_success(hist_add(&hist, "a"));
+	assert_success(hist_add(&hist, "b"));
+	assert_success(hist_add(&hist, "c"));
+	assert_success(hist_add(&hist, "b"));
+
+	assert_int_equal(2, hist.pos);
+	assert_string_equal("b", hist_get(&hist, 0));
+	assert_string_equal("c", hist_get(&hist, 1));
+	assert_string_equal("a", hist_get(&hist, 2));
+
+	hist_reset(&hist);
+}
+
+TEST(oldest_items_are_dropped_on_overflow)
+{
+	char item[16];
+	int i;
+	hist_t hist;
+	assert_success(hist_init(&hist, INITIAL_SIZE));
+
+	for(i = 0; i < INITIAL_SIZE*3; ++i)
+	{
+		snprintf(item, sizeof(item), "%d", i);
+		assert_success(hist_add(&hist, item));
+	}
+
+	assert_int_equal(INITIAL_SIZE - 1, hist.pos);
+	assert_string_equal("29", hist_get(&hist, 0));
+	assert_string_equal("20", hist_get(&hist, INITIAL_SIZE - 1));
+	assert_true(hist_contains(&hist, "20"));
+	assert_false(hist_contains(&hist, "19"));
+	assert_false(hist_contains(&hist, "0"));
+
+	assert_success(hist_add(&hist, "25"));
+	assert_string_equal("25", hist_get(&hist, 0));
+	assert_string_equal("29", hist_get(&hist, 1));
+	assert_string_equal("20", hist_get(&hist, INITIAL_SIZE - 1));
+
+	hist_reset(&hist);
+}
+
+TEST(shrinking_keeps_most_recent_items)
+{
+	char item[16];
+	int i;
+	hist_t hist;
+	assert_success(hist_init(&hist, INITIAL_SIZE));
+
+	for(i = 0; i < INITIAL_SIZE + 3; ++i)
+	{
+		snprintf(item, sizeof(item), "%d", i);
+		assert_success(hist_add(&hist, item));
+	}
+
+	assert_success(hist_resize(&hist, INITIAL_SIZE/2));
+	assert_int_equal(INITIAL_SIZE/2 - 1, hist.pos);
+	assert_string_equal("12", hist_get(&hist, 0));
+	assert_string_equal("8", hist_get(&hist, INITIAL_SIZE/2 - 1));
+	assert_false(hist_contains(&hist, "7"));
+
+	assert_success(hist_add(&hist, "7"));
+	assert_string_equal("7", hist_get(&hist, 0));
+	assert_false(hist_contains(&hist, "8"));
+
+	hist_reset(&hist);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
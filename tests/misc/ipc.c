@@ -0,0 +1,419 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <sys/socket.h> /* AF_UNIX SOCK_STREAM connect() socket() */
+#include <sys/stat.h> /* stat stat() */
+#include <sys/un.h> /* sockaddr_un */
+#include <poll.h> /* poll() */
+#include <pthread.h> /* pthread_create() pthread_join() */
+#include <unistd.h> /* close() getpid() read() write() */
+
+#include <limits.h> /* PATH_MAX */
+#include <stdint.h> /* int32_t uint32_t */
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* memcpy() memset() strcat() strcmp() strdup()
+                      strlen() */
+
+#include "../../src/utils/path.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/ipc.h"
+
+/* Number of messages sent by stress test. */
+#define NMESSAGES 20000
+
+/* Number of clients for tests of concurrent clients. */
+#define NCLIENTS 16
+
+static int echo_callback(char *args[], char **output);
+static void * send_one(void *arg);
+static void * send_pipelined(void *arg);
+static void * write_requests(void *arg);
+static void * send_many(void *arg);
+static void serve_until_done(void);
+static int connect_to_server(void);
+static void send_request(int fd, const char cmd[]);
+static int receive_reply(int fd, char buf[], size_t len);
+static int read_exactly(int fd, void *buf, size_t len);
+
+static char name[64];
+static volatile int done;
+static int nrequests;
+
+SETUP_ONCE()
+{
+	snprintf(name, sizeof(name), "test-%d", (int)getpid());
+	ipc_init(name, &echo_callback);
+}
+
+SETUP()
+{
+	done = 0;
+	nrequests = 0;
+}
+
+TEST(server_does_not_list_itself)
+{
+	int len;
+	char **list = ipc_list(&len);
+	assert_false(is_in_string_array(list, len, name));
+	free_string_array(list, len);
+}
+
+TEST(socket_is_accessible_only_by_owner)
+{
+	char path[PATH_MAX];
+	struct stat st;
+
+	snprintf(path, sizeof(path), "%s/vifm-ipc-%s", get_tmpdir(), name);
+	assert_success(stat(path, &st));
+	assert_int_equal(0, st.st_mode & 077);
+}
+
+TEST(reply_has_status_and_output)
+{
+	char *data[] = { "a", "b", "fail", NULL };
+	int status = -1;
+	char *output = NULL;
+	void *result;
+	pthread_t thread;
+
+	struct { char **data; int *status; char **output; } args = {
+		data, &status, &output
+	};
+
+	assert_int_equal(0, pthread_create(&thread, NULL, &send_one, &args));
+	serve_until_done();
+	assert_int_equal(0, pthread_join(thread, &result));
+
+	assert_null(result);
+	assert_int_equal(3, status);
+	assert_string_equal("a b fail", output);
+	free(output);
+}
+
+TEST(sending_without_waiting_does_not_need_server_to_respond)
+{
+	int i;
+	char *data[] = { "nowait", NULL };
+
+	/* Server isn't checked until request is sent. */
+	assert_success(ipc_send(name, data, NULL, NULL));
+
+	for(i = 0; i < 100 && nrequests < 1; ++i)
+	{
+		ipc_check();
+	}
+	assert_int_equal(1, nrequests);
+}
+
+TEST(requests_are_pipelined_and_replied_in_order)
+{
+	int i;
+	int fd = connect_to_server();
+	assert_true(fd != -1);
+
+	send_request(fd, "first");
+	send_request(fd, "second");
+	send_request(fd, "third");
+
+	for(i = 0; i < 100 && nrequests < 3; ++i)
+	{
+		ipc_check();
+	}
+	/* All three requests can be processed by a single check. */
+	assert_int_equal(3, nrequests);
+
+	{
+		char buf[64];
+		assert_int_equal(1, receive_reply(fd, buf, sizeof(buf)));
+		assert_string_equal("first", buf);
+		assert_int_equal(1, receive_reply(fd, buf, sizeof(buf)));
+		assert_string_equal("second", buf);
+		assert_int_equal(1, receive_reply(fd, buf, sizeof(buf)));
+		assert_string_equal("third", buf);
+	}
+
+	close(fd);
+}
+
+TEST(multiple_clients_are_served_at_once)
+{
+	int fds[NCLIENTS];
+	int i;
+
+	for(i = 0; i < NCLIENTS; ++i)
+	{
+		char cmd[16];
+		fds[i] = connect_to_server();
+		assert_true(fds[i] != -1);
+		snprintf(cmd, sizeof(cmd), "client%d", i);
+		send_request(fds[i], cmd);
+	}
+
+	for(i = 0; i < 100 && nrequests < NCLIENTS; ++i)
+	{
+		ipc_check();
+	}
+	assert_int_equal(NCLIENTS, nrequests);
+
+	for(i = NCLIENTS - 1; i >= 0; --i)
+	{
+		char buf[64];
+		char cmd[16];
+		snprintf(cmd, sizeof(cmd), "client%d", i);
+		assert_int_equal(1, receive_reply(fds[i], buf, sizeof(buf)));
+		assert_string_equal(cmd, buf);
+		close(fds[i]);
+	}
+}
+
+TEST(disconnected_client_does_not_break_server)
+{
+	int i;
+	char buf[64];
+	int fd = connect_to_server();
+	assert_true(fd != -1);
+	send_request(fd, "lost");
+	close(fd);
+
+	fd = connect_to_server();
+	assert_true(fd != -1);
+	send_request(fd, "next");
+
+	for(i = 0; i < 100 && nrequests < 2; ++i)
+	{
+		ipc_check();
+	}
+	assert_int_equal(1, receive_reply(fd, buf, sizeof(buf)));
+	assert_string_equal("next", buf);
+	close(fd);
+}
+
+TEST(stress)
+{
+	pthread_t thread;
+	void *result;
+
+	assert_int_equal(0, pthread_create(&thread, NULL, &send_pipelined, NULL));
+	serve_until_done();
+	assert_int_equal(0, pthread_join(thread, &result));
+	assert_null(result);
+	assert_int_equal(NMESSAGES, nrequests);
+
+	done = 0;
+	nrequests = 0;
+
+	assert_int_equal(0, pthread_create(&thread, NULL, &send_many, NULL));
+	serve_until_done();
+	assert_int_equal(0, pthread_join(thread, &result));
+	assert_null(result);
+	assert_int_equal(NMESSAGES/10, nrequests);
+}
+
+/* Replies with arguments joined by spaces and their number as status. */
+static int
+echo_callback(char *args[], char **output)
+{
+	char buf[256] = "";
+	int i;
+
+	++nrequests;
+
+	for(i = 1; args[i] != NULL; ++i)
+	{
+		if(i != 1)
+		{
+			strcat(buf, " ");
+		}
+		strcat(buf, args[i]);
+	}
+
+	*output = strdup(buf);
+	return i - 1;
+}
+
+/* Sends single request via ipc_send().  Returns NULL on success. */
+static void *
+send_one(void *arg)
+{
+	struct { char **data; int *status; char **output; } *const args = arg;
+	const int result = ipc_send(name, args->data, args->status, args->output);
+	done = 1;
+	return (result == 0) ? NULL : arg;
+}
+
+/* Sends NMESSAGES requests over single connection without waiting for replies,
+ * which are read concurrently.  Returns NULL on success. */
+static void *
+send_pipelined(void *arg)
+{
+	int i;
+	void *result = NULL;
+	pthread_t writer;
+	int fd = connect_to_server();
+
+	if(pthread_create(&writer, NULL, &write_requests, &fd) != 0)
+	{
+		close(fd);
+		done = 1;
+		return &nrequests;
+	}
+
+	for(i = 0; i < NMESSAGES; ++i)
+	{
+		char buf[16];
+		if(receive_reply(fd, buf, sizeof(buf)) != 1 || strcmp(buf, "msg") != 0)
+		{
+			result = &nrequests;
+			break;
+		}
+	}
+
+	(void)pthread_join(writer, NULL);
+	close(fd);
+	done = 1;
+	return result;
+}
+
+/* Writes NMESSAGES requests to the socket pointed to by arg.  Returns NULL. */
+static void *
+write_requests(void *arg)
+{
+	int i;
+	const int fd = *(int *)arg;
+	for(i = 0; i < NMESSAGES; ++i)
+	{
+		send_request(fd, "msg");
+	}
+	return NULL;
+}
+
+/* Sends NMESSAGES/10 requests via ipc_send() one by one.  Returns NULL on
+ * success. */
+static void *
+send_many(void *arg)
+{
+	int i;
+	void *result = NULL;
+	char *data[] = { "msg", NULL };
+
+	for(i = 0; i < NMESSAGES/10; ++i)
+	{
+		int status;
+		char *output;
+		if(ipc_send(name, data, &status, &output) != 0 || status != 1)
+		{
+			result = &nrequests;
+			break;
+		}
+		free(output);
+	}
+
+	done = 1;
+	return result;
+}
+
+/* Runs loop of the server until done flag is set. */
+static void
+serve_until_done(void)
+{
+	while(!done)
+	{
+		struct pollfd pfds[128];
+		int fds[128];
+		int i;
+		const int nfds = ipc_get_fds(fds, 128);
+
+		for(i = 0; i < nfds; ++i)
+		{
+			pfds[i].fd = fds[i];
+			pfds[i].events = POLLIN;
+		}
+		(void)poll(pfds, (nfds < 0) ? 0 : nfds, (nfds < 0) ? 1 : 10);
+
+		ipc_check();
+	}
+}
+
+/* Connects to the server.  Returns socket or -1 on error. */
+static int
+connect_to_server(void)
+{
+	struct sockaddr_un addr;
+	int fd;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/vifm-ipc-%s",
+			get_tmpdir(), name);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd != -1 && connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+	{
+		close(fd);
+		fd = -1;
+	}
+	return fd;
+}
+
+/* Sends a framed request with single argument to the server. */
+static void
+send_request(int fd, const char cmd[])
+{
+	char buf[128];
+	const char cwd[] = "/";
+	const uint32_t size = sizeof(cwd) + strlen(cmd) + 2U;
+
+	memcpy(buf, &size, sizeof(size));
+	memcpy(buf + sizeof(size), cwd, sizeof(cwd));
+	memcpy(buf + sizeof(size) + sizeof(cwd), cmd, strlen(cmd) + 1U);
+	buf[sizeof(size) + size - 1U] = '\0';
+
+	assert_int_equal(sizeof(size) + size, write(fd, buf, sizeof(size) + size));
+}
+
+/* Reads single reply from the server into the buffer.  Returns status from the
+ * reply or -1 on error. */
+static int
+receive_reply(int fd, char buf[], size_t len)
+{
+	uint32_t size;
+	int32_t status;
+
+	if(read_exactly(fd, &size, sizeof(size)) != 0 || size < sizeof(status) ||
+			size - sizeof(status) >= len ||
+			read_exactly(fd, &status, sizeof(status)) != 0 ||
+			read_exactly(fd, buf, size - sizeof(status)) != 0)
+	{
+		return -1;
+	}
+
+	buf[size - sizeof(status)] = '\0';
+	return status;
+}
+
+/* Reads exactly len bytes.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+read_exactly(int fd, void *buf, size_t len)
+{
+	char *p = buf;
+	while(len != 0U)
+	{
+		const ssize_t n = read(fd, p, len);
+		if(n <= 0)
+		{
+			return 1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
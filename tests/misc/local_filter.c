@@ -0,0 +1,155 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/filelist.h"
+#include "../../src/filtering.h"
+
+#include "utils.h"
+
+static void add_entries(FileView *view, int count);
+static void add_entry(FileView *view, const char name[], FileType type);
+
+SETUP()
+{
+	view_setup(&lwin);
+	cfg.dot_dirs = 0;
+	cfg.ignore_case = 0;
+	cfg.smart_case = 0;
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+}
+
+TEST(typing_narrows_list)
+{
+	add_entry(&lwin, "abc", FT_REG);
+	add_entry(&lwin, "abd", FT_REG);
+	add_entry(&lwin, "xyz", FT_REG);
+
+	local_filter_set(&lwin, "a");
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+
+	local_filter_set(&lwin, "ab");
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_set(&lwin, "abd");
+	assert_int_equal(1, lwin.list_rows);
+	assert_int_equal(2, lwin.filtered);
+	assert_string_equal("abd", lwin.dir_entry[0].name);
+
+	local_filter_accept(&lwin);
+	assert_int_equal(1, lwin.list_rows);
+}
+
+TEST(deletion_restores_entries)
+{
+	add_entry(&lwin, "abc", FT_REG);
+	add_entry(&lwin, "abd", FT_REG);
+
+	local_filter_set(&lwin, "abc");
+	assert_int_equal(1, lwin.list_rows);
+
+	local_filter_set(&lwin, "ab");
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(2, lwin.list_rows);
+}
+
+TEST(regexps_do_not_narrow_list)
+{
+	add_entry(&lwin, "a", FT_REG);
+	add_entry(&lwin, "b", FT_REG);
+
+	local_filter_set(&lwin, "a");
+	assert_int_equal(1, lwin.list_rows);
+
+	local_filter_set(&lwin, "a|b");
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_cancel(&lwin);
+}
+
+TEST(directories_are_matched_with_trailing_slash)
+{
+	add_entry(&lwin, "dir", FT_DIR);
+	add_entry(&lwin, "dirfile", FT_REG);
+
+	local_filter_set(&lwin, "dir");
+	assert_int_equal(2, lwin.list_rows);
+
+	local_filter_set(&lwin, "dir/");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("dir", lwin.dir_entry[0].name);
+
+	local_filter_accept(&lwin);
+}
+
+TEST(empty_result_leaves_parent_directory)
+{
+	add_entry(&lwin, "..", FT_DIR);
+	add_entry(&lwin, "abc", FT_REG);
+
+	local_filter_set(&lwin, "ab");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("abc", lwin.dir_entry[0].name);
+
+	local_filter_set(&lwin, "abx");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("..", lwin.dir_entry[0].name);
+
+	local_filter_cancel(&lwin);
+}
+
+TEST(large_lists_are_filtered_correctly)
+{
+	add_entries(&lwin, 50000);
+
+	local_filter_set(&lwin, "7$");
+	assert_int_equal(5000, lwin.list_rows);
+
+	local_filter_set(&lwin, "file77");
+	assert_int_equal(111, lwin.list_rows);
+
+	local_filter_set(&lwin, "file777");
+	assert_int_equal(11, lwin.list_rows);
+
+	local_filter_accept(&lwin);
+	assert_int_equal(11, lwin.list_rows);
+}
+
+static void
+add_entries(FileView *view, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "file%d", i);
+		add_entry(view, name, FT_REG);
+	}
+}
+
+static void
+add_entry(FileView *view, const char name[], FileType type)
+{
+	dir_entry_t *entry;
+
+	view->dir_entry = dynarray_cextend(view->dir_entry,
+			sizeof(*view->dir_entry));
+	entry = &view->dir_entry[view->list_rows++];
+	entry->name = strdup(name);
+	entry->origin = &view->curr_dir[0];
+	entry->type = type;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
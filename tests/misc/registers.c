@@ -0,0 +1,96 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+
+#include "../../src/registers.h"
+
+SETUP()
+{
+	regs_init();
+}
+
+TEARDOWN()
+{
+	regs_reset();
+}
+
+TEST(duplicates_are_rejected)
+{
+	reg_t *const reg = regs_find('a');
+
+	assert_success(regs_append_listed('a', "/path/a"));
+	assert_success(regs_append_listed('a', "/path/b"));
+	assert_failure(regs_append_listed('a', "/path/a"));
+	assert_failure(regs_append_listed('a', "/path/b"));
+
+	assert_int_equal(2, reg->nfiles);
+}
+
+TEST(nonexistent_files_are_rejected_only_by_checked_append)
+{
+	assert_failure(regs_append('a', "/no/such/path"));
+	assert_success(regs_append_listed('a', "/no/such/path"));
+}
+
+TEST(many_files_are_appended)
+{
+	char path[32];
+	int i;
+	reg_t *const reg = regs_find('a');
+
+	for(i = 0; i < 1000; ++i)
+	{
+		snprintf(path, sizeof(path), "/path/%d", i);
+		assert_success(regs_append_listed('a', path));
+	}
+	assert_failure(regs_append_listed('a', "/path/500"));
+
+	assert_int_equal(1000, reg->nfiles);
+	assert_string_equal("/path/0", reg->files[0]);
+	assert_string_equal("/path/999", reg->files[999]);
+}
+
+TEST(renamed_file_is_not_a_duplicate_anymore)
+{
+	assert_success(regs_append_listed('a', "/path/old"));
+	regs_rename_contents("/path/old", "/path/new");
+
+	assert_success(regs_append_listed('a', "/path/old"));
+	assert_failure(regs_append_listed('a', "/path/new"));
+}
+
+TEST(packed_out_file_is_not_a_duplicate_anymore)
+{
+	reg_t *const reg = regs_find('a');
+
+	assert_success(regs_append_listed('a', "/path/a"));
+	assert_success(regs_append_listed('a', "/path/b"));
+	free(reg->files[0]);
+	reg->files[0] = NULL;
+	regs_pack('a');
+
+	assert_int_equal(1, reg->nfiles);
+	assert_success(regs_append_listed('a', "/path/a"));
+	assert_failure(regs_append_listed('a', "/path/b"));
+}
+
+TEST(unnamed_register_gets_a_copy)
+{
+	reg_t *const unnamed = regs_find(DEFAULT_REG_NAME);
+
+	assert_success(regs_append_listed('a', "/path/a"));
+	assert_success(regs_append_listed('a', "/path/b"));
+	regs_update_unnamed('a');
+
+	assert_int_equal(2, unnamed->nfiles);
+	assert_string_equal("/path/a", unnamed->files[0]);
+	assert_string_equal("/path/b", unnamed->files[1]);
+
+	assert_failure(regs_append_listed(DEFAULT_REG_NAME, "/path/b"));
+	assert_success(regs_append_listed(DEFAULT_REG_NAME, "/path/c"));
+	assert_int_equal(3, unnamed->nfiles);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -2,6 +2,10 @@
 
 #include <unistd.h> /* chdir() */
 
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
 #include "../../src/ui/ui.h"
 #include "../../src/utils/macros.h"
 #include "../../src/fileops.h"
@@ -45,6 +49,22 @@ TEST(rename_inside_subdir_ok)
 #endif
 }
 
+TEST(duplicated_names_fail)
+{
+	char *src[] = { "a", "b", "c" };
+	char list0[] = "x", list1[] = "y", list2[] = "x";
+	char *dst[] = { list0, list1, list2 };
+	assert_false(is_name_list_ok(ARRAY_LEN(src), ARRAY_LEN(dst), dst, src));
+}
+
+TEST(empty_names_are_not_duplicates)
+{
+	char *src[] = { "a", "b" };
+	char list0[] = "", list1[] = "";
+	char *dst[] = { list0, list1 };
+	assert_true(is_name_list_ok(ARRAY_LEN(src), ARRAY_LEN(dst), dst, src));
+}
+
 TEST(incdec_leaves_zeros)
 {
 	assert_string_equal("1", incdec_name("0", 1));
@@ -89,5 +109,43 @@ TEST(rename_list_checks)
 	}
 }
 
+TEST(swapped_names_are_marked_as_duplicates)
+{
+	char *files[] = { "a", "b", "c" };
+	char *list[] = { "b", "a", "d" };
+	int dup[ARRAY_LEN(files)] = {};
+
+	assert_true(is_rename_list_ok(files, dup, ARRAY_LEN(files), list));
+	assert_true(dup[0]);
+	assert_true(dup[1]);
+	assert_false(dup[2]);
+}
+
+TEST(cycle_in_large_list_is_handled)
+{
+	enum { N = 10000 };
+	static char *files[N], *list[N];
+	static int dup[N];
+	char name[32];
+	int i;
+
+	for(i = 0; i < N; ++i)
+	{
+		snprintf(name, sizeof(name), "file%d", i);
+		files[i] = strdup(name);
+		snprintf(name, sizeof(name), "file%d", (i + 1)%N);
+		list[i] = strdup(name);
+	}
+
+	assert_true(is_name_list_ok(N, N, list, files));
+	assert_true(is_rename_list_ok(files, dup, N, list));
+	for(i = 0; i < N; ++i)
+	{
+		assert_true(dup[i]);
+		free(files[i]);
+		free(list[i]);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
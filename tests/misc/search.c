@@ -0,0 +1,184 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* strdup() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/search.h"
+
+#include "utils.h"
+
+static void add_entries(FileView *view, int count);
+static void add_entry(FileView *view, const char name[]);
+
+SETUP()
+{
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	cfg.hl_search = 0;
+	cfg.ignore_case = 0;
+	cfg.smart_case = 0;
+}
+
+TEARDOWN()
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	cfg.ignore_case = 0;
+}
+
+TEST(literal_pattern_matches_substrings)
+{
+	int found;
+
+	add_entry(&lwin, "..");
+	add_entry(&lwin, "abcd");
+	add_entry(&lwin, "xbcx");
+	add_entry(&lwin, "bbb");
+
+	(void)find_pattern(&lwin, "bc", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(2, lwin.matches);
+	assert_int_equal(0, lwin.dir_entry[0].search_match);
+	assert_int_equal(1, lwin.dir_entry[1].search_match);
+	assert_int_equal(1, lwin.dir_entry[1].match_left);
+	assert_int_equal(3, lwin.dir_entry[1].match_right);
+	assert_int_equal(2, lwin.dir_entry[2].search_match);
+	assert_int_equal(0, lwin.dir_entry[3].search_match);
+}
+
+TEST(literal_pattern_respects_ignorecase)
+{
+	int found;
+
+	add_entry(&lwin, "ABCD");
+	add_entry(&lwin, "abcd");
+
+	(void)find_pattern(&lwin, "bc", 0, 0, &found, 0);
+	assert_int_equal(1, lwin.matches);
+
+	cfg.ignore_case = 1;
+	(void)find_pattern(&lwin, "bc", 0, 0, &found, 0);
+	assert_int_equal(2, lwin.matches);
+	assert_int_equal(1, lwin.dir_entry[0].search_match);
+	assert_int_equal(1, lwin.dir_entry[0].match_left);
+	assert_int_equal(2, lwin.dir_entry[1].search_match);
+}
+
+TEST(regexp_pattern_is_matched)
+{
+	int found;
+
+	add_entry(&lwin, "file.c");
+	add_entry(&lwin, "filexc");
+	add_entry(&lwin, "file.h");
+
+	(void)find_pattern(&lwin, "\\.[ch]$", 0, 0, &found, 0);
+	assert_int_equal(2, lwin.matches);
+	assert_int_equal(1, lwin.dir_entry[0].search_match);
+	assert_int_equal(0, lwin.dir_entry[1].search_match);
+	assert_int_equal(2, lwin.dir_entry[2].search_match);
+}
+
+TEST(extended_pattern_narrows_results)
+{
+	int found;
+
+	add_entry(&lwin, "abc");
+	add_entry(&lwin, "abd");
+	add_entry(&lwin, "xyz");
+
+	(void)find_pattern(&lwin, "ab", 0, 0, &found, 0);
+	assert_int_equal(2, lwin.matches);
+
+	(void)find_pattern(&lwin, "abd", 0, 0, &found, 0);
+	assert_int_equal(1, lwin.matches);
+	assert_int_equal(0, lwin.dir_entry[0].search_match);
+	assert_int_equal(1, lwin.dir_entry[1].search_match);
+}
+
+TEST(narrowing_is_not_done_when_case_sensitivity_is_relaxed)
+{
+	int found;
+
+	add_entry(&lwin, "abc");
+	add_entry(&lwin, "ABC");
+
+	(void)find_pattern(&lwin, "a", 0, 0, &found, 0);
+	assert_int_equal(1, lwin.matches);
+
+	cfg.ignore_case = 1;
+	(void)find_pattern(&lwin, "ab", 0, 0, &found, 0);
+	assert_int_equal(2, lwin.matches);
+}
+
+TEST(narrowing_is_not_done_for_regexps)
+{
+	int found;
+
+	add_entry(&lwin, "a");
+	add_entry(&lwin, "b");
+
+	(void)find_pattern(&lwin, "a", 0, 0, &found, 0);
+	assert_int_equal(1, lwin.matches);
+
+	(void)find_pattern(&lwin, "a|b", 0, 0, &found, 0);
+	assert_int_equal(2, lwin.matches);
+}
+
+TEST(large_lists_are_matched_correctly)
+{
+	int found;
+	int i;
+
+	add_entries(&lwin, 50000);
+
+	(void)find_pattern(&lwin, "7$", 0, 0, &found, 0);
+	assert_int_equal(5000, lwin.matches);
+
+	(void)find_pattern(&lwin, "file77", 0, 0, &found, 0);
+	assert_int_equal(111, lwin.matches);
+
+	(void)find_pattern(&lwin, "file777", 0, 0, &found, 0);
+	assert_int_equal(11, lwin.matches);
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		if(lwin.dir_entry[i].search_match)
+		{
+			assert_int_equal(0, lwin.dir_entry[i].match_left);
+			assert_int_equal(7, lwin.dir_entry[i].match_right);
+		}
+	}
+}
+
+static void
+add_entries(FileView *view, int count)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "file%d", i);
+		add_entry(view, name);
+	}
+}
+
+static void
+add_entry(FileView *view, const char name[])
+{
+	dir_entry_t *entry;
+
+	view->dir_entry = dynarray_cextend(view->dir_entry,
+			sizeof(*view->dir_entry));
+	entry = &view->dir_entry[view->list_rows++];
+	entry->name = strdup(name);
+	entry->origin = &view->curr_dir[0];
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
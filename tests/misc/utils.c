@@ -102,12 +102,17 @@ view_teardown(FileView *view)
 		free_dir_entry(view, &view->dir_entry[i]);
 	}
 	dynarray_free(view->dir_entry);
+	view->dir_entry = NULL;
+	view->list_rows = 0;
+	view->filtered = 0;
 
 	for(i = 0; i < view->custom.entry_count; ++i)
 	{
 		free_dir_entry(view, &view->custom.entries[i]);
 	}
 	dynarray_free(view->custom.entries);
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
 
 	filter_dispose(&view->local_filter.filter);
 	filter_dispose(&view->auto_filter);
@@ -3,7 +3,8 @@
 #include <sys/stat.h> /* stat */
 #include <unistd.h> /* stat() */
 
-#include <stdio.h> /* fclose() fopen() fprintf() remove() */
+#include <stdio.h> /* FILE fclose() fgets() fopen() fprintf() remove() */
+#include <string.h> /* strcmp() strcspn() */
 
 #include "../../src/cfg/config.h"
 #include "../../src/cfg/info.h"
@@ -11,12 +12,15 @@
 #include "../../src/ui/ui.h"
 #include "../../src/utils/matcher.h"
 #include "../../src/utils/str.h"
+#include "../../src/bmarks.h"
 #include "../../src/cmd_core.h"
 #include "../../src/filetype.h"
 #include "../../src/opt_handlers.h"
 
 #include "utils.h"
 
+static int count_matching_lines(const char path[], const char line[]);
+
 TEST(view_sorting_is_read_from_vifminfo)
 {
 	FILE *const f = fopen(SANDBOX_PATH "/vifminfo", "w");
@@ -76,5 +80,77 @@ TEST(filetypes_are_deduplicated)
 	reset_cmds();
 }
 
+TEST(histories_are_merged_without_duplicates)
+{
+	FILE *const f = fopen(SANDBOX_PATH "/vifminfo", "w");
+	fprintf(f, "%ca\n", LINE_TYPE_SEARCH_HIST);
+	fprintf(f, "%cb\n", LINE_TYPE_SEARCH_HIST);
+	fclose(f);
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), SANDBOX_PATH);
+	cfg.vifm_info = VIFMINFO_SHISTORY;
+	cfg_resize_histories(10);
+	cfg_save_search_history("b");
+	cfg_save_search_history("c");
+
+	write_info_file();
+
+	assert_int_equal(1, count_matching_lines(SANDBOX_PATH "/vifminfo", "/a"));
+	assert_int_equal(1, count_matching_lines(SANDBOX_PATH "/vifminfo", "/b"));
+	assert_int_equal(1, count_matching_lines(SANDBOX_PATH "/vifminfo", "/c"));
+
+	cfg_resize_histories(0);
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+	assert_success(remove(SANDBOX_PATH "/vifminfo"));
+}
+
+TEST(newer_bookmarks_win_on_merge)
+{
+	FILE *const f = fopen(SANDBOX_PATH "/vifminfo", "w");
+	fprintf(f, "%c/old\n\tfile\n\t10\n", LINE_TYPE_BOOKMARK);
+	fprintf(f, "%c/new\n\tfile\n\t30\n", LINE_TYPE_BOOKMARK);
+	fclose(f);
+
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), SANDBOX_PATH);
+	cfg.vifm_info = VIFMINFO_BOOKMARKS;
+	assert_success(bmarks_setup("/old", "memory", 20));
+	assert_success(bmarks_setup("/new", "memory", 20));
+
+	write_info_file();
+
+	assert_int_equal(0, count_matching_lines(SANDBOX_PATH "/vifminfo", "\t10"));
+	assert_int_equal(1, count_matching_lines(SANDBOX_PATH "/vifminfo", "\t30"));
+
+	bmarks_clear();
+	assert_success(remove(SANDBOX_PATH "/vifminfo"));
+}
+
+/* Counts number of lines of the file that are equal to the line.  Returns the
+ * number. */
+static int
+count_matching_lines(const char path[], const char line[])
+{
+	char buf[128];
+	int count = 0;
+	FILE *const f = fopen(path, "r");
+	if(f == NULL)
+	{
+		return -1;
+	}
+
+	while(fgets(buf, sizeof(buf), f) != NULL)
+	{
+		buf[strcspn(buf, "\n")] = '\0';
+		count += (strcmp(buf, line) == 0);
+	}
+
+	fclose(f);
+	return count;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -157,6 +157,15 @@ TEST(int_option_ok)
 	ASSERT_INT_OK("&tabstop", 8);
 }
 
+TEST(option_value_is_read_on_each_evaluation)
+{
+	optval_t val = { .int_val = 4 };
+
+	ASSERT_INT_OK("&g:tabstop", 2);
+	set_option("tabstop", val, OPT_GLOBAL);
+	ASSERT_INT_OK("&g:tabstop", 4);
+}
+
 TEST(str_option_ok)
 {
 	ASSERT_OK("&fusehome", "fusehome-default");
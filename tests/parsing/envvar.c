@@ -1,5 +1,6 @@
 #include <stic.h>
 
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() */
 
 #include "../../src/engine/parsing.h"
@@ -7,6 +8,7 @@
 #include "asserts.h"
 
 static const char * getenv_value(const char name[]);
+static const char * getenv_counter(const char name[]);
 
 SETUP()
 {
@@ -19,6 +21,23 @@ getenv_value(const char *name)
 	return name + 1;
 }
 
+/* Returns number of times it was called as a string. */
+static const char *
+getenv_counter(const char name[])
+{
+	static char buf[16];
+	static int count;
+	snprintf(buf, sizeof(buf), "%d", ++count);
+	return buf;
+}
+
+TEST(variable_is_read_on_each_evaluation)
+{
+	init_parser(&getenv_counter);
+	ASSERT_OK("$VAR", "1");
+	ASSERT_OK("$VAR", "2");
+}
+
 TEST(simple_ok)
 {
 	ASSERT_OK("$ENV", "NV");
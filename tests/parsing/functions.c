@@ -15,10 +15,12 @@ SETUP_ONCE()
 	static const function_t function_a = { "a", 1, &dummy };
 	static const function_t function_b = { "b", 2, &dummy };
 	static const function_t function_c = { "c", 0, &dummy };
+	static const function_t function_d = { "d", 1, &dummy, 1 };
 
 	assert_int_equal(0, function_register(&function_a));
 	assert_int_equal(0, function_register(&function_b));
 	assert_int_equal(0, function_register(&function_c));
+	assert_int_equal(0, function_register(&function_d));
 }
 
 TEARDOWN_ONCE()
@@ -45,6 +47,14 @@ TEST(wrong_arg_fail)
 	assert_string_equal("a)", get_last_position());
 }
 
+TEST(optional_args_can_be_omitted)
+{
+	ASSERT_OK("d('a')", "");
+	ASSERT_OK("d('a','b')", "");
+	ASSERT_FAIL("d()", PE_INVALID_EXPRESSION);
+	ASSERT_FAIL("d('a','b','c')", PE_INVALID_EXPRESSION);
+}
+
 TEST(two_args_ok)
 {
 	ASSERT_OK("b('a','b')", "");
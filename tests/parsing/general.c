@@ -68,5 +68,22 @@ TEST(expression_and_comment)
 	ASSERT_FAIL(" 4 || \"", PE_INVALID_EXPRESSION);
 }
 
+TEST(repeated_partial_parse_gives_same_state)
+{
+	int i;
+	for(i = 0; i < 2; ++i)
+	{
+		var_t res_var;
+
+		ASSERT_FAIL("'a' 'b'", PE_INVALID_EXPRESSION);
+		assert_true(is_prev_token_whitespace());
+		assert_string_equal("'b'", get_last_parsed_char());
+
+		res_var = get_parsing_result();
+		assert_string_equal("a", res_var.value.string);
+		var_free(res_var);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
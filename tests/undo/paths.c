@@ -0,0 +1,135 @@
+#include <stic.h>
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strcmp() strdup() */
+
+#include "../../src/undo.h"
+
+#include "test.h"
+
+static int collecting_exec(OPS op, void *data, const char *src,
+		const char *dst);
+
+static char *srcs[4];
+static char *dsts[4];
+static int nexecs;
+static int check_renames;
+static int nmismatches;
+
+SETUP()
+{
+	static int undo_levels = 100000;
+
+	reset_undo_list();
+	init_undo_list_for_tests(&collecting_exec, &undo_levels);
+	nexecs = 0;
+	check_renames = 0;
+	nmismatches = 0;
+}
+
+TEARDOWN()
+{
+	int i;
+	for(i = 0; i < nexecs && i < 4 && !check_renames; ++i)
+	{
+		free(srcs[i]);
+		free(dsts[i]);
+	}
+}
+
+TEST(paths_are_passed_to_operations_unchanged)
+{
+	cmd_group_begin("msg");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/dir/a", "/dir/b"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/a", "/b"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "rel", "dir/"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/x//y/", "/x/z"));
+	cmd_group_end();
+
+	assert_success(undo_group());
+	assert_int_equal(4, nexecs);
+
+	assert_string_equal("/x/z", srcs[0]);
+	assert_string_equal("/x//y/", dsts[0]);
+	assert_string_equal("dir/", srcs[1]);
+	assert_string_equal("rel", dsts[1]);
+	assert_string_equal("/b", srcs[2]);
+	assert_string_equal("/a", dsts[2]);
+	assert_string_equal("/dir/b", srcs[3]);
+	assert_string_equal("/dir/a", dsts[3]);
+}
+
+TEST(large_groups_are_undone_and_redone)
+{
+	char src[64], dst[64];
+	int i;
+
+	check_renames = 1;
+
+	cmd_group_begin("rename");
+	for(i = 0; i < 10000; ++i)
+	{
+		snprintf(src, sizeof(src), "/dir%d/file%d", i%3, i);
+		snprintf(dst, sizeof(dst), "/dir%d/renamed%d", i%3, i);
+		assert_success(add_operation(OP_MOVE, NULL, NULL, src, dst));
+	}
+	cmd_group_end();
+
+	assert_success(undo_group());
+	assert_success(redo_group());
+	assert_int_equal(20000, nexecs);
+	assert_int_equal(0, nmismatches);
+}
+
+TEST(only_commands_with_files_in_trash_are_cleaned)
+{
+	cmd_group_begin("msg");
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/dir/a", "/trash/0_a"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/dir/b", "/other/b"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/dir/c", "/trash/0_c"));
+	assert_success(add_operation(OP_MOVE, NULL, NULL, "/dir/d", "/trash2/d"));
+	cmd_group_end();
+
+	clean_cmds_with_trash("/trash");
+
+	assert_success(undo_group());
+	assert_int_equal(2, nexecs);
+	assert_string_equal("/trash2/d", srcs[0]);
+	assert_string_equal("/other/b", srcs[1]);
+}
+
+static int
+collecting_exec(OPS op, void *data, const char *src, const char *dst)
+{
+	if(!check_renames)
+	{
+		if(nexecs < 4)
+		{
+			srcs[nexecs] = strdup(src);
+			dsts[nexecs] = strdup(dst);
+		}
+	}
+	else
+	{
+		/* Second half of executions is redo of operations that were undone in
+		 * reverse order. */
+		const int redo = (nexecs >= 10000);
+		const int i = redo ? (nexecs - 10000) : (10000 - 1 - nexecs);
+		char file[64], renamed[64];
+		snprintf(file, sizeof(file), "/dir%d/file%d", i%3, i);
+		snprintf(renamed, sizeof(renamed), "/dir%d/renamed%d", i%3, i);
+
+		if(strcmp(src, redo ? file : renamed) != 0 ||
+				strcmp(dst, redo ? renamed : file) != 0)
+		{
+			++nmismatches;
+		}
+	}
+
+	++nexecs;
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,84 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <stddef.h> /* size_t */
+#include <string.h> /* strcpy() strlen() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/mntent.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/utils.h"
+
+static void check_path(const char path[]);
+static int find_longest(struct mntent *entry, void *arg);
+
+/* Path being looked up by find_longest(). */
+static const char *looked_up;
+/* Longest mount point among those that contain looked_up path. */
+static char longest[PATH_MAX];
+
+TEST(root_is_found)
+{
+	check_path("/");
+}
+
+TEST(lookup_matches_linear_search)
+{
+	check_path("/proc/self");
+	check_path("/dev/null");
+	check_path("/tmp/");
+	check_path(SANDBOX_PATH);
+	check_path(TEST_DATA_PATH "/existing-files");
+}
+
+TEST(mount_points_are_found_for_themselves)
+{
+	char mount_point[PATH_MAX];
+	char itself[PATH_MAX];
+
+	assert_success(get_mount_point(SANDBOX_PATH, sizeof(mount_point),
+				mount_point));
+	assert_success(get_mount_point(mount_point, sizeof(itself), itself));
+	assert_string_equal(mount_point, itself);
+}
+
+TEST(relative_paths_have_no_mount_point)
+{
+	char mount_point[PATH_MAX];
+	assert_failure(get_mount_point("relative/path", sizeof(mount_point),
+				mount_point));
+}
+
+/* Checks that get_mount_point() gives the same result as linear search among
+ * all mount points does. */
+static void
+check_path(const char path[])
+{
+	char mount_point[PATH_MAX];
+
+	looked_up = path;
+	longest[0] = '\0';
+	assert_success(traverse_mount_points(&find_longest, NULL));
+
+	assert_success(get_mount_point(path, sizeof(mount_point), mount_point));
+	assert_string_equal(longest, mount_point);
+}
+
+/* traverse_mount_points() client that finds the longest mount point that
+ * contains looked_up path. */
+static int
+find_longest(struct mntent *entry, void *arg)
+{
+	const size_t len = strlen(entry->mnt_dir);
+	if(path_starts_with(looked_up, entry->mnt_dir) && len > strlen(longest))
+	{
+		strcpy(longest, entry->mnt_dir);
+	}
+	return 0;
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,116 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL */
+
+#include "../../src/utils/matcher.h"
+#include "../../src/utils/matcher_index.h"
+
+static void add(const char expr[]);
+
+static matcher_index_t *index;
+static matcher_t *matchers[16];
+static int nmatchers;
+
+SETUP()
+{
+	index = matcher_index_alloc();
+	assert_non_null(index);
+	nmatchers = 0;
+}
+
+TEARDOWN()
+{
+	int i;
+	matcher_index_free(index);
+	for(i = 0; i < nmatchers; ++i)
+	{
+		matcher_free(matchers[i]);
+	}
+}
+
+TEST(empty_index_matches_nothing)
+{
+	assert_int_equal(-1, matcher_index_find(index, "file", 0));
+}
+
+TEST(names_are_matched_case_insensitively)
+{
+	add("{Makefile,README}");
+
+	assert_int_equal(0, matcher_index_find(index, "makefile", 0));
+	assert_int_equal(0, matcher_index_find(index, "ReadMe", 0));
+	assert_int_equal(-1, matcher_index_find(index, "Makefile.am", 0));
+}
+
+TEST(suffixes_follow_glob_semantics)
+{
+	add("{*.tar.gz}");
+
+	assert_int_equal(0, matcher_index_find(index, "a.tar.gz", 0));
+	assert_int_equal(0, matcher_index_find(index, "a.b.TAR.GZ", 0));
+	assert_int_equal(0, matcher_index_find(index, "/path/a.tar.gz", 0));
+	assert_int_equal(-1, matcher_index_find(index, ".tar.gz", 0));
+	assert_int_equal(-1, matcher_index_find(index, ".a.tar.gz", 0));
+	assert_int_equal(-1, matcher_index_find(index, "a.gz", 0));
+}
+
+TEST(order_of_matchers_is_preserved)
+{
+	add("/^a/");
+	add("{*.c}");
+	add("{*.[ch]}");
+	add("{*.c,*.h}");
+
+	assert_int_equal(0, matcher_index_find(index, "a.c", 0));
+	assert_int_equal(1, matcher_index_find(index, "b.c", 0));
+	assert_int_equal(2, matcher_index_find(index, "b.c", 2));
+	assert_int_equal(3, matcher_index_find(index, "b.c", 3));
+	assert_int_equal(2, matcher_index_find(index, "b.h", 0));
+	assert_int_equal(-1, matcher_index_find(index, "b.c", 4));
+}
+
+TEST(results_match_those_of_matchers)
+{
+	static const char *const names[] = {
+		"a.c", ".c", "..c", "x.C", "Makefile", "dir/", "a.tar.gz", "archive.zip",
+	};
+
+	int i;
+
+	add("{*.zip}");
+	add("{Makefile}");
+	add("{*.gz,dir}");
+	add("/^\\./");
+	add("{*.c}");
+	add("{{*.c}}");
+
+	for(i = 0; i < (int)(sizeof(names)/sizeof(names[0])); ++i)
+	{
+		int j;
+		int expected = -1;
+		for(j = 0; j < nmatchers; ++j)
+		{
+			if(matcher_matches(matchers[j], names[i]))
+			{
+				expected = j;
+				break;
+			}
+		}
+		assert_int_equal(expected, matcher_index_find(index, names[i], 0));
+	}
+}
+
+static void
+add(const char expr[])
+{
+	char *error;
+	matcher_t *const m = matcher_alloc(expr, 0, 1, &error);
+	assert_non_null(m);
+	assert_null(error);
+
+	matchers[nmatchers++] = m;
+	assert_success(matcher_index_add(index, m));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
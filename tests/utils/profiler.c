@@ -0,0 +1,129 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() remove() */
+#include <string.h> /* strstr() */
+
+#include "../../src/utils/profiler.h"
+#include "../../src/utils/string_array.h"
+
+static char ** get_report(int *nlines);
+
+TEARDOWN()
+{
+	prof_stop();
+}
+
+TEST(nothing_is_recorded_unless_started)
+{
+	int nlines;
+	char **lines;
+
+	prof_phase("phase");
+	assert_int_equal(-1, prof_enter("span", NULL));
+
+	lines = get_report(&nlines);
+	assert_int_equal(2, nlines);
+	free_string_array(lines, nlines);
+}
+
+TEST(phases_and_spans_are_reported_in_order)
+{
+	int nlines;
+	char **lines;
+	int id;
+
+	prof_start();
+	prof_phase("first");
+	id = prof_enter("source", "/path/to/file");
+	assert_true(id >= 0);
+	prof_leave(id);
+	prof_phase("second");
+
+	lines = get_report(&nlines);
+	assert_int_equal(5, nlines);
+	if(nlines == 5)
+	{
+		assert_non_null(strstr(lines[1], "  first"));
+		assert_non_null(strstr(lines[2], "    source /path/to/file"));
+		assert_non_null(strstr(lines[3], "  second"));
+		assert_non_null(strstr(lines[4], "  total"));
+	}
+	free_string_array(lines, nlines);
+}
+
+TEST(spans_are_nested)
+{
+	int nlines;
+	char **lines;
+
+	prof_start();
+	prof_phase("phase");
+	(void)prof_enter("outer", NULL);
+	(void)prof_enter("inner", NULL);
+
+	lines = get_report(&nlines);
+	assert_int_equal(5, nlines);
+	if(nlines == 5)
+	{
+		assert_non_null(strstr(lines[2], "    outer"));
+		assert_non_null(strstr(lines[3], "      inner"));
+	}
+	free_string_array(lines, nlines);
+}
+
+TEST(leaving_span_closes_nested_ones)
+{
+	int nlines;
+	char **lines;
+	int id;
+
+	prof_start();
+	id = prof_enter("outer", NULL);
+	(void)prof_enter("inner", NULL);
+	prof_leave(id);
+	(void)prof_enter("next", NULL);
+
+	lines = get_report(&nlines);
+	assert_int_equal(5, nlines);
+	if(nlines == 5)
+	{
+		assert_non_null(strstr(lines[3], "  next"));
+		assert_null(strstr(lines[3], "   next"));
+	}
+	free_string_array(lines, nlines);
+}
+
+TEST(nothing_is_recorded_after_finish)
+{
+	int nlines;
+	char **lines;
+
+	prof_start();
+	prof_phase("phase");
+	prof_finish();
+	prof_phase("late");
+	assert_int_equal(-1, prof_enter("span", NULL));
+
+	lines = get_report(&nlines);
+	assert_int_equal(3, nlines);
+	free_string_array(lines, nlines);
+}
+
+/* Writes report into a file and reads it back.  Returns lines of the report
+ * or NULL on error. */
+static char **
+get_report(int *nlines)
+{
+	char **lines;
+	FILE *const fp = fopen(SANDBOX_PATH "/profile", "w");
+	assert_non_null(fp);
+	assert_success(prof_report(fp));
+	fclose(fp);
+
+	lines = read_file_of_lines(SANDBOX_PATH "/profile", nlines);
+	assert_success(remove(SANDBOX_PATH "/profile"));
+	return lines;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,70 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* memset() */
+
+#include "../../src/utils/strbuf.h"
+
+TEST(empty_buffer_produces_empty_string)
+{
+	strbuf_t buf = STRBUF_INITIALIZER;
+	char *const str = strbuf_finish(&buf);
+	assert_string_equal("", str);
+	free(str);
+}
+
+TEST(pieces_are_appended)
+{
+	strbuf_t buf = STRBUF_INITIALIZER;
+	char *str;
+
+	assert_success(strbuf_append(&buf, "abc"));
+	assert_success(strbuf_appendn(&buf, "defgh", 2U));
+	assert_success(strbuf_append(&buf, ""));
+	assert_int_equal(5, buf.len);
+	assert_string_equal("abcde", buf.data);
+
+	str = strbuf_finish(&buf);
+	assert_string_equal("abcde", str);
+	assert_null(buf.data);
+	assert_int_equal(0, buf.len);
+	free(str);
+}
+
+TEST(long_strings_are_built)
+{
+	char piece[100];
+	int i;
+	strbuf_t buf = STRBUF_INITIALIZER;
+
+	memset(piece, 'x', sizeof(piece) - 1U);
+	piece[sizeof(piece) - 1U] = '\0';
+
+	for(i = 0; i < 1000; ++i)
+	{
+		assert_success(strbuf_append(&buf, piece));
+	}
+
+	assert_int_equal(99000, buf.len);
+	assert_true(buf.capacity > buf.len);
+	assert_int_equal('x', buf.data[98999]);
+	assert_int_equal('\0', buf.data[99000]);
+
+	strbuf_free(&buf);
+	assert_null(buf.data);
+}
+
+TEST(failed_buffer_produces_null)
+{
+	strbuf_t buf = STRBUF_INITIALIZER;
+
+	assert_success(strbuf_append(&buf, "abc"));
+	buf.failed = 1;
+	assert_failure(strbuf_append(&buf, "def"));
+	assert_string_equal("abc", buf.data);
+
+	assert_null(strbuf_finish(&buf));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */